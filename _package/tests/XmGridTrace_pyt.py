@@ -1,6 +1,8 @@
 """Test GridTrace."""
 
 # 1. Standard Python modules
+import os
+import tempfile
 import unittest
 
 # 2. Third party modules
@@ -10,7 +12,7 @@ import numpy as np
 from xms.grid.ugrid import UGrid
 
 # 4. Local modules
-from xms.gridtrace import exit_reason_enum, GridTrace
+from xms.gridtrace import exit_reason_enum, GridTrace, integrator_enum
 
 
 class TestGridTrace(unittest.TestCase):
@@ -316,6 +318,94 @@ class TestGridTrace(unittest.TestCase):
         self.assertGreater(max_x, seeds[0][0])
         self.assertLess(traces[0][-1][0], max_x)
 
+    def test_window_time_steps(self):
+        """A window of three steps traces through the middle one in a single call."""
+        seeds = [(20, 10, 0)]
+        seed_times = [0]
+
+        stepped = self.create_rotating_field_tracer()
+        self.assertEqual(2, stepped.window_time_steps)
+        stepped.start_traces(seeds, seed_times)
+        self.assertEqual(1, stepped.continue_traces())
+        stepped.add_grid_scalars_at_time([(-1, 0, 0)], 'cells', [True], 'cells', 20)
+        self.assertEqual(0, stepped.continue_traces())
+        expected_traces, expected_times, expected_reasons = stepped.get_trace_results()
+
+        tracer = self.create_rotating_field_tracer()
+        tracer.window_time_steps = 1
+        self.assertEqual(2, tracer.window_time_steps)
+        tracer.window_time_steps = 3
+        self.assertEqual(3, tracer.window_time_steps)
+        tracer.add_grid_scalars_at_time([(-1, 0, 0)], 'cells', [True], 'cells', 20)
+        tracer.start_traces(seeds, seed_times)
+        self.assertEqual(0, tracer.continue_traces())
+        traces, times, reasons = tracer.get_trace_results()
+        self.assertEqual(exit_reason_enum.MAX_TRACING_TIME, reasons[0])
+        self.assertEqual(expected_reasons[0], reasons[0])
+        self.assertAlmostEqual(18.0, times[0][-1])
+        # The field is uniform, so only where steps are cut short differs. Both runs are pinned: the two-step run
+        # resumes with the step cut short to land on t = 10, and the three-step run never cuts one there.
+        self.assertEqual(35, len(expected_traces[0]))
+        np.testing.assert_array_almost_equal((22.336482412555245, 19.718198249323862), expected_traces[0][-1][:2],
+                                             decimal=12)
+        self.assertEqual(30, len(traces[0]))
+        np.testing.assert_array_almost_equal((22.36518864288648, 19.737489876430747), traces[0][-1][:2], decimal=12)
+
+    def test_time_step_cache(self):
+        """Scrubbing back re-adds cached steps, which trace exactly as the steps first added."""
+        seeds = [(20, 10, 0)]
+        expected = self.create_rotating_field_tracer().trace_point(seeds[0], 0)
+
+        tracer = self.create_rotating_field_tracer()
+        self.assertEqual(0, tracer.time_step_cache_bytes)
+        self.assertFalse(tracer.add_cached_grid_scalars_at_time(0))
+        tracer.time_step_cache_bytes = 1 << 20
+        tracer.time_step_dataset = 'rotating'
+        self.assertEqual('rotating', tracer.time_step_dataset)
+        tracer.add_grid_scalars_at_time([(1, 0, 0)], 'cells', [True], 'cells', 0)
+        tracer.add_grid_scalars_at_time([(0, 1, 0)], 'cells', [True], 'cells', 10)
+        tracer.add_grid_scalars_at_time([(-1, 0, 0)], 'cells', [True], 'cells', 20)
+        tracer.reset_statistics()
+        self.assertTrue(tracer.add_cached_grid_scalars_at_time(0))
+        self.assertTrue(tracer.add_cached_grid_scalars_at_time(10))
+        self.assertFalse(tracer.add_cached_grid_scalars_at_time(30))
+        stats = tracer.get_statistics()
+        self.assertEqual(2, stats['time_step_cache_hits'])
+        self.assertEqual(1, stats['time_step_cache_misses'])
+        trace, times = tracer.trace_point(seeds[0], 0)
+        np.testing.assert_array_equal(expected[0], trace)
+        np.testing.assert_array_equal(expected[1], times)
+
+        tracer.clear_time_step_cache()
+        self.assertFalse(tracer.add_cached_grid_scalars_at_time(0))
+
+    def test_geometry_cache_directory(self):
+        """A grid opened again with a geometry cache directory loads its triangulation and traces the same."""
+        seed = (20, 10, 0)
+        expected = self.create_rotating_field_tracer().trace_point(seed, 0)
+        points = [(0, 0, 0), (40, 0, 0), (40, 40, 0), (0, 40, 0)]
+        cells = [UGrid.cell_type_enum.QUAD, 4, 0, 1, 2, 3]
+        with tempfile.TemporaryDirectory() as directory:
+            for _ in range(2):
+                tracer = GridTrace(UGrid(points, cells))
+                self.assertEqual('', tracer.geometry_cache_directory)
+                tracer.geometry_cache_directory = directory
+                self.assertEqual(directory, tracer.geometry_cache_directory)
+                tracer.vector_multiplier = 1
+                tracer.max_tracing_time = 18
+                tracer.max_tracing_distance = 1000
+                tracer.min_delta_time = .01
+                tracer.max_change_distance = .5
+                tracer.max_change_velocity = -1
+                tracer.max_change_direction_in_radians = np.pi
+                tracer.add_grid_scalars_at_time([(1, 0, 0)], 'cells', [True], 'cells', 0)
+                tracer.add_grid_scalars_at_time([(0, 1, 0)], 'cells', [True], 'cells', 10)
+                self.assertEqual(1, len(os.listdir(directory)))
+                trace, times = tracer.trace_point(seed, 0)
+                np.testing.assert_array_almost_equal(expected[0], trace)
+                np.testing.assert_array_almost_equal(expected[1], times)
+                del tracer
+
     def test_start_traces_rejects_mismatched_times(self):
         """A caller supplying the wrong number of start times gets an error, not a silent no-op."""
         tracer = self.create_rotating_field_tracer()
@@ -343,6 +433,322 @@ class TestGridTrace(unittest.TestCase):
         self.assertEqual(0, len(traces[2]))
         self.assertEqual(exit_reason_enum.SEED_NOT_TRACEABLE, reasons[2])
 
+    def test_flat_trace_results(self):
+        """The flat arrays hold exactly what get_trace_results returns, trace by trace."""
+        seeds = [(.5, .5, 0), (.25, .75, 0), (-.1, 0, 0)]
+        tracer = self.create_default_single_cell()
+        tracer.start_traces(seeds, [.5, .5, .5])
+        tracer.continue_traces()
+        traces, times, reasons = tracer.get_trace_results()
+        flat_xy, flat_times, offsets, flat_reasons = tracer.get_flat_trace_results()
+
+        self.assertEqual((offsets[-1], 2), flat_xy.shape)
+        self.assertEqual(len(seeds) + 1, len(offsets))
+        for i in range(len(seeds)):
+            begin, end = offsets[i], offsets[i + 1]
+            np.testing.assert_array_equal(np.array(traces[i]).reshape(-1, 3)[:, :2], flat_xy[begin:end])
+            np.testing.assert_array_equal(times[i], flat_times[begin:end])
+            self.assertEqual(int(reasons[i]), flat_reasons[i])
+        self.assertEqual(offsets[2], offsets[3])
+
+    def test_trace_points(self):
+        """trace_points gives each point what trace_point gives it, from arrays or lists."""
+        seeds = [(.5, .5, 0), (.25, .75, 0), (-.1, 0, 0)]
+        tracer = self.create_default_single_cell()
+        expected = [tracer.trace_point(pt, .5) for pt in seeds]
+
+        for pts, times in ((np.array(seeds), np.full(3, .5)), (np.array(seeds)[:, :2], .5), (seeds, [.5] * 3)):
+            xy, flat_times, offsets, reasons = tracer.trace_points(pts, times)
+            self.assertEqual(len(seeds) + 1, len(offsets))
+            for i, (expected_trace, expected_times) in enumerate(expected):
+                begin, end = offsets[i], offsets[i + 1]
+                np.testing.assert_array_equal(np.array(expected_trace).reshape(-1, 3)[:, :2], xy[begin:end])
+                np.testing.assert_array_equal(expected_times, flat_times[begin:end])
+            self.assertEqual(int(exit_reason_enum.SEED_NOT_TRACEABLE), reasons[2])
+
+        with self.assertRaises(ValueError):
+            tracer.trace_points(np.array(seeds), [.5])
+
+    def test_start_traces_from_arrays(self):
+        """start_traces reads NumPy seeds as it reads lists."""
+        seeds = [(.5, .5, 0), (.25, .75, 0)]
+        results = []
+        for pts, times in ((seeds, [.5, .5]), (np.array(seeds)[:, :2], np.array([.5, .5]))):
+            tracer = self.create_default_single_cell()
+            tracer.start_traces(pts, times)
+            tracer.continue_traces()
+            results.append(tracer.get_flat_trace_results())
+        for expected, actual in zip(results[0], results[1]):
+            np.testing.assert_array_equal(expected, actual)
+
+    def test_take_trace_results(self):
+        """Finished traces can be taken one at a time, and the rest all at once."""
+        seeds = [(.5, .5, 0), (.25, .75, 0), (-.1, 0, 0)]
+        tracer = self.create_default_single_cell()
+        tracer.start_traces(seeds, [.5, .5, .5])
+        tracer.continue_traces()
+        traces, times, reasons = tracer.get_trace_results()
+
+        taken = tracer.take_trace_result(0)
+        np.testing.assert_array_equal(traces[0], taken[0])
+        np.testing.assert_array_equal(times[0], taken[1])
+        self.assertEqual(reasons[0], taken[2])
+        self.assertIsNone(tracer.take_trace_result(len(seeds)))
+
+        rest = tracer.take_trace_results()
+        self.assertEqual(0, len(rest[0][0]))
+        np.testing.assert_array_equal(traces[1], rest[0][1])
+        self.assertEqual(list(reasons), list(rest[2]))
+        self.assertEqual(0, len(tracer.get_trace_results()[0]))
+
+    def test_trace_sink(self):
+        """A sink is handed the traces get_trace_results would otherwise return."""
+        seeds = [(.5, .5, 0), (.25, .75, 0), (-.1, 0, 0)]
+        tracer = self.create_default_single_cell()
+        tracer.start_traces(seeds, [.5, .5, .5])
+        tracer.continue_traces()
+        traces, times, reasons = tracer.get_trace_results()
+
+        runs = {}
+        ends = {}
+        tracer.set_trace_sink(lambda i, xyt: runs.setdefault(i, []).append(xyt),
+                              lambda i, reason: ends.__setitem__(i, reason))
+        tracer.start_traces(seeds, [.5, .5, .5])
+        tracer.continue_traces()
+        # A trace still waiting on a later time step has not ended yet.
+        waiting = exit_reason_enum.WAITING_FOR_TIME_STEP
+        self.assertEqual(list(reasons), [ends.get(i, waiting) for i in range(len(seeds))])
+        for i in runs:
+            xyt = np.concatenate(runs[i])
+            np.testing.assert_array_almost_equal(np.asarray(traces[i])[:, :2], xyt[:, :2])
+            np.testing.assert_array_almost_equal(times[i], xyt[:, 2])
+        self.assertEqual(0, sum(len(trace) for trace in tracer.get_trace_results()[0]))
+
+        tracer.set_trace_sink()
+        tracer.start_traces(seeds, [.5, .5, .5])
+        tracer.continue_traces()
+        self.assertEqual(len(traces[0]), len(tracer.get_trace_results()[0][0]))
+
+    def test_simplification_tolerance(self):
+        """A simplified trace keeps its ends and some of its vertices, with their times."""
+        tracer = self.create_default_single_cell()
+        tracer.max_change_distance = .01
+        trace, times = tracer.trace_point((.1, .1, 0), .5)
+
+        tracer.simplification_tolerance = .001
+        self.assertEqual(.001, tracer.simplification_tolerance)
+        kept, kept_times = tracer.trace_point((.1, .1, 0), .5)
+        self.assertLess(len(kept), len(trace))
+        np.testing.assert_array_equal(trace[0], kept[0])
+        np.testing.assert_array_equal(trace[-1], kept[-1])
+        self.assertTrue(set(kept_times) <= set(times))
+
+    def test_snapshot_time(self):
+        """A snapshot traces past the second time step without waiting for another."""
+        tracer = self.create_default_single_cell()
+        self.assertIsNone(tracer.snapshot_time)
+        tracer.start_traces([(.1, .1, 0)], [9.5])
+        self.assertEqual(1, tracer.continue_traces())
+
+        tracer.snapshot_time = 5
+        self.assertEqual(5, tracer.snapshot_time)
+        tracer.start_traces([(.1, .1, 0)], [9.5])
+        self.assertEqual(0, tracer.continue_traces())
+        traces, times, reasons = tracer.get_trace_results()
+        self.assertEqual(exit_reason_enum.LEFT_GRID, reasons[0])
+        self.assertGreater(times[0][-1], 10)
+
+        tracer.snapshot_time = None
+        self.assertIsNone(tracer.snapshot_time)
+
+    def test_integrators_stop_the_same_way(self):
+        """Every integrator honours the time budget and reports it the same way."""
+        for integrator in (integrator_enum.EULER, integrator_enum.RK4, integrator_enum.DORMAND_PRINCE):
+            tracer = self.create_default_single_cell()
+            tracer.integrator = integrator
+            tracer.absolute_tolerance = 1e-8
+            tracer.relative_tolerance = 1e-8
+            self.assertEqual(integrator, tracer.integrator)
+            self.assertEqual(1e-8, tracer.absolute_tolerance)
+            self.assertEqual(1e-8, tracer.relative_tolerance)
+            tracer.max_tracing_time = .25
+            trace, times = tracer.trace_point((.25, .25, 0), .5)
+            self.assertEqual(exit_reason_enum.MAX_TRACING_TIME, tracer.get_exit_reason())
+            self.assertAlmostEqual(.75, times[-1])
+            np.testing.assert_array_almost_equal((.5, .5, 0), trace[-1])
+
+    def test_thread_count_does_not_change_results(self):
+        """continue_traces returns the same batch whatever thread_count is."""
+        seeds = [(.1 * i, .05 * i, 0) for i in range(1, 10)] * 8
+        seed_times = [.5] * len(seeds)
+
+        serial = self.create_default_single_cell()
+        self.assertEqual(1, serial.thread_count)
+        serial.start_traces(seeds, seed_times)
+        serial.continue_traces()
+        expected = serial.get_trace_results()
+
+        parallel = self.create_default_single_cell()
+        parallel.thread_count = 4
+        self.assertEqual(4, parallel.thread_count)
+        parallel.start_traces(seeds, seed_times)
+        parallel.continue_traces()
+        traces, times, reasons = parallel.get_trace_results()
+
+        self.assertEqual(list(expected[2]), list(reasons))
+        for i in range(len(seeds)):
+            np.testing.assert_array_equal(expected[0][i], traces[i])
+            np.testing.assert_array_equal(expected[1][i], times[i])
+
+    def test_packet_width_does_not_change_results(self):
+        """continue_traces returns the same batch whatever packet_width is."""
+        seeds = [(.1 * i, .05 * i, 0) for i in range(1, 10)] * 8
+        seed_times = [.5] * len(seeds)
+
+        single = self.create_default_single_cell()
+        self.assertEqual(1, single.packet_width)
+        single.start_traces(seeds, seed_times)
+        single.continue_traces()
+        expected = single.get_trace_results()
+
+        packed = self.create_default_single_cell()
+        packed.packet_width = 8
+        self.assertEqual(8, packed.packet_width)
+        packed.start_traces(seeds, seed_times)
+        packed.continue_traces()
+        traces, times, reasons = packed.get_trace_results()
+
+        self.assertEqual(list(expected[2]), list(reasons))
+        for i in range(len(seeds)):
+            np.testing.assert_array_equal(expected[0][i], traces[i])
+            np.testing.assert_array_equal(expected[1][i], times[i])
+
+    def test_spatial_ordering_does_not_change_results(self):
+        """continue_traces returns the same batch, in seed order, whatever order it steps in."""
+        seeds = [((.37 * i) % 1, (.61 * i) % 1, 0) for i in range(1, 40)]
+        seed_times = [.5] * len(seeds)
+
+        seed_order = self.create_default_single_cell()
+        self.assertFalse(seed_order.spatial_ordering)
+        seed_order.start_traces(seeds, seed_times)
+        seed_order.continue_traces()
+        expected = seed_order.get_trace_results()
+
+        ordered = self.create_default_single_cell()
+        ordered.spatial_ordering = True
+        self.assertTrue(ordered.spatial_ordering)
+        ordered.start_traces(seeds, seed_times)
+        ordered.continue_traces()
+        traces, times, reasons = ordered.get_trace_results()
+
+        self.assertEqual(list(expected[2]), list(reasons))
+        for i in range(len(seeds)):
+            np.testing.assert_array_equal(expected[0][i], traces[i])
+            np.testing.assert_array_equal(expected[1][i], times[i])
+
+    def test_exit_edge_is_reported(self):
+        """A trace that leaves the grid reports the cell edge it left through."""
+        tracer = self.create_default_two_cell()
+        tracer.add_grid_scalars_at_time([(.1, 0, 0), (.2, 0, 0)], "cells", [True] * 2, "cells", 100)
+        tracer.trace_point((.5, .5, 0), 10)
+        self.assertEqual(exit_reason_enum.LEFT_GRID, tracer.get_exit_reason())
+        self.assertEqual((1, 1), tuple(tracer.get_exit_edge()))
+
+        tracer.start_traces([(.5, .5, 0), (5, 5, 0)], [10, 10])
+        tracer.continue_traces()
+        cells, cell_edges = tracer.get_trace_exit_edges()
+        self.assertEqual([1, -1], list(cells))
+        self.assertEqual([1, -1], list(cell_edges))
+
+    def test_statistics(self):
+        """get_statistics counts what tracing did, and reset_statistics zeroes it."""
+        tracer = self.create_default_two_cell()
+        tracer.add_grid_scalars_at_time([(.1, 0, 0), (.2, 0, 0)], "cells", [True] * 2, "cells", 100)
+        tracer.start_traces([(.5, .5, 0), (5, 5, 0)], [10, 10])
+        tracer.continue_traces()
+        traces, _, _ = tracer.get_trace_results()
+
+        stats = tracer.get_statistics()
+        self.assertGreaterEqual(stats['accepted_steps'], len(traces[0]) - 1)
+        self.assertEqual(stats['rejected_steps'],
+                         stats['velocity_splits'] + stats['direction_splits'] + stats['error_rejections'])
+        self.assertGreater(stats['evaluations'], 0)
+        self.assertGreaterEqual(stats['boundary_exits'], 1)
+        self.assertEqual(1, stats['exit_reasons'][exit_reason_enum.LEFT_GRID])
+        self.assertEqual(1, stats['exit_reasons'][exit_reason_enum.SEED_NOT_TRACEABLE])
+        self.assertGreater(stats['add_scalars_seconds'], 0)
+        self.assertGreater(stats['stepping_seconds'], 0)
+
+        tracer.reset_statistics()
+        stats = tracer.get_statistics()
+        self.assertEqual(0, stats['accepted_steps'])
+        self.assertEqual(0, stats['exit_reasons'][exit_reason_enum.LEFT_GRID])
+        self.assertEqual(0.0, stats['stepping_seconds'])
+
+    def test_add_grid_scalars_at_time_async(self):
+        """A step added asynchronously traces exactly as one added synchronously."""
+        results = []
+        for use_async in (False, True):
+            tracer = self.create_default_two_cell()
+            tracer.start_traces([(.1, .5, 0)], [0])
+            scalars = [(.02, .01, 0), (.01, .01, 0)]
+            if use_async:
+                tracer.add_grid_scalars_at_time_async(scalars, "cells", [True] * 2, "cells", 20)
+                self.assertEqual(1, tracer.continue_traces())
+            else:
+                self.assertEqual(1, tracer.continue_traces())
+                tracer.add_grid_scalars_at_time(scalars, "cells", [True] * 2, "cells", 20)
+            tracer.continue_traces()
+            results.append(tracer.get_trace_results())
+            self.assertGreaterEqual(tracer.get_statistics()['time_step_wait_seconds'], 0)
+
+        np.testing.assert_array_equal(results[0][0][0], results[1][0][0])
+        np.testing.assert_array_equal(results[0][1][0], results[1][1][0])
+        self.assertGreater(results[1][1][0][-1], 10)
+
+    def test_add_grid_scalars_from_arrays(self):
+        """NumPy arrays of vectors, as rows or as components, trace exactly as lists of tuples."""
+        scalars = [(.1, .02, 0), (.2, -.01, 0)]
+        activity = [True, True]
+        results = []
+        steps = [
+            lambda t, time: t.add_grid_scalars_at_time(scalars, "cells", activity, "cells", time),
+            lambda t, time: t.add_grid_scalars_at_time(np.array(scalars), "cells", np.array(activity), "cells",
+                                                       time),
+            lambda t, time: t.add_grid_scalars_at_time(np.array(scalars, dtype=np.float32)[:, :2], "cells",
+                                                       activity, "cells", time),
+            lambda t, time: t.add_grid_scalar_components_at_time(np.array([.1, .2]), np.array([.02, -.01]),
+                                                                 "cells", np.ones(2, dtype=bool), "cells", time),
+        ]
+        for add_step in steps:
+            tracer = self.create_default_two_cell()
+            add_step(tracer, 20)
+            results.append(tracer.trace_point((.1, .5, 0), 5))
+
+        for result in results[1:]:
+            np.testing.assert_array_equal(results[0][0], result[0])
+            np.testing.assert_array_equal(results[0][1], result[1])
+        self.assertGreater(len(results[0][0]), 2)
+
+        tracer = self.create_default_two_cell()
+        with self.assertRaises(ValueError):
+            tracer.add_grid_scalars_at_time(np.zeros((2, 4)), "cells", activity, "cells", 20)
+
+    def test_add_grid_scalar_changes_at_time(self):
+        """A step added as changes traces exactly as the whole step it describes."""
+        results = []
+        for use_changes in (False, True):
+            tracer = self.create_default_two_cell()
+            if use_changes:
+                tracer.add_grid_scalar_changes_at_time([1], [(.1, .05, 0)], [], 20)
+            else:
+                tracer.add_grid_scalars_at_time([(.1, 0, 0), (.1, .05, 0)], "cells", [True] * 2, "cells", 20)
+            results.append(tracer.trace_point((.1, .5, 0), 5))
+
+        np.testing.assert_array_equal(results[0][0], results[1][0])
+        np.testing.assert_array_equal(results[0][1], results[1][1])
+        self.assertGreater(len(results[1][0]), 2)
+
     def test_max_tracing_distance(self):
         """Test functionality of max tracing distance."""
         tracer = self.create_default_single_cell()
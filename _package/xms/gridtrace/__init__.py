@@ -1,4 +1,5 @@
 """Initialize the module."""
 from ._xmsgridtrace import __version__  # NOQA: F401
 from ._xmsgridtrace.gridtrace import exit_reason_enum  # NOQA: F401
+from ._xmsgridtrace.gridtrace import integrator_enum  # NOQA: F401
 from .grid_trace import GridTrace  # NOQA: F401
@@ -125,10 +125,151 @@ class GridTrace(object):
         """Set the maximum change in direction between trace steps, in radians."""
         self._instance.max_change_direction_in_radians = value
 
+    @property
+    def integrator(self):
+        """How each step is integrated, an integrator_enum; EULER by default."""
+        return self._instance.integrator
+
+    @integrator.setter
+    def integrator(self, value):
+        """Set how each step is integrated; DORMAND_PRINCE sizes its steps from the tolerances."""
+        self._instance.integrator = value
+
+    @property
+    def absolute_tolerance(self):
+        """Position error a DORMAND_PRINCE step may make, in grid units."""
+        return self._instance.absolute_tolerance
+
+    @absolute_tolerance.setter
+    def absolute_tolerance(self, value):
+        """Set the position error a DORMAND_PRINCE step may make, in grid units."""
+        self._instance.absolute_tolerance = value
+
+    @property
+    def relative_tolerance(self):
+        """Position error a DORMAND_PRINCE step may make, as a fraction of the step's length."""
+        return self._instance.relative_tolerance
+
+    @relative_tolerance.setter
+    def relative_tolerance(self, value):
+        """Set the position error a DORMAND_PRINCE step may make, as a fraction of its length."""
+        self._instance.relative_tolerance = value
+
+    @property
+    def thread_count(self):
+        """Threads continue_traces spreads a batch across; 0 or less means one per hardware thread."""
+        return self._instance.thread_count
+
+    @thread_count.setter
+    def thread_count(self, value):
+        """Set the threads continue_traces spreads a batch across; results do not depend on it."""
+        self._instance.thread_count = value
+
+    @property
+    def packet_width(self):
+        """Traces continue_traces advances in lockstep on each thread; used clamped to 1..8."""
+        return self._instance.packet_width
+
+    @packet_width.setter
+    def packet_width(self, value):
+        """Set the traces continue_traces advances in lockstep; results do not depend on it."""
+        self._instance.packet_width = value
+
+    @property
+    def spatial_ordering(self):
+        """Whether continue_traces steps traces in Hilbert order of where they are."""
+        return self._instance.spatial_ordering
+
+    @spatial_ordering.setter
+    def spatial_ordering(self, value):
+        """Set whether continue_traces steps traces in Hilbert order; results do not depend on it."""
+        self._instance.spatial_ordering = value
+
+    @property
+    def window_time_steps(self):
+        """How many time steps the window keeps."""
+        return self._instance.window_time_steps
+
+    @window_time_steps.setter
+    def window_time_steps(self, value):
+        """Set how many time steps the window keeps; traces wait only at the newest."""
+        self._instance.window_time_steps = value
+
+    @property
+    def snapshot_time(self):
+        """The time the loaded window's field is frozen at, or None to trace through the window."""
+        return self._instance.snapshot_time
+
+    @snapshot_time.setter
+    def snapshot_time(self, value):
+        """Set the time to freeze the loaded window's field at, or None to trace through the window."""
+        self._instance.snapshot_time = value
+
+    @property
+    def simplification_tolerance(self):
+        """How far a trace's polyline may stray from the path traced; zero keeps every step."""
+        return self._instance.simplification_tolerance
+
+    @simplification_tolerance.setter
+    def simplification_tolerance(self, value):
+        """Set how far a trace's polyline may stray from the path traced, in grid units."""
+        self._instance.simplification_tolerance = value
+
+    @property
+    def time_step_cache_bytes(self):
+        """How much memory, in bytes, the time step cache may hold; zero caches nothing."""
+        return self._instance.time_step_cache_bytes
+
+    @time_step_cache_bytes.setter
+    def time_step_cache_bytes(self, value):
+        """Set how much memory the time step cache may hold; the least recently used steps are dropped."""
+        self._instance.time_step_cache_bytes = value
+
+    @property
+    def time_step_dataset(self):
+        """The name of the dataset the steps added are cached under."""
+        return self._instance.time_step_dataset
+
+    @time_step_dataset.setter
+    def time_step_dataset(self, value):
+        """Set the name of the dataset the steps added from now on are cached under."""
+        self._instance.time_step_dataset = value
+
+    @property
+    def geometry_cache_directory(self):
+        """The directory the grid's triangulations are saved to between runs; empty saves nothing."""
+        return self._instance.geometry_cache_directory
+
+    @geometry_cache_directory.setter
+    def geometry_cache_directory(self, value):
+        """Set a directory to save the grid's triangulations to, so reopening the grid skips triangulating it."""
+        self._instance.geometry_cache_directory = value
+
+    def set_trace_sink(self, on_vertices=None, on_trace_end=None):
+        """Stream the vertices of every batch started from now on to functions instead of keeping them.
+
+        A batch of any length then runs in constant memory; get_trace_results still reports exit reasons,
+        but no positions. The functions are called from the tracing threads, one call at a time, while
+        continue_traces runs, and must not call back into the tracer::
+
+            tracer.set_trace_sink(lambda i, xyt: out.write(i, xyt), lambda i, reason: out.close(i, reason))
+
+        Args:
+            on_vertices (callable): Called with a trace's index and an N x 3 float64 array of x, y and time
+            for each run of its vertices, in order
+            on_trace_end (callable): Called with a trace's index and its exit_reason_enum once it has stopped
+            for good. A trace ending with EXTRACTION_FAILED is discarded; drop what was sent of it
+
+        Passing neither keeps vertices again.
+        """
+        self._instance.set_trace_sink(on_vertices, on_trace_end)
+
     def add_grid_scalars_at_time(self, scalars, scalar_loc, cell_activity, activity_loc, time):
         """Assign velocity vectors to each point or cell for a time step.
 
-        Keeps the previous step and drops the one before that, for a maximum of two time steps.
+        Keeps the previous steps and drops the oldest once the window holds window_time_steps of them; a step at or
+        before the newest starts the window over. An N x 2 or N x 3 float32 or float64 NumPy array of vectors, and a
+        bool array of activity, are read where they lie without converting each element to a Python object.
 
         Args:
             scalars (iterable): The velocity vectors
@@ -139,6 +280,81 @@ class GridTrace(object):
         """
         self._instance.add_grid_scalars_at_time(scalars, scalar_loc, cell_activity, activity_loc, time)
 
+    def add_grid_scalar_components_at_time(self, u, v, scalar_loc, cell_activity, activity_loc, time):
+        """Assign velocity vectors for a time step as add_grid_scalars_at_time does, from separate x and y arrays.
+
+        Float32 or float64 NumPy arrays are read where they lie.
+
+        Args:
+            u (iterable): The x component of each vector
+            v (iterable): The y component of each vector
+            scalar_loc (str): Where the vectors are assigned. One of 'points', 'cells', or 'unknown'
+            cell_activity (iterable): Whether each cell or point is active
+            activity_loc (str): Where the activities are assigned. One of 'points', 'cells', or 'unknown'
+            time (float): The time of the scalars
+        """
+        self._instance.add_grid_scalar_components_at_time(u, v, scalar_loc, cell_activity, activity_loc, time)
+
+    def add_grid_scalars_at_time_async(self, scalars, scalar_loc, cell_activity, activity_loc, time):
+        """Assign velocity vectors for a time step as add_grid_scalars_at_time does, converting them on a
+        background thread while the current window is traced.
+
+        The step joins the window when the next continue_traces returns, so each step loads while the one
+        before it is traced::
+
+            tracer.start_traces(seeds, seed_times)
+            while True:
+                step = series.next()
+                if step is not None:
+                    tracer.add_grid_scalars_at_time_async(*step)
+                if tracer.continue_traces() == 0 or step is None:
+                    break
+
+        Args:
+            scalars (iterable): The velocity vectors
+            scalar_loc (str): Where the vectors are assigned. One of 'points', 'cells', or 'unknown'
+            cell_activity (iterable): Whether each cell or point is active
+            activity_loc (str): Where the activities are assigned. One of 'points', 'cells', or 'unknown'
+            time (float): The time of the scalars
+        """
+        self._instance.add_grid_scalars_at_time_async(scalars, scalar_loc, cell_activity, activity_loc, time)
+
+    def add_grid_scalar_changes_at_time(self, indices, scalars, activity_flips, time):
+        """Add a time step that is the last one added with a few points or cells changed.
+
+        Only the triangles around the changes are refit, so a step that changes a small part of a large
+        grid costs far less than passing the whole arrays to add_grid_scalars_at_time. The data and
+        activity locations are the last step's. Refused, with an error logged, at a time not after the
+        newest step's.
+
+        Args:
+            indices (iterable): The points or cells whose vectors changed
+            scalars (iterable): The new vector of each, parallel to indices
+            activity_flips (iterable): The points or cells whose activity toggled
+            time (float): The time of the scalars
+        """
+        self._instance.add_grid_scalar_changes_at_time(indices, scalars, activity_flips, time)
+
+    def add_cached_grid_scalars_at_time(self, time):
+        """Add the step of time_step_dataset at a time from the time step cache, if it is there.
+
+        Scrubbing back through a series then re-adds each step without converting or fitting it::
+
+            if not tracer.add_cached_grid_scalars_at_time(time):
+                tracer.add_grid_scalars_at_time(series.at(time), 'points', [], 'points', time)
+
+        Args:
+            time (float): The time of the step
+
+        Returns:
+            bool: True if the step was cached and has been added; False, with nothing added, if it was not
+        """
+        return self._instance.add_cached_grid_scalars_at_time(time)
+
+    def clear_time_step_cache(self):
+        """Drop every step in the time step cache, as when a dataset's values have been edited."""
+        self._instance.clear_time_step_cache()
+
     def trace_point(self, pt, pt_time):
         """Run the grid trace for a point.
 
@@ -151,6 +367,27 @@ class GridTrace(object):
         """
         return self._instance.trace_point(pt, pt_time)
 
+    def trace_points(self, pts, pt_times):
+        """Run the grid trace for many points, each exactly as trace_point would.
+
+        The points are stepped together on thread_count threads with the GIL released, and a batch begun
+        with start_traces is left as it was.
+
+        Args:
+            pts (iterable): The starting point of each trace. An N x 2 or N x 3 NumPy array is read without
+                converting each point to a Python object
+            pt_times (iterable): The starting time of each trace, one per point, or one number for them all
+
+        Returns:
+            tuple: The traces in the layout of get_flat_trace_results: the position of each vertex (N x 2),
+            the time of each vertex, where each trace begins (one entry per point plus one), and why each
+            trace stopped (int32 exit_reason_enum values)
+
+        Raises:
+            ValueError: If pt_times does not hold one time per point
+        """
+        return self._instance.trace_points(pts, pt_times)
+
     def get_exit_message(self):
         """Returns a message describing what caused the trace to exit.
 
@@ -164,19 +401,28 @@ class GridTrace(object):
 
         Prefer this over get_exit_message when deciding what to do with a trace; the message is for
         display. WAITING_FOR_TIME_STEP means the path stops early because the field is not known past
-        the second loaded time step, not that the particle came to rest.
+        the newest loaded time step in the window, not that the particle came to rest.
 
         Returns:
             exit_reason_enum: The exit reason of the last trace operation
         """
         return self._instance.get_exit_reason()
 
+    def get_exit_edge(self):
+        """Returns the cell edge the last trace operation left the grid through.
+
+        Returns:
+            tuple: The cell and the edge's index within the cell; both -1 if the trace did not stop
+            with LEFT_GRID
+        """
+        return self._instance.get_exit_edge()
+
     def start_traces(self, pts, pt_times):
         """Begin tracing a batch of seeds against the currently loaded time steps.
 
-        A trace runs only as far as the second loaded time step, because that is as far as the field is
-        known. Supply the next time step with add_grid_scalars_at_time and call continue_traces to carry
-        every unfinished trace onward::
+        A trace runs only as far as the newest loaded time step in the window, because that is as far as
+        the field is known. Supply the next time step with add_grid_scalars_at_time and call
+        continue_traces to carry every unfinished trace onward::
 
             tracer.start_traces(seeds, seed_times)
             while tracer.continue_traces() > 0:
@@ -190,8 +436,9 @@ class GridTrace(object):
         tracer; starting a batch discards any previous one.
 
         Args:
-            pts (iterable): The starting point of each trace
-            pt_times (iterable): The starting time of each trace, one per point
+            pts (iterable): The starting point of each trace. An N x 2 or N x 3 NumPy array is read without
+                converting each point to a Python object
+            pt_times (iterable): The starting time of each trace, one per point, or one number for them all
 
         Raises:
             ValueError: If pt_times does not have one entry per point
@@ -223,3 +470,87 @@ class GridTrace(object):
             entry's times are parallel to its positions
         """
         return self._instance.get_trace_results()
+
+    def get_flat_trace_results(self):
+        """Return the batch traced so far as flat NumPy arrays.
+
+        The same results as get_trace_results without a Python object per trace or per vertex, in the layout a
+        vertex buffer wants. Trace i is rows offsets[i] up to but not including offsets[i + 1]::
+
+            xy, times, offsets, reasons = tracer.get_flat_trace_results()
+            first_trace = xy[offsets[0]:offsets[1]]
+
+        Returns:
+            tuple: The position of each vertex (N x 2 float64), the time of each vertex (N float64), where each
+            trace begins (uint64, one entry per seed plus one past the last vertex), and why each trace stopped
+            (int32 exit_reason_enum values, one per seed)
+        """
+        return self._instance.get_flat_trace_results()
+
+    def take_trace_results(self):
+        """Return the batch's results as get_trace_results does, and free the batch.
+
+        Returns:
+            tuple: The positions of each trace, the times of each trace, and why each trace stopped as an
+            exit_reason_enum, all parallel to the seeds passed to start_traces
+        """
+        return self._instance.take_trace_results()
+
+    def take_trace_result(self, index):
+        """Return one finished trace of the batch and free its vertices.
+
+        A long run can hand each trace on as soon as it stops instead of holding every trace until the last
+        one does::
+
+            while True:
+                waiting = tracer.continue_traces()
+                for i in list(pending):
+                    result = tracer.take_trace_result(i)
+                    if result is not None:
+                        pending.remove(i)
+                        consume(i, *result)
+                if waiting == 0:
+                    break
+                tracer.add_grid_scalars_at_time(*series.next())
+
+        A taken trace keeps its exit reason but has no positions in later results.
+
+        Args:
+            index (int): The trace, by the index of its seed in start_traces
+
+        Returns:
+            tuple: The positions, the times and the exit_reason_enum of the trace, or None if the trace is
+            still running or there is no such trace
+        """
+        return self._instance.take_trace_result(index)
+
+    def get_trace_exit_edges(self):
+        """Return the cell edge each trace of the batch left the grid through.
+
+        For a trace that stopped on entering an inactive cell, this is the edge of the last active cell
+        it was in.
+
+        Returns:
+            tuple: The cell each trace left through and the edge's index within that cell, both parallel
+            to the seeds passed to start_traces; -1 for a trace that did not stop with LEFT_GRID
+        """
+        return self._instance.get_trace_exit_edges()
+
+    def get_statistics(self):
+        """Return what the tracer has done since it was made or its statistics were last reset.
+
+        Returns:
+            dict: accepted_steps, rejected_steps, and the rejections by cause in velocity_splits,
+            direction_splits and error_rejections; evaluations of the field; searches, the whole-grid
+            point locations a walk could not replace; boundary_exits, steps cut back at the edge of the
+            grid or of the active cells; exit_reasons, a dict of traces stopped by exit_reason_enum;
+            time_step_cache_hits and time_step_cache_misses of add_cached_grid_scalars_at_time; and
+            the wall time in seconds of add_scalars_seconds, triangulation_seconds (part of the first),
+            stepping_seconds, time_step_wait_seconds (waiting on add_grid_scalars_at_time_async) and
+            result_copy_seconds
+        """
+        return self._instance.get_statistics()
+
+    def reset_statistics(self):
+        """Zero the statistics get_statistics returns."""
+        self._instance.reset_statistics()
@@ -0,0 +1,790 @@
+//------------------------------------------------------------------------------
+/// \file
+/// \brief Standalone benchmark for XmGridTrace: traces a fixed set of scenarios, writes
+///        the measurements as JSON, and compares them against a stored baseline.
+/// \copyright (C) Copyright Aquaveo 2018. Distributed under FreeBSD License
+/// (See accompanying file LICENSE or https://aqaveo.com/bsd/license.txt)
+//------------------------------------------------------------------------------
+
+//----- Included files ---------------------------------------------------------
+
+// 3. Standard library headers
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// 4. External library headers
+
+// 5. Shared code headers
+#include <xmscore/misc/DynBitset.h>
+#include <xmscore/stl/vector.h>
+#include <xmsgrid/ugrid/XmUGrid.h>
+#include <xmsgridtrace/gridtrace/XmGridTrace.h>
+
+//----- Namespace declaration --------------------------------------------------
+
+using namespace xms;
+
+namespace
+{
+//----- Constants / Enumerations -----------------------------------------------
+
+/// Version of the JSON layout. A baseline written with another version is not compared.
+const int kFormat = 1;
+
+/// Every scenario, in the order they run.
+const char* const kScenarioNames[] = {"vortex_quads", "triangles", "mixed_cells", "cell_data",
+                                      "changing_activity"};
+
+/// Counts compared against the baseline. They are exact for a given build and input, so a
+/// difference either way means tracing changed, and a commit that changes them updates
+/// benchmark/baseline.json with them.
+const char* const kCountMetrics[] = {"searches_per_seed",     "steps_per_seed",
+                                     "rejected_steps_per_seed", "evaluations_per_seed",
+                                     "trace_points_per_seed", "left_grid"};
+/// Costs compared against the baseline, lower being better. They vary from run to run and
+/// machine to machine, so growth past the threshold fails the comparison only with
+/// --check-timings; otherwise they are only reported.
+const char* const kCostMetrics[] = {"seconds_per_seed", "peak_memory_bytes"};
+/// Relative difference within which two counts are the same; the JSON keeps nine digits.
+const double kCountTolerance = 1e-8;
+
+//----- Classes / Structs ------------------------------------------------------
+
+/// Command line settings.
+struct Options
+{
+  int m_seeds = 50000;          ///< seeds per scenario
+  int m_cells = 200;            ///< cells along each side of the square domain
+  int m_threads = 1;            ///< XmGridTrace::SetThreadCount
+  int m_repeat = 5;             ///< runs per scenario; the fastest is kept
+  std::string m_scenario;       ///< run only this scenario; empty for all
+  std::string m_output;         ///< JSON file to write; empty for stdout
+  std::string m_baseline;       ///< JSON file to compare against; empty for none
+  double m_threshold = 0.10;    ///< allowed growth of a compared cost, as a fraction
+  bool m_checkTimings = false;  ///< fail on a cost growing past m_threshold, not just report it
+};
+
+/// A grid and the locations its data can be given at.
+struct Grid
+{
+  std::shared_ptr<XmUGrid> m_ugrid; ///< the grid
+  VecPt3d m_points;                 ///< point locations
+  VecPt3d m_centers;                ///< cell centroids
+};
+
+/// One time step of a scenario.
+struct TimeStep
+{
+  VecPt3d m_vectors;          ///< velocity per point or per cell
+  DataLocationEnum m_location; ///< where m_vectors is
+  DynBitset m_activity;       ///< cell activity; empty when all are active
+  double m_time;              ///< the step's time
+};
+
+/// A tracing problem: a grid, its time steps, and the seeds traced over them.
+struct Scenario
+{
+  std::string m_name;          ///< identifies the scenario in the JSON
+  std::string m_description;   ///< what it exercises
+  Grid m_grid;                 ///< the grid
+  std::vector<TimeStep> m_steps; ///< at least two
+  VecPt3d m_seeds;             ///< released at the first step's time
+  double m_maxTracingTime;     ///< XmGridTrace::SetMaxTracingTime
+  double m_maxTracingDistance; ///< XmGridTrace::SetMaxTracingDistance
+};
+
+/// Named measurements of one scenario, in the order they are written.
+typedef std::vector<std::pair<std::string, double>> Metrics;
+
+/// What is kept of a scenario once it has run.
+struct Result
+{
+  std::string m_name;        ///< Scenario::m_name
+  std::string m_description; ///< Scenario::m_description
+  Metrics m_metrics;         ///< the measurements
+};
+
+/// A parsed JSON value; just enough JSON to read a file this program wrote.
+struct JsonValue
+{
+  enum Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+  Type m_type = NUL;                        ///< which of the members below is set
+  double m_number = 0;                      ///< for NUMBER, and BOOLEAN as 0 or 1
+  std::string m_string;                     ///< for STRING
+  std::vector<JsonValue> m_array;           ///< for ARRAY
+  std::map<std::string, JsonValue> m_object; ///< for OBJECT
+
+  /// \brief Returns a member of an object.
+  /// \param[in] a_key The member's name
+  /// \return the member, or null if this is not an object or has no such member
+  const JsonValue* Find(const std::string& a_key) const
+  {
+    auto it = m_object.find(a_key);
+    return it == m_object.end() ? nullptr : &it->second;
+  }
+};
+
+//----- Internal functions -----------------------------------------------------
+
+//------------------------------------------------------------------------------
+/// \brief Returns the most memory the process has held at once.
+/// \return peak resident memory in bytes, or 0 where it cannot be read
+//------------------------------------------------------------------------------
+double iPeakMemoryBytes()
+{
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    return (double)counters.PeakWorkingSetSize;
+  return 0;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+#ifdef __APPLE__
+  return (double)usage.ru_maxrss; // bytes on macOS
+#else
+  return (double)usage.ru_maxrss * 1024.0; // kilobytes on Linux
+#endif
+#endif
+} // iPeakMemoryBytes
+//------------------------------------------------------------------------------
+/// \brief Builds a square grid of a_cells by a_cells, each cell a quad or a pair of
+///        triangles.
+/// \param[in] a_cells Cells along each side
+/// \param[in] a_length Length of each side
+/// \param[in] a_triangles Which cells to split: 0 none, 1 all, 2 every other one
+/// \return the grid
+//------------------------------------------------------------------------------
+Grid iBuildGrid(int a_cells, double a_length, int a_triangles)
+{
+  const int ptsPerSide = a_cells + 1;
+  const double dx = a_length / a_cells;
+  Grid grid;
+  grid.m_points.reserve((size_t)ptsPerSide * ptsPerSide);
+  for (int j = 0; j < ptsPerSide; ++j)
+  {
+    for (int i = 0; i < ptsPerSide; ++i)
+      grid.m_points.push_back({i * dx, j * dx, 0.0});
+  }
+
+  VecInt cells;
+  cells.reserve((size_t)a_cells * a_cells * 10);
+  for (int j = 0; j < a_cells; ++j)
+  {
+    for (int i = 0; i < a_cells; ++i)
+    {
+      const int p0 = j * ptsPerSide + i;
+      const int p1 = p0 + 1;
+      const int p2 = p0 + ptsPerSide + 1;
+      const int p3 = p0 + ptsPerSide;
+      const bool split = a_triangles == 1 || (a_triangles == 2 && (i + j) % 2 == 1);
+      if (split)
+      {
+        cells.insert(cells.end(), {XMU_TRIANGLE, 3, p0, p1, p2, XMU_TRIANGLE, 3, p2, p3, p0});
+        grid.m_centers.push_back({(i + 2.0 / 3.0) * dx, (j + 1.0 / 3.0) * dx, 0.0});
+        grid.m_centers.push_back({(i + 1.0 / 3.0) * dx, (j + 2.0 / 3.0) * dx, 0.0});
+      }
+      else
+      {
+        cells.insert(cells.end(), {XMU_QUAD, 4, p0, p1, p2, p3});
+        grid.m_centers.push_back({(i + 0.5) * dx, (j + 0.5) * dx, 0.0});
+      }
+    }
+  }
+  grid.m_ugrid = XmUGrid::New(grid.m_points, cells);
+  return grid;
+} // iBuildGrid
+//------------------------------------------------------------------------------
+/// \brief Builds a vortex about the domain's center plus a uniform drift in +x.
+///
+/// The curvature makes the stepping subdivide as it does on real flow, and the drift
+/// carries part of the seeds off the grid so leaving it is measured too.
+/// \param[in] a_locations Where the vectors are
+/// \param[in] a_omega Angular rate of the vortex; negative reverses it
+/// \param[in] a_length Length of the square domain along each axis
+/// \return one vector per location
+//------------------------------------------------------------------------------
+VecPt3d iVortexVectors(const VecPt3d& a_locations, double a_omega, double a_length)
+{
+  const double drift = 1.0;
+  const double c = a_length / 2;
+  VecPt3d vectors;
+  vectors.reserve(a_locations.size());
+  for (const Pt3d& pt : a_locations)
+    vectors.push_back({-a_omega * (pt.y - c) + drift, a_omega * (pt.x - c), 0.0});
+  return vectors;
+} // iVortexVectors
+//------------------------------------------------------------------------------
+/// \brief Scatters seeds over the domain, the same ones on every run and every machine.
+/// \param[in] a_count Number of seeds
+/// \param[in] a_length Length of the square domain along each axis
+/// \return the seeds
+//------------------------------------------------------------------------------
+VecPt3d iSeeds(int a_count, double a_length)
+{
+  unsigned int state = 12345u;
+  auto nextUnit = [&state]() {
+    state = state * 1664525u + 1013904223u;
+    return (state >> 8) / 16777216.0;
+  };
+  VecPt3d seeds;
+  seeds.reserve(a_count);
+  for (int i = 0; i < a_count; ++i)
+  {
+    const double x = 0.5 + nextUnit() * (a_length - 1.0);
+    const double y = 0.5 + nextUnit() * (a_length - 1.0);
+    seeds.push_back({x, y, 0.0});
+  }
+  return seeds;
+} // iSeeds
+//------------------------------------------------------------------------------
+/// \brief Builds a scenario. One is built at a time, just before it runs, so that the
+///        peak memory of each includes only its own grid.
+/// \param[in] a_name The scenario; one of kScenarioNames
+/// \param[in] a_options The command line settings
+/// \return the scenario
+//------------------------------------------------------------------------------
+Scenario iBuildScenario(const std::string& a_name, const Options& a_options)
+{
+  const double length = 200.0;
+  const double omega = 0.05;
+  const double interval = 10.0;
+  auto pointSteps = [&](const Grid& a_grid, int a_count) {
+    std::vector<TimeStep> steps;
+    for (int s = 0; s < a_count; ++s)
+    {
+      const double w = s % 2 ? -omega : omega;
+      steps.push_back({iVortexVectors(a_grid.m_points, w, length), DataLocationEnum::LOC_POINTS,
+                       DynBitset(), s * interval});
+    }
+    return steps;
+  };
+
+  Scenario s;
+  s.m_name = a_name;
+  if (a_name == "vortex_quads")
+  {
+    s.m_description = "quad grid, point data, vortex reversing between two steps";
+    s.m_grid = iBuildGrid(a_options.m_cells, length, 0);
+    s.m_steps = pointSteps(s.m_grid, 2);
+  }
+  else if (a_name == "triangles")
+  {
+    s.m_description = "triangle mesh, point data";
+    s.m_grid = iBuildGrid(a_options.m_cells, length, 1);
+    s.m_steps = pointSteps(s.m_grid, 2);
+  }
+  else if (a_name == "mixed_cells")
+  {
+    s.m_description = "quads and triangles in a checkerboard, point data";
+    s.m_grid = iBuildGrid(a_options.m_cells, length, 2);
+    s.m_steps = pointSteps(s.m_grid, 2);
+  }
+  else if (a_name == "cell_data")
+  {
+    s.m_description = "quad grid, cell-centered data";
+    s.m_grid = iBuildGrid(a_options.m_cells, length, 0);
+    for (int step = 0; step < 2; ++step)
+    {
+      const double w = step % 2 ? -omega : omega;
+      s.m_steps.push_back({iVortexVectors(s.m_grid.m_centers, w, length),
+                           DataLocationEnum::LOC_CELLS, DynBitset(), step * interval});
+    }
+  }
+  else // changing_activity
+  {
+    // A band of dry cells sweeps across the domain, so each window has different activity
+    // and traces are continued across four of them.
+    s.m_description = "quad grid, point data, a band of inactive cells moving each step";
+    s.m_grid = iBuildGrid(a_options.m_cells, length, 0);
+    s.m_steps = pointSteps(s.m_grid, 5);
+    const int cells = a_options.m_cells;
+    for (size_t step = 0; step < s.m_steps.size(); ++step)
+    {
+      DynBitset& activity = s.m_steps[step].m_activity;
+      activity.resize((size_t)cells * cells, true);
+      const int bandLo = (int)(cells * (0.1 + 0.2 * step));
+      const int bandHi = bandLo + std::max(1, cells / 20);
+      for (int j = 0; j < cells; ++j)
+      {
+        for (int i = bandLo; i < std::min(bandHi, cells); ++i)
+          activity[(size_t)j * cells + i] = false;
+      }
+    }
+  }
+  s.m_seeds = iSeeds(a_options.m_seeds, length);
+  s.m_maxTracingTime = interval * (s.m_steps.size() - 1);
+  s.m_maxTracingDistance = 15.0 * (s.m_steps.size() - 1);
+  return s;
+} // iBuildScenario
+//------------------------------------------------------------------------------
+/// \brief Traces a scenario's seeds over all its time steps.
+/// \param[in] a_scenario The scenario
+/// \param[in] a_options The command line settings
+/// \param[out] a_stats What the tracer did
+/// \param[out] a_tracePoints Vertices over all the traces
+/// \return wall time spent in StartTraces and ContinueTraces
+//------------------------------------------------------------------------------
+double iRunScenario(const Scenario& a_scenario,
+                    const Options& a_options,
+                    XmGridTraceStatistics& a_stats,
+                    size_t& a_tracePoints)
+{
+  BSHP<XmGridTrace> tracer = XmGridTrace::New(a_scenario.m_grid.m_ugrid);
+  tracer->SetThreadCount(a_options.m_threads);
+  tracer->SetVectorMultiplier(1);
+  tracer->SetMaxTracingTime(a_scenario.m_maxTracingTime);
+  tracer->SetMaxTracingDistance(a_scenario.m_maxTracingDistance);
+  tracer->SetMinDeltaTime(.01);
+  tracer->SetMaxChangeDistance(2.0);
+  tracer->SetMaxChangeVelocity(-1);
+  tracer->SetMaxChangeDirectionInRadians(0.2);
+
+  double seconds = 0;
+  const VecDbl seedTimes(a_scenario.m_seeds.size(), a_scenario.m_steps[0].m_time);
+  for (size_t s = 0; s < a_scenario.m_steps.size(); ++s)
+  {
+    const TimeStep& step = a_scenario.m_steps[s];
+    tracer->AddGridScalarsAtTime(step.m_vectors, step.m_location, step.m_activity,
+                                 DataLocationEnum::LOC_CELLS, step.m_time);
+    if (s == 0)
+      continue;
+    const auto start = std::chrono::steady_clock::now();
+    if (s == 1)
+      tracer->StartTraces(a_scenario.m_seeds, seedTimes);
+    tracer->ContinueTraces();
+    seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  VecDbl xy, times;
+  std::vector<size_t> offsets;
+  std::vector<XmGridTraceExitEnum> reasons;
+  tracer->GetFlatTraceResults(xy, times, offsets, reasons);
+  a_tracePoints = times.size();
+  a_stats = tracer->GetStatistics();
+  return seconds;
+} // iRunScenario
+//------------------------------------------------------------------------------
+/// \brief Runs a scenario a_options.m_repeat times and measures the fastest run.
+/// \param[in] a_scenario The scenario
+/// \param[in] a_options The command line settings
+/// \return the scenario's measurements
+//------------------------------------------------------------------------------
+Metrics iMeasureScenario(const Scenario& a_scenario, const Options& a_options)
+{
+  double best = -1;
+  XmGridTraceStatistics stats;
+  size_t tracePoints = 0;
+  for (int r = 0; r < std::max(1, a_options.m_repeat); ++r)
+  {
+    const double seconds = iRunScenario(a_scenario, a_options, stats, tracePoints);
+    if (best < 0 || seconds < best)
+      best = seconds;
+  }
+  // Counts are the same on every run, so the last run's stand for all of them.
+  const double seeds = std::max<size_t>(1, a_scenario.m_seeds.size());
+  Metrics metrics;
+  metrics.push_back({"seeds", (double)a_scenario.m_seeds.size()});
+  metrics.push_back({"cells", (double)a_scenario.m_grid.m_ugrid->GetCellCount()});
+  metrics.push_back({"time_steps", (double)a_scenario.m_steps.size()});
+  metrics.push_back({"seconds", best});
+  metrics.push_back({"seconds_per_seed", best / seeds});
+  metrics.push_back({"add_scalars_seconds", stats.m_addScalarsSeconds});
+  metrics.push_back({"searches_per_seed", stats.m_searches / seeds});
+  metrics.push_back({"steps_per_seed", stats.m_acceptedSteps / seeds});
+  metrics.push_back({"rejected_steps_per_seed", stats.m_rejectedSteps / seeds});
+  metrics.push_back({"evaluations_per_seed", stats.m_evaluations / seeds});
+  metrics.push_back({"trace_points_per_seed", tracePoints / seeds});
+  metrics.push_back({"left_grid", (double)stats.m_exitReasons[GTEXIT_LEFT_GRID]});
+  // Process-wide and never falls, so each scenario reports the peak up to and including
+  // itself. Scenarios always run in the same order, which keeps the numbers comparable.
+  metrics.push_back({"peak_memory_bytes", iPeakMemoryBytes()});
+  return metrics;
+} // iMeasureScenario
+//------------------------------------------------------------------------------
+/// \brief Writes a string as a JSON string literal.
+/// \param[in,out] a_os The stream
+/// \param[in] a_string The string
+//------------------------------------------------------------------------------
+void iWriteJsonString(std::ostream& a_os, const std::string& a_string)
+{
+  a_os << '"';
+  for (char c : a_string)
+  {
+    if (c == '"' || c == '\\')
+      a_os << '\\';
+    a_os << c;
+  }
+  a_os << '"';
+} // iWriteJsonString
+//------------------------------------------------------------------------------
+/// \brief Writes the measurements of every scenario as JSON.
+/// \param[in,out] a_os The stream
+/// \param[in] a_options The command line settings
+/// \param[in] a_results The measurements of each scenario
+//------------------------------------------------------------------------------
+void iWriteJson(std::ostream& a_os, const Options& a_options, const std::vector<Result>& a_results)
+{
+  a_os << std::setprecision(9);
+  a_os << "{\n  \"benchmark\": \"xmsgridtrace\",\n  \"format\": " << kFormat << ",\n";
+  a_os << "  \"config\": {\"seeds\": " << a_options.m_seeds << ", \"cells\": " << a_options.m_cells
+       << ", \"threads\": " << a_options.m_threads << ", \"repeat\": " << a_options.m_repeat
+       << "},\n";
+  a_os << "  \"scenarios\": [";
+  for (size_t i = 0; i < a_results.size(); ++i)
+  {
+    a_os << (i ? ",\n" : "\n") << "    {\"name\": ";
+    iWriteJsonString(a_os, a_results[i].m_name);
+    a_os << ", \"description\": ";
+    iWriteJsonString(a_os, a_results[i].m_description);
+    for (const auto& metric : a_results[i].m_metrics)
+      a_os << ",\n     \"" << metric.first << "\": " << metric.second;
+    a_os << "}";
+  }
+  a_os << "\n  ],\n  \"peak_memory_bytes\": " << iPeakMemoryBytes() << "\n}\n";
+} // iWriteJson
+//------------------------------------------------------------------------------
+/// \brief Parses one JSON value.
+/// \param[in] a_text The whole text
+/// \param[in,out] a_pos Where the value begins; left just past it
+/// \param[out] a_value The value
+/// \return false if the text is not valid JSON there
+//------------------------------------------------------------------------------
+bool iParseJson(const std::string& a_text, size_t& a_pos, JsonValue& a_value)
+{
+  auto skipSpace = [&]() {
+    while (a_pos < a_text.size() && std::isspace((unsigned char)a_text[a_pos]))
+      ++a_pos;
+  };
+  auto parseString = [&](std::string& a_out) {
+    if (a_pos >= a_text.size() || a_text[a_pos] != '"')
+      return false;
+    ++a_pos;
+    a_out.clear();
+    while (a_pos < a_text.size() && a_text[a_pos] != '"')
+    {
+      if (a_text[a_pos] == '\\' && a_pos + 1 < a_text.size())
+        ++a_pos;
+      a_out += a_text[a_pos++];
+    }
+    if (a_pos >= a_text.size())
+      return false;
+    ++a_pos;
+    return true;
+  };
+
+  skipSpace();
+  if (a_pos >= a_text.size())
+    return false;
+  const char c = a_text[a_pos];
+  if (c == '{')
+  {
+    a_value.m_type = JsonValue::OBJECT;
+    ++a_pos;
+    skipSpace();
+    if (a_pos < a_text.size() && a_text[a_pos] == '}')
+    {
+      ++a_pos;
+      return true;
+    }
+    for (;;)
+    {
+      std::string key;
+      skipSpace();
+      if (!parseString(key))
+        return false;
+      skipSpace();
+      if (a_pos >= a_text.size() || a_text[a_pos++] != ':')
+        return false;
+      if (!iParseJson(a_text, a_pos, a_value.m_object[key]))
+        return false;
+      skipSpace();
+      if (a_pos < a_text.size() && a_text[a_pos] == ',')
+      {
+        ++a_pos;
+        continue;
+      }
+      return a_pos < a_text.size() && a_text[a_pos++] == '}';
+    }
+  }
+  if (c == '[')
+  {
+    a_value.m_type = JsonValue::ARRAY;
+    ++a_pos;
+    skipSpace();
+    if (a_pos < a_text.size() && a_text[a_pos] == ']')
+    {
+      ++a_pos;
+      return true;
+    }
+    for (;;)
+    {
+      a_value.m_array.emplace_back();
+      if (!iParseJson(a_text, a_pos, a_value.m_array.back()))
+        return false;
+      skipSpace();
+      if (a_pos < a_text.size() && a_text[a_pos] == ',')
+      {
+        ++a_pos;
+        continue;
+      }
+      return a_pos < a_text.size() && a_text[a_pos++] == ']';
+    }
+  }
+  if (c == '"')
+  {
+    a_value.m_type = JsonValue::STRING;
+    return parseString(a_value.m_string);
+  }
+  for (const char* word : {"true", "false", "null"})
+  {
+    if (a_text.compare(a_pos, std::strlen(word), word) == 0)
+    {
+      a_value.m_type = word[0] == 'n' ? JsonValue::NUL : JsonValue::BOOLEAN;
+      a_value.m_number = word[0] == 't' ? 1 : 0;
+      a_pos += std::strlen(word);
+      return true;
+    }
+  }
+  const char* begin = a_text.c_str() + a_pos;
+  char* end = nullptr;
+  a_value.m_type = JsonValue::NUMBER;
+  a_value.m_number = std::strtod(begin, &end);
+  if (end == begin)
+    return false;
+  a_pos += end - begin;
+  return true;
+} // iParseJson
+//------------------------------------------------------------------------------
+/// \brief Compares the measurements against a baseline file and reports each metric.
+///
+/// Fails on any count that differs from the baseline's. Time and memory fail it only with
+/// --check-timings: run to run they vary by more than any threshold that would still catch
+/// a real regression, so by default they are reported for a person to judge.
+/// \param[in] a_options The command line settings
+/// \param[in] a_results The measurements of each scenario run
+/// \return 0 if nothing changed or regressed, 1 if something did, 2 if the baseline is
+///         unusable
+//------------------------------------------------------------------------------
+int iCompareToBaseline(const Options& a_options, const std::vector<Result>& a_results)
+{
+  std::ifstream file(a_options.m_baseline);
+  if (!file)
+  {
+    std::cerr << "Cannot read baseline " << a_options.m_baseline << "\n";
+    return 2;
+  }
+  std::stringstream text;
+  text << file.rdbuf();
+  JsonValue baseline;
+  size_t pos = 0;
+  if (!iParseJson(text.str(), pos, baseline) || baseline.m_type != JsonValue::OBJECT)
+  {
+    std::cerr << "Baseline " << a_options.m_baseline << " is not valid JSON\n";
+    return 2;
+  }
+  const JsonValue* format = baseline.Find("format");
+  if (!format || (int)format->m_number != kFormat)
+  {
+    std::cerr << "Baseline " << a_options.m_baseline << " is from another version of the "
+              << "benchmark; regenerate it\n";
+    return 2;
+  }
+  // Per-seed numbers still depend on how large the grid is and how many seeds share it,
+  // so runs with different settings measure different things.
+  const JsonValue* config = baseline.Find("config");
+  const JsonValue* seeds = config ? config->Find("seeds") : nullptr;
+  const JsonValue* cells = config ? config->Find("cells") : nullptr;
+  const JsonValue* threads = config ? config->Find("threads") : nullptr;
+  if (!seeds || !cells || !threads || (int)seeds->m_number != a_options.m_seeds ||
+      (int)cells->m_number != a_options.m_cells || (int)threads->m_number != a_options.m_threads)
+  {
+    std::cerr << "Baseline " << a_options.m_baseline << " was run with other --seeds, "
+              << "--cells or --threads; run with the same settings to compare\n";
+    return 2;
+  }
+
+  std::map<std::string, const JsonValue*> baselineScenarios;
+  if (const JsonValue* list = baseline.Find("scenarios"))
+  {
+    for (const JsonValue& scenario : list->m_array)
+    {
+      if (const JsonValue* name = scenario.Find("name"))
+        baselineScenarios[name->m_string] = &scenario;
+    }
+  }
+
+  int changedCounts = 0, regressions = 0;
+  std::cerr << "Compared with " << a_options.m_baseline << ": counts must match; costs may "
+            << "grow " << a_options.m_threshold * 100 << "%"
+            << (a_options.m_checkTimings ? "" : ", and are only reported") << "\n";
+  for (size_t i = 0; i < a_results.size(); ++i)
+  {
+    const Metrics& metrics = a_results[i].m_metrics;
+    auto found = baselineScenarios.find(a_results[i].m_name);
+    if (found == baselineScenarios.end())
+    {
+      std::cerr << "  " << a_results[i].m_name << ": not in the baseline\n";
+      continue;
+    }
+    auto compare = [&](const char* a_name, bool a_count) {
+      const JsonValue* before = found->second->Find(a_name);
+      auto after = std::find_if(metrics.begin(), metrics.end(),
+                                [&](const std::pair<std::string, double>& a_metric) {
+                                  return a_metric.first == a_name;
+                                });
+      if (!before || after == metrics.end())
+        return;
+      // A metric that was zero, such as peak memory where it cannot be read, is only
+      // reported.
+      const double ratio = before->m_number > 0 ? after->second / before->m_number : 1.0;
+      const char* verdict = "";
+      if (a_count && fabs(after->second - before->m_number) >
+                       kCountTolerance * std::max(1.0, fabs(before->m_number)))
+      {
+        verdict = "  CHANGED";
+        ++changedCounts;
+      }
+      else if (!a_count && ratio > 1.0 + a_options.m_threshold)
+      {
+        verdict = a_options.m_checkTimings ? "  REGRESSED" : "  slower";
+        regressions += a_options.m_checkTimings ? 1 : 0;
+      }
+      std::cerr << "  " << std::left << std::setw(18) << a_results[i].m_name << std::setw(24)
+                << a_name << std::right << std::setw(14) << std::setprecision(6)
+                << before->m_number << " -> " << std::setw(14) << after->second << "  "
+                << std::fixed << std::setprecision(1) << std::showpos << (ratio - 1) * 100
+                << "%" << std::noshowpos << std::defaultfloat << verdict << "\n";
+    };
+    for (const char* name : kCountMetrics)
+      compare(name, true);
+    for (const char* name : kCostMetrics)
+      compare(name, false);
+  }
+  if (changedCounts)
+  {
+    std::cerr << changedCounts << " count(s) differ from the baseline; if tracing was meant "
+              << "to change, regenerate it with --output " << a_options.m_baseline << "\n";
+  }
+  if (regressions)
+    std::cerr << regressions << " cost(s) regressed past the threshold\n";
+  return changedCounts || regressions ? 1 : 0;
+} // iCompareToBaseline
+//------------------------------------------------------------------------------
+/// \brief Prints how to run the benchmark.
+/// \param[in] a_program The program's name
+//------------------------------------------------------------------------------
+void iUsage(const char* a_program)
+{
+  std::cerr
+    << "Usage: " << a_program << " [options]\n"
+    << "  --seeds N          seeds per scenario (50000)\n"
+    << "  --cells N          cells along each side of the domain (200)\n"
+    << "  --threads N        tracing threads; 0 is one per core (1)\n"
+    << "  --repeat N         runs per scenario, keeping the fastest (5)\n"
+    << "  --scenario NAME    run one of vortex_quads, triangles, mixed_cells, cell_data,\n"
+    << "                     changing_activity (all)\n"
+    << "  --output FILE      write the JSON here instead of to stdout\n"
+    << "  --baseline FILE    compare with an earlier run's JSON; exits 1 if a count\n"
+    << "                     differs from it\n"
+    << "  --check-timings    with --baseline, also exit 1 if time or peak memory grew\n"
+    << "                     past --threshold\n"
+    << "  --threshold F      growth allowed before a cost counts as regressed (0.10)\n";
+} // iUsage
+
+} // namespace
+
+//------------------------------------------------------------------------------
+/// \brief Runs the benchmark.
+/// \param[in] argc Argument count
+/// \param[in] argv Arguments; see iUsage
+/// \return 0 on success, 1 if a count changed or a cost regressed, 2 on bad arguments or
+///         baseline
+//------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  Options options;
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if (arg == "--seeds" && hasValue)
+      options.m_seeds = std::atoi(argv[++i]);
+    else if (arg == "--cells" && hasValue)
+      options.m_cells = std::atoi(argv[++i]);
+    else if (arg == "--threads" && hasValue)
+      options.m_threads = std::atoi(argv[++i]);
+    else if (arg == "--repeat" && hasValue)
+      options.m_repeat = std::atoi(argv[++i]);
+    else if (arg == "--scenario" && hasValue)
+      options.m_scenario = argv[++i];
+    else if (arg == "--output" && hasValue)
+      options.m_output = argv[++i];
+    else if (arg == "--baseline" && hasValue)
+      options.m_baseline = argv[++i];
+    else if (arg == "--threshold" && hasValue)
+      options.m_threshold = std::atof(argv[++i]);
+    else if (arg == "--check-timings")
+      options.m_checkTimings = true;
+    else
+    {
+      iUsage(argv[0]);
+      return 2;
+    }
+  }
+  if (options.m_seeds < 1 || options.m_cells < 1)
+  {
+    iUsage(argv[0]);
+    return 2;
+  }
+
+  std::vector<Result> results;
+  for (const char* name : kScenarioNames)
+  {
+    if (!options.m_scenario.empty() && options.m_scenario != name)
+      continue;
+    std::cerr << "Running " << name << "...\n";
+    const Scenario scenario = iBuildScenario(name, options);
+    results.push_back(
+      {scenario.m_name, scenario.m_description, iMeasureScenario(scenario, options)});
+  }
+  if (results.empty())
+  {
+    std::cerr << "No scenario named " << options.m_scenario << "\n";
+    return 2;
+  }
+
+  if (options.m_output.empty())
+    iWriteJson(std::cout, options, results);
+  else
+  {
+    std::ofstream output(options.m_output);
+    iWriteJson(output, options, results);
+    if (!output)
+    {
+      std::cerr << "Cannot write " << options.m_output << "\n";
+      return 2;
+    }
+  }
+  return options.m_baseline.empty() ? 0 : iCompareToBaseline(options, results);
+} // main
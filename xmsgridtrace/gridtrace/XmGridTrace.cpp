@@ -13,7 +13,20 @@
 #include <xmsgridtrace/gridtrace/XmGridTrace.h>
 
 // 3. Standard library headers
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
 
 // 4. External library headers
 
@@ -23,11 +36,16 @@
 #include <xmscore/misc/XmLog.h>
 #include <xmscore/misc/xmstype.h> // XM_ZERO_TOL
 #include <xmsextractor/extractor/XmUGrid2dDataExtractor.h>
-#include <xmsextractor/extractor/XmUGrid2dPolylineDataExtractor.h>
 #include <xmsextractor/ugrid/XmUGridTriangles2d.h>
 #include <xmsgrid/geometry/geoms.h>
+#include <xmsgrid/ugrid/XmUGrid.h>
 
 // 6. Non-shared code headers
+#include <xmsgridtrace/gridtrace/XmGridTraceArena.h>
+#include <xmsgridtrace/gridtrace/XmGridTraceBoundary.h>
+#include <xmsgridtrace/gridtrace/XmGridTraceGeometry.h>
+#include <xmsgridtrace/gridtrace/XmGridTraceLog.h>
+#include <xmsgridtrace/gridtrace/XmGridTraceSharedGrid.h>
 
 //----- Forward declarations ---------------------------------------------------
 
@@ -42,39 +60,181 @@
 //----- Internal functions -----------------------------------------------------
 namespace xms
 {
-namespace
-{
-/// XMS Namespace
-
 #ifdef CXX_TEST
-/// \brief Count of point-location searches since it was last zeroed.
-/// Test-build-only instrumentation for testTraceBenchmark. A trace's cost is dominated by
-/// these searches, so the benchmark needs the count and not only wall time -- otherwise an
-/// algorithmic win cannot be told apart from a faster machine. Not thread safe; the
-/// benchmark is single threaded.
-size_t g_searchCalls = 0;
-/// \brief Adds a_n to the search count. Compiles away outside test builds.
-#define XMGT_COUNT_SEARCH(a_n) (g_searchCalls += (a_n))
-/// \brief Count of XmUGrid2dPolylineDataExtractor constructions since it was last zeroed.
-/// Test-build-only instrumentation for testBoundaryExtractorIsCached. Caching that extractor
-/// is a pure performance change with no effect on trace output, so a construction count is
-/// the only thing that can tell a cached run from an uncached one.
-size_t g_boundaryExtractorBuilds = 0;
-/// \brief Records one boundary-extractor construction. Compiles away outside test builds.
-#define XMGT_COUNT_BOUNDARY_EXTRACTOR_BUILD() (++g_boundaryExtractorBuilds)
+/// \brief Time steps PrepareTimeStep is still to fail. Test-build-only, for
+/// testFailedTimeStepLeavesTracer: nothing a caller can pass makes preparing a step throw,
+/// so the failure is injected once the step has written all it writes.
+std::atomic<int> g_timeStepFailures(0);
+/// \brief Throws if a time step failure is still to be injected. Compiles away outside test
+/// builds.
+#define XMGT_INJECT_TIME_STEP_FAILURE()                        \
+  do                                                           \
+  {                                                            \
+    if (g_timeStepFailures > 0)                                \
+    {                                                          \
+      --g_timeStepFailures;                                    \
+      throw std::runtime_error("injected time step failure"); \
+    }                                                          \
+  } while (0)
 #else
-/// \brief No-op outside test builds, so production traces pay nothing for instrumentation.
-#define XMGT_COUNT_SEARCH(a_n) ((void)0)
 /// \brief No-op outside test builds.
-#define XMGT_COUNT_BOUNDARY_EXTRACTOR_BUILD() ((void)0)
+#define XMGT_INJECT_TIME_STEP_FAILURE() ((void)0)
 #endif
 
+namespace
+{
+/// XMS Namespace
+
 //----- Class / Function definitions -------------------------------------------
 
 /// Step size a trace begins with, and the value a resumed trace falls back to when the
-/// window it just finished clamped its step to zero. See StepTrace for why zero cannot be
+/// window it just finished clamped its step to zero. See BeginLane for why zero cannot be
 /// carried forward.
 const double kInitialDeltaT = 1.0;
+/// Traces a ContinueTraces worker claims at a time. Trace lengths vary by orders of magnitude
+/// -- a seed in an inactive cell ends at once, one in a slow eddy runs for thousands of steps
+/// -- so a static split leaves threads idle behind the one holding the long traces. Small
+/// enough to balance that, large enough that the shared counter is not contended.
+const size_t kTraceChunk = 16;
+/// Most traces ContinueTraces advances in lockstep; see XmGridTrace::SetPacketWidth. Eight
+/// doubles fill one AVX-512 register, and a wider packet would spend more of each round on
+/// lanes whose traces have already diverged.
+const int kMaxPacketWidth = 8;
+/// Vertices a lane holds for an XmGridTraceSink before handing them over. Enough that the
+/// sink's lock is taken once per few dozen steps rather than per step, few enough that the
+/// lanes of every thread together hold a few kilobytes.
+const int kSinkRun = 32;
+
+/// \name Dormand-Prince 4(5) coefficients
+/// Node c, stage weights a, and the difference e between the 5th- and 4th-order solution
+/// weights, from Dormand & Prince (1980). The 5th-order weights are the last row of a, which
+/// is what makes the seventh stage -- the field at the new point -- the next step's first.
+///@{
+const double kDpC[7] = {0.0, 1.0 / 5, 3.0 / 10, 4.0 / 5, 8.0 / 9, 1.0, 1.0};
+const double kDpA[7][6] = {
+  {0, 0, 0, 0, 0, 0},
+  {1.0 / 5, 0, 0, 0, 0, 0},
+  {3.0 / 40, 9.0 / 40, 0, 0, 0, 0},
+  {44.0 / 45, -56.0 / 15, 32.0 / 9, 0, 0, 0},
+  {19372.0 / 6561, -25360.0 / 2187, 64448.0 / 6561, -212.0 / 729, 0, 0},
+  {9017.0 / 3168, -355.0 / 33, 46732.0 / 5247, 49.0 / 176, -5103.0 / 18656, 0},
+  {35.0 / 384, 0, 500.0 / 1113, 125.0 / 192, -2187.0 / 6784, 11.0 / 84}};
+const double kDpE[7] = {71.0 / 57600,      0, -71.0 / 16695, 71.0 / 1920, -17253.0 / 339200,
+                        22.0 / 525, -1.0 / 40};
+///@}
+/// Largest factor an error-controlled step may shrink or grow by in one go. The usual
+/// Hairer-Norsett-Wanner bounds: larger growth just buys rejections.
+const double kMinStepFactor = 0.2;
+const double kMaxStepFactor = 5.0;
+/// An empty activity mask, which XmGridTraceGeometry reads as every cell active.
+const DynBitset kAllActive;
+/// Rows in one chunk of a SharedChunks, as a power of two: 1024 triangles of coefficients
+/// is 96 kilobytes, few enough that a change reaching a handful of triangles copies little,
+/// and many enough that a grid of millions of triangles is a few thousand chunks.
+const int kSharedChunkShift = 10;
+const size_t kSharedChunkRows = size_t(1) << kSharedChunkShift; ///< see kSharedChunkShift
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Rows of values held in chunks that copies share until one of them writes.
+///
+/// Copying one copies its chunk pointers rather than its values, and writing a row first
+/// copies the row's chunk if anything else holds it. So a time step made from the one before
+/// by a sparse change copies only the chunks the change reaches, and the time step cache
+/// keeps a step without copying it. A row never straddles two chunks.
+///
+/// A chunk is written only by whoever holds it alone, so others may read it from any thread.
+/// Another thread letting go of a chunk can only lower its count of holders, which at worst
+/// has a writer copy a chunk it need not have.
+template <typename T>
+class SharedChunks
+{
+public:
+  /// \brief Constructor.
+  /// \param[in] a_width Values per row
+  explicit SharedChunks(int a_width)
+  : m_width(a_width)
+  {
+  }
+  /// \brief Returns the number of rows.
+  /// \return the number of rows
+  size_t GetSize() const { return m_size; }
+  /// \brief Returns the number of chunks.
+  /// \return the number of chunks
+  size_t GetChunkCount() const { return m_values.size(); }
+  /// \brief Returns a chunk's values, its rows one after another.
+  /// \param[in] a_chunk The chunk
+  /// \return the values
+  const T* GetChunk(size_t a_chunk) const { return m_values[a_chunk]; }
+  /// \brief Returns a row's values for reading.
+  /// \param[in] a_row The row
+  /// \return the row's values
+  const T* GetRow(size_t a_row) const
+  {
+    return m_values[a_row >> kSharedChunkShift] + (a_row & (kSharedChunkRows - 1)) * m_width;
+  }
+  /// \brief Returns a row's values for writing, first copying its chunk if another holds it.
+  /// \param[in] a_row The row
+  /// \return the row's values
+  T* GetMutableRow(size_t a_row)
+  {
+    const size_t chunk = a_row >> kSharedChunkShift;
+    if (m_chunks[chunk].use_count() > 1)
+    {
+      m_chunks[chunk] = std::make_shared<std::vector<T>>(*m_chunks[chunk]);
+      m_values[chunk] = m_chunks[chunk]->data();
+    }
+    return m_values[chunk] + (a_row & (kSharedChunkRows - 1)) * m_width;
+  }
+  /// \brief Sizes for rows that are all about to be written: chunks another holds are let go
+  ///        rather than copied, and the rest are reused as they are.
+  /// \param[in] a_size The number of rows
+  void Reset(size_t a_size)
+  {
+    const size_t chunkCount = (a_size + kSharedChunkRows - 1) >> kSharedChunkShift;
+    m_chunks.resize(chunkCount);
+    m_values.resize(chunkCount);
+    for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+    {
+      if (m_chunks[chunk].use_count() != 1)
+      {
+        m_chunks[chunk] = std::make_shared<std::vector<T>>(kSharedChunkRows * m_width);
+        m_values[chunk] = m_chunks[chunk]->data();
+      }
+    }
+    m_size = a_size;
+  }
+  /// \brief Makes the rows a copy of a_values, a_width values to a row.
+  /// \param[in] a_values The values
+  void Assign(const std::vector<T>& a_values)
+  {
+    Reset(a_values.size() / m_width);
+    const size_t chunkValues = kSharedChunkRows * m_width;
+    for (size_t chunk = 0; chunk < m_values.size(); ++chunk)
+    {
+      const size_t begin = chunk * chunkValues;
+      const size_t end = std::min(a_values.size(), begin + chunkValues);
+      std::copy(a_values.begin() + begin, a_values.begin() + end, m_values[chunk]);
+    }
+  }
+  /// \brief Trades rows with another of the same width.
+  /// \param[in,out] a_other The other
+  void Swap(SharedChunks& a_other)
+  {
+    std::swap(m_size, a_other.m_size);
+    m_chunks.swap(a_other.m_chunks);
+    m_values.swap(a_other.m_values);
+  }
+  /// \brief Returns the memory the rows take, whether or not their chunks are shared.
+  /// \return the size in bytes
+  size_t GetBytes() const { return m_size * m_width * sizeof(T); }
+
+private:
+  int m_width;       ///< values per row
+  size_t m_size = 0; ///< number of rows
+  std::vector<std::shared_ptr<std::vector<T>>> m_chunks; ///< kSharedChunkRows rows each
+  /// Each chunk's values, so that reading a row goes through one pointer rather than two.
+  std::vector<T*> m_values;
+};
 
 //------------------------------------------------------------------------------
 /// \brief Whether a reason means the trace can never advance again.
@@ -85,68 +245,614 @@ bool iIsTerminal(XmGridTraceExitEnum a_reason)
 {
   return a_reason != GTEXIT_NOT_STARTED && a_reason != GTEXIT_WAITING_FOR_TIME_STEP;
 } // iIsTerminal
+//------------------------------------------------------------------------------
+/// \brief Returns the wall time since a_start, for XmGridTraceStatistics.
+/// \param[in] a_start When the timed phase began
+/// \return the seconds elapsed
+//------------------------------------------------------------------------------
+double iSecondsSince(std::chrono::steady_clock::time_point a_start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - a_start).count();
+} // iSecondsSince
+//------------------------------------------------------------------------------
+/// \brief Returns the distance along a Hilbert curve through a square of cells.
+///
+/// Points close on the curve are close in the plane, which a row-major or a Morton order
+/// only mostly is: both jump across the square at every power of two.
+/// \param[in] a_x The cell's column, 0 up to 65535
+/// \param[in] a_y The cell's row, 0 up to 65535
+/// \return the cell's position along the curve through 65536 by 65536 cells
+//------------------------------------------------------------------------------
+uint32_t iHilbertIndex(uint32_t a_x, uint32_t a_y)
+{
+  uint32_t d = 0;
+  for (uint32_t s = 1u << 15; s > 0; s >>= 1)
+  {
+    const uint32_t rx = (a_x & s) ? 1 : 0;
+    const uint32_t ry = (a_y & s) ? 1 : 0;
+    d += s * s * ((3 * rx) ^ ry);
+    // Rotate the quadrant so the curve within it runs the same way as the whole.
+    if (ry == 0)
+    {
+      if (rx == 1)
+      {
+        a_x = s - 1 - (a_x & (s - 1));
+        a_y = s - 1 - (a_y & (s - 1));
+      }
+      std::swap(a_x, a_y);
+    }
+  }
+  return d;
+} // iHilbertIndex
 
 //------------------------------------------------------------------------------
-/// \brief Applies one set of interpolation weights to a time step's x and y scalars.
+/// \brief Fits one triangle's linear interpolant of one time step's x and y scalars.
+///
+/// Interpolating with a triangle's barycentric weights is a linear function of position, so
+/// it can be solved once per triangle when the time step arrives instead of once per query:
+/// u = a + b*x + c*y, and likewise for v. Positions are measured from a_origin so that a grid
+/// in projected coordinates, far from zero, does not lose the field's detail to cancellation
+/// in a.
+/// \param[in] a_geometry The triangulation
+/// \param[in] a_vectors The x and y scalars, a row of two per triangulation point
+/// \param[in] a_origin Where positions are measured from
+/// \param[in] a_triIdx The triangle
+/// \param[out] a_out The triangle's six coefficients: a, b and c for u, then for v
+//------------------------------------------------------------------------------
+void iFitTriangle(const XmGridTraceGeometry& a_geometry,
+                  const SharedChunks<float>& a_vectors,
+                  const Pt3d& a_origin,
+                  int a_triIdx,
+                  double* a_out)
+{
+  const int* tri = a_geometry.GetTrianglePoints(a_triIdx);
+  const double ax = a_geometry.GetPointX(tri[0]) - a_origin.x;
+  const double ay = a_geometry.GetPointY(tri[0]) - a_origin.y;
+  const double bx = a_geometry.GetPointX(tri[1]) - a_origin.x;
+  const double by = a_geometry.GetPointY(tri[1]) - a_origin.y;
+  const double cx = a_geometry.GetPointX(tri[2]) - a_origin.x;
+  const double cy = a_geometry.GetPointY(tri[2]) - a_origin.y;
+  const double det = (by - cy) * (ax - cx) + (cx - bx) * (ay - cy);
+  if (det == 0)
+  {
+    // Never returned by a search, which cannot place a point in a degenerate triangle.
+    std::fill(a_out, a_out + 6, 0.0);
+    return;
+  }
+  // The weights of the first two points as functions of position; the third is the rest.
+  const double b0 = (by - cy) / det, c0 = (cx - bx) / det;
+  const double b1 = (cy - ay) / det, c1 = (ax - cx) / det;
+  // One read of each point's pair serves both components.
+  const float* p0 = a_vectors.GetRow(tri[0]);
+  const float* p1 = a_vectors.GetRow(tri[1]);
+  const float* p2 = a_vectors.GetRow(tri[2]);
+  for (int component = 0; component < 2; ++component)
+  {
+    const double f2 = p2[component];
+    const double d0 = p0[component] - f2, d1 = p1[component] - f2;
+    const double b = d0 * b0 + d1 * b1;
+    const double c = d0 * c0 + d1 * c1;
+    a_out[3 * component] = f2 - b * cx - c * cy;
+    a_out[3 * component + 1] = b;
+    a_out[3 * component + 2] = c;
+  }
+} // iFitTriangle
+//------------------------------------------------------------------------------
+/// \brief Fits every triangle's linear interpolant of one time step; see iFitTriangle.
 ///
-/// Reproduces XmUGrid2dDataExtractor::ExtractData exactly -- accumulating in double, then
-/// narrowing to float -- so that replacing four ExtractData calls with one search plus this
-/// gives bit-identical answers rather than merely close ones.
-/// \param[in] a_x The extractor holding the x component
-/// \param[in] a_y The extractor holding the y component, sharing a_x's triangulation
-/// \param[in] a_idxs Triangulation point indices from the search
-/// \param[in] a_weights Interpolation weights parallel to a_idxs
-/// \param[out] a_outX The interpolated x component
-/// \param[out] a_outY The interpolated y component
+/// Each triangle has a row of 12 coefficients, a, b and c for u and then for v, for the
+/// step before and then the step fitted. Only the second half is filled.
+/// \param[in] a_geometry The triangulation
+/// \param[in] a_vectors The x and y scalars, a row of two per triangulation point
+/// \param[in] a_origin Where positions are measured from
+/// \param[out] a_coefficients A row of 12 per triangle
+//------------------------------------------------------------------------------
+void iFitTriangles(const XmGridTraceGeometry& a_geometry,
+                   const SharedChunks<float>& a_vectors,
+                   const Pt3d& a_origin,
+                   SharedChunks<double>& a_coefficients)
+{
+  const int triCount = a_geometry.GetTriangleCount();
+  a_coefficients.Reset((size_t)triCount);
+  for (int triIdx = 0; triIdx < triCount; ++triIdx)
+    iFitTriangle(a_geometry, a_vectors, a_origin, triIdx, a_coefficients.GetMutableRow(triIdx) + 6);
+} // iFitTriangles
 //------------------------------------------------------------------------------
-void iApplyWeights(const XmUGrid2dDataExtractor& a_x,
-                   const XmUGrid2dDataExtractor& a_y,
-                   const VecInt& a_idxs,
-                   const VecDbl& a_weights,
-                   float& a_outX,
-                   float& a_outY)
+/// \brief Evaluates two time steps' fitted fields at a point and blends them in time.
+///
+/// Each time step is weighted by its *closeness* to the current time, so the distance from
+/// one time step is the weight of the other: at a_time == a_time1 the field is entirely the
+/// first step's. Weighting each step by its own distance instead -- which is what this did
+/// until the weights were swapped -- inverts the interpolation, advecting a particle released
+/// at the first step entirely by the field at the second.
+///
+/// Each step's value is narrowed to float, as XmUGrid2dDataExtractor::ExtractData narrows
+/// it. The scalars are floats, so this loses nothing real, and it keeps a change in velocity
+/// that sits exactly on a subdivision threshold on the side it always fell.
+///
+/// Inline, and shared by GetVectorAtLocationAndTime and EvaluatePacket, so a lane of a
+/// packet is evaluated with the very same arithmetic as a lone trace.
+/// \param[in] a_c1 The first step's six coefficients for the point's triangle
+/// \param[in] a_c2 The second step's six coefficients for the point's triangle
+/// \param[in] a_dx The point's x, measured from the fit's origin
+/// \param[in] a_dy The point's y, measured from the fit's origin
+/// \param[in] a_time The time at the point
+/// \param[in] a_time1 The time of the first step
+/// \param[in] a_time2 The time of the second step
+/// \param[out] a_x The blended x component
+/// \param[out] a_y The blended y component
+//------------------------------------------------------------------------------
+inline void iBlendSteps(const double* a_c1,
+                        const double* a_c2,
+                        double a_dx,
+                        double a_dy,
+                        double a_time,
+                        double a_time1,
+                        double a_time2,
+                        double& a_x,
+                        double& a_y)
+{
+  const double totalTime = fabs(a_time1 - a_time2);
+  const double weight1 = fabs(a_time - a_time2) / totalTime;
+  const double weight2 = fabs(a_time - a_time1) / totalTime;
+  const float x1 = static_cast<float>(a_c1[0] + a_c1[1] * a_dx + a_c1[2] * a_dy);
+  const float y1 = static_cast<float>(a_c1[3] + a_c1[4] * a_dx + a_c1[5] * a_dy);
+  const float x2 = static_cast<float>(a_c2[0] + a_c2[1] * a_dx + a_c2[2] * a_dy);
+  const float y2 = static_cast<float>(a_c2[3] + a_c2[4] * a_dx + a_c2[5] * a_dy);
+  a_x = x1 * weight1 + x2 * weight2;
+  a_y = y1 * weight1 + y2 * weight2;
+} // iBlendSteps
+//------------------------------------------------------------------------------
+/// \brief Converts an activity bitset to the cell activity the extractor applies.
+///
+/// Point activity makes a cell inactive when any of its points is; this is the rule
+/// XmUGrid2dDataExtractor applies to its own triangulation, and the tracer's searches have to
+/// agree with it or they would weight no-data values.
+/// \param[in] a_ugrid The grid
+/// \param[in] a_activity Activity per point or per cell; empty means all active
+/// \param[in] a_activityLoc Whether a_activity is per point or per cell
+/// \return activity per cell; empty when every cell is active
+//------------------------------------------------------------------------------
+DynBitset iCellActivity(const XmUGrid& a_ugrid,
+                        const DynBitset& a_activity,
+                        DataLocationEnum a_activityLoc)
+{
+  DynBitset cellActivity;
+  if (a_activity.empty())
+    return cellActivity;
+  const int cellCount = a_ugrid.GetCellCount();
+  if (a_activityLoc == DataLocationEnum::LOC_CELLS)
+  {
+    cellActivity = a_activity;
+    cellActivity.resize(cellCount, true);
+  }
+  else
+  {
+    cellActivity.resize(cellCount, true);
+    VecInt cellPoints;
+    for (int cellIdx = 0; cellIdx < cellCount; ++cellIdx)
+    {
+      a_ugrid.GetCellPoints(cellIdx, cellPoints);
+      for (int ptIdx : cellPoints)
+      {
+        if ((size_t)ptIdx < a_activity.size() && !a_activity[ptIdx])
+        {
+          cellActivity[cellIdx] = false;
+          break;
+        }
+      }
+    }
+  }
+  // An all-active mask is reported as empty, so callers can tell "nothing is inactive"
+  // without a scan.
+  if (cellActivity.count() == cellActivity.size())
+    cellActivity.clear();
+  return cellActivity;
+} // iCellActivity
+//------------------------------------------------------------------------------
+/// \brief Finds the triangle containing a point, walking from a trace's last triangle.
+///
+/// Consecutive steps of a trace land in the same triangle or one next to it, so the walk
+/// almost always succeeds after a triangle or two; only the first query of a trace, and
+/// those the walk cannot finish, pay for the binned search.
+///
+/// The walk ignores activity, which is then a lookup on the found triangle's cell. A point
+/// well inside an inactive cell is answered there, without a search: in a wet/dry series,
+/// a trace reaching a cell that has just dried would otherwise search the whole grid for
+/// an active triangle that cannot exist.
+/// \param[in] a_geometry The triangulation to search
+/// \param[in] a_cellActivity Which cells may be returned; empty means all
+/// \param[in] a_pt The point
+/// \param[in,out] a_hint The triangle to start from, -1 if none; updated when one is found
+/// \param[out] a_weights Barycentric weights of the found triangle's three points
+/// \param[in,out] a_stats Statistics of the calling thread; counts the search if there is one
+/// \return the triangle, or -1 if the point is not in an active triangle
+//------------------------------------------------------------------------------
+int iLocate(const XmGridTraceGeometry& a_geometry,
+            const DynBitset& a_cellActivity,
+            const Pt3d& a_pt,
+            int& a_hint,
+            double a_weights[3],
+            XmGridTraceStatistics& a_stats)
+{
+  int triIdx = a_geometry.WalkToTriangle(a_hint, a_pt, kAllActive, a_weights);
+  if (triIdx >= 0)
+  {
+    const size_t cellIdx = (size_t)a_geometry.GetTriangleCell(triIdx);
+    if (cellIdx < a_cellActivity.size() && !a_cellActivity[cellIdx])
+    {
+      if (a_geometry.IsInterior(triIdx, a_pt))
+        return -1;
+      triIdx = -1; // on the edge, where an active neighbor may hold it
+    }
+  }
+  if (triIdx < 0)
+  {
+    triIdx = a_geometry.LocateTriangle(a_pt, a_cellActivity, a_weights);
+    ++a_stats.m_searches;
+  }
+  if (triIdx >= 0)
+    a_hint = triIdx;
+  return triIdx;
+} // iLocate
+//------------------------------------------------------------------------------
+/// \brief Finds which of a cell's edges joins two grid points.
+/// \param[in] a_ugrid The grid
+/// \param[in] a_cellIdx The cell
+/// \param[in] a_pt1 One end of the edge
+/// \param[in] a_pt2 The other end, in either order
+/// \return the edge index within the cell, as XmUGrid::GetCellEdge numbers them, or -1
+//------------------------------------------------------------------------------
+int iCellEdgeBetween(const XmUGrid& a_ugrid, int a_cellIdx, int a_pt1, int a_pt2)
 {
-  const VecFlt& xScalars = a_x.GetScalars();
-  const VecFlt& yScalars = a_y.GetScalars();
-  double interpX = 0.0, interpY = 0.0;
-  for (size_t i = 0; i < a_idxs.size(); ++i)
+  const int edgeCount = a_ugrid.GetCellEdgeCount(a_cellIdx);
+  for (int edgeIdx = 0; edgeIdx < edgeCount; ++edgeIdx)
   {
-    const int ptIdx = a_idxs[i];
-    const double weight = a_weights[i];
-    interpX += xScalars[ptIdx] * weight;
-    interpY += yScalars[ptIdx] * weight;
+    XmEdge edge = a_ugrid.GetCellEdge(a_cellIdx, edgeIdx);
+    if ((edge.GetFirst() == a_pt1 && edge.GetSecond() == a_pt2) ||
+        (edge.GetFirst() == a_pt2 && edge.GetSecond() == a_pt1))
+      return edgeIdx;
   }
-  a_outX = static_cast<float>(interpX);
-  a_outY = static_cast<float>(interpY);
-} // iApplyWeights
+  return -1;
+} // iCellEdgeBetween
 
 ////////////////////////////////////////////////////////////////////////////////
-/// One trace in progress, and everything about it that has to survive a time step change.
+/// The traces of a batch, and everything about each that has to survive a time step change.
 ///
-/// A trace stops when it reaches the second of the two loaded time steps and continues once
-/// a later one is supplied. Position and time are the obvious carry-overs; the rest are the
+/// A trace stops when it reaches the newest loaded time step in the window and continues
+/// once a later one is supplied. Position and time are the obvious carry-overs; the rest are the
 /// ones whose absence would be a silent defect. The distance and elapsed-time budgets are
 /// whole-trace, not per-window. The step size and previous velocity feed the subdivision
 /// tests, which compare each step against the one before it -- restarting those at a window
 /// boundary would kink the path exactly where the time step changes, which is the one place
 /// this has to be smooth.
-struct TraceState
-{
-  Pt3d m_pt;                 ///< current position
-  double m_ptTime = 0;       ///< time the trace was released; never advanced
-  double m_elapsedTime = 0;  ///< time advanced since release, against m_maxTracingTime
-  double m_distTraveled = 0; ///< distance covered, against m_maxTracingDistance
-  double m_deltaT = kInitialDeltaT; ///< adaptive step size carried into the next step
-  double m_vx = 0;           ///< velocity x at m_pt, for the subdivision tests
-  double m_vy = 0;           ///< velocity y at m_pt, for the subdivision tests
-  double m_mag = 0;          ///< speed at m_pt, for the change-in-velocity test
-  bool m_started = false;    ///< the seed has been evaluated and recorded
-  /// Why it stopped, or that it is waiting. Doubles as the resume flag -- see iIsTerminal --
-  /// so there is one source of truth rather than a reason and a separate finished bool that
-  /// could disagree.
-  XmGridTraceExitEnum m_exitReason = GTEXIT_NOT_STARTED;
-  VecPt3d m_trace; ///< positions so far
-  VecDbl m_times;  ///< times so far, parallel to m_trace
+///
+/// One array per field rather than one struct per trace, and the vertices in an arena
+/// rather than in two vectors per trace: a million-seed batch is then a few dozen
+/// allocations, not two million. Traces are independent, so different threads may step
+/// different traces at once; m_started is chars rather than a std::vector<bool> so that
+/// neighbouring traces do not share a word.
+struct TraceBatch
+{
+  /// \brief Makes the batch a_count fresh traces, none started.
+  /// \param[in] a_count How many traces
+  void Assign(size_t a_count)
+  {
+    m_x.assign(a_count, 0.0);
+    m_y.assign(a_count, 0.0);
+    m_ptTime.assign(a_count, 0.0);
+    m_elapsedTime.assign(a_count, 0.0);
+    m_distTraveled.assign(a_count, 0.0);
+    m_deltaT.assign(a_count, kInitialDeltaT);
+    m_vx.assign(a_count, 0.0);
+    m_vy.assign(a_count, 0.0);
+    m_mag.assign(a_count, 0.0);
+    m_started.assign(a_count, 0);
+    m_exitReasons.assign(a_count, GTEXIT_NOT_STARTED);
+    m_triangles.assign(2 * a_count, -1);
+    m_exitCells.assign(a_count, -1);
+    m_exitCellEdges.assign(a_count, -1);
+    m_lastX.assign(a_count, 0.0);
+    m_lastY.assign(a_count, 0.0);
+    m_vertices.Reset(a_count);
+  }
+  /// \brief Empties the batch and frees all its memory.
+  void Release()
+  {
+    Assign(0);
+    for (VecDbl* values : {&m_x, &m_y, &m_ptTime, &m_elapsedTime, &m_distTraveled, &m_deltaT,
+                           &m_vx, &m_vy, &m_mag, &m_lastX, &m_lastY})
+      VecDbl().swap(*values);
+    std::vector<char>().swap(m_started);
+    std::vector<XmGridTraceExitEnum>().swap(m_exitReasons);
+    VecInt().swap(m_triangles);
+    VecInt().swap(m_exitCells);
+    VecInt().swap(m_exitCellEdges);
+    m_vertices.Release();
+    m_sink.reset();
+  }
+  /// \brief Returns the number of traces.
+  /// \return the number of traces
+  size_t GetSize() const { return m_ptTime.size(); }
+
+  VecDbl m_x;            ///< current position x
+  VecDbl m_y;            ///< current position y
+  VecDbl m_ptTime;       ///< time each trace was released; never advanced
+  VecDbl m_elapsedTime;  ///< time advanced since release, against m_maxTracingTime
+  VecDbl m_distTraveled; ///< distance covered, against m_maxTracingDistance
+  VecDbl m_deltaT;       ///< adaptive step size carried into the next step
+  VecDbl m_vx;           ///< velocity x at the current position, for the subdivision tests
+  VecDbl m_vy;           ///< velocity y at the current position, for the subdivision tests
+  VecDbl m_mag;          ///< speed at the current position, for the change-in-velocity test
+  std::vector<char> m_started; ///< the seed has been evaluated and recorded
+  /// Why each stopped, or that it is waiting. Doubles as the resume flag -- see iIsTerminal
+  /// -- so there is one source of truth rather than a reason and a separate finished flag
+  /// that could disagree.
+  std::vector<XmGridTraceExitEnum> m_exitReasons;
+  /// Two per trace: the triangle it was last found in, per triangulation -- the first for
+  /// point-located data and the second for cell-located. Each step's search walks from here
+  /// instead of searching the whole grid. Kept per triangulation rather than per time step
+  /// because a triangulation outlives the time steps using it, so the hint stays valid
+  /// across windows without being shifted.
+  VecInt m_triangles;
+  /// Cell and cell edge each trace left through, when it stopped with GTEXIT_LEFT_GRID;
+  /// otherwise -1. See XmGridTrace::GetTraceExitEdges.
+  VecInt m_exitCells;
+  VecInt m_exitCellEdges;      ///< see m_exitCells
+  /// Position of the last vertex recorded, which a step has to move away from to record
+  /// another. Kept apart from the vertices so that it survives a window change when they
+  /// have gone to m_sink.
+  VecDbl m_lastX;
+  VecDbl m_lastY;              ///< see m_lastX
+  XmGridTraceArena m_vertices; ///< positions and times so far, unless m_sink takes them
+  /// Where the vertices go as they are traced, instead of m_vertices; see
+  /// XmGridTrace::SetTraceSink. Null to keep them.
+  BSHP<XmGridTraceSink> m_sink;
+  std::mutex m_sinkMutex; ///< keeps the threads stepping the batch from calling m_sink at once
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// Scratch for one thread stepping traces. Everything a search writes goes here rather than
+/// onto the tracer, so that ContinueTraces can give each worker its own and share the tracer
+/// itself read-only.
+struct TraceContext
+{
+  double m_weights1[3]; ///< barycentric weights found in the first time step's triangulation
+  double m_weights2[3]; ///< barycentric weights found in the second time step's triangulation
+  /// What this thread has done, added to the tracer's statistics once stepping is over.
+  XmGridTraceStatistics m_statistics;
+};
+
+/// What a lane needs next, once its step has been proposed.
+enum TraceLanePhase {
+  LANE_STOPPED,   ///< its trace stopped and was written back
+  LANE_EVALUATE,  ///< the field at its candidate point
+  LANE_EVALUATED, ///< nothing: a Runge-Kutta step found the field itself
+  LANE_RETRY      ///< nothing: the step was rejected and is proposed again, smaller
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// One trace being stepped: the batch entry it came from and is written back to when it
+/// stops, and the working values one step hands the next. StepTraces keeps several of these
+/// live at once and runs every phase of a step on each of them before the next phase, which
+/// is what lets one EvaluatePacket call serve them all.
+struct TraceLane
+{
+  TraceBatch* m_batch = nullptr; ///< the batch the trace is in
+  size_t m_trace = 0;            ///< which trace of m_batch
+  Pt3d m_pt0;                    ///< current position
+  Pt3d m_pt1;                    ///< candidate position of the step being taken
+  Pt3d m_vector;                 ///< field at m_pt1, as extracted
+  double m_evalTime = 0;         ///< time m_vector is wanted at
+  double m_deltaT = 0;           ///< size of the step being taken
+  double m_elapsedTime = 0;      ///< see TraceBatch
+  double m_distTraveled = 0;     ///< see TraceBatch
+  double m_vx0 = 0;              ///< velocity x at m_pt0, vector multiplier applied
+  double m_vy0 = 0;              ///< velocity y at m_pt0, vector multiplier applied
+  double m_mag0 = 0;             ///< speed at m_pt0, as extracted
+  double m_maxAngleChange = 1;   ///< cosine of the largest change in direction not split
+  double m_error = 0;            ///< Dormand-Prince's error estimate for the step
+  bool m_integrated = false;     ///< the step was taken by IntegrateStep
+  /// Whether another step follows this one. Tracked with m_stopReason explicitly rather
+  /// than inferred afterwards: several conditions in one step overwrite each other, and a
+  /// later split can put the trace back into motion after the time step clamp has fired.
+  bool m_continue = true;
+  XmGridTraceExitEnum m_stopReason = GTEXIT_WAITING_FOR_TIME_STEP; ///< see m_continue
+  /// Cell and cell edge the last candidate point left the grid through.
+  int m_exitCell = -1;
+  int m_exitCellEdge = -1; ///< see m_exitCell
+  TraceLanePhase m_phase = LANE_EVALUATE; ///< what the lane needs this round
+  double m_lastX = 0;      ///< see TraceBatch
+  double m_lastY = 0;      ///< see TraceBatch
+  /// \name Simplification
+  /// The state of the simplification iRecordVertex runs when m_tolerance is positive. The
+  /// anchor is the last vertex kept. The pending vertex is the last one accepted, held back
+  /// until a later one shows whether it is needed. The cone is the directions from the
+  /// anchor along which a line passes within m_tolerance of every vertex since it, as
+  /// offsets from m_coneDirection.
+  ///@{
+  double m_tolerance = 0;
+  bool m_hasAnchor = false;
+  double m_anchorX = 0;
+  double m_anchorY = 0;
+  bool m_hasPending = false;
+  double m_pending[3] = {0, 0, 0};
+  bool m_hasCone = false;
+  double m_coneDirection = 0;
+  double m_coneLow = 0;
+  double m_coneHigh = 0;
+  double m_maxAnchorDistance = 0; ///< farthest any vertex since the anchor has been from it
+  ///@}
+  /// Vertices recorded and not yet handed to the batch's sink, x, y and time each. Unused
+  /// without a sink.
+  double m_run[3 * kSinkRun];
+  int m_runCount = 0; ///< vertices in m_run
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// Where a time step's vectors are read from: x and y components, each m_stride values
+/// after the last, in the caller's doubles or floats. Lets arrays laid out as rows of
+/// (x, y[, z]) or as separate x and y columns be read where they are.
+struct VectorSource
+{
+  const double* m_x = nullptr; ///< first x, if the components are doubles
+  const double* m_y = nullptr; ///< first y, if the components are doubles
+  const float* m_xf = nullptr; ///< first x, if the components are floats
+  const float* m_yf = nullptr; ///< first y, if the components are floats
+  int m_count = 0;             ///< number of vectors
+  int m_stride = 1;            ///< values from one vector's component to the next's
+};
+
+
+//------------------------------------------------------------------------------
+/// \brief Describes the x and y of a vector of points where they lie.
+/// \param[in] a_vectors The vectors; z is skipped over
+/// \return the source, valid while a_vectors is
+//------------------------------------------------------------------------------
+VectorSource iVectorSource(const VecPt3d& a_vectors)
+{
+  static_assert(sizeof(Pt3d) == 3 * sizeof(double), "Pt3d must be three packed doubles");
+  VectorSource source;
+  source.m_count = (int)a_vectors.size();
+  source.m_stride = 3;
+  if (!a_vectors.empty())
+  {
+    source.m_x = &a_vectors[0].x;
+    source.m_y = &a_vectors[0].y;
+  }
+  return source;
+} // iVectorSource
+//------------------------------------------------------------------------------
+/// \brief Reads one component of a time step's vectors as the floats the extractor takes.
+/// \param[in] a_values The first value of the component
+/// \param[in] a_count Number of values
+/// \param[in] a_stride Values from one to the next
+/// \param[out] a_out The component
+//------------------------------------------------------------------------------
+template <typename T>
+void iReadComponent(const T* a_values, int a_count, int a_stride, VecFlt& a_out)
+{
+  a_out.resize(a_count);
+  if (a_stride == 1)
+  {
+    std::copy(a_values, a_values + a_count, a_out.begin());
+    return;
+  }
+  for (int i = 0; i < a_count; ++i)
+    a_out[i] = (float)a_values[(size_t)i * a_stride];
+} // iReadComponent
+
+////////////////////////////////////////////////////////////////////////////////
+/// A time step converted and fitted, ready to become the newest step of the window.
+///
+/// Kept apart from the window so AddGridScalarsAtTimeAsync can fill one on a background
+/// thread while ContinueTraces reads the window; CommitTimeStep moves it in. A whole step
+/// carries its own inputs and converted values too, so one that fails to prepare leaves
+/// the tracer's as they were.
+struct PreparedTimeStep
+{
+  double m_time = 0; ///< time of the scalars
+  DataLocationEnum m_scalarLoc = DataLocationEnum::LOC_UNKNOWN; ///< where the scalars are
+  std::shared_ptr<const XmGridTraceGeometry> m_geometry; ///< triangulation at m_scalarLoc
+  /// A row of 12 per triangle of m_geometry, the step's own in the second half; see
+  /// iFitTriangles.
+  SharedChunks<double> m_coefficients{12};
+  DynBitset m_cellActivity; ///< cell activity, empty when all active; see iCellActivity
+  /// The step is the window's newest step with m_changedTriangles refitted from m_vectors,
+  /// and m_coefficients is unused.
+  bool m_isChange = false;
+  VecInt m_changedTriangles; ///< triangles whose values a change reached; see m_isChange
+  /// The step was taken from the time step cache, so committing it does not cache it again.
+  bool m_fromCache = false;
+  std::string m_dataset; ///< time step dataset the step is cached under when committed
+  XmGridTraceStatistics m_statistics; ///< time spent preparing it
+  /// The step's XmGridTraceImpl::m_vectors, traded in when it is committed. Unused for a
+  /// change, which updates the tracer's in place.
+  SharedChunks<float> m_vectors{2};
+  SharedChunks<float> m_inputX{1}; ///< the step's XmGridTraceImpl::m_inputX; see m_vectors
+  SharedChunks<float> m_inputY{1}; ///< the step's XmGridTraceImpl::m_inputY; see m_vectors
+  DynBitset m_inputActivity; ///< the step's XmGridTraceImpl::m_inputActivity; see m_vectors
+  /// The step's XmGridTraceImpl::m_inputActivityLoc.
+  DataLocationEnum m_inputActivityLoc = DataLocationEnum::LOC_UNKNOWN;
+  /// \name Conversion scratch
+  /// The vectors as read and as converted, in the arrays XmGridTraceSharedGrid::Convert
+  /// takes, before PrepareTimeStep copies them into m_inputX, m_inputY and m_vectors.
+  ///@{
+  VecFlt m_readX;
+  VecFlt m_readY;
+  VecFlt m_converted;
+  ///@}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief A time step of the window, with what tracing between it and the step before it
+///        reads. The window keeps them oldest first; see XmGridTraceImpl::m_window.
+struct WindowStep
+{
+  /// \brief Returns the step before's coefficients for a triangle of its geometry.
+  /// \param[in] a_triIdx The triangle, of the step before's geometry
+  /// \return the triangle's six coefficients
+  const double* GetCoefficients1(size_t a_triIdx) const
+  {
+    return m_coefficients1[a_triIdx >> kSharedChunkShift] +
+           (a_triIdx & (kSharedChunkRows - 1)) * 12;
+  }
+  /// \brief Returns this step's coefficients for a triangle of m_geometry.
+  /// \param[in] a_triIdx The triangle
+  /// \return the triangle's six coefficients
+  const double* GetCoefficients2(size_t a_triIdx) const
+  {
+    return m_coefficients.GetRow(a_triIdx) + 6;
+  }
+
+  double m_time = 0; ///< time of the scalars
+  DataLocationEnum m_scalarLoc = DataLocationEnum::LOC_UNKNOWN; ///< where the scalars are
+  /// Searchable triangulation of the step. Searched here rather than through
+  /// XmUGridTriangles2d::GetIntersectedCell, whose GmTriSearch keeps per-query state on the
+  /// search object and so cannot be shared by the threads of ContinueTraces.
+  std::shared_ptr<const XmGridTraceGeometry> m_geometry;
+  DynBitset m_cellActivity; ///< cell activity, empty when all active; see iCellActivity
+  /// Cells active in this step and the one before, empty when all are. A trace stops on
+  /// entering any other cell, so this is what an exit into an inactive cell is found
+  /// against.
+  DynBitset m_exitActivity;
+  /// Fitted velocity of every triangle of m_geometry, a row of 12 doubles each: u and v for
+  /// the step before, then for this step. See iFitTriangles. Both steps sit side by side, so
+  /// when a whole step shares a triangulation with the one before -- the usual case -- a
+  /// lookup reads one contiguous run instead of three point pairs per step. The first half
+  /// is stale when the step before is at the other data location, or when this step is a
+  /// change, whose table shares every chunk the change did not reach with the step before's;
+  /// m_coefficients1 says where the step before's coefficients are then.
+  SharedChunks<double> m_coefficients{12};
+  /// Where the step before's coefficients are, one pointer per chunk of its table, offset so
+  /// that its rows read alike: into this step's own table, or into the step before's own
+  /// half when the two are at different locations or this step is a change. Empty for the
+  /// window's first step, which has no step before it in the window.
+  std::vector<const double*> m_coefficients1;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief A time step kept in the time step cache: what CommitTimeStep made of it, and the
+///        inputs AddGridScalarChangesAtTime builds on, as they were once it was committed.
+///
+/// Shares its tables' chunks with the window step it was kept from, and a change step with
+/// the step it was made from, so keeping a step copies nothing.
+struct CachedTimeStep
+{
+  std::string m_dataset; ///< time step dataset it was added under
+  double m_time = 0;     ///< time of the scalars
+  DataLocationEnum m_scalarLoc = DataLocationEnum::LOC_UNKNOWN; ///< where the scalars are
+  std::shared_ptr<const XmGridTraceGeometry> m_geometry; ///< triangulation at m_scalarLoc
+  /// The step's window table; only the second half of each row, its own, is read.
+  SharedChunks<double> m_coefficients{12};
+  DynBitset m_cellActivity; ///< cell activity, empty when all active; see iCellActivity
+  SharedChunks<float> m_vectors{2}; ///< the step's XmGridTraceImpl::m_vectors
+  SharedChunks<float> m_inputX{1};  ///< the step's XmGridTraceImpl::m_inputX
+  SharedChunks<float> m_inputY{1};  ///< the step's XmGridTraceImpl::m_inputY
+  DynBitset m_inputActivity; ///< the step's XmGridTraceImpl::m_inputActivity
+  /// The step's XmGridTraceImpl::m_inputActivityLoc.
+  DataLocationEnum m_inputActivityLoc = DataLocationEnum::LOC_UNKNOWN;
+  size_t m_bytes = 0; ///< memory the step takes, as counted against the cache's budget
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -155,7 +861,7 @@ class XmGridTraceImpl : public XmGridTrace
 {
 public:
   XmGridTraceImpl(std::shared_ptr<XmUGrid> a_ugrid);
-  ~XmGridTraceImpl(){};
+  ~XmGridTraceImpl();
 
   double GetVectorMultiplier() const final;
   void SetVectorMultiplier(const double a_vectorMultiplier) final;
@@ -178,32 +884,176 @@ public:
   double GetMaxChangeDirectionInRadians() const final;
   void SetMaxChangeDirectionInRadians(const double a_maxChangeDirection) final;
 
+  XmGridTraceIntegratorEnum GetIntegrator() const final;
+  void SetIntegrator(XmGridTraceIntegratorEnum a_integrator) final;
+
+  double GetAbsoluteTolerance() const final;
+  void SetAbsoluteTolerance(double a_tolerance) final;
+
+  double GetRelativeTolerance() const final;
+  void SetRelativeTolerance(double a_tolerance) final;
+
+  int GetThreadCount() const final;
+  void SetThreadCount(int a_threadCount) final;
+
+  int GetPacketWidth() const final;
+  void SetPacketWidth(int a_packetWidth) final;
+
+  bool GetSpatialOrdering() const final;
+  void SetSpatialOrdering(bool a_spatialOrdering) final;
+
+  int GetWindowTimeSteps() const final;
+  void SetWindowTimeSteps(int a_timeSteps) final;
+
+  bool GetSnapshotTime(double& a_time) const final;
+  void SetSnapshotTime(double a_time) final;
+  void ClearSnapshotTime() final;
+
+  double GetSimplificationTolerance() const final;
+  void SetSimplificationTolerance(double a_tolerance) final;
+
+  BSHP<XmGridTraceSink> GetTraceSink() const final;
+  void SetTraceSink(BSHP<XmGridTraceSink> a_sink) final;
+
+  size_t GetTimeStepCacheBytes() const final;
+  void SetTimeStepCacheBytes(size_t a_bytes) final;
+  const std::string& GetTimeStepDataset() const final;
+  void SetTimeStepDataset(const std::string& a_dataset) final;
+  const std::string& GetGeometryCacheDirectory() const final;
+  void SetGeometryCacheDirectory(const std::string& a_directory) final;
+
   void AddGridScalarsAtTime(const VecPt3d& a_scalars,
                             DataLocationEnum a_scalarLoc,
                             const xms::DynBitset& a_activity,
                             DataLocationEnum a_activityLoc,
                             double a_time) final;
+  void AddGridScalarsAtTime(const double* a_vx,
+                            const double* a_vy,
+                            int a_count,
+                            int a_stride,
+                            DataLocationEnum a_scalarLoc,
+                            const xms::DynBitset& a_activity,
+                            DataLocationEnum a_activityLoc,
+                            double a_time) final;
+  void AddGridScalarsAtTime(const float* a_vx,
+                            const float* a_vy,
+                            int a_count,
+                            int a_stride,
+                            DataLocationEnum a_scalarLoc,
+                            const xms::DynBitset& a_activity,
+                            DataLocationEnum a_activityLoc,
+                            double a_time) final;
+  void AddGridScalarsAtTimeAsync(const VecPt3d& a_scalars,
+                                 DataLocationEnum a_scalarLoc,
+                                 const xms::DynBitset& a_activity,
+                                 DataLocationEnum a_activityLoc,
+                                 double a_time) final;
+  void AddGridScalarChangesAtTime(const VecInt& a_changedIndices,
+                                  const VecPt3d& a_changedScalars,
+                                  const VecInt& a_activityFlips,
+                                  double a_time) final;
+  bool AddCachedGridScalarsAtTime(double a_time) final;
+  void ClearTimeStepCache() final;
 
   void TracePoint(const Pt3d& a_pt,
                   const double& a_ptTime,
                   VecPt3d& a_outTrace,
                   VecDbl& a_outTimes) final;
+  void TracePoints(const VecPt3d& a_pts,
+                   const VecDbl& a_ptTimes,
+                   VecDbl& a_outXy,
+                   VecDbl& a_outTimes,
+                   std::vector<size_t>& a_outOffsets,
+                   std::vector<XmGridTraceExitEnum>& a_outExitReasons) final;
 
   void StartTraces(const VecPt3d& a_pts, const VecDbl& a_ptTimes) final;
   int ContinueTraces() final;
   void GetTraceResults(std::vector<VecPt3d>& a_outTraces,
                        std::vector<VecDbl>& a_outTimes,
                        std::vector<XmGridTraceExitEnum>& a_outExitReasons) const final;
+  void GetFlatTraceResults(VecDbl& a_outXy,
+                           VecDbl& a_outTimes,
+                           std::vector<size_t>& a_outOffsets,
+                           std::vector<XmGridTraceExitEnum>& a_outExitReasons) const final;
+  void TakeTraceResults(std::vector<VecPt3d>& a_outTraces,
+                        std::vector<VecDbl>& a_outTimes,
+                        std::vector<XmGridTraceExitEnum>& a_outExitReasons) final;
+  bool TakeTraceResult(size_t a_trace,
+                       VecPt3d& a_outTrace,
+                       VecDbl& a_outTimes,
+                       XmGridTraceExitEnum& a_outExitReason) final;
+
+  void GetTraceExitEdges(VecInt& a_outCells, VecInt& a_outCellEdges) const final;
 
   XmGridTraceExitEnum GetExitReason() const final;
   const std::string& GetExitMessage() const final;
+  void GetExitEdge(int& a_cellIdx, int& a_cellEdgeIdx) const final;
 
-private:
-  void StepTrace(TraceState& a_state);
+  const XmGridTraceStatistics& GetStatistics() const final;
+  void ResetStatistics() final;
 
-  bool GetVectorAtLocationAndTime(const xms::Pt3d& a_pt,
+private:
+  void OrderTraces(const TraceBatch& a_batch);
+  void StepBatch(TraceBatch& a_batch);
+  void StepTraces(TraceContext& a_ctx,
+                  TraceBatch& a_batch,
+                  const size_t* a_traces,
+                  size_t a_count,
+                  int a_width) const;
+  bool BeginLane(TraceContext& a_ctx, TraceBatch& a_batch, size_t a_trace, TraceLane& a_lane) const;
+  TraceLanePhase ProposeStep(TraceContext& a_ctx, TraceLane& a_lane) const;
+  bool FinishStep(TraceContext& a_ctx, TraceLane& a_lane, bool a_extracted) const;
+  bool IntegrateStep(TraceContext& a_ctx,
+                     int a_triangles[2],
+                     const Pt3d& a_pt0,
+                     double a_time0,
+                     double a_vx0,
+                     double a_vy0,
+                     double a_deltaT,
+                     Pt3d& a_pt1,
+                     Pt3d& a_vector1,
+                     double& a_error) const;
+
+  bool GetVectorAtLocationAndTime(TraceContext& a_ctx,
+                                  int a_triangles[2],
+                                  const xms::Pt3d& a_pt,
                                   double a_currentTime,
                                   xms::Pt3d& a_data) const;
+  bool EvaluatePacket(TraceContext& a_ctx, TraceLane* const* a_lanes, int a_count) const;
+  void EvaluateIntervalPacket(TraceContext& a_ctx,
+                              size_t a_step,
+                              TraceLane* const* a_lanes,
+                              int a_count) const;
+  void EvaluateSnapshotPacket(TraceContext& a_ctx,
+                              size_t a_step,
+                              TraceLane* const* a_lanes,
+                              int a_count) const;
+  size_t WindowStepAt(double a_time) const;
+  void PrepareSnapshot();
+  bool FindExit(TraceContext& a_ctx,
+                int a_triangles[2],
+                const Pt3d& a_pt0,
+                const Pt3d& a_pt1,
+                double a_time,
+                double& a_t,
+                int& a_cellIdx,
+                int& a_cellEdgeIdx) const;
+  void PrepareTimeStep(const VectorSource& a_scalars,
+                       DataLocationEnum a_scalarLoc,
+                       const DynBitset& a_activity,
+                       DataLocationEnum a_activityLoc,
+                       double a_time,
+                       const std::string& a_geometryCacheDirectory,
+                       PreparedTimeStep& a_step);
+  bool PrepareTimeStepChanges(const VecInt& a_changedIndices,
+                              const VecPt3d& a_changedScalars,
+                              const VecInt& a_activityFlips,
+                              double a_time,
+                              PreparedTimeStep& a_step);
+  void CommitTimeStep(PreparedTimeStep& a_step);
+  void CacheTimeStep(const std::string& a_dataset, const WindowStep& a_step);
+  void TrimTimeStepCache();
+  void FinishPendingTimeStep(bool a_deferError = false);
 
   std::shared_ptr<XmUGrid> m_ugrid;                ///< UGrid for the TracePoint operation
   double m_vectorMultiplier=1;          ///< multiplier for all vectors in grid
@@ -213,50 +1063,110 @@ private:
   double m_maxChangeDistance=-1;        ///< maximum distance per trace step
   double m_maxChangeVelocity=-1;        ///< maximum change in velocity per trace step
   double m_maxChangeDirectionInRadians=XM_PI/4; ///< maxmium change in direction per trace step
-
-  /// data extractor for the x component for the first time step
-  BSHP<XmUGrid2dDataExtractor> m_extractor1x;
-  /// data extractor for the y component for the first time step
-  BSHP<XmUGrid2dDataExtractor> m_extractor1y;
-  double m_time1=-1;  ///< time of the first time step
-  /// data extractor for the x component for the second time step
-  BSHP<XmUGrid2dDataExtractor> m_extractor2x;
-  /// data extractor for the y component for the second time step
-  BSHP<XmUGrid2dDataExtractor> m_extractor2y;
-  double m_time2=-1;        ///< time of the second time step
-  xms::DynBitset m_activity2; ///< activity of the second time step, to compare with the next
-  /// Data location of the second time step's scalars, to compare with the next. The
-  /// triangulation is built for a location, so a change here forbids sharing.
-  DataLocationEnum m_scalarLoc2 = DataLocationEnum::LOC_UNKNOWN;
-  /// Data location of the second time step's activity, to compare with the next. Decides how
-  /// the activity bitset maps onto cell activity, so a change here forbids sharing too.
-  DataLocationEnum m_activityLoc2 = DataLocationEnum::LOC_UNKNOWN;
-  /// Whether both time steps share one triangulation, which they can when the two steps agree
-  /// on activity and on both data locations. When they do, one search serves all four
-  /// extractors instead of one per step.
-  bool m_sharedAcrossTime = false;
-  /// Scratch for the point-location search. Members rather than locals because
-  /// GetVectorAtLocationAndTime runs a few dozen times per traced seed and these would
-  /// otherwise reallocate on every call. They make the tracer unsafe to share across
-  /// threads, which it already was -- GmTriSearch caches barycentric state per query.
-  mutable VecInt m_searchIdxs;
-  mutable VecDbl m_searchWeights;
-  /// Extractor used to find where a trace leaves the grid, built lazily on the first
-  /// out-of-domain step and reused for every one after it. Its construction triangulates the
-  /// whole grid and its first SetPolyline indexes every triangle into a GmMultiPolyIntersector;
-  /// neither depends on the polyline, and both were previously rebuilt per exit event at a
-  /// measured ~40 ms each. Null until a trace actually exits, so a tracer whose traces all
-  /// stay inside the grid never pays the memory.
-  BSHP<XmUGrid2dPolylineDataExtractor> m_boundaryExtractor;
+  XmGridTraceIntegratorEnum m_integrator = GTINT_EULER; ///< how each step is integrated
+  double m_absoluteTolerance = 1e-6; ///< Dormand-Prince position error allowed per step
+  double m_relativeTolerance = 1e-5; ///< same, as a fraction of the step's length
+  int m_threadCount = 1; ///< threads ContinueTraces uses; zero or less is one per core
+  int m_packetWidth = 1; ///< traces ContinueTraces advances in lockstep on each thread
+  bool m_spatialOrdering = false; ///< step traces in Hilbert order of where they are
+  double m_simplificationTolerance = 0; ///< how far a simplified trace may stray; 0 is off
+  bool m_snapshot = false;  ///< trace against the field frozen at m_snapshotTime
+  double m_snapshotTime = 0; ///< the time the field is frozen at, as asked for
+  /// m_snapshotTime clamped to the window, which is the time the field is frozen at.
+  double m_snapshotBlendTime = 0;
+  /// The window's steps either side of m_snapshotBlendTime blended at that time: six
+  /// coefficients per triangle of their geometry, as iFitTriangle lays them out. Built by
+  /// PrepareSnapshot when both steps share a triangulation; otherwise each evaluation blends
+  /// the two at that time.
+  VecDbl m_snapshotCoefficients;
+  bool m_snapshotStale = true; ///< the window has changed since the snapshot was blended
+  BSHP<XmGridTraceSink> m_sink; ///< sink the next StartTraces streams to, or null
+
+  int m_windowTimeSteps = 2; ///< time steps the window keeps; at least two
+  /// The time steps traces run through, oldest first and in order of time, at most
+  /// m_windowTimeSteps of them. A trace runs from one step into the next without stopping,
+  /// each evaluation blending the two steps either side of its time; it waits only at the
+  /// newest. A deque so that adding a step never moves the others, whose coefficient
+  /// tables the steps after them may point into.
+  std::deque<WindowStep> m_window;
+  /// The triangulations and boundary index of m_ugrid, shared with every other
+  /// tracer on it and built by whichever needs each first.
+  std::shared_ptr<XmGridTraceSharedGrid> m_shared;
+  /// The newest time step's vectors as converted, a row of x and y per triangulation
+  /// point, so fitting a triangle reads each point's pair from one place. Kept so
+  /// AddGridScalarChangesAtTime can update the values a change reaches and refit only their
+  /// triangles.
+  SharedChunks<float> m_vectors{2};
+  /// The newest time step's x scalars as given, at its data location. Kept, with the other
+  /// m_input members, for AddGridScalarChangesAtTime, which updates them in place. Their
+  /// chunks are shared with the time step cache, so an update copies the chunks it writes
+  /// while the cache holds them, and keeping a change step copies nothing else.
+  SharedChunks<float> m_inputX{1};
+  SharedChunks<float> m_inputY{1}; ///< the newest time step's y scalars as given; see m_inputX
+  DynBitset m_inputActivity; ///< the newest time step's activity as given
+  /// Where m_inputActivity is; anything but cells means points, as for iCellActivity.
+  DataLocationEnum m_inputActivityLoc = DataLocationEnum::LOC_UNKNOWN;
+  size_t m_stepCacheBudget = 0; ///< bytes the time step cache may hold; 0 caches nothing
+  size_t m_stepCacheBytes = 0;  ///< bytes the steps in m_stepCache take
+  std::string m_timeStepDataset; ///< dataset the steps added are cached under
+  std::string m_geometryCacheDirectory; ///< where triangulations are saved; empty for nowhere
+  /// Time steps kept for AddCachedGridScalarsAtTime, most recently added or taken first, so
+  /// the ones dropped to stay within m_stepCacheBudget are at the back. A list, so a step
+  /// moves to the front without moving any other and m_stepCacheIndex stays valid.
+  std::list<CachedTimeStep> m_stepCache;
+  /// Where each step of m_stepCache is, by its dataset and time.
+  std::map<std::pair<std::string, double>, std::list<CachedTimeStep>::iterator> m_stepCacheIndex;
+  /// Scratch for PrepareTimeStepChanges, one flag per triangulation point, triangle and cell,
+  /// so each is visited once however many changes reach it. Left all clear between steps.
+  std::vector<char> m_pointMarks;
+  std::vector<char> m_triangleMarks; ///< see m_pointMarks
+  std::vector<char> m_cellMarks;     ///< see m_pointMarks
+  /// Geometry for point-located scalars, once a step at that location has been committed.
+  /// The triangulation depends only on the grid and the data location, so it is the one
+  /// m_shared holds, whichever step it came with.
+  std::shared_ptr<const XmGridTraceGeometry> m_pointGeometry;
+  /// Geometry built for cell-located scalars; see m_pointGeometry.
+  std::shared_ptr<const XmGridTraceGeometry> m_cellGeometry;
+  /// Where positions are measured from in the fitted coefficients: the low corner of the
+  /// grid's extents.
+  Pt3d m_origin;
+  /// The incoming time step, between PrepareTimeStep and CommitTimeStep. Reused from step
+  /// to step, and traded with the coefficient table and inputs of the step it is committed
+  /// as.
+  PreparedTimeStep m_prepared;
+  /// Prepares the step AddGridScalarsAtTimeAsync was given into m_prepared; joinable until
+  /// FinishPendingTimeStep commits it. It touches only m_prepared and the shared
+  /// triangulations, neither of which tracing reads.
+  std::thread m_loader;
+  /// What m_loader threw. Read only once it is joined, and rethrown by the next
+  /// FinishPendingTimeStep that does not defer it.
+  std::exception_ptr m_loaderError;
+  VecPt3d m_loaderScalars;          ///< m_loader's copy of the caller's scalars
+  DynBitset m_loaderActivity;       ///< m_loader's copy of the caller's activity
   /// Traces started by StartTracePoints and advanced by ContinueTracePoints. Empty unless
   /// a batch is in flight; one batch per tracer, because the time step window it runs
   /// against is itself instance state.
-  std::vector<TraceState> m_batch;
+  TraceBatch m_batch;
+  /// The batch TracePoint and TracePoints step, kept so its arena is reused from call to
+  /// call.
+  TraceBatch m_single;
+  /// The unfinished traces of m_batch, in the order ContinueTraces steps them: seed order,
+  /// or Hilbert order with m_spatialOrdering. Rebuilt by every ContinueTraces, so finished
+  /// traces drop out and the order follows the traces as they drift.
+  std::vector<size_t> m_order;
+  /// Scratch for OrderTraces: each unfinished trace's curve index in the high 32 bits and
+  /// its seed index in the low, so one sort of plain integers orders them and breaks ties.
+  std::vector<uint64_t> m_orderKeys;
+  /// What the tracer has done; see GetStatistics. Mutable because copying results out is
+  /// timed, and that happens in const functions.
+  mutable XmGridTraceStatistics m_statistics;
 
   /// Why the last trace operation ended. Kept beside the message so the single-point
   /// TracePoint can answer the same question GetTraceResults answers per seed.
   XmGridTraceExitEnum m_exitReason = GTEXIT_NOT_STARTED;
   std::string m_exitMessage; ///< exit message for the last trace operation
+  int m_exitCell = -1;       ///< cell the last trace operation left through, or -1
+  int m_exitCellEdge = -1;   ///< edge of m_exitCell it left through, or -1
 protected:
 };
 double iGetDirAsCosTheta(double a_vx0, double a_vy0, double a_vx1, double a_vy1)
@@ -272,8 +1182,20 @@ double iGetDirAsCosTheta(double a_vx0, double a_vy0, double a_vx1, double a_vy1)
 //------------------------------------------------------------------------------
 XmGridTraceImpl::XmGridTraceImpl(std::shared_ptr<XmUGrid> a_ugrid)
 : m_ugrid(a_ugrid)
+, m_shared(XmGridTraceSharedGrid::Get(a_ugrid))
 {
+  Pt3d maxPt;
+  m_ugrid->GetExtents(m_origin, maxPt);
 }
+//------------------------------------------------------------------------------
+/// \brief Waits for a time step still being prepared, so its thread never outlives the
+///        tracer.
+//------------------------------------------------------------------------------
+XmGridTraceImpl::~XmGridTraceImpl()
+{
+  if (m_loader.joinable())
+    m_loader.join();
+} // XmGridTraceImpl::~XmGridTraceImpl
 
 ////////////////////////////////////////////////////////////////////////////////
 /// \class XmGridTraceImpl
@@ -395,6 +1317,236 @@ void XmGridTraceImpl::SetMaxChangeDirectionInRadians(const double a_maxChangeDir
   m_maxChangeDirectionInRadians = a_maxChangeDirection;
 } // XmGridTraceImpl::SetMaxChangeDirectionInRadians
 //------------------------------------------------------------------------------
+/// \brief Returns the integration scheme
+/// \return the integration scheme
+//------------------------------------------------------------------------------
+XmGridTraceIntegratorEnum XmGridTraceImpl::GetIntegrator() const
+{
+  return m_integrator;
+} // XmGridTraceImpl::GetIntegrator
+//------------------------------------------------------------------------------
+/// \brief Sets the integration scheme
+/// \param[in] a_integrator the integration scheme
+//------------------------------------------------------------------------------
+void XmGridTraceImpl::SetIntegrator(XmGridTraceIntegratorEnum a_integrator)
+{
+  m_integrator = a_integrator;
+} // XmGridTraceImpl::SetIntegrator
+//------------------------------------------------------------------------------
+/// \brief Returns the absolute tolerance
+/// \return the absolute tolerance
+//------------------------------------------------------------------------------
+double XmGridTraceImpl::GetAbsoluteTolerance() const
+{
+  return m_absoluteTolerance;
+} // XmGridTraceImpl::GetAbsoluteTolerance
+//------------------------------------------------------------------------------
+/// \brief Sets the absolute tolerance
+/// \param[in] a_tolerance the absolute tolerance
+//------------------------------------------------------------------------------
+void XmGridTraceImpl::SetAbsoluteTolerance(double a_tolerance)
+{
+  m_absoluteTolerance = a_tolerance;
+} // XmGridTraceImpl::SetAbsoluteTolerance
+//------------------------------------------------------------------------------
+/// \brief Returns the relative tolerance
+/// \return the relative tolerance
+//------------------------------------------------------------------------------
+double XmGridTraceImpl::GetRelativeTolerance() const
+{
+  return m_relativeTolerance;
+} // XmGridTraceImpl::GetRelativeTolerance
+//------------------------------------------------------------------------------
+/// \brief Sets the relative tolerance
+/// \param[in] a_tolerance the relative tolerance
+//------------------------------------------------------------------------------
+void XmGridTraceImpl::SetRelativeTolerance(double a_tolerance)
+{
+  m_relativeTolerance = a_tolerance;
+} // XmGridTraceImpl::SetRelativeTolerance
+//------------------------------------------------------------------------------
+/// \brief Returns the number of threads ContinueTraces uses
+/// \return the thread count as set; zero or less means one per hardware thread
+//------------------------------------------------------------------------------
+int XmGridTraceImpl::GetThreadCount() const
+{
+  return m_threadCount;
+} // XmGridTraceImpl::GetThreadCount
+//------------------------------------------------------------------------------
+/// \brief Sets the number of threads ContinueTraces uses
+/// \param[in] a_threadCount the thread count; zero or less means one per hardware thread
+//------------------------------------------------------------------------------
+void XmGridTraceImpl::SetThreadCount(int a_threadCount)
+{
+  m_threadCount = a_threadCount;
+} // XmGridTraceImpl::SetThreadCount
+//------------------------------------------------------------------------------
+/// \brief Returns how many traces ContinueTraces advances in lockstep
+/// \return the packet width as set
+//------------------------------------------------------------------------------
+int XmGridTraceImpl::GetPacketWidth() const
+{
+  return m_packetWidth;
+} // XmGridTraceImpl::GetPacketWidth
+//------------------------------------------------------------------------------
+/// \brief Sets how many traces ContinueTraces advances in lockstep
+/// \param[in] a_packetWidth the packet width; used clamped to 1..8
+//------------------------------------------------------------------------------
+void XmGridTraceImpl::SetPacketWidth(int a_packetWidth)
+{
+  m_packetWidth = a_packetWidth;
+} // XmGridTraceImpl::SetPacketWidth
+//------------------------------------------------------------------------------
+/// \brief Returns whether ContinueTraces steps traces in order of where they are
+/// \return true if traces are stepped in Hilbert order of their positions
+//------------------------------------------------------------------------------
+bool XmGridTraceImpl::GetSpatialOrdering() const
+{
+  return m_spatialOrdering;
+} // XmGridTraceImpl::GetSpatialOrdering
+//------------------------------------------------------------------------------
+/// \brief Sets whether ContinueTraces steps traces in order of where they are
+/// \param[in] a_spatialOrdering true to step traces in Hilbert order of their positions
+//------------------------------------------------------------------------------
+void XmGridTraceImpl::SetSpatialOrdering(bool a_spatialOrdering)
+{
+  m_spatialOrdering = a_spatialOrdering;
+} // XmGridTraceImpl::SetSpatialOrdering
+//------------------------------------------------------------------------------
+/// \brief Returns how many time steps the window keeps
+/// \return the time step count
+//------------------------------------------------------------------------------
+int XmGridTraceImpl::GetWindowTimeSteps() const
+{
+  return m_windowTimeSteps;
+} // XmGridTraceImpl::GetWindowTimeSteps
+//------------------------------------------------------------------------------
+/// \brief Sets how many time steps the window keeps, dropping the oldest at once if it
+///        already holds more.
+/// \param[in] a_timeSteps the time step count; used clamped to at least two
+//------------------------------------------------------------------------------
+void XmGridTraceImpl::SetWindowTimeSteps(int a_timeSteps)
+{
+  m_windowTimeSteps = std::max(2, a_timeSteps);
+  if (m_window.size() <= (size_t)m_windowTimeSteps)
+    return;
+  while (m_window.size() > (size_t)m_windowTimeSteps)
+    m_window.pop_front();
+  // The new first step's table for the step before may have been the one just dropped.
+  m_window.front().m_coefficients1.clear();
+  m_snapshotStale = true;
+} // XmGridTraceImpl::SetWindowTimeSteps
+//------------------------------------------------------------------------------
+/// \brief Returns whether traces follow the field frozen at one time, and which
+/// \param[out] a_time The time the field is frozen at, if it is
+/// \return true if traces follow a frozen field
+//------------------------------------------------------------------------------
+bool XmGridTraceImpl::GetSnapshotTime(double& a_time) const
+{
+  a_time = m_snapshotTime;
+  return m_snapshot;
+} // XmGridTraceImpl::GetSnapshotTime
+//------------------------------------------------------------------------------
+/// \brief Traces against the loaded window's field frozen at one time
+/// \param[in] a_time The time to freeze the field at
+//------------------------------------------------------------------------------
+void XmGridTraceImpl::SetSnapshotTime(double a_time)
+{
+  m_snapshot = true;
+  m_snapshotTime = a_time;
+  m_snapshotStale = true;
+} // XmGridTraceImpl::SetSnapshotTime
+//------------------------------------------------------------------------------
+/// \brief Goes back to tracing through the window as the field changes
+//------------------------------------------------------------------------------
+void XmGridTraceImpl::ClearSnapshotTime()
+{
+  m_snapshot = false;
+  VecDbl().swap(m_snapshotCoefficients);
+  m_snapshotStale = true;
+} // XmGridTraceImpl::ClearSnapshotTime
+//------------------------------------------------------------------------------
+/// \brief Returns how far a simplified trace may stray from the path traced
+/// \return the tolerance; zero or less means traces are not simplified
+//------------------------------------------------------------------------------
+double XmGridTraceImpl::GetSimplificationTolerance() const
+{
+  return m_simplificationTolerance;
+} // XmGridTraceImpl::GetSimplificationTolerance
+//------------------------------------------------------------------------------
+/// \brief Sets how far a simplified trace may stray from the path traced
+/// \param[in] a_tolerance the tolerance; zero or less keeps every step
+//------------------------------------------------------------------------------
+void XmGridTraceImpl::SetSimplificationTolerance(double a_tolerance)
+{
+  m_simplificationTolerance = a_tolerance;
+} // XmGridTraceImpl::SetSimplificationTolerance
+//------------------------------------------------------------------------------
+/// \brief Returns the sink batches stream their vertices to
+/// \return the sink, or null
+//------------------------------------------------------------------------------
+BSHP<XmGridTraceSink> XmGridTraceImpl::GetTraceSink() const
+{
+  return m_sink;
+} // XmGridTraceImpl::GetTraceSink
+//------------------------------------------------------------------------------
+/// \brief Sets the sink the next batch streams its vertices to
+/// \param[in] a_sink The sink, or null to keep vertices
+//------------------------------------------------------------------------------
+void XmGridTraceImpl::SetTraceSink(BSHP<XmGridTraceSink> a_sink)
+{
+  m_sink = a_sink;
+} // XmGridTraceImpl::SetTraceSink
+//------------------------------------------------------------------------------
+/// \brief Returns how much memory the time step cache may hold
+/// \return the budget, in bytes
+//------------------------------------------------------------------------------
+size_t XmGridTraceImpl::GetTimeStepCacheBytes() const
+{
+  return m_stepCacheBudget;
+} // XmGridTraceImpl::GetTimeStepCacheBytes
+//------------------------------------------------------------------------------
+/// \brief Sets how much memory the time step cache may hold
+/// \param[in] a_bytes the budget; 0 keeps no steps
+//------------------------------------------------------------------------------
+void XmGridTraceImpl::SetTimeStepCacheBytes(size_t a_bytes)
+{
+  m_stepCacheBudget = a_bytes;
+  TrimTimeStepCache();
+} // XmGridTraceImpl::SetTimeStepCacheBytes
+//------------------------------------------------------------------------------
+/// \brief Returns the name of the dataset the steps added are cached under
+/// \return the name
+//------------------------------------------------------------------------------
+const std::string& XmGridTraceImpl::GetTimeStepDataset() const
+{
+  return m_timeStepDataset;
+} // XmGridTraceImpl::GetTimeStepDataset
+//------------------------------------------------------------------------------
+/// \brief Names the dataset the steps added from now on are cached under
+/// \param[in] a_dataset The name
+//------------------------------------------------------------------------------
+void XmGridTraceImpl::SetTimeStepDataset(const std::string& a_dataset)
+{
+  m_timeStepDataset = a_dataset;
+} // XmGridTraceImpl::SetTimeStepDataset
+//------------------------------------------------------------------------------
+/// \brief Returns the directory triangulations of the grid are saved to between runs
+/// \return the directory; empty when they are not saved
+//------------------------------------------------------------------------------
+const std::string& XmGridTraceImpl::GetGeometryCacheDirectory() const
+{
+  return m_geometryCacheDirectory;
+} // XmGridTraceImpl::GetGeometryCacheDirectory
+//------------------------------------------------------------------------------
+/// \brief Sets the directory triangulations of the grid are saved to between runs
+/// \param[in] a_directory The directory; empty saves nothing
+//------------------------------------------------------------------------------
+void XmGridTraceImpl::SetGeometryCacheDirectory(const std::string& a_directory)
+{
+  m_geometryCacheDirectory = a_directory;
+} // XmGridTraceImpl::SetGeometryCacheDirectory
+//------------------------------------------------------------------------------
 /// \brief returns why the last trace operation ended
 /// \return the exit reason of the last trace operation
 //------------------------------------------------------------------------------
@@ -411,9 +1563,19 @@ const std::string& XmGridTraceImpl::GetExitMessage() const
   return m_exitMessage;
 } // XmGridTraceImpl::GetExitMessage
 //------------------------------------------------------------------------------
+/// \brief returns the cell edge the last trace operation left the grid through
+/// \param[out] a_cellIdx The cell, or -1 if the trace did not stop with GTEXIT_LEFT_GRID
+/// \param[out] a_cellEdgeIdx The edge within a_cellIdx, or -1
+//------------------------------------------------------------------------------
+void XmGridTraceImpl::GetExitEdge(int& a_cellIdx, int& a_cellEdgeIdx) const
+{
+  a_cellIdx = m_exitCell;
+  a_cellEdgeIdx = m_exitCellEdge;
+} // XmGridTraceImpl::GetExitEdge
+//------------------------------------------------------------------------------
 /// \brief Assigns velocity vectors to each point or cell for a time step,
-///        keeping the previous step, and dropping the one before that
-///        for a maximum of two time steps.
+///        keeping the previous steps, and dropping the oldest once the window
+///        holds GetWindowTimeSteps of them.
 /// \param[in] a_scalars The velocity vectors
 /// \param[in] a_scalarLoc Whether the vectors are assigned to cells or points
 /// \param[in] a_activity Whether each cell or point is active
@@ -426,2125 +1588,5964 @@ void XmGridTraceImpl::AddGridScalarsAtTime(const VecPt3d& a_scalars,
                                            DataLocationEnum a_activityLoc,
                                            double a_time)
 {
-  const bool hadPrevious = m_extractor2x && m_extractor2y;
-  if (hadPrevious)
-  {
-    m_extractor1x = m_extractor2x;
-    m_extractor1y = m_extractor2y;
-    m_time1 = m_time2;
-  }
-
-  m_time2 = a_time;
-  std::vector<float> xx, yy;
-  xx.reserve(a_scalars.size());
-  yy.reserve(a_scalars.size());
-  for (auto& pt : a_scalars)
-  {
-    xx.push_back((float)pt.x);
-    yy.push_back((float)pt.y);
-  }
-
-  // Share the triangulation with the previous time step when the two agree on everything it
-  // is built from: the grid (fixed at construction), the data location, and the activity
-  // mask. When they do, one point-location query serves all four extractors instead of one
-  // per time step, and no rebuild happens.
-  //
-  // All three terms are load-bearing, and the location ones are the easy ones to miss. The
-  // triangulation's shape comes from a_scalarLoc -- LOC_CELLS adds a centroid point per cell
-  // and LOC_POINTS adds none -- while a_activityLoc decides how the same bitset maps onto
-  // cell activity. Sharing does not copy the triangulation, it shares the object, and the
-  // second step's SetGrid*Scalars rebuilds that shared object in place; so sharing across a
-  // location change would rebuild the triangulation the *first* step is still pointing at,
-  // leaving its shorter scalar array indexed by the new triangulation's centroid indices.
-  // That is an out-of-bounds read in iApplyWeights, not a wrong answer.
-  m_sharedAcrossTime = hadPrevious && a_activity == m_activity2 &&
-                       a_scalarLoc == m_scalarLoc2 && a_activityLoc == m_activityLoc2;
-  m_extractor2x = m_sharedAcrossTime ? XmUGrid2dDataExtractor::New(m_extractor1x)
-                                     : XmUGrid2dDataExtractor::New(m_ugrid);
-  if (a_scalarLoc == DataLocationEnum::LOC_POINTS)
-    m_extractor2x->SetGridPointScalars(xx, a_activity, a_activityLoc);
-  else
-    m_extractor2x->SetGridCellScalars(xx, a_activity, a_activityLoc);
-
-  // y is built from x, and only after x's scalars are set. The sharing constructor copies
-  // the triangulation *and* the flag saying what it was built for; copying x before it has
-  // built one would leave y thinking it must build, and y would then rebuild the very
-  // triangulation it is sharing. Only the scalar arrays differ between the two.
-  m_extractor2y = XmUGrid2dDataExtractor::New(m_extractor2x);
-  if (a_scalarLoc == DataLocationEnum::LOC_POINTS)
-    m_extractor2y->SetGridPointScalars(yy, a_activity, a_activityLoc);
-  else
-    m_extractor2y->SetGridCellScalars(yy, a_activity, a_activityLoc);
-
-  m_activity2 = a_activity;
-  m_scalarLoc2 = a_scalarLoc;
-  m_activityLoc2 = a_activityLoc;
-}
-
-//------------------------------------------------------------------------------
-/// \brief Advances one trace as far as the currently loaded pair of time steps allows.
-///
-/// Starting a trace and resuming one differ only in the prologue: a fresh state has to
-/// evaluate and record its seed, while a resumed one already carries a position, its
-/// budgets, its step size and its previous velocity.
-/// \param[in,out] a_state The trace to advance
+  FinishPendingTimeStep();
+  PrepareTimeStep(iVectorSource(a_scalars), a_scalarLoc, a_activity, a_activityLoc, a_time,
+                  m_geometryCacheDirectory, m_prepared);
+  m_prepared.m_dataset = m_timeStepDataset;
+  CommitTimeStep(m_prepared);
+} // XmGridTraceImpl::AddGridScalarsAtTime
+//------------------------------------------------------------------------------
+/// \brief Assigns velocity vectors read from the caller's arrays for a time step, as
+///        the overload taking points does.
+/// \param[in] a_vx The first vector's x
+/// \param[in] a_vy The first vector's y
+/// \param[in] a_count Number of vectors
+/// \param[in] a_stride Values from one vector's x, or y, to the next's
+/// \param[in] a_scalarLoc Whether the vectors are assigned to cells or points
+/// \param[in] a_activity Whether each cell or point is active
+/// \param[in] a_activityLoc Whether the activities are assigned to cells or points
+/// \param[in] a_time The time of the scalars
 //------------------------------------------------------------------------------
-void XmGridTraceImpl::StepTrace(TraceState& a_state)
+void XmGridTraceImpl::AddGridScalarsAtTime(const double* a_vx,
+                                           const double* a_vy,
+                                           int a_count,
+                                           int a_stride,
+                                           DataLocationEnum a_scalarLoc,
+                                           const xms::DynBitset& a_activity,
+                                           DataLocationEnum a_activityLoc,
+                                           double a_time)
 {
-  if (iIsTerminal(a_state.m_exitReason))
-    return;
-
-  const double ptTime = a_state.m_ptTime;
-  Pt3d pt0 = a_state.m_pt, pt1;
-  double deltaT = a_state.m_deltaT;
-  // A window that ended exactly on m_time2 left deltaT clamped to zero (see the time step
-  // clamp in the loop below), and zero cannot be carried into the next window: a zero-length
-  // step moves nothing and changes no velocity, so it satisfies none of the loop's exit
-  // tests -- not the clamps, which need elapsedTime to advance, and not the subdivision
-  // tests, which compare a step against the one before it and would see no change. The loop
-  // would spin forever. Start the next window from the initial step and let the clamps size
-  // it again, which is what a fresh trace does.
-  if (deltaT <= 0)
-    deltaT = kInitialDeltaT;
-  double elapsedTime = a_state.m_elapsedTime;
-  double distTraveled = a_state.m_distTraveled;
-  double vx0 = a_state.m_vx, vy0 = a_state.m_vy, mag0 = a_state.m_mag;
-  double vx1 = 0, vy1 = 0, mag1 = 0;
-  bool bContinue = true;
-  Pt3d vtkVec;
-  Pt3d vector;
-  VecPt3d& outTrace = a_state.m_trace;
-  VecDbl& outTimes = a_state.m_times;
-
-  // Writes back everything the next call resumes from. Every exit from this function goes
-  // through it, so there is no path that advances the trace without recording where it got to.
-  auto stopWith = [&](XmGridTraceExitEnum a_reason) {
-    a_state.m_pt = pt0;
-    a_state.m_deltaT = deltaT;
-    a_state.m_elapsedTime = elapsedTime;
-    a_state.m_distTraveled = distTraveled;
-    a_state.m_vx = vx0;
-    a_state.m_vy = vy0;
-    a_state.m_mag = mag0;
-    a_state.m_exitReason = a_reason;
-    m_exitReason = a_reason;
-    m_exitMessage = XmGridTraceExitReasonToString(a_reason);
-  };
-
-  if (!a_state.m_started)
-  {
-    outTrace.clear();
-    outTimes.clear();
-    if (ptTime > m_time2)
-    {
-      // The seed is released after the loaded window, so its field is not known yet. That is
-      // the same situation the time step clamp below reports as WAITING, and it has to be
-      // reported the same way here: EXTRACTION_FAILED is terminal (see iIsTerminal), so a
-      // seed given a later release time than the current window would never start, even once
-      // the time step covering it arrived. StartTraces takes a release time per seed
-      // precisely so a batch can be staggered, which makes this a normal input, not an error.
-      stopWith(GTEXIT_WAITING_FOR_TIME_STEP);
-      return;
-    }
-    if (!GetVectorAtLocationAndTime(pt0, ptTime, vector)) // Ensure extraction did not fail
+  VectorSource source;
+  source.m_x = a_vx;
+  source.m_y = a_vy;
+  source.m_count = a_count;
+  source.m_stride = a_stride;
+  FinishPendingTimeStep();
+  PrepareTimeStep(source, a_scalarLoc, a_activity, a_activityLoc, a_time,
+                  m_geometryCacheDirectory, m_prepared);
+  m_prepared.m_dataset = m_timeStepDataset;
+  CommitTimeStep(m_prepared);
+} // XmGridTraceImpl::AddGridScalarsAtTime
+//------------------------------------------------------------------------------
+/// \brief Assigns velocity vectors read from the caller's arrays for a time step, as
+///        the overload taking points does.
+/// \param[in] a_vx The first vector's x
+/// \param[in] a_vy The first vector's y
+/// \param[in] a_count Number of vectors
+/// \param[in] a_stride Values from one vector's x, or y, to the next's
+/// \param[in] a_scalarLoc Whether the vectors are assigned to cells or points
+/// \param[in] a_activity Whether each cell or point is active
+/// \param[in] a_activityLoc Whether the activities are assigned to cells or points
+/// \param[in] a_time The time of the scalars
+//------------------------------------------------------------------------------
+void XmGridTraceImpl::AddGridScalarsAtTime(const float* a_vx,
+                                           const float* a_vy,
+                                           int a_count,
+                                           int a_stride,
+                                           DataLocationEnum a_scalarLoc,
+                                           const xms::DynBitset& a_activity,
+                                           DataLocationEnum a_activityLoc,
+                                           double a_time)
+{
+  VectorSource source;
+  source.m_xf = a_vx;
+  source.m_yf = a_vy;
+  source.m_count = a_count;
+  source.m_stride = a_stride;
+  FinishPendingTimeStep();
+  PrepareTimeStep(source, a_scalarLoc, a_activity, a_activityLoc, a_time,
+                  m_geometryCacheDirectory, m_prepared);
+  m_prepared.m_dataset = m_timeStepDataset;
+  CommitTimeStep(m_prepared);
+} // XmGridTraceImpl::AddGridScalarsAtTime
+//------------------------------------------------------------------------------
+/// \brief Adds a time step as AddGridScalarsAtTime does, preparing it on a background
+///        thread; it joins the window when the next ContinueTraces returns.
+/// \param[in] a_scalars The velocity vectors
+/// \param[in] a_scalarLoc Whether the vectors are assigned to cells or points
+/// \param[in] a_activity Whether each cell or point is active
+/// \param[in] a_activityLoc Whether the activities are assigned to cells or points
+/// \param[in] a_time The time of the scalars
+//------------------------------------------------------------------------------
+void XmGridTraceImpl::AddGridScalarsAtTimeAsync(const VecPt3d& a_scalars,
+                                                DataLocationEnum a_scalarLoc,
+                                                const xms::DynBitset& a_activity,
+                                                DataLocationEnum a_activityLoc,
+                                                double a_time)
+{
+  // One step in flight: a second one added before the first is swapped in waits for it,
+  // exactly as two synchronous adds would follow one another.
+  FinishPendingTimeStep();
+  m_loaderScalars = a_scalars;
+  m_loaderActivity = a_activity;
+  m_prepared.m_dataset = m_timeStepDataset;
+  // A copy, so the directory may be changed while the step loads.
+  const std::string geometryCacheDirectory = m_geometryCacheDirectory;
+  m_loader = std::thread([this, a_scalarLoc, a_activityLoc, a_time, geometryCacheDirectory]() {
+    try
     {
-      stopWith(GTEXIT_EXTRACTION_FAILED);
-      return;
+      PrepareTimeStep(iVectorSource(m_loaderScalars), a_scalarLoc, m_loaderActivity,
+                      a_activityLoc, a_time, geometryCacheDirectory, m_prepared);
     }
-    if (EQ_TOL(vector.x, XM_NODATA, 1) || EQ_TOL(vector.y, XM_NODATA, 1))
+    catch (...)
     {
-      stopWith(GTEXIT_SEED_NOT_TRACEABLE);
-      return;
+      m_loaderError = std::current_exception();
     }
-
-    outTrace.push_back(pt0);
-    outTimes.push_back(ptTime);
-
-    vx0 = vector.x * m_vectorMultiplier;
-    vy0 = vector.y * m_vectorMultiplier;
-    mag0 = sqrt(vector.x * vector.x + vector.y * vector.y);
-    a_state.m_started = true;
+  });
+} // XmGridTraceImpl::AddGridScalarsAtTimeAsync
+//------------------------------------------------------------------------------
+/// \brief Converts and fits a time step without touching the window being traced.
+///
+/// Writes only a_step, including the inputs and converted values CommitTimeStep trades in,
+/// and the grid's shared triangulations, which are locked while built. It reads nothing of
+/// the window, so it may run on a background thread while ContinueTraces steps traces
+/// against the current window, and a step that throws leaves the tracer as it was.
+/// \param[in] a_scalars Where to read the velocity vectors
+/// \param[in] a_scalarLoc Whether the vectors are assigned to cells or points
+/// \param[in] a_activity Whether each cell or point is active
+/// \param[in] a_activityLoc Whether the activities are assigned to cells or points
+/// \param[in] a_time The time of the scalars
+/// \param[in] a_geometryCacheDirectory Where the grid's triangulations are saved between
+///            runs; empty for nowhere
+/// \param[out] a_step The prepared step, for CommitTimeStep
+//------------------------------------------------------------------------------
+void XmGridTraceImpl::PrepareTimeStep(const VectorSource& a_scalars,
+                                      DataLocationEnum a_scalarLoc,
+                                      const DynBitset& a_activity,
+                                      DataLocationEnum a_activityLoc,
+                                      double a_time,
+                                      const std::string& a_geometryCacheDirectory,
+                                      PreparedTimeStep& a_step)
+{
+  const auto start = std::chrono::steady_clock::now();
+  a_step.m_statistics = XmGridTraceStatistics();
+  a_step.m_time = a_time;
+  a_step.m_scalarLoc = a_scalarLoc;
+  a_step.m_isChange = false;
+  a_step.m_fromCache = false;
+  // The one copy of the caller's vectors: the extractor takes each component as floats.
+  if (a_scalars.m_xf)
+  {
+    iReadComponent(a_scalars.m_xf, a_scalars.m_count, a_scalars.m_stride, a_step.m_readX);
+    iReadComponent(a_scalars.m_yf, a_scalars.m_count, a_scalars.m_stride, a_step.m_readY);
   }
-
-  double maxAngleChange = cos(m_maxChangeDirectionInRadians);
-  // Which reason the loop will stop with. Tracked explicitly rather than inferred afterwards:
-  // several conditions in one iteration overwrite each other, and a later split can put the
-  // trace back into motion after the time step clamp has already fired.
-  XmGridTraceExitEnum stopReason = GTEXIT_WAITING_FOR_TIME_STEP;
-
-  while (bContinue)
+  else
+  {
+    iReadComponent(a_scalars.m_x, a_scalars.m_count, a_scalars.m_stride, a_step.m_readX);
+    iReadComponent(a_scalars.m_y, a_scalars.m_count, a_scalars.m_stride, a_step.m_readY);
+  }
+  a_step.m_inputActivity = a_activity;
+  a_step.m_inputActivityLoc = a_activityLoc;
+
+  // Each component becomes the float values the extractor would have interpolated. The
+  // triangulation depends only on the grid and the location, so it is built once, by
+  // whichever tracer on the grid first adds a step there.
+  a_step.m_cellActivity = iCellActivity(*m_ugrid, a_activity, a_activityLoc);
+  a_step.m_geometry = m_shared->Convert(a_scalarLoc, a_step.m_readX, a_step.m_readY,
+                                        a_activity, a_activityLoc, a_step.m_cellActivity,
+                                        a_geometryCacheDirectory, a_step.m_converted,
+                                        a_step.m_statistics.m_triangulationSeconds);
+  a_step.m_inputX.Assign(a_step.m_readX);
+  a_step.m_inputY.Assign(a_step.m_readY);
+  a_step.m_vectors.Assign(a_step.m_converted);
+  iFitTriangles(*a_step.m_geometry, a_step.m_vectors, m_origin, a_step.m_coefficients);
+  XMGT_INJECT_TIME_STEP_FAILURE();
+  a_step.m_statistics.m_addScalarsSeconds += iSecondsSince(start);
+} // XmGridTraceImpl::PrepareTimeStep
+//------------------------------------------------------------------------------
+/// \brief Adds a time step made from the last one added and a sparse set of changes.
+/// \param[in] a_changedIndices The points or cells whose vectors changed
+/// \param[in] a_changedScalars The new vector of each, parallel to a_changedIndices
+/// \param[in] a_activityFlips The points or cells whose activity toggled
+/// \param[in] a_time The time of the scalars
+//------------------------------------------------------------------------------
+void XmGridTraceImpl::AddGridScalarChangesAtTime(const VecInt& a_changedIndices,
+                                                 const VecPt3d& a_changedScalars,
+                                                 const VecInt& a_activityFlips,
+                                                 double a_time)
+{
+  FinishPendingTimeStep();
+  if (PrepareTimeStepChanges(a_changedIndices, a_changedScalars, a_activityFlips, a_time,
+                             m_prepared))
+  {
+    m_prepared.m_dataset = m_timeStepDataset;
+    CommitTimeStep(m_prepared);
+  }
+} // XmGridTraceImpl::AddGridScalarChangesAtTime
+//------------------------------------------------------------------------------
+/// \brief Adds the time step of the time step dataset at a time from the time step cache,
+///        if it is there.
+///
+/// The step's table is committed as a prepared step would be, so the window holds exactly
+/// what it held when the step was first added. The inputs kept with it are restored, for
+/// changes to build on. Both share their chunks with the cache rather than copy them.
+/// \param[in] a_time The time of the step
+/// \return true if the step was cached and has been added
+//------------------------------------------------------------------------------
+bool XmGridTraceImpl::AddCachedGridScalarsAtTime(double a_time)
+{
+  FinishPendingTimeStep();
+  auto found = m_stepCacheIndex.find(std::make_pair(m_timeStepDataset, a_time));
+  if (found == m_stepCacheIndex.end())
+  {
+    ++m_statistics.m_timeStepCacheMisses;
+    return false;
+  }
+  const auto start = std::chrono::steady_clock::now();
+  ++m_statistics.m_timeStepCacheHits;
+  m_stepCache.splice(m_stepCache.begin(), m_stepCache, found->second);
+  const CachedTimeStep& cached = m_stepCache.front();
+
+  PreparedTimeStep& step = m_prepared;
+  step.m_statistics = XmGridTraceStatistics();
+  step.m_time = cached.m_time;
+  step.m_scalarLoc = cached.m_scalarLoc;
+  step.m_geometry = cached.m_geometry;
+  step.m_isChange = false;
+  step.m_fromCache = true;
+  step.m_coefficients = cached.m_coefficients;
+  step.m_cellActivity = cached.m_cellActivity;
+  step.m_vectors = cached.m_vectors;
+  step.m_inputX = cached.m_inputX;
+  step.m_inputY = cached.m_inputY;
+  step.m_inputActivity = cached.m_inputActivity;
+  step.m_inputActivityLoc = cached.m_inputActivityLoc;
+  step.m_statistics.m_addScalarsSeconds += iSecondsSince(start);
+  CommitTimeStep(step);
+  return true;
+} // XmGridTraceImpl::AddCachedGridScalarsAtTime
+//------------------------------------------------------------------------------
+/// \brief Drops every step in the time step cache.
+//------------------------------------------------------------------------------
+void XmGridTraceImpl::ClearTimeStepCache()
+{
+  m_stepCache.clear();
+  m_stepCacheIndex.clear();
+  m_stepCacheBytes = 0;
+} // XmGridTraceImpl::ClearTimeStepCache
+//------------------------------------------------------------------------------
+/// \brief Prepares a time step from the newest one and a sparse set of changes.
+///
+/// Updates the kept inputs in place, copying only the chunks it writes that the time step
+/// cache shares, and recomputes only the triangulation values the changes reach, by the
+/// rules applied to whole steps: for point-located scalars a grid point takes its own value
+/// and a cell's centroid the mean of the cell's points; for cell-located scalars a centroid
+/// takes its cell's value and a grid point the mean of the active cells around it. Values
+/// whole steps mark as no data are only ever read by triangles of inactive cells, which no
+/// search returns, so those are left as the rules give them. The triangles using a changed
+/// value are listed for CommitTimeStep to refit.
+/// \param[in] a_changedIndices The points or cells whose vectors changed
+/// \param[in] a_changedScalars The new vector of each, parallel to a_changedIndices
+/// \param[in] a_activityFlips The points or cells whose activity toggled
+/// \param[in] a_time The time of the scalars
+/// \param[out] a_step The prepared step, for CommitTimeStep
+/// \return false, with an error logged and nothing changed, if the changes were refused
+//------------------------------------------------------------------------------
+bool XmGridTraceImpl::PrepareTimeStepChanges(const VecInt& a_changedIndices,
+                                             const VecPt3d& a_changedScalars,
+                                             const VecInt& a_activityFlips,
+                                             double a_time,
+                                             PreparedTimeStep& a_step)
+{
+  const auto start = std::chrono::steady_clock::now();
+  if (m_window.empty())
   {
-    if (m_maxChangeDistance > 0)
+    XMGT_LOG(xmlog::error,
+             "Gridtracer: a whole time step must be added before changes to it.");
+    return false;
+  }
+  const WindowStep& newest = m_window.back();
+  if (a_time <= newest.m_time)
+  {
+    // A change is layered on the newest step, so it can only come after it; at or before,
+    // it would put the window out of order.
+    XMGT_LOG(xmlog::error, "Gridtracer: time step changes must be at a time after the newest "
+                           "time step.");
+    return false;
+  }
+  const bool pointData = newest.m_scalarLoc == DataLocationEnum::LOC_POINTS;
+  const bool cellActivity = m_inputActivityLoc == DataLocationEnum::LOC_CELLS;
+  const int gridPointCount = m_ugrid->GetPointCount();
+  const int cellCount = m_ugrid->GetCellCount();
+  const int activityCount = cellActivity ? cellCount : gridPointCount;
+  bool valid = a_changedIndices.size() == a_changedScalars.size();
+  for (int idx : a_changedIndices)
+    valid = valid && idx >= 0 && (size_t)idx < m_inputX.GetSize();
+  for (int idx : a_activityFlips)
+    valid = valid && idx >= 0 && idx < activityCount;
+  if (!valid)
+  {
+    // Refusing the whole step rather than applying the valid part, as StartTraces refuses a
+    // whole batch: a caller that got this wrong has a bug a partial step would hide.
+    XMGT_LOG(xmlog::error, "Gridtracer: time step changes must be one vector per index and "
+                           "index existing points or cells.");
+    return false;
+  }
+
+  const XmGridTraceGeometry& geometry = *newest.m_geometry;
+  a_step.m_statistics = XmGridTraceStatistics();
+  a_step.m_time = a_time;
+  a_step.m_scalarLoc = newest.m_scalarLoc;
+  a_step.m_geometry = newest.m_geometry;
+  a_step.m_isChange = true;
+  a_step.m_fromCache = false;
+  a_step.m_changedTriangles.clear();
+  a_step.m_cellActivity = newest.m_cellActivity;
+  m_pointMarks.resize(geometry.GetPointCount(), 0);
+  m_triangleMarks.resize(geometry.GetTriangleCount(), 0);
+  m_cellMarks.resize(cellCount, 0);
+
+  // Every triangulation point whose value may change, and every cell whose centroid may.
+  VecInt points, cells;
+  auto markPoint = [&](int a_pt) {
+    if (!m_pointMarks[a_pt])
     {
-      // make sure deltaT is small enough to not go past the max dist
-      double d2 = m_maxChangeDistance * m_maxChangeDistance;
-      double denom = (vx0 * vx0) + (vy0 * vy0) + (m_maxChangeDistance * XM_ZERO_TOL);
-      double dt = sqrt(d2 / denom);
-      if (deltaT > dt)
-        deltaT = dt;
+      m_pointMarks[a_pt] = 1;
+      points.push_back(a_pt);
     }
-    // If the change in DeltaT would push us beyond the time step, set it to hit the timestep
-    if (elapsedTime + deltaT + ptTime > m_time2)
+  };
+  auto markCell = [&](int a_cell) {
+    if (!m_cellMarks[a_cell])
     {
-      deltaT = m_time2 - elapsedTime - ptTime;
-      if (deltaT <= 0)
-      {
-        // Nothing left in this window -- the trace is already sitting exactly on m_time2,
-        // which is what a second ContinueTraces with no new data finds. Stop before stepping,
-        // and put back the step size this call came in with: a zero-length step would append
-        // nothing anyway, and persisting the zero is what used to leave the resumed trace
-        // unable to advance at all. Restoring it is what makes a redundant ContinueTraces
-        // genuinely do no useful work, rather than quietly changing the path that follows.
-        deltaT = a_state.m_deltaT;
-        stopWith(GTEXIT_WAITING_FOR_TIME_STEP);
-        return;
-      }
-      bContinue = false; // This will be the last point traced in this window
-      stopReason = GTEXIT_WAITING_FOR_TIME_STEP;
+      m_cellMarks[a_cell] = 1;
+      cells.push_back(a_cell);
     }
-    // If the change in delta time would push beyond the max tracing time, set it to hit max
-    // tracing time
-    if (m_maxTracingTime > 0 && (elapsedTime + deltaT) > m_maxTracingTime)
+  };
+  VecInt cellPoints;
+  for (size_t i = 0; i < a_changedIndices.size(); ++i)
+  {
+    const int idx = a_changedIndices[i];
+    *m_inputX.GetMutableRow(idx) = (float)a_changedScalars[i].x;
+    *m_inputY.GetMutableRow(idx) = (float)a_changedScalars[i].y;
+    if (pointData)
     {
-      deltaT = m_maxTracingTime - elapsedTime;
-      bContinue = false; // This will be the last point traced
-      stopReason = GTEXIT_MAX_TRACING_TIME;
+      markPoint(idx);
+      for (int cellIdx : m_ugrid->GetPointAdjacentCells(idx))
+        markCell(cellIdx);
     }
-
-    // compute candidate point
-    pt1.x = pt0.x + deltaT * vx0;
-    pt1.y = pt0.y + deltaT * vy0;
-
-    if (!GetVectorAtLocationAndTime(pt1, ptTime + elapsedTime + deltaT, vtkVec))
+    else
     {
-      outTrace.clear();
-      outTimes.clear();
-      stopWith(GTEXIT_EXTRACTION_FAILED);
-      return;
+      markCell(idx);
+      m_ugrid->GetCellPoints(idx, cellPoints);
+      for (int ptIdx : cellPoints)
+        markPoint(ptIdx);
     }
-    // if pt1 outside of domain, compute new deltaT to get to boundary
-    if (EQ_TOL(vtkVec.x, XM_NODATA, 1) || EQ_TOL(vtkVec.y, XM_NODATA, 1))
+  }
+
+  if (!a_activityFlips.empty())
+  {
+    // Activity is updated where it toggled, and cell activity re-derived only for the cells
+    // a toggle can reach; see iCellActivity for the rule.
+    DynBitset& activity = a_step.m_cellActivity;
+    if (activity.empty())
+      activity.resize(cellCount, true);
+    if (m_inputActivity.size() < (size_t)activityCount)
+      m_inputActivity.resize(activityCount, true);
+    VecInt changedCells;
+    for (int idx : a_activityFlips)
     {
-      VecPt3d points = {pt0, pt1};
-      if (!m_boundaryExtractor)
+      m_inputActivity[idx].flip();
+      if (cellActivity)
+        changedCells.push_back(idx);
+      else
       {
-        // DataLocationEnum is irrelevant here: only the extract locations are consumed below,
-        // never the extracted values, so the dummy zero scalars the constructor installs do
-        // not matter and the instance stays valid for this tracer's lifetime.
-        m_boundaryExtractor =
-          XmUGrid2dPolylineDataExtractor::New(m_ugrid, DataLocationEnum::LOC_POINTS);
-        XMGT_COUNT_BOUNDARY_EXTRACTOR_BUILD();
+        for (int cellIdx : m_ugrid->GetPointAdjacentCells(idx))
+          changedCells.push_back(cellIdx);
       }
-      m_boundaryExtractor->SetPolyline(points);
-      points = m_boundaryExtractor->GetExtractLocations();
-      if (points.size() < 3)
+    }
+    for (int cellIdx : changedCells)
+    {
+      bool active = true;
+      if (cellActivity)
+        active = m_inputActivity[cellIdx];
+      else
       {
-        XM_LOG(xmlog::error, "Gridtracer failed to find an intersection when exiting grid.");
-        stopWith(GTEXIT_LEFT_GRID);
-        return;
+        m_ugrid->GetCellPoints(cellIdx, cellPoints);
+        for (int ptIdx : cellPoints)
+          active = active && m_inputActivity[ptIdx];
       }
-      double segDist = Mdist(pt0.x, pt0.y, pt1.x, pt1.y);
-      pt1 = points[points.size() - 2];
-      double newSegDist = Mdist(pt0.x, pt0.y, pt1.x, pt1.y);
-      deltaT *= (newSegDist / segDist);
-      bContinue = false;
-      stopReason = GTEXIT_LEFT_GRID;
-      if (!GetVectorAtLocationAndTime(pt1, ptTime + elapsedTime + deltaT, vtkVec) ||
-          vtkVec.x == XM_NODATA || vtkVec.y == XM_NODATA)
+      activity[cellIdx] = active;
+      // Around cell-located scalars a point averages only the active cells, so a cell
+      // toggling changes its points; point-located values do not depend on activity.
+      if (!pointData)
       {
-        stopWith(GTEXIT_EXTRACTION_FAILED);
-        return;
+        m_ugrid->GetCellPoints(cellIdx, cellPoints);
+        for (int ptIdx : cellPoints)
+          markPoint(ptIdx);
       }
     }
-    vx1 = vtkVec.x;
-    vy1 = vtkVec.y;
-    vx1 *= m_vectorMultiplier;
-    vy1 *= m_vectorMultiplier;
+    if (activity.count() == activity.size())
+      activity.clear();
+  }
 
-    if (EQ_TOL(vx1, 0.0, .0001) && EQ_TOL(vy1, 0.0, .0001)) // No velocity
+  const DynBitset& activity = a_step.m_cellActivity;
+  for (int cellIdx : cells)
+  {
+    m_cellMarks[cellIdx] = 0;
+    const int centroid = geometry.GetCellCentroid(cellIdx);
+    if (centroid < 0)
+      continue;
+    float* values = m_vectors.GetMutableRow(centroid);
+    if (!pointData)
     {
-      outTrace.push_back(pt1);
-      outTimes.push_back(ptTime + elapsedTime + deltaT);
-      pt0 = pt1;
-      elapsedTime += deltaT;
-      stopWith(GTEXIT_ZERO_VELOCITY);
-      return;
+      values[0] = *m_inputX.GetRow(cellIdx);
+      values[1] = *m_inputY.GetRow(cellIdx);
     }
-    bool bSplit = false;
-
-    mag1 = sqrt(vx1 * vx1 + vy1 * vy1);
-
-    // do we subdivide?
-
-    if (!bSplit && m_maxChangeVelocity > 0)
+    else
     {
-      double changeVel = fabs(mag1 - mag0);
-      if (changeVel > m_maxChangeVelocity)
-        bSplit = true;
+      m_ugrid->GetCellPoints(cellIdx, cellPoints);
+      double sumX = 0, sumY = 0;
+      for (int ptIdx : cellPoints)
+      {
+        sumX += *m_inputX.GetRow(ptIdx);
+        sumY += *m_inputY.GetRow(ptIdx);
+      }
+      values[0] = (float)(sumX / cellPoints.size());
+      values[1] = (float)(sumY / cellPoints.size());
     }
-    if (!bSplit && m_maxChangeDirectionInRadians > 0)
+    markPoint(centroid);
+  }
+  for (int ptIdx : points)
+  {
+    if (ptIdx >= gridPointCount)
+      continue; // a centroid, set above
+    float* values = m_vectors.GetMutableRow(ptIdx);
+    if (pointData)
     {
-      double dir = iGetDirAsCosTheta(vx0, vy0, vx1, vy1);
-      if (dir < maxAngleChange)
-        bSplit = true;
+      values[0] = *m_inputX.GetRow(ptIdx);
+      values[1] = *m_inputY.GetRow(ptIdx);
+      continue;
     }
-    if (bSplit)
+    double sumX = 0, sumY = 0;
+    int count = 0;
+    for (int cellIdx : m_ugrid->GetPointAdjacentCells(ptIdx))
     {
-      // A split puts the trace back in motion, so any stop decided earlier in this iteration
-      // is void -- including the time step clamp, which is why resumability cannot be read
-      // off the loop's final state without this.
-      bContinue = true;
-      stopReason = GTEXIT_WAITING_FOR_TIME_STEP;
-      deltaT /= 2;
-      if (m_minDeltaTime > 0 && deltaT < m_minDeltaTime)
+      if (activity.empty() || activity[cellIdx])
       {
-        // done, exit
-        bContinue = false;
-        stopReason = GTEXIT_MIN_DELTA_TIME;
+        sumX += *m_inputX.GetRow(cellIdx);
+        sumY += *m_inputY.GetRow(cellIdx);
+        ++count;
       }
     }
-    else
-    {
-      double segDist = Mdist(pt0.x, pt0.y, pt1.x, pt1.y);
-      distTraveled += segDist;
-      if (m_maxTracingDistance > 0 && distTraveled > m_maxTracingDistance)
-      {
-        // because our last point exceeded the exitDistance
-        // find this point by linear calculations
-        double distancePast = distTraveled - m_maxTracingDistance;
-        double perc = distancePast / segDist;
-        Pt3d newPt;
-        newPt.x = (pt0.x * perc) + (pt1.x * (1 - perc));
-        newPt.y = (pt0.y * perc) + (pt1.y * (1 - perc));
-
-        distTraveled = m_maxTracingDistance;
-        outTrace.push_back(newPt);
-        outTimes.push_back(ptTime + elapsedTime + deltaT * perc);
-        pt0 = newPt;
-        elapsedTime += deltaT * perc;
-        stopWith(GTEXIT_MAX_TRACING_DISTANCE);
-        return;
-      }
+    values[0] = count ? (float)(sumX / count) : (float)XM_NODATA;
+    values[1] = count ? (float)(sumY / count) : (float)XM_NODATA;
+  }
 
-      // add new pt if not identical to last -- and push its time only when the point is
-      // pushed. The time push used to be unconditional, so a step shorter than XM_ZERO_TOL
-      // left the times array one longer and silently misaligned every later pair, which a
-      // caller reading them as parallel arrays cannot detect.
-      const bool moved = outTrace.empty() || !EQ_TOL(pt1.x, outTrace.back().x, XM_ZERO_TOL) ||
-                         !EQ_TOL(pt1.y, outTrace.back().y, XM_ZERO_TOL);
-      pt0 = pt1;
-      elapsedTime += deltaT;
-      vx0 = vx1;
-      vy0 = vy1;
-      deltaT *= 1.2;
-      mag0 = mag1;
-      if (moved)
+  for (int ptIdx : points)
+  {
+    m_pointMarks[ptIdx] = 0;
+    int count;
+    const int* triangles = geometry.GetPointTriangles(ptIdx, count);
+    for (int i = 0; i < count; ++i)
+    {
+      if (!m_triangleMarks[triangles[i]])
       {
-        outTrace.push_back(pt1);
-        outTimes.push_back(ptTime + elapsedTime);
+        m_triangleMarks[triangles[i]] = 1;
+        a_step.m_changedTriangles.push_back(triangles[i]);
       }
     }
-  } // while ()
-  stopWith(stopReason);
-} // XmGridTraceImpl::StepTrace
+  }
+  for (int triIdx : a_step.m_changedTriangles)
+    m_triangleMarks[triIdx] = 0;
+  a_step.m_statistics.m_addScalarsSeconds += iSecondsSince(start);
+  return true;
+} // XmGridTraceImpl::PrepareTimeStepChanges
 //------------------------------------------------------------------------------
-/// \brief Runs the Grid Trace for a point against the currently loaded time steps
-/// \param[in] a_pt The starting point of the trace
-/// \param[in] a_ptTime The starting time of the trace
-/// \param[out] a_outTrace the resultant positions at each step
-/// \param[out] a_outTimes the resultant times at each step
+/// \brief Makes a prepared time step the window's newest, dropping its oldest if the
+///        window is full.
+///
+/// Work in proportion to the triangle count, not to the conversion: the step before's
+/// coefficients are copied into the first half of the incoming step's table, and the
+/// prepared table is traded in rather than copied. The dropped step's buffers are reused
+/// for the incoming one, so a window of whole steps that is full allocates nothing.
+///
+/// A change is in proportion to the triangles it reached instead. Its table shares the step
+/// before's chunks, copying only those holding a refitted triangle, and it reads the step
+/// before's coefficients from that step's own table, as across data locations, rather
+/// than copying them alongside its own.
+/// \param[in,out] a_step The step from PrepareTimeStep; left holding scratch to reuse
 //------------------------------------------------------------------------------
-void XmGridTraceImpl::TracePoint(const Pt3d& a_pt,
-                                 const double& a_ptTime,
-                                 VecPt3d& a_outTrace,
-                                 VecDbl& a_outTimes)
+void XmGridTraceImpl::CommitTimeStep(PreparedTimeStep& a_step)
 {
-  TraceState state;
-  state.m_pt = a_pt;
-  state.m_ptTime = a_ptTime;
-  StepTrace(state);
-  a_outTrace.swap(state.m_trace);
-  a_outTimes.swap(state.m_times);
-} // XmGridTraceImpl::TracePoint
-//------------------------------------------------------------------------------
-/// \brief Begins tracing a batch of seeds against the currently loaded time steps
-/// \param[in] a_pts The starting point of each trace
-/// \param[in] a_ptTimes The starting time of each trace; must be one per point
+  const auto start = std::chrono::steady_clock::now();
+  const DataLocationEnum scalarLoc = a_step.m_scalarLoc;
+  std::shared_ptr<const XmGridTraceGeometry>& geometry =
+    scalarLoc == DataLocationEnum::LOC_POINTS ? m_pointGeometry : m_cellGeometry;
+  if (!geometry)
+    geometry = a_step.m_geometry;
+
+  // A whole step at or before the newest starts the window over, as when a caller scrubs
+  // back through a series: the steps after it no longer follow it. A change is layered on
+  // the newest step, so it cannot start over; PrepareTimeStepChanges refuses any that is
+  // not after it.
+  XM_ASSERT(!a_step.m_isChange || a_step.m_time > m_window.back().m_time);
+  if (!a_step.m_isChange && !m_window.empty() && a_step.m_time <= m_window.back().m_time)
+    m_window.clear();
+  if (m_window.size() >= (size_t)m_windowTimeSteps)
+  {
+    m_window.push_back(std::move(m_window.front()));
+    m_window.pop_front();
+    m_window.front().m_coefficients1.clear();
+  }
+  else
+    m_window.emplace_back();
+  WindowStep& step = m_window.back();
+  const WindowStep* previous = m_window.size() > 1 ? &m_window[m_window.size() - 2] : nullptr;
+  const bool sameGeometry = previous && previous->m_geometry == geometry;
+  if (a_step.m_isChange)
+  {
+    // A change starts from the step before, whose coefficients are also the incoming step's
+    // own wherever the change did not reach. The dropped step's table goes to be reused by
+    // the next whole step.
+    step.m_coefficients.Swap(a_step.m_coefficients);
+    step.m_coefficients = previous->m_coefficients;
+    for (int triIdx : a_step.m_changedTriangles)
+      iFitTriangle(*geometry, m_vectors, m_origin, triIdx,
+                   step.m_coefficients.GetMutableRow(triIdx) + 6);
+  }
+  else
+  {
+    step.m_coefficients.Swap(a_step.m_coefficients);
+    if (sameGeometry)
+    {
+      for (size_t triIdx = 0; triIdx < step.m_coefficients.GetSize(); ++triIdx)
+      {
+        const double* before = previous->GetCoefficients2(triIdx);
+        std::copy(before, before + 6, step.m_coefficients.GetMutableRow(triIdx));
+      }
+    }
+  }
+  // A change, or a step at the other data location, reads the step before from its own
+  // table, where its coefficients are the second half; offsetting by that half lets either
+  // be read alike.
+  step.m_coefficients1.clear();
+  if (previous)
+  {
+    const bool ownTable = sameGeometry && !a_step.m_isChange;
+    const SharedChunks<double>& table1 = ownTable ? step.m_coefficients : previous->m_coefficients;
+    for (size_t chunk = 0; chunk < table1.GetChunkCount(); ++chunk)
+      step.m_coefficients1.push_back(table1.GetChunk(chunk) + (ownTable ? 0 : 6));
+  }
+
+  step.m_time = a_step.m_time;
+  step.m_scalarLoc = scalarLoc;
+  step.m_geometry = geometry;
+  step.m_cellActivity.swap(a_step.m_cellActivity);
+  if (!a_step.m_isChange)
+  {
+    m_vectors.Swap(a_step.m_vectors);
+    m_inputX.Swap(a_step.m_inputX);
+    m_inputY.Swap(a_step.m_inputY);
+    m_inputActivity.swap(a_step.m_inputActivity);
+    m_inputActivityLoc = a_step.m_inputActivityLoc;
+  }
+  if (!previous || previous->m_cellActivity.empty())
+    step.m_exitActivity = step.m_cellActivity;
+  else if (step.m_cellActivity.empty())
+    step.m_exitActivity = previous->m_cellActivity;
+  else
+    step.m_exitActivity = previous->m_cellActivity & step.m_cellActivity;
+  m_snapshotStale = true;
+  if (!a_step.m_fromCache)
+    CacheTimeStep(a_step.m_dataset, step);
+  m_statistics.Add(a_step.m_statistics);
+  m_statistics.m_addScalarsSeconds += iSecondsSince(start);
+} // XmGridTraceImpl::CommitTimeStep
+//------------------------------------------------------------------------------
+/// \brief Keeps a step just committed in the time step cache, if it has a budget.
+///
+/// Replaces any step kept under the same dataset and time, then drops the least recently
+/// used steps until the cache is back within its budget.
+/// \param[in] a_dataset The time step dataset the step was added under
+/// \param[in] a_step The step, the window's newest
 //------------------------------------------------------------------------------
-void XmGridTraceImpl::StartTraces(const VecPt3d& a_pts, const VecDbl& a_ptTimes)
+void XmGridTraceImpl::CacheTimeStep(const std::string& a_dataset, const WindowStep& a_step)
 {
-  m_batch.clear();
-  if (a_pts.size() != a_ptTimes.size())
-  {
-    // Refusing the whole batch rather than seeding the common prefix: a caller that
-    // mismatched these has a bug, and a partial batch would let it go unnoticed.
-    XM_LOG(xmlog::error, "Gridtracer: StartTraces needs one start time per point.");
+  if (m_stepCacheBudget == 0)
     return;
+  const auto key = std::make_pair(a_dataset, a_step.m_time);
+  auto found = m_stepCacheIndex.find(key);
+  if (found != m_stepCacheIndex.end())
+  {
+    m_stepCacheBytes -= found->second->m_bytes;
+    m_stepCache.erase(found->second);
+    m_stepCacheIndex.erase(found);
   }
-  m_batch.resize(a_pts.size());
-  for (size_t i = 0; i < a_pts.size(); ++i)
+  // Counted in full, though a step may share most of its chunks with the one before, so the
+  // cache never holds more than its budget whichever of the two it drops.
+  const size_t bytes = a_step.m_coefficients.GetBytes() + m_vectors.GetBytes() +
+                       m_inputX.GetBytes() + m_inputY.GetBytes() +
+                       (a_step.m_cellActivity.size() + m_inputActivity.size()) / 8;
+  if (bytes > m_stepCacheBudget)
+    return;
+
+  m_stepCache.emplace_front();
+  CachedTimeStep& cached = m_stepCache.front();
+  cached.m_dataset = a_dataset;
+  cached.m_time = a_step.m_time;
+  cached.m_scalarLoc = a_step.m_scalarLoc;
+  cached.m_geometry = a_step.m_geometry;
+  cached.m_coefficients = a_step.m_coefficients;
+  cached.m_cellActivity = a_step.m_cellActivity;
+  cached.m_vectors = m_vectors;
+  cached.m_inputX = m_inputX;
+  cached.m_inputY = m_inputY;
+  cached.m_inputActivity = m_inputActivity;
+  cached.m_inputActivityLoc = m_inputActivityLoc;
+  cached.m_bytes = bytes;
+  m_stepCacheIndex[key] = m_stepCache.begin();
+  m_stepCacheBytes += bytes;
+  TrimTimeStepCache();
+} // XmGridTraceImpl::CacheTimeStep
+//------------------------------------------------------------------------------
+/// \brief Drops the least recently used steps of the time step cache until it is within
+///        its budget.
+//------------------------------------------------------------------------------
+void XmGridTraceImpl::TrimTimeStepCache()
+{
+  while (m_stepCacheBytes > m_stepCacheBudget && !m_stepCache.empty())
   {
-    m_batch[i].m_pt = a_pts[i];
-    m_batch[i].m_ptTime = a_ptTimes[i];
+    const CachedTimeStep& oldest = m_stepCache.back();
+    m_stepCacheBytes -= oldest.m_bytes;
+    m_stepCacheIndex.erase(std::make_pair(oldest.m_dataset, oldest.m_time));
+    m_stepCache.pop_back();
   }
-} // XmGridTraceImpl::StartTraces
+} // XmGridTraceImpl::TrimTimeStepCache
 //------------------------------------------------------------------------------
-/// \brief Advances every unfinished trace as far as the loaded time steps allow
-/// \return How many traces are waiting on a later time step
+/// \brief Waits for the step AddGridScalarsAtTimeAsync is preparing, if any, and commits
+///        it.
+///
+/// Rethrows whatever preparing it threw, in which case the step is dropped and the tracer
+/// is left as it was. Deferred, the error is kept for the next call instead, so a caller
+/// with results of its own to return can return them first.
+/// \param[in] a_deferError Whether to keep an error for the next call rather than throw it
 //------------------------------------------------------------------------------
-int XmGridTraceImpl::ContinueTraces()
+void XmGridTraceImpl::FinishPendingTimeStep(bool a_deferError)
 {
-  int waiting = 0;
-  for (auto& state : m_batch)
+  if (m_loader.joinable())
   {
-    StepTrace(state); // returns immediately for traces that are already finished
-    if (state.m_exitReason == GTEXIT_WAITING_FOR_TIME_STEP)
-      ++waiting;
+    const auto start = std::chrono::steady_clock::now();
+    m_loader.join();
+    m_statistics.m_timeStepWaitSeconds += iSecondsSince(start);
+    if (!m_loaderError)
+      CommitTimeStep(m_prepared);
   }
-  return waiting;
-} // XmGridTraceImpl::ContinueTraces
+  if (m_loaderError && !a_deferError)
+  {
+    std::exception_ptr error = m_loaderError;
+    m_loaderError = nullptr;
+    std::rethrow_exception(error);
+  }
+} // XmGridTraceImpl::FinishPendingTimeStep
 //------------------------------------------------------------------------------
-/// \brief Copies out the batch traced so far
-/// \param[out] a_outTraces The positions of each trace, one entry per seed
-/// \param[out] a_outTimes The times of each trace, parallel to a_outTraces
-/// \param[out] a_outExitReasons Why each trace stopped, one entry per seed
+/// \brief Blends the window's steps either side of the snapshot time into the snapshot
+///        field, if tracing against one and the window has changed since it was last
+///        blended.
+///
+/// A linear fit blended with another is the fit of the blended values, so blending each
+/// triangle's coefficients gives the same field as blending each evaluation, for one pass
+/// over the triangles instead of a second lookup per evaluation.
 //------------------------------------------------------------------------------
-void XmGridTraceImpl::GetTraceResults(std::vector<VecPt3d>& a_outTraces,
-                                      std::vector<VecDbl>& a_outTimes,
-                                      std::vector<XmGridTraceExitEnum>& a_outExitReasons) const
+void XmGridTraceImpl::PrepareSnapshot()
 {
-  a_outTraces.clear();
-  a_outTimes.clear();
-  a_outExitReasons.clear();
-  a_outTraces.reserve(m_batch.size());
-  a_outTimes.reserve(m_batch.size());
-  a_outExitReasons.reserve(m_batch.size());
-  for (const auto& state : m_batch)
+  if (!m_snapshot || !m_snapshotStale || m_window.size() < 2)
+    return;
+  m_snapshotStale = false;
+  m_snapshotBlendTime =
+    std::max(m_window.front().m_time, std::min(m_snapshotTime, m_window.back().m_time));
+  const size_t stepIdx = WindowStepAt(m_snapshotBlendTime);
+  const WindowStep& previous = m_window[stepIdx - 1];
+  const WindowStep& step = m_window[stepIdx];
+  if (previous.m_geometry != step.m_geometry)
   {
-    a_outTraces.push_back(state.m_trace);
-    a_outTimes.push_back(state.m_times);
-    a_outExitReasons.push_back(state.m_exitReason);
+    VecDbl().swap(m_snapshotCoefficients);
+    return;
   }
-} // XmGridTraceImpl::GetTraceResults
+  const double totalTime = fabs(previous.m_time - step.m_time);
+  const double weight1 = fabs(m_snapshotBlendTime - step.m_time) / totalTime;
+  const double weight2 = fabs(m_snapshotBlendTime - previous.m_time) / totalTime;
+  const size_t triCount = (size_t)step.m_geometry->GetTriangleCount();
+  m_snapshotCoefficients.resize(triCount * 6);
+  for (size_t triIdx = 0; triIdx < triCount; ++triIdx)
+  {
+    const double* c1 = step.GetCoefficients1(triIdx);
+    const double* c2 = step.GetCoefficients2(triIdx);
+    double* out = &m_snapshotCoefficients[triIdx * 6];
+    for (int k = 0; k < 6; ++k)
+      out[k] = c1[k] * weight1 + c2[k] * weight2;
+  }
+} // XmGridTraceImpl::PrepareSnapshot
 //------------------------------------------------------------------------------
-/// \brief Returns the velocity scalar for a given point and time
-/// \param[in] a_pt The point
-/// \param[in] a_currentTime The time at extraction
-/// \param[out] a_data the resultant velocity scalar
+/// \brief Returns which of the window's steps ends the interval a time falls in.
+///
+/// The first step after the window's first that is at or after the time, so a time on a
+/// step blends entirely to it from either side; times before the window fall in its first
+/// interval and times after it in its last. Needs at least two steps.
+/// \param[in] a_time The time
+/// \return the index in m_window of the later of the two steps bracketing a_time
 //------------------------------------------------------------------------------
-bool XmGridTraceImpl::GetVectorAtLocationAndTime(const xms::Pt3d& a_pt,
-                                                 double a_currentTime,
-                                                 xms::Pt3d& a_data) const
+size_t XmGridTraceImpl::WindowStepAt(double a_time) const
 {
-  if (!m_extractor1x || !m_extractor1y || !m_extractor2x || !m_extractor2y)
-  {
-    // Two time steps are required. This used to dereference a null first extractor when only
-    // one had been supplied.
-    XM_LOG(xmlog::error, "Gridtracer: two time steps must be added before tracing.");
-    return false;
-  }
-
-  // One point-location query per distinct triangulation, rather than one per scalar array.
-  // The weights returned index the triangulation's points, and every extractor sharing that
-  // triangulation indexes its own scalars the same way, so a single query serves the x and y
-  // of a time step -- and both time steps too when they share a triangulation.
-  float x1 = m_extractor1x->GetNoDataValue();
-  float y1 = m_extractor1y->GetNoDataValue();
-  const int cell1 =
-    m_extractor1x->GetUGridTriangles()->GetIntersectedCell(a_pt, m_searchIdxs, m_searchWeights);
-  XMGT_COUNT_SEARCH(1);
-  if (cell1 >= 0)
-    iApplyWeights(*m_extractor1x, *m_extractor1y, m_searchIdxs, m_searchWeights, x1, y1);
+  if (m_window.size() == 2)
+    return 1;
+  auto later = std::lower_bound(
+    m_window.begin() + 1, m_window.end() - 1, a_time,
+    [](const WindowStep& a_step, double a_t) { return a_step.m_time < a_t; });
+  return (size_t)(later - m_window.begin());
+} // XmGridTraceImpl::WindowStepAt
 
-  float x2 = m_extractor2x->GetNoDataValue();
-  float y2 = m_extractor2y->GetNoDataValue();
-  if (m_sharedAcrossTime)
+//------------------------------------------------------------------------------
+/// \brief Advances a run of traces as far as the currently loaded pair of time steps
+///        allows, a_width of them at a time in lockstep.
+///
+/// Const, and writing only to the run's traces and to a_ctx, so ContinueTraces can step
+/// different runs on different threads. Exit reasons land on the batch; the callers copy
+/// them to the tracer.
+///
+/// Each round, every live lane proposes its next step, the lanes that need the field at
+/// their candidate point get it from one EvaluatePacket call, and then each lane accepts,
+/// splits or stops. A lane that stops is refilled from the run at once, so the packet stays
+/// full while the run lasts however much its traces' lengths differ.
+///
+/// A lane runs exactly the arithmetic it would run in a packet of one: the phases are the
+/// same functions, and only how many lanes share an evaluation differs. So the results do
+/// not depend on a_width.
+/// \param[in,out] a_ctx Scratch for the calling thread
+/// \param[in,out] a_batch The batch the traces are in
+/// \param[in] a_traces The traces to advance, in the order to begin them
+/// \param[in] a_count How many traces a_traces has
+/// \param[in] a_width Lanes per packet; clamped to 1..kMaxPacketWidth
+//------------------------------------------------------------------------------
+void XmGridTraceImpl::StepTraces(TraceContext& a_ctx,
+                                 TraceBatch& a_batch,
+                                 const size_t* a_traces,
+                                 size_t a_count,
+                                 int a_width) const
+{
+  const int width = std::max(1, std::min(a_width, kMaxPacketWidth));
+  TraceLane lanes[kMaxPacketWidth];
+  TraceLane* evaluate[kMaxPacketWidth];
+  int live = 0;
+  size_t next = 0;
+  auto countStop = [&](size_t a_trace) {
+    ++a_ctx.m_statistics.m_exitReasons[a_batch.m_exitReasons[a_trace]];
+  };
+  for (;;)
   {
-    if (cell1 >= 0)
-      iApplyWeights(*m_extractor2x, *m_extractor2y, m_searchIdxs, m_searchWeights, x2, y2);
+    while (live < width && next < a_count)
+    {
+      const size_t trace = a_traces[next++];
+      if (iIsTerminal(a_batch.m_exitReasons[trace]))
+        continue; // stopped in an earlier window, and counted then
+      if (BeginLane(a_ctx, a_batch, trace, lanes[live]))
+        ++live;
+      else
+        countStop(trace);
+    }
+    if (live == 0)
+      return;
+
+    // A stopped lane is replaced by the last one, which has not been proposed yet this round,
+    // so the slot is looked at again rather than skipped.
+    int evaluateCount = 0;
+    for (int i = 0; i < live;)
+    {
+      lanes[i].m_phase = ProposeStep(a_ctx, lanes[i]);
+      if (lanes[i].m_phase == LANE_STOPPED)
+      {
+        countStop(lanes[i].m_trace);
+        lanes[i] = lanes[--live];
+        continue;
+      }
+      if (lanes[i].m_phase == LANE_EVALUATE)
+        evaluate[evaluateCount++] = &lanes[i];
+      ++i;
+    }
+    const bool extracted = evaluateCount == 0 || EvaluatePacket(a_ctx, evaluate, evaluateCount);
+    for (int i = 0; i < live;)
+    {
+      if (lanes[i].m_phase != LANE_RETRY && !FinishStep(a_ctx, lanes[i], extracted))
+      {
+        countStop(lanes[i].m_trace);
+        lanes[i] = lanes[--live];
+        continue;
+      }
+      ++i;
+    }
   }
-  else
+} // XmGridTraceImpl::StepTraces
+//------------------------------------------------------------------------------
+/// \brief Hands the vertices a lane holds to its batch's sink, and the end of its trace if
+///        the trace has ended for good.
+/// \param[in,out] a_lane The lane
+/// \param[in] a_reason Why the trace stopped, or GTEXIT_NOT_STARTED if it is still going
+//------------------------------------------------------------------------------
+void iFlushLane(TraceLane& a_lane, XmGridTraceExitEnum a_reason)
+{
+  TraceBatch& batch = *a_lane.m_batch;
+  const bool ended = iIsTerminal(a_reason);
+  if (a_lane.m_runCount == 0 && !ended)
+    return;
+  std::lock_guard<std::mutex> lock(batch.m_sinkMutex);
+  if (a_lane.m_runCount > 0)
+    batch.m_sink->OnVertices(a_lane.m_trace, a_lane.m_run, a_lane.m_runCount);
+  a_lane.m_runCount = 0;
+  if (ended)
+    batch.m_sink->OnTraceEnd(a_lane.m_trace, a_reason);
+} // iFlushLane
+//------------------------------------------------------------------------------
+/// \brief Keeps a vertex of a lane's trace: in the batch's arena, or in the lane for the
+///        batch's sink. The vertex becomes the anchor simplification measures from.
+/// \param[in,out] a_lane The lane
+/// \param[in] a_x The vertex's x
+/// \param[in] a_y The vertex's y
+/// \param[in] a_time The vertex's time
+//------------------------------------------------------------------------------
+void iKeepVertex(TraceLane& a_lane, double a_x, double a_y, double a_time)
+{
+  TraceBatch& batch = *a_lane.m_batch;
+  if (batch.m_sink)
   {
-    const int cell2 =
-      m_extractor2x->GetUGridTriangles()->GetIntersectedCell(a_pt, m_searchIdxs, m_searchWeights);
-    XMGT_COUNT_SEARCH(1);
-    if (cell2 >= 0)
-      iApplyWeights(*m_extractor2x, *m_extractor2y, m_searchIdxs, m_searchWeights, x2, y2);
+    if (a_lane.m_runCount == kSinkRun)
+      iFlushLane(a_lane, GTEXIT_NOT_STARTED);
+    double* xyt = &a_lane.m_run[3 * a_lane.m_runCount++];
+    xyt[0] = a_x;
+    xyt[1] = a_y;
+    xyt[2] = a_time;
   }
+  else
+    batch.m_vertices.Append(a_lane.m_trace, a_x, a_y, a_time);
+  a_lane.m_hasAnchor = true;
+  a_lane.m_anchorX = a_x;
+  a_lane.m_anchorY = a_y;
+  a_lane.m_hasPending = false;
+  a_lane.m_hasCone = false;
+  a_lane.m_maxAnchorDistance = 0;
+} // iKeepVertex
+//------------------------------------------------------------------------------
+/// \brief Whether a line from a lane's anchor through a vertex passes within the tolerance
+///        of every vertex accepted since the anchor, narrowing the cone to suit if it does.
+///
+/// The directions from the anchor whose line passes within the tolerance of a vertex at
+/// distance d form a wedge of half-angle asin(tolerance / d) about the vertex's own
+/// direction; a vertex within the tolerance of the anchor allows every direction. The
+/// cone is the intersection of those wedges, so the line through the new vertex is good
+/// for them all exactly when its direction is in the cone. That bounds the distance to the
+/// line rather than to the segment, which would let a trace that doubles back on itself
+/// lose the excursion; a vertex beyond the tolerance but closer to the anchor than an
+/// earlier one therefore ends the segment too. Every vertex left out is then within the
+/// tolerance of the segment that replaces it.
+/// \param[in,out] a_lane The lane
+/// \param[in] a_x The vertex's x
+/// \param[in] a_y The vertex's y
+/// \return true if the vertex extends the segment from the anchor
+//------------------------------------------------------------------------------
+bool iExtendsSegment(TraceLane& a_lane, double a_x, double a_y)
+{
+  const double dx = a_x - a_lane.m_anchorX;
+  const double dy = a_y - a_lane.m_anchorY;
+  const double distance = sqrt(dx * dx + dy * dy);
+  const double tolerance = a_lane.m_tolerance;
+  if (distance <= tolerance)
+    return true;
+  if (distance < a_lane.m_maxAnchorDistance)
+    return false;
+  a_lane.m_maxAnchorDistance = distance;
 
-  if (a_currentTime < m_time1 - XM_ZERO_TOL)
-  {
-    XM_LOG(xmlog::warning, "Gridtracer: The given time is before the first time step.");
-    a_currentTime = m_time1;
-  }
-  // A location outside the grid or in an inactive cell in *either* bracketing timestep has no
-  // usable velocity, and the sentinel must be propagated rather than weighted: blending
-  // XM_NODATA (-9999999) against a real value produces something like -999999.9, which is
-  // neither no-data nor meaningful, and every caller tests for XM_NODATA exactly. Returning
-  // true is correct -- extraction succeeded, and no-data is the answer.
-  if (EQ_TOL(x1, XM_NODATA, 1) || EQ_TOL(y1, XM_NODATA, 1) || EQ_TOL(x2, XM_NODATA, 1) ||
-      EQ_TOL(y2, XM_NODATA, 1))
+  const double direction = atan2(dy, dx);
+  const double halfAngle = asin(tolerance / distance);
+  if (!a_lane.m_hasCone)
   {
-    a_data.x = XM_NODATA;
-    a_data.y = XM_NODATA;
+    a_lane.m_hasCone = true;
+    a_lane.m_coneDirection = direction;
+    a_lane.m_coneLow = -halfAngle;
+    a_lane.m_coneHigh = halfAngle;
     return true;
   }
-
-  double totalTime = fabs(m_time1 - m_time2);
-  // Each timestep is weighted by its *closeness* to the current time, so the distance from
-  // one timestep is the weight of the other: at a_currentTime == m_time1 the field is
-  // entirely timestep 1's. Weighting each timestep by its own distance instead -- which is
-  // what this did until the weights were swapped -- inverts the interpolation, advecting a
-  // particle released at m_time1 entirely by the field at m_time2.
-  double weight1 = fabs(a_currentTime - m_time2) / totalTime;
-  double weight2 = fabs(a_currentTime - m_time1) / totalTime;
-  a_data.x = x1 * weight1 + x2 * weight2;
-  a_data.y = y1 * weight1 + y2 * weight2;
+  const double offset = remainder(direction - a_lane.m_coneDirection, 2 * XM_PI);
+  if (offset < a_lane.m_coneLow || offset > a_lane.m_coneHigh)
+    return false;
+  a_lane.m_coneLow = std::max(a_lane.m_coneLow, offset - halfAngle);
+  a_lane.m_coneHigh = std::min(a_lane.m_coneHigh, offset + halfAngle);
   return true;
-} // XmGridTraceImpl::GetVectorAtLocationAndTime
-} // namespace {}
-////////////////////////////////////////////////////////////////////////////////
-/// \class XmGridTrace
-/// \brief Traces points in an XmUGrid following a vector dataset
-////////////////////////////////////////////////////////////////////////////////
+} // iExtendsSegment
 //------------------------------------------------------------------------------
-/// \brief Empty constructer for abstract class
+/// \brief Records a vertex of a lane's trace, keeping it at once or, when simplifying,
+///        holding it back until a later vertex shows whether it is needed.
+/// \param[in,out] a_lane The lane
+/// \param[in] a_x The vertex's x
+/// \param[in] a_y The vertex's y
+/// \param[in] a_time The vertex's time
 //------------------------------------------------------------------------------
-XmGridTrace::XmGridTrace()
+void iRecordVertex(TraceLane& a_lane, double a_x, double a_y, double a_time)
 {
-} // XmGridTrace::XmGridTrace
-//------------------------------------------------------------------------------
-/// \brief Empty destructer for abstract class
-//------------------------------------------------------------------------------
-XmGridTrace::~XmGridTrace()
-{
-} // XmGridTrace::~XmGridTrace
+  a_lane.m_lastX = a_x;
+  a_lane.m_lastY = a_y;
+  if (a_lane.m_tolerance <= 0 || !a_lane.m_hasAnchor)
+  {
+    iKeepVertex(a_lane, a_x, a_y, a_time);
+    return;
+  }
+  if (!iExtendsSegment(a_lane, a_x, a_y))
+  {
+    // The pending vertex is where the segment has to bend; the new one always extends a
+    // segment starting there, since nothing has narrowed its cone yet.
+    iKeepVertex(a_lane, a_lane.m_pending[0], a_lane.m_pending[1], a_lane.m_pending[2]);
+    iExtendsSegment(a_lane, a_x, a_y);
+  }
+  a_lane.m_hasPending = true;
+  a_lane.m_pending[0] = a_x;
+  a_lane.m_pending[1] = a_y;
+  a_lane.m_pending[2] = a_time;
+} // iRecordVertex
 //------------------------------------------------------------------------------
-/// \brief Construct from a new XmGridTrace using a UGrid.
-/// \param[in] a_ugrid The UGrid to construct a grid trace for
-/// \return a boost shared pointer to an XmGridTrace
+/// \brief Drops the vertices recorded for a lane's trace. Those already handed to a sink
+///        are the sink's to drop, when told the trace failed.
+/// \param[in,out] a_lane The lane
 //------------------------------------------------------------------------------
-BSHP<XmGridTrace> XmGridTrace::New(std::shared_ptr<XmUGrid> a_ugrid)
+void iDiscardVertices(TraceLane& a_lane)
 {
-  return BSHP<XmGridTraceImpl>(new XmGridTraceImpl(a_ugrid));
-} // XmGridTrace::New
+  a_lane.m_batch->m_vertices.Clear(a_lane.m_trace);
+  a_lane.m_runCount = 0;
+  a_lane.m_hasAnchor = false;
+  a_lane.m_hasPending = false;
+} // iDiscardVertices
 //------------------------------------------------------------------------------
-/// \brief Returns a human-readable description of an exit reason.
-/// \param[in] a_reason The exit reason
-/// \return a description suitable for a log or a tooltip
+/// \brief Writes a lane back to its trace, which stops for a_reason.
+///
+/// Every way a trace stops goes through here, so there is no path that advances a trace
+/// without recording where it got to.
+/// \param[in,out] a_lane The lane
+/// \param[in] a_reason Why the trace stops, or that it is waiting
 //------------------------------------------------------------------------------
-const char* XmGridTraceExitReasonToString(XmGridTraceExitEnum a_reason)
+void iStopLane(TraceLane& a_lane, XmGridTraceExitEnum a_reason)
 {
-  switch (a_reason)
-  {
-  case GTEXIT_NOT_STARTED:
-    return "Trace has not started.";
-  case GTEXIT_WAITING_FOR_TIME_STEP:
-    return "Trace reached the second time step and is waiting for a later one.";
-  case GTEXIT_MAX_TRACING_TIME:
-    return "Exceeded or reached max tracing time.";
-  case GTEXIT_MAX_TRACING_DISTANCE:
-    return "Point has reached or exceeded the max tracing distance.";
-  case GTEXIT_LEFT_GRID:
-    return "Point has traveled out of domain.";
-  case GTEXIT_ZERO_VELOCITY:
-    return "Velocity has gone to zero.";
-  case GTEXIT_MIN_DELTA_TIME:
-    return "Delta time was less than min delta time.";
-  case GTEXIT_SEED_NOT_TRACEABLE:
-    return "Point does not start inside an active cell.";
-  case GTEXIT_EXTRACTION_FAILED:
-    return "Error occurred while extracting a vector.";
-  }
-  return "Unknown exit reason.";
-} // XmGridTraceExitReasonToString
-
-} // namespace xms
-#ifdef CXX_TEST
-#include <xmsgridtrace/gridtrace/XmGridTrace.t.h>
+  // Where a trace stops is kept even when simplifying, so that the results are whole at
+  // every stop and a resumed trace anchors where it left off.
+  if (a_lane.m_hasPending)
+    iKeepVertex(a_lane, a_lane.m_pending[0], a_lane.m_pending[1], a_lane.m_pending[2]);
+  TraceBatch& batch = *a_lane.m_batch;
+  const size_t i = a_lane.m_trace;
+  batch.m_x[i] = a_lane.m_pt0.x;
+  batch.m_y[i] = a_lane.m_pt0.y;
+  batch.m_deltaT[i] = a_lane.m_deltaT;
+  batch.m_elapsedTime[i] = a_lane.m_elapsedTime;
+  batch.m_distTraveled[i] = a_lane.m_distTraveled;
+  batch.m_vx[i] = a_lane.m_vx0;
+  batch.m_vy[i] = a_lane.m_vy0;
+  batch.m_mag[i] = a_lane.m_mag0;
+  batch.m_exitReasons[i] = a_reason;
+  batch.m_exitCells[i] = a_reason == GTEXIT_LEFT_GRID ? a_lane.m_exitCell : -1;
+  batch.m_exitCellEdges[i] = a_reason == GTEXIT_LEFT_GRID ? a_lane.m_exitCellEdge : -1;
+  batch.m_lastX[i] = a_lane.m_lastX;
+  batch.m_lastY[i] = a_lane.m_lastY;
+  if (batch.m_sink)
+    iFlushLane(a_lane, a_reason);
+} // iStopLane
+//------------------------------------------------------------------------------
+/// \brief Loads a trace into a lane, evaluating and recording its seed if it is fresh.
+///
+/// Starting a trace and resuming one differ only here: a fresh state has to evaluate and
+/// record its seed, while a resumed one already carries a position, its budgets, its step
+/// size and its previous velocity.
+/// \param[in,out] a_ctx Scratch for the calling thread
+/// \param[in,out] a_batch The batch the trace is in
+/// \param[in] a_trace Which trace of a_batch
+/// \param[out] a_lane The lane to load it into
+/// \return false if the trace has nothing to step, having finished or stopped at its seed
+//------------------------------------------------------------------------------
+bool XmGridTraceImpl::BeginLane(TraceContext& a_ctx,
+                                TraceBatch& a_batch,
+                                size_t a_trace,
+                                TraceLane& a_lane) const
+{
+  if (iIsTerminal(a_batch.m_exitReasons[a_trace]))
+    return false;
 
-#include <chrono>
-#include <cstdlib>
-#include <iomanip>
-#include <iostream>
-#include <algorithm>
-#include <map>
+  a_lane = TraceLane();
+  a_lane.m_batch = &a_batch;
+  a_lane.m_trace = a_trace;
+  a_lane.m_pt0 = Pt3d(a_batch.m_x[a_trace], a_batch.m_y[a_trace], 0.0);
+  a_lane.m_deltaT = a_batch.m_deltaT[a_trace];
+  // A window that ended exactly on the trace's time left deltaT clamped to zero (see the time
+  // step clamp in ProposeStep), and zero cannot be carried into the next window: a zero-length
+  // step moves nothing and changes no velocity, so it satisfies none of the loop's exit
+  // tests -- not the clamps, which need elapsedTime to advance, and not the subdivision
+  // tests, which compare a step against the one before it and would see no change. The loop
+  // would spin forever. Start the next window from the initial step and let the clamps size
+  // it again, which is what a fresh trace does.
+  if (a_lane.m_deltaT <= 0)
+    a_lane.m_deltaT = kInitialDeltaT;
+  a_lane.m_elapsedTime = a_batch.m_elapsedTime[a_trace];
+  a_lane.m_distTraveled = a_batch.m_distTraveled[a_trace];
+  a_lane.m_vx0 = a_batch.m_vx[a_trace];
+  a_lane.m_vy0 = a_batch.m_vy[a_trace];
+  a_lane.m_mag0 = a_batch.m_mag[a_trace];
+  a_lane.m_lastX = a_batch.m_lastX[a_trace];
+  a_lane.m_lastY = a_batch.m_lastY[a_trace];
+  a_lane.m_tolerance = m_simplificationTolerance;
+  // A resumed trace goes on from its last vertex, which its stop kept.
+  a_lane.m_hasAnchor = a_batch.m_started[a_trace] != 0;
+  a_lane.m_anchorX = a_lane.m_lastX;
+  a_lane.m_anchorY = a_lane.m_lastY;
+  a_lane.m_maxAngleChange = cos(m_maxChangeDirectionInRadians);
+
+  if (!a_batch.m_started[a_trace])
+  {
+    const double ptTime = a_batch.m_ptTime[a_trace];
+    iDiscardVertices(a_lane);
+    if (!m_snapshot && ptTime > (m_window.empty() ? -1.0 : m_window.back().m_time))
+    {
+      // The seed is released after the loaded window, so its field is not known yet. That is
+      // the same situation the time step clamp reports as WAITING, and it has to be reported
+      // the same way here: EXTRACTION_FAILED is terminal (see iIsTerminal), so a seed given
+      // a later release time than the current window would never start, even once the time
+      // step covering it arrived. StartTraces takes a release time per seed precisely so a
+      // batch can be staggered, which makes this a normal input, not an error.
+      iStopLane(a_lane, GTEXIT_WAITING_FOR_TIME_STEP);
+      return false;
+    }
+    Pt3d vector;
+    // Ensure extraction did not fail
+    if (!GetVectorAtLocationAndTime(a_ctx, &a_batch.m_triangles[2 * a_trace], a_lane.m_pt0, ptTime,
+                                    vector))
+    {
+      iStopLane(a_lane, GTEXIT_EXTRACTION_FAILED);
+      return false;
+    }
+    if (EQ_TOL(vector.x, XM_NODATA, 1) || EQ_TOL(vector.y, XM_NODATA, 1))
+    {
+      iStopLane(a_lane, GTEXIT_SEED_NOT_TRACEABLE);
+      return false;
+    }
 
-#include <xmscore/testing/TestTools.h>
-#include <xmsextractor/ugrid/XmUGridTriangles2d.h>
-#include <xmsgrid/ugrid/XmUGrid.h>
+    iRecordVertex(a_lane, a_lane.m_pt0.x, a_lane.m_pt0.y, ptTime);
 
-using namespace xms;
-namespace
-{
+    a_lane.m_vx0 = vector.x * m_vectorMultiplier;
+    a_lane.m_vy0 = vector.y * m_vectorMultiplier;
+    a_lane.m_mag0 = sqrt(vector.x * vector.x + vector.y * vector.y);
+    a_batch.m_started[a_trace] = true;
+  }
+  return true;
+} // XmGridTraceImpl::BeginLane
 //------------------------------------------------------------------------------
-/// \brief Returns a tracer for a default cell
-/// \param[out] a_tracer The tracer for a default cell
+/// \brief Sizes a lane's next step and finds its candidate point.
+///
+/// An Euler step only finds the point, leaving the field there to EvaluatePacket; a
+/// Runge-Kutta step evaluates its own stages, since they depend on one another.
+/// \param[in,out] a_ctx Scratch for the calling thread
+/// \param[in,out] a_lane The lane
+/// \return what the lane needs next
 //------------------------------------------------------------------------------
-void iCreateDefaultSingleCell(BSHP<XmGridTrace>& a_tracer)
+TraceLanePhase XmGridTraceImpl::ProposeStep(TraceContext& a_ctx, TraceLane& a_lane) const
 {
-  //  3----2
-  //  | 1 /|
-  //  |  / |
-  //  | /  |
-  //  |/ 0 |
-  //  0----1
-  VecPt3d points = {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}};
-  VecInt cells = {XMU_TRIANGLE, 3, 0, 1, 2, XMU_TRIANGLE, 3, 2, 3, 0};
-  std::shared_ptr<XmUGrid> ugrid = XmUGrid::New(points, cells);
-  a_tracer = XmGridTrace::New(ugrid);
-  const double vm = 1;
-  a_tracer->SetVectorMultiplier(vm);
-  TS_ASSERT_EQUALS(a_tracer->GetVectorMultiplier(), vm);
-
-  const double tt = 100;
-  a_tracer->SetMaxTracingTime(tt);
-  TS_ASSERT_EQUALS(a_tracer->GetMaxTracingTime(), tt);
-
-  const double td = 100;
-  a_tracer->SetMaxTracingDistance(td);
-  TS_ASSERT_EQUALS(a_tracer->GetMaxTracingDistance(), td);
-
-  const double dt = .1;
-  a_tracer->SetMinDeltaTime(dt);
-  TS_ASSERT_EQUALS(a_tracer->GetMinDeltaTime(), dt);
+  TraceBatch& batch = *a_lane.m_batch;
+  const size_t trace = a_lane.m_trace;
+  const double ptTime = batch.m_ptTime[trace];
+  double& deltaT = a_lane.m_deltaT;
+  const double elapsedTime = a_lane.m_elapsedTime;
+  if (m_maxChangeDistance > 0)
+  {
+    // make sure deltaT is small enough to not go past the max dist
+    double d2 = m_maxChangeDistance * m_maxChangeDistance;
+    double denom = (a_lane.m_vx0 * a_lane.m_vx0) + (a_lane.m_vy0 * a_lane.m_vy0) +
+                   (m_maxChangeDistance * XM_ZERO_TOL);
+    double dt = sqrt(d2 / denom);
+    if (deltaT > dt)
+      deltaT = dt;
+  }
+  // If the change in DeltaT would push us beyond the window's newest time step, set it to hit
+  // that step; the steps before it are stepped across. A snapshot's field does not change
+  // with time, so it has no time step to stop at.
+  const double windowEnd = m_window.back().m_time;
+  if (!m_snapshot && elapsedTime + deltaT + ptTime > windowEnd)
+  {
+    deltaT = windowEnd - elapsedTime - ptTime;
+    if (deltaT <= 0)
+    {
+      // Nothing left in this window -- the trace is already sitting exactly on its end,
+      // which is what a second ContinueTraces with no new data finds. Stop before stepping,
+      // and put back the step size this call came in with: a zero-length step would append
+      // nothing anyway, and persisting the zero is what used to leave the resumed trace
+      // unable to advance at all. Restoring it is what makes a redundant ContinueTraces
+      // genuinely do no useful work, rather than quietly changing the path that follows.
+      deltaT = batch.m_deltaT[trace];
+      iStopLane(a_lane, GTEXIT_WAITING_FOR_TIME_STEP);
+      return LANE_STOPPED;
+    }
+    a_lane.m_continue = false; // This will be the last point traced in this window
+    a_lane.m_stopReason = GTEXIT_WAITING_FOR_TIME_STEP;
+  }
+  // If the change in delta time would push beyond the max tracing time, set it to hit max
+  // tracing time
+  double maxTracingTime = m_maxTracingTime;
+  if (m_snapshot && m_maxTracingTime <= 0 && m_maxTracingDistance <= 0)
+    maxTracingTime = windowEnd - m_window.front().m_time;
+  if (maxTracingTime > 0 && (elapsedTime + deltaT) > maxTracingTime)
+  {
+    deltaT = maxTracingTime - elapsedTime;
+    a_lane.m_continue = false; // This will be the last point traced
+    a_lane.m_stopReason = GTEXIT_MAX_TRACING_TIME;
+  }
 
-  const double cd = 100;
-  a_tracer->SetMaxChangeDistance(cd);
-  TS_ASSERT_EQUALS(a_tracer->GetMaxChangeDistance(), cd);
+  // Runge-Kutta when selected, except for a step some stage of which falls outside the
+  // grid or in an inactive cell. That step is taken with Euler instead, whose single
+  // evaluation at the candidate point is what the boundary exit in FinishStep is built
+  // around, so leaving the grid ends a trace the same way whatever the integrator.
+  a_lane.m_error = 0;
+  a_lane.m_integrated =
+    m_integrator != GTINT_EULER &&
+    IntegrateStep(a_ctx, &batch.m_triangles[2 * trace], a_lane.m_pt0, ptTime + elapsedTime,
+                  a_lane.m_vx0, a_lane.m_vy0, deltaT, a_lane.m_pt1, a_lane.m_vector,
+                  a_lane.m_error);
+  if (a_lane.m_integrated && m_integrator == GTINT_DORMAND_PRINCE && a_lane.m_error > 1.0)
+  {
+    // Rejected: pt0 and the velocity there are unchanged, so the retry reuses them. Like a
+    // split, this voids any stop decided earlier in the step.
+    ++a_ctx.m_statistics.m_rejectedSteps;
+    ++a_ctx.m_statistics.m_errorRejections;
+    a_lane.m_continue = true;
+    a_lane.m_stopReason = GTEXIT_WAITING_FOR_TIME_STEP;
+    deltaT *= std::max(kMinStepFactor, 0.9 * pow(a_lane.m_error, -0.2));
+    if (m_minDeltaTime > 0 && deltaT < m_minDeltaTime)
+    {
+      iStopLane(a_lane, GTEXIT_MIN_DELTA_TIME);
+      return LANE_STOPPED;
+    }
+    return LANE_RETRY;
+  }
+  if (a_lane.m_integrated)
+    return LANE_EVALUATED;
+
+  // compute candidate point
+  a_lane.m_pt1.x = a_lane.m_pt0.x + deltaT * a_lane.m_vx0;
+  a_lane.m_pt1.y = a_lane.m_pt0.y + deltaT * a_lane.m_vy0;
+  a_lane.m_evalTime = ptTime + elapsedTime + deltaT;
+  return LANE_EVALUATE;
+} // XmGridTraceImpl::ProposeStep
+//------------------------------------------------------------------------------
+/// \brief Accepts, splits or ends a lane's step once the field at its candidate point is
+///        known.
+/// \param[in,out] a_ctx Scratch for the calling thread
+/// \param[in,out] a_lane The lane
+/// \param[in] a_extracted Whether the candidate point's field could be extracted
+/// \return true if the lane goes on to another step, false if its trace stopped
+//------------------------------------------------------------------------------
+bool XmGridTraceImpl::FinishStep(TraceContext& a_ctx, TraceLane& a_lane, bool a_extracted) const
+{
+  TraceBatch& batch = *a_lane.m_batch;
+  const size_t trace = a_lane.m_trace;
+  int* triangles = &batch.m_triangles[2 * trace];
+  const double ptTime = batch.m_ptTime[trace];
+  Pt3d& pt0 = a_lane.m_pt0;
+  Pt3d& pt1 = a_lane.m_pt1;
+  Pt3d& vtkVec = a_lane.m_vector;
+  double& deltaT = a_lane.m_deltaT;
+  double& elapsedTime = a_lane.m_elapsedTime;
+  const bool integrated = a_lane.m_integrated;
+  if (!integrated && !a_extracted)
+  {
+    iDiscardVertices(a_lane);
+    iStopLane(a_lane, GTEXIT_EXTRACTION_FAILED);
+    return false;
+  }
+  // if pt1 outside of domain, compute new deltaT to get to boundary. Where the last candidate
+  // point left the grid is only kept if the trace then stops there: a split after the exit
+  // can pull the step back inside.
+  if (!integrated && (EQ_TOL(vtkVec.x, XM_NODATA, 1) || EQ_TOL(vtkVec.y, XM_NODATA, 1)))
+  {
+    double t = 0;
+    ++a_ctx.m_statistics.m_boundaryExits;
+    if (!FindExit(a_ctx, triangles, pt0, pt1, ptTime + elapsedTime + deltaT, t, a_lane.m_exitCell,
+                  a_lane.m_exitCellEdge))
+    {
+      XMGT_LOG(xmlog::error, "Gridtracer failed to find an intersection when exiting grid.");
+      iStopLane(a_lane, GTEXIT_LEFT_GRID);
+      return false;
+    }
+    pt1.x = pt0.x + t * (pt1.x - pt0.x);
+    pt1.y = pt0.y + t * (pt1.y - pt0.y);
+    deltaT *= t;
+    a_lane.m_continue = false;
+    a_lane.m_stopReason = GTEXIT_LEFT_GRID;
+    if (!GetVectorAtLocationAndTime(a_ctx, triangles, pt1, ptTime + elapsedTime + deltaT, vtkVec) ||
+        vtkVec.x == XM_NODATA || vtkVec.y == XM_NODATA)
+    {
+      iStopLane(a_lane, GTEXIT_EXTRACTION_FAILED);
+      return false;
+    }
+  }
+  double vx1 = vtkVec.x;
+  double vy1 = vtkVec.y;
+  vx1 *= m_vectorMultiplier;
+  vy1 *= m_vectorMultiplier;
 
-  const double cv = 100;
-  a_tracer->SetMaxChangeVelocity(cv);
-  TS_ASSERT_EQUALS(a_tracer->GetMaxChangeVelocity(), cv);
+  if (EQ_TOL(vx1, 0.0, .0001) && EQ_TOL(vy1, 0.0, .0001)) // No velocity
+  {
+    ++a_ctx.m_statistics.m_acceptedSteps;
+    iRecordVertex(a_lane, pt1.x, pt1.y, ptTime + elapsedTime + deltaT);
+    pt0 = pt1;
+    elapsedTime += deltaT;
+    iStopLane(a_lane, GTEXIT_ZERO_VELOCITY);
+    return false;
+  }
+  bool bSplit = false;
 
-  const double cdir = 1.5 * XM_PI;
-  a_tracer->SetMaxChangeDirectionInRadians(cdir);
-  TS_ASSERT_EQUALS(a_tracer->GetMaxChangeDirectionInRadians(), cdir);
+  const double mag1 = sqrt(vx1 * vx1 + vy1 * vy1);
 
-  double time = 0;
-  VecPt3d scalars = {{1, 1, 0}, {1, 1, 0}, {1, 1, 0}, {1, 1, 0}};
-  DynBitset pointActivity;
-  for (int i = 0; i < 4; ++i)
+  // do we subdivide? Not for an error-controlled step, which was accepted on its error
+  // estimate and which these tests would only cut short again.
+  const bool errorControlled = integrated && m_integrator == GTINT_DORMAND_PRINCE;
+  if (!errorControlled && m_maxChangeVelocity > 0)
   {
-    pointActivity.push_back(true);
+    double changeVel = fabs(mag1 - a_lane.m_mag0);
+    if (changeVel > m_maxChangeVelocity)
+    {
+      bSplit = true;
+      ++a_ctx.m_statistics.m_velocitySplits;
+    }
   }
-  a_tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_POINTS, pointActivity,
-                                 DataLocationEnum::LOC_POINTS, time);
+  if (!errorControlled && !bSplit && m_maxChangeDirectionInRadians > 0)
+  {
+    double dir = iGetDirAsCosTheta(a_lane.m_vx0, a_lane.m_vy0, vx1, vy1);
+    if (dir < a_lane.m_maxAngleChange)
+    {
+      bSplit = true;
+      ++a_ctx.m_statistics.m_directionSplits;
+    }
+  }
+  if (bSplit)
+  {
+    ++a_ctx.m_statistics.m_rejectedSteps;
+    // A split puts the trace back in motion, so any stop decided earlier in this step is
+    // void -- including the time step clamp, which is why resumability cannot be read off
+    // the lane's final state without this.
+    a_lane.m_continue = true;
+    a_lane.m_stopReason = GTEXIT_WAITING_FOR_TIME_STEP;
+    deltaT /= 2;
+    if (m_minDeltaTime > 0 && deltaT < m_minDeltaTime)
+    {
+      // done, exit
+      a_lane.m_continue = false;
+      a_lane.m_stopReason = GTEXIT_MIN_DELTA_TIME;
+    }
+  }
+  else
+  {
+    ++a_ctx.m_statistics.m_acceptedSteps;
+    double segDist = Mdist(pt0.x, pt0.y, pt1.x, pt1.y);
+    a_lane.m_distTraveled += segDist;
+    if (m_maxTracingDistance > 0 && a_lane.m_distTraveled > m_maxTracingDistance)
+    {
+      // because our last point exceeded the exitDistance
+      // find this point by linear calculations
+      double distancePast = a_lane.m_distTraveled - m_maxTracingDistance;
+      double perc = distancePast / segDist;
+      Pt3d newPt;
+      newPt.x = (pt0.x * perc) + (pt1.x * (1 - perc));
+      newPt.y = (pt0.y * perc) + (pt1.y * (1 - perc));
+
+      a_lane.m_distTraveled = m_maxTracingDistance;
+      iRecordVertex(a_lane, newPt.x, newPt.y, ptTime + elapsedTime + deltaT * perc);
+      pt0 = newPt;
+      elapsedTime += deltaT * perc;
+      iStopLane(a_lane, GTEXIT_MAX_TRACING_DISTANCE);
+      return false;
+    }
 
-  time = 10;
-  // Uses exact same scalars/pointActivity
-  a_tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_POINTS, pointActivity,
-                                 DataLocationEnum::LOC_POINTS, time);
-} // iCreateDefaultSingleCell
-//------------------------------------------------------------------------------
-/// \brief Returns a tracer for two default cells
-/// \param[out] a_tracer The tracer for two default cells
+    // add new pt if not identical to last -- and push its time only when the point is
+    // pushed. The time push used to be unconditional, so a step shorter than XM_ZERO_TOL
+    // left the times array one longer and silently misaligned every later pair, which a
+    // caller reading them as parallel arrays cannot detect.
+    // A stepping trace always has its seed recorded, so there is a last vertex to compare to.
+    const bool moved = !EQ_TOL(pt1.x, a_lane.m_lastX, XM_ZERO_TOL) ||
+                       !EQ_TOL(pt1.y, a_lane.m_lastY, XM_ZERO_TOL);
+    pt0 = pt1;
+    elapsedTime += deltaT;
+    a_lane.m_vx0 = vx1;
+    a_lane.m_vy0 = vy1;
+    if (errorControlled)
+    {
+      const double error = a_lane.m_error;
+      deltaT *= error > 0 ? std::min(kMaxStepFactor, 0.9 * pow(error, -0.2)) : kMaxStepFactor;
+    }
+    else
+      deltaT *= 1.2;
+    a_lane.m_mag0 = mag1;
+    if (moved)
+      iRecordVertex(a_lane, pt1.x, pt1.y, ptTime + elapsedTime);
+  }
+  if (!a_lane.m_continue)
+  {
+    iStopLane(a_lane, a_lane.m_stopReason);
+    return false;
+  }
+  return true;
+} // XmGridTraceImpl::FinishStep
 //------------------------------------------------------------------------------
-void iCreateDefaultTwoCell(BSHP<XmGridTrace>& a_tracer)
+/// \brief Takes one Runge-Kutta step of the selected scheme.
+///
+/// The velocity at the start point is passed in rather than evaluated: it is the velocity at
+/// the end of the previous step, which both schemes evaluate anyway -- Dormand-Prince as its
+/// seventh stage, RK4 for the step controller -- so every step after a trace's first costs
+/// one evaluation fewer than its stage count ("first same as last").
+/// \param[in,out] a_ctx Scratch for the calling thread
+/// \param[in,out] a_triangles The trace's last triangle per triangulation; see TraceBatch
+/// \param[in] a_pt0 The start point
+/// \param[in] a_time0 The time at the start point
+/// \param[in] a_vx0 Velocity x at the start point, vector multiplier applied
+/// \param[in] a_vy0 Velocity y at the start point, vector multiplier applied
+/// \param[in] a_deltaT The step size
+/// \param[out] a_pt1 The end point
+/// \param[out] a_vector1 The field at the end point and time, as extracted
+/// \param[out] a_error Dormand-Prince's scaled error estimate, where 1 is exactly at the
+///             tolerance; 0 for RK4
+/// \return false if any stage fell outside the grid or in an inactive cell
+//------------------------------------------------------------------------------
+bool XmGridTraceImpl::IntegrateStep(TraceContext& a_ctx,
+                                    int a_triangles[2],
+                                    const Pt3d& a_pt0,
+                                    double a_time0,
+                                    double a_vx0,
+                                    double a_vy0,
+                                    double a_deltaT,
+                                    Pt3d& a_pt1,
+                                    Pt3d& a_vector1,
+                                    double& a_error) const
 {
-  // clang-format off
-    //      3========2========5
-    //      |        |        |
-    //      |        |        |
-    //      |        |        |
-    //      0--------1--------4
-  // clang-format on
-
-  VecPt3d points = {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}, {2, 0, 0}, {2, 1, 0}};
-  VecInt cells = {XMU_QUAD, 4, 0, 1, 2, 3, XMU_QUAD, 4, 1, 4, 5, 2};
-  std::shared_ptr<XmUGrid> ugrid = XmUGrid::New(points, cells);
-  a_tracer = XmGridTrace::New(ugrid);
-  const double vm = 1;
-  a_tracer->SetVectorMultiplier(vm);
-
-  const double tt = 100;
-  a_tracer->SetMaxTracingTime(tt);
-
-  const double td = 100;
-  a_tracer->SetMaxTracingDistance(td);
-
-  const double dt = .1;
-  a_tracer->SetMinDeltaTime(dt);
-
-  const double cd = 100;
-  a_tracer->SetMaxChangeDistance(cd);
-
-  const double cv = 100;
-  a_tracer->SetMaxChangeVelocity(cv);
-
-  const double cdir = 1.5 * XM_PI;
-  a_tracer->SetMaxChangeDirectionInRadians(cdir);
+  Pt3d stagePt = a_pt0;
+  auto evaluate = [&](double a_x, double a_y, double a_time, Pt3d& a_vector) {
+    stagePt.x = a_x;
+    stagePt.y = a_y;
+    return GetVectorAtLocationAndTime(a_ctx, a_triangles, stagePt, a_time, a_vector) &&
+           !EQ_TOL(a_vector.x, XM_NODATA, 1) && !EQ_TOL(a_vector.y, XM_NODATA, 1);
+  };
 
-  double time = 0;
-  VecPt3d scalars = {{.1, 0, 0}, {.2, 0, 0}};
-  DynBitset pointActivity;
-  for (int i = 0; i < 2; ++i)
+  const double h = a_deltaT;
+  a_pt1 = a_pt0;
+  a_error = 0;
+  Pt3d vec;
+  if (m_integrator == GTINT_RK4)
   {
-    pointActivity.push_back(true);
+    const double kx1 = a_vx0, ky1 = a_vy0;
+    if (!evaluate(a_pt0.x + h / 2 * kx1, a_pt0.y + h / 2 * ky1, a_time0 + h / 2, vec))
+      return false;
+    const double kx2 = vec.x * m_vectorMultiplier, ky2 = vec.y * m_vectorMultiplier;
+    if (!evaluate(a_pt0.x + h / 2 * kx2, a_pt0.y + h / 2 * ky2, a_time0 + h / 2, vec))
+      return false;
+    const double kx3 = vec.x * m_vectorMultiplier, ky3 = vec.y * m_vectorMultiplier;
+    if (!evaluate(a_pt0.x + h * kx3, a_pt0.y + h * ky3, a_time0 + h, vec))
+      return false;
+    const double kx4 = vec.x * m_vectorMultiplier, ky4 = vec.y * m_vectorMultiplier;
+    a_pt1.x = a_pt0.x + h / 6 * (kx1 + 2 * kx2 + 2 * kx3 + kx4);
+    a_pt1.y = a_pt0.y + h / 6 * (ky1 + 2 * ky2 + 2 * ky3 + ky4);
+    return evaluate(a_pt1.x, a_pt1.y, a_time0 + h, a_vector1);
   }
-  a_tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_CELLS, pointActivity,
-                                 DataLocationEnum::LOC_CELLS, time);
 
-  time = 10;
-  // Uses exact same scalars/pointActivity
-  a_tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_CELLS, pointActivity,
-                                 DataLocationEnum::LOC_CELLS, time);
-} // iCreateDefaultTwoCell
+  double kx[7], ky[7];
+  kx[0] = a_vx0;
+  ky[0] = a_vy0;
+  for (int stage = 1; stage < 7; ++stage)
+  {
+    double x = a_pt0.x, y = a_pt0.y;
+    for (int j = 0; j < stage; ++j)
+    {
+      x += h * kDpA[stage][j] * kx[j];
+      y += h * kDpA[stage][j] * ky[j];
+    }
+    if (!evaluate(x, y, a_time0 + kDpC[stage] * h, vec))
+      return false;
+    kx[stage] = vec.x * m_vectorMultiplier;
+    ky[stage] = vec.y * m_vectorMultiplier;
+    if (stage == 6)
+    {
+      // The seventh stage is evaluated at the 5th-order solution itself.
+      a_pt1.x = x;
+      a_pt1.y = y;
+      a_vector1 = vec;
+    }
+  }
 
+  double errX = 0, errY = 0;
+  for (int stage = 0; stage < 7; ++stage)
+  {
+    errX += kDpE[stage] * kx[stage];
+    errY += kDpE[stage] * ky[stage];
+  }
+  errX *= h;
+  errY *= h;
+  const double stepLength = Mdist(a_pt0.x, a_pt0.y, a_pt1.x, a_pt1.y);
+  const double scale = m_absoluteTolerance + m_relativeTolerance * stepLength;
+  a_error = sqrt((errX * errX + errY * errY) / 2) / scale;
+  return true;
+} // XmGridTraceImpl::IntegrateStep
 //------------------------------------------------------------------------------
-/// \brief A structured quad grid plus its point locations, for the tracing benchmark.
-/// The locations are kept alongside the ugrid so the velocity field can be evaluated
-/// without depending on how the ugrid exposes its points.
+/// \brief Runs the Grid Trace for a point against the currently loaded time steps
+/// \param[in] a_pt The starting point of the trace
+/// \param[in] a_ptTime The starting time of the trace
+/// \param[out] a_outTrace the resultant positions at each step
+/// \param[out] a_outTimes the resultant times at each step
 //------------------------------------------------------------------------------
-struct BenchmarkGrid
+void XmGridTraceImpl::TracePoint(const Pt3d& a_pt,
+                                 const double& a_ptTime,
+                                 VecPt3d& a_outTrace,
+                                 VecDbl& a_outTimes)
 {
-  std::shared_ptr<XmUGrid> m_ugrid; ///< the grid itself
-  VecPt3d m_points;                 ///< grid point locations, in grid point order
-};
-
-//------------------------------------------------------------------------------
-/// \brief Measurements from one benchmark batch.
+  FinishPendingTimeStep();
+  PrepareSnapshot();
+  m_single.Assign(1);
+  m_single.m_x[0] = a_pt.x;
+  m_single.m_y[0] = a_pt.y;
+  m_single.m_ptTime[0] = a_ptTime;
+  const auto start = std::chrono::steady_clock::now();
+  TraceContext ctx;
+  const size_t trace = 0;
+  StepTraces(ctx, m_single, &trace, 1, 1);
+  const auto stepped = std::chrono::steady_clock::now();
+  m_exitReason = m_single.m_exitReasons[0];
+  m_exitMessage = XmGridTraceExitReasonToString(m_exitReason);
+  m_exitCell = m_single.m_exitCells[0];
+  m_exitCellEdge = m_single.m_exitCellEdges[0];
+  m_single.m_vertices.GetVertices(0, a_outTrace, a_outTimes);
+  ctx.m_statistics.m_steppingSeconds += std::chrono::duration<double>(stepped - start).count();
+  ctx.m_statistics.m_resultCopySeconds += iSecondsSince(stepped);
+  m_statistics.Add(ctx.m_statistics);
+} // XmGridTraceImpl::TracePoint
 //------------------------------------------------------------------------------
-struct BenchmarkStats
-{
-  int m_seeds = 0;                          ///< seed points handed to TracePoint
-  int m_traced = 0;                         ///< seeds that produced a usable (2+ point) polyline
-  size_t m_tracePoints = 0;                 ///< total polyline points produced
-  size_t m_searchCalls = 0;                 ///< point-location searches consumed
-  double m_seconds = 0;                     ///< wall time of the traced batch, excluding setup
-  std::map<std::string, int> m_exitReasons; ///< exit message -> count, over a sample
-};
-
-//------------------------------------------------------------------------------
-/// \brief Builds a structured quad grid standing in for a real hydrodynamic mesh.
-/// \param[in] a_cellsPerSide Number of cells along each axis
-/// \param[in] a_length Length of the square domain along each axis
-/// \return the grid and its point locations
-//------------------------------------------------------------------------------
-BenchmarkGrid iBuildBenchmarkGrid(int a_cellsPerSide, double a_length)
+/// \brief Runs the Grid Trace for many points, each exactly as TracePoint would
+/// \param[in] a_pts The starting point of each trace
+/// \param[in] a_ptTimes The starting time of each trace; must be one per point
+/// \param[out] a_outXy The position of each vertex, x and y interleaved
+/// \param[out] a_outTimes The time of each vertex
+/// \param[out] a_outOffsets Where each trace's vertices begin, plus one past the end
+/// \param[out] a_outExitReasons Why each trace stopped, one entry per point
+//------------------------------------------------------------------------------
+void XmGridTraceImpl::TracePoints(const VecPt3d& a_pts,
+                                  const VecDbl& a_ptTimes,
+                                  VecDbl& a_outXy,
+                                  VecDbl& a_outTimes,
+                                  std::vector<size_t>& a_outOffsets,
+                                  std::vector<XmGridTraceExitEnum>& a_outExitReasons)
 {
-  const int ptsPerSide = a_cellsPerSide + 1;
-  const double dx = a_length / a_cellsPerSide;
-  BenchmarkGrid grid;
-  grid.m_points.reserve((size_t)ptsPerSide * ptsPerSide);
-  for (int j = 0; j < ptsPerSide; ++j)
+  FinishPendingTimeStep();
+  // m_single rather than m_batch, so a batch in flight is not disturbed.
+  m_single.Assign(0);
+  if (a_pts.size() != a_ptTimes.size())
   {
-    for (int i = 0; i < ptsPerSide; ++i)
-      grid.m_points.push_back({i * dx, j * dx, 0.0});
+    XMGT_LOG(xmlog::error, "Gridtracer: TracePoints needs one start time per point.");
   }
-
-  VecInt cells;
-  cells.reserve((size_t)a_cellsPerSide * a_cellsPerSide * 6);
-  for (int j = 0; j < a_cellsPerSide; ++j)
+  else
   {
-    for (int i = 0; i < a_cellsPerSide; ++i)
+    m_single.Assign(a_pts.size());
+    for (size_t i = 0; i < a_pts.size(); ++i)
     {
-      const int p0 = j * ptsPerSide + i;
-      cells.push_back(XMU_QUAD);
-      cells.push_back(4);
-      cells.push_back(p0);
-      cells.push_back(p0 + 1);
-      cells.push_back(p0 + ptsPerSide + 1);
-      cells.push_back(p0 + ptsPerSide);
+      m_single.m_x[i] = a_pts[i].x;
+      m_single.m_y[i] = a_pts[i].y;
     }
+    m_single.m_ptTime = a_ptTimes;
+    StepBatch(m_single);
   }
-  grid.m_ugrid = XmUGrid::New(grid.m_points, cells);
-  return grid;
-} // iBuildBenchmarkGrid
+  const auto start = std::chrono::steady_clock::now();
+  m_single.m_vertices.GetFlatVertices(a_outXy, a_outTimes, a_outOffsets);
+  a_outExitReasons = m_single.m_exitReasons;
+  m_statistics.m_resultCopySeconds += iSecondsSince(start);
+} // XmGridTraceImpl::TracePoints
 //------------------------------------------------------------------------------
-/// \brief Builds a rotating-plus-drifting velocity field over the grid points.
-/// A vortex is used rather than a uniform field for two reasons: the curvature makes the
-/// adaptive stepping subdivide the way it does on real flow, and the drift carries part
-/// of the seed population off the grid so the out-of-domain exit path -- which builds a
-/// fresh polyline extractor per event -- is measured rather than assumed away.
-/// \param[in] a_points Grid point locations
-/// \param[in] a_omega Angular rate of the vortex; negative reverses the rotation
-/// \param[in] a_drift Uniform velocity added in +x
-/// \param[in] a_length Length of the square domain along each axis
-/// \return velocity vectors, one per grid point
+/// \brief Begins tracing a batch of seeds against the currently loaded time steps
+/// \param[in] a_pts The starting point of each trace
+/// \param[in] a_ptTimes The starting time of each trace; must be one per point
 //------------------------------------------------------------------------------
-VecPt3d iBenchmarkVectors(const VecPt3d& a_points, double a_omega, double a_drift, double a_length)
+void XmGridTraceImpl::StartTraces(const VecPt3d& a_pts, const VecDbl& a_ptTimes)
 {
-  const double cx = a_length / 2, cy = a_length / 2;
-  VecPt3d vectors;
-  vectors.reserve(a_points.size());
-  for (const auto& pt : a_points)
-    vectors.push_back({-a_omega * (pt.y - cy) + a_drift, a_omega * (pt.x - cx), 0.0});
-  return vectors;
-} // iBenchmarkVectors
+  m_batch.Assign(0);
+  m_batch.m_sink = m_sink;
+  m_order.clear();
+  if (a_pts.size() != a_ptTimes.size())
+  {
+    // Refusing the whole batch rather than seeding the common prefix: a caller that
+    // mismatched these has a bug, and a partial batch would let it go unnoticed.
+    XMGT_LOG(xmlog::error, "Gridtracer: StartTraces needs one start time per point.");
+    return;
+  }
+  m_batch.Assign(a_pts.size());
+  for (size_t i = 0; i < a_pts.size(); ++i)
+  {
+    m_batch.m_x[i] = a_pts[i].x;
+    m_batch.m_y[i] = a_pts[i].y;
+  }
+  m_batch.m_ptTime = a_ptTimes;
+} // XmGridTraceImpl::StartTraces
 //------------------------------------------------------------------------------
-/// \brief Builds seed points scattered inside a rectangular band of the domain.
-/// The scatter is driven by a fixed linear congruential generator rather than std::rand
-/// so that reruns and different machines trace the identical seed set; a benchmark whose
-/// input changes between runs cannot measure a delta.
-/// \param[in] a_count Number of seeds
-/// \param[in] a_lo Low corner of the band, on both axes
-/// \param[in] a_hi High corner of the band, on both axes
-/// \param[in] a_holeLo Low corner of a rectangular hole to reject seeds from
-/// \param[in] a_holeHi High corner of the hole; pass a_holeHi <= a_holeLo for no hole
-/// \return the seed points
+/// \brief Advances every unfinished trace as far as the loaded time steps allow
+///
+/// Only the unfinished traces are stepped, in the order OrderTraces puts them. Traces are
+/// independent of one another, so with more than one thread that order is handed out in
+/// chunks from a shared counter, each worker stepping its chunks with its own TraceContext.
+/// Within a chunk, traces are stepped a packet at a time; see StepTraces. Every trace runs
+/// exactly the arithmetic it would run alone, so the results do not depend on the thread
+/// count, the packet width, the order, or on which worker took which chunk.
+/// \return How many traces are waiting on a later time step
 //------------------------------------------------------------------------------
-VecPt3d iBenchmarkSeeds(int a_count, double a_lo, double a_hi, double a_holeLo, double a_holeHi)
+int XmGridTraceImpl::ContinueTraces()
 {
-  unsigned int state = 12345u;
-  auto nextUnit = [&state]() {
-    state = state * 1664525u + 1013904223u;
-    return (state >> 8) / 16777216.0;
-  };
-
-  VecPt3d seeds;
-  seeds.reserve(a_count);
-  while ((int)seeds.size() < a_count)
-  {
-    const double x = a_lo + nextUnit() * (a_hi - a_lo);
-    const double y = a_lo + nextUnit() * (a_hi - a_lo);
-    const bool inHole =
-      a_holeHi > a_holeLo && x > a_holeLo && x < a_holeHi && y > a_holeLo && y < a_holeHi;
-    if (!inHole)
-      seeds.push_back({x, y, 0.0});
-  }
-  return seeds;
-} // iBenchmarkSeeds
+  // A step whose loading failed on an earlier call is reported before the window it never
+  // joined is traced again. One still loading is left to load while this call traces.
+  if (!m_loader.joinable())
+    FinishPendingTimeStep();
+  StepBatch(m_batch);
+  const int waiting = (int)std::count(m_batch.m_exitReasons.begin(), m_batch.m_exitReasons.end(),
+                                      GTEXIT_WAITING_FOR_TIME_STEP);
+  // The window has now been traced as it was, so a step loaded meanwhile may move it on. If
+  // loading it failed, the traces have still been stepped, so the count is returned and the
+  // error left for the next call.
+  FinishPendingTimeStep(true);
+  return waiting;
+} // XmGridTraceImpl::ContinueTraces
 //------------------------------------------------------------------------------
-/// \brief Traces every seed and measures the batch.
-/// Timing covers only the TracePoint calls. The exit-reason histogram is gathered in a
-/// separate untimed pass over a sample, because GetExitMessage returns a std::string by
-/// value and a per-seed map insert would show up in a measurement this small.
-/// \param[in] a_tracer The tracer, already loaded with two time steps
-/// \param[in] a_seeds The seed points
-/// \param[out] a_stats The measurements
+/// \brief Advances every unfinished trace of a batch as far as the loaded time steps allow;
+///        see ContinueTraces.
+/// \param[in,out] a_batch The batch
 //------------------------------------------------------------------------------
-void iRunTraceBenchmark(BSHP<XmGridTrace>& a_tracer,
-                        const VecPt3d& a_seeds,
-                        BenchmarkStats& a_stats)
+void XmGridTraceImpl::StepBatch(TraceBatch& a_batch)
 {
-  a_stats = BenchmarkStats();
-  a_stats.m_seeds = (int)a_seeds.size();
-
-  VecPt3d trace;
-  VecDbl times;
-  g_searchCalls = 0;
   const auto start = std::chrono::steady_clock::now();
-  for (const auto& seed : a_seeds)
+  PrepareSnapshot();
+  OrderTraces(a_batch);
+  // GetExitReason reports the last trace that actually ran, as it did when the batch was only
+  // ever stepped in seed order; which one that is has to be decided before any of them run.
+  int lastRunning = -1;
+  for (size_t trace : m_order)
+    lastRunning = std::max(lastRunning, (int)trace);
+
+  const size_t batchSize = m_order.size();
+  int threadCount = m_threadCount > 0 ? m_threadCount : (int)std::thread::hardware_concurrency();
+  const size_t chunkCount = (batchSize + kTraceChunk - 1) / kTraceChunk;
+  threadCount = (int)std::min((size_t)std::max(threadCount, 1), chunkCount);
+  // One context per worker, kept past the join so their statistics can be added up.
+  std::vector<TraceContext> contexts(std::max(threadCount, 1));
+  if (threadCount <= 1)
   {
-    a_tracer->TracePoint(seed, 0.0, trace, times);
-    if (trace.size() > 1)
+    StepTraces(contexts[0], a_batch, m_order.data(), batchSize, m_packetWidth);
+  }
+  else
+  {
+    std::atomic<size_t> nextChunk(0);
+    std::vector<std::exception_ptr> errors(threadCount);
+    auto worker = [&](int a_worker) {
+      TraceContext& ctx = contexts[a_worker];
+      try
+      {
+        for (size_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++)
+        {
+          const size_t begin = chunk * kTraceChunk;
+          const size_t end = std::min(batchSize, begin + kTraceChunk);
+          StepTraces(ctx, a_batch, &m_order[begin], end - begin, m_packetWidth);
+        }
+      }
+      catch (...)
+      {
+        errors[a_worker] = std::current_exception();
+        nextChunk = chunkCount; // the batch is abandoned; stop the other workers early
+      }
+    };
+    // The calling thread is one of the workers rather than waiting idle on the others.
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (int t = 1; t < threadCount; ++t)
+      threads.emplace_back(worker, t);
+    worker(0);
+    for (auto& thread : threads)
+      thread.join();
+    for (auto& error : errors)
     {
-      ++a_stats.m_traced;
-      a_stats.m_tracePoints += trace.size();
+      if (error)
+        std::rethrow_exception(error);
     }
   }
-  const auto end = std::chrono::steady_clock::now();
-  a_stats.m_seconds = std::chrono::duration<double>(end - start).count();
-  a_stats.m_searchCalls = g_searchCalls;
 
-  const int sampleSize = std::min((int)a_seeds.size(), 1000);
-  for (int i = 0; i < sampleSize; ++i)
+  for (const TraceContext& ctx : contexts)
+    m_statistics.Add(ctx.m_statistics);
+  m_statistics.m_steppingSeconds += iSecondsSince(start);
+
+  if (lastRunning >= 0)
   {
-    a_tracer->TracePoint(a_seeds[i], 0.0, trace, times);
-    a_stats.m_exitReasons[a_tracer->GetExitMessage()]++;
+    m_exitReason = a_batch.m_exitReasons[lastRunning];
+    m_exitMessage = XmGridTraceExitReasonToString(m_exitReason);
+    m_exitCell = a_batch.m_exitCells[lastRunning];
+    m_exitCellEdge = a_batch.m_exitCellEdges[lastRunning];
   }
-} // iRunTraceBenchmark
-//------------------------------------------------------------------------------
-/// \brief Prints one benchmark batch in a form that can be pasted into a results table.
-/// \param[in] a_label Which seed population this batch was
-/// \param[in] a_stats The measurements
+} // XmGridTraceImpl::StepBatch
 //------------------------------------------------------------------------------
-void iReportTraceBenchmark(const char* a_label, const BenchmarkStats& a_stats)
+/// \brief Lists the unfinished traces of a batch in m_order, in the order to step them.
+///
+/// In seed order by default. With spatial ordering, in Hilbert order of where each trace is
+/// now, over the box holding them all: consecutive traces then sit in the same few
+/// triangles, so stepping them reuses the triangles, coefficients and bins the one before
+/// left in cache, and a thread's chunk covers one patch of the grid rather than a scatter
+/// across it. Sorted afresh on every call, since traces drift from window to window.
+/// Either way each trace's results stay where its seed was.
+/// \param[in] a_batch The batch
+//------------------------------------------------------------------------------
+void XmGridTraceImpl::OrderTraces(const TraceBatch& a_batch)
 {
-  const double seeds = a_stats.m_seeds ? (double)a_stats.m_seeds : 1.0;
-  const double usPerSeed = a_stats.m_seconds * 1e6 / seeds;
-  const double searchesPerSeed = a_stats.m_searchCalls / seeds;
-  const double usPerExtract =
-    a_stats.m_searchCalls ? a_stats.m_seconds * 1e6 / a_stats.m_searchCalls : 0.0;
-  const double ptsPerTrace =
-    a_stats.m_traced ? (double)a_stats.m_tracePoints / a_stats.m_traced : 0.0;
+  m_order.clear();
+  const size_t batchSize = a_batch.GetSize();
+  for (size_t i = 0; i < batchSize; ++i)
+  {
+    if (!iIsTerminal(a_batch.m_exitReasons[i]))
+      m_order.push_back(i);
+  }
+  if (!m_spatialOrdering || m_order.size() < 2)
+    return;
 
-  std::cout << std::fixed << std::setprecision(3) << "\n  [" << a_label
-            << "] seeds=" << a_stats.m_seeds << " traced=" << a_stats.m_traced << "\n"
-            << "    wall            " << a_stats.m_seconds * 1e3 << " ms\n"
-            << "    per seed        " << usPerSeed << " us\n"
-            << "    searches        " << a_stats.m_searchCalls << " (" << std::setprecision(1)
-            << searchesPerSeed << "/seed, " << std::setprecision(3) << usPerExtract << " us/call)\n"
-            << "    trace points    " << a_stats.m_tracePoints << " (" << std::setprecision(1)
-            << ptsPerTrace << "/trace)\n"
-            << "    exit reasons (sampled):\n";
-  for (const auto& reason : a_stats.m_exitReasons)
-    std::cout << "      " << std::setw(5) << reason.second << "  " << reason.first << "\n";
-  std::cout << std::flush;
-} // iReportTraceBenchmark
+  double xMin = a_batch.m_x[m_order[0]], xMax = xMin;
+  double yMin = a_batch.m_y[m_order[0]], yMax = yMin;
+  for (size_t trace : m_order)
+  {
+    xMin = std::min(xMin, a_batch.m_x[trace]);
+    xMax = std::max(xMax, a_batch.m_x[trace]);
+    yMin = std::min(yMin, a_batch.m_y[trace]);
+    yMax = std::max(yMax, a_batch.m_y[trace]);
+  }
+  // One square scale for both axes, so a long thin domain is not cut into long thin cells.
+  const double extent = std::max(xMax - xMin, yMax - yMin);
+  const double scale = extent > 0 ? 65535.0 / extent : 0.0;
+  m_orderKeys.resize(m_order.size());
+  for (size_t i = 0; i < m_order.size(); ++i)
+  {
+    const size_t trace = m_order[i];
+    const uint32_t x = (uint32_t)((a_batch.m_x[trace] - xMin) * scale);
+    const uint32_t y = (uint32_t)((a_batch.m_y[trace] - yMin) * scale);
+    m_orderKeys[i] = ((uint64_t)iHilbertIndex(x, y) << 32) | trace;
+  }
+  std::sort(m_orderKeys.begin(), m_orderKeys.end());
+  for (size_t i = 0; i < m_order.size(); ++i)
+    m_order[i] = (size_t)(m_orderKeys[i] & 0xffffffffu);
+} // XmGridTraceImpl::OrderTraces
 //------------------------------------------------------------------------------
-/// \brief Reads a positive integer from the environment, or returns a fallback.
-/// \param[in] a_name Environment variable name
-/// \param[in] a_fallback Value to use when unset, unparseable, or not positive
-/// \return the resolved value
+/// \brief Copies out the batch traced so far
+/// \param[out] a_outTraces The positions of each trace, one entry per seed
+/// \param[out] a_outTimes The times of each trace, parallel to a_outTraces
+/// \param[out] a_outExitReasons Why each trace stopped, one entry per seed
 //------------------------------------------------------------------------------
-int iEnvInt(const char* a_name, int a_fallback)
+void XmGridTraceImpl::GetTraceResults(std::vector<VecPt3d>& a_outTraces,
+                                      std::vector<VecDbl>& a_outTimes,
+                                      std::vector<XmGridTraceExitEnum>& a_outExitReasons) const
 {
-  const char* raw = std::getenv(a_name);
-  if (!raw)
-    return a_fallback;
-  const int value = std::atoi(raw);
-  return value > 0 ? value : a_fallback;
-} // iEnvInt
-}
-////////////////////////////////////////////////////////////////////////////////
-/// \class XmGridTraceUnitTests
-/// \brief Tests functionality of XmGridTrace
-////////////////////////////////////////////////////////////////////////////////
+  const auto start = std::chrono::steady_clock::now();
+  const size_t batchSize = m_batch.GetSize();
+  a_outTraces.resize(batchSize);
+  a_outTimes.resize(batchSize);
+  for (size_t i = 0; i < batchSize; ++i)
+    m_batch.m_vertices.GetVertices(i, a_outTraces[i], a_outTimes[i]);
+  a_outExitReasons = m_batch.m_exitReasons;
+  m_statistics.m_resultCopySeconds += iSecondsSince(start);
+} // XmGridTraceImpl::GetTraceResults
 //------------------------------------------------------------------------------
-/// \brief test the basic functionality of trace point
+/// \brief Copies out the batch traced so far as flat arrays
+/// \param[out] a_outXy The position of each vertex, x and y interleaved
+/// \param[out] a_outTimes The time of each vertex
+/// \param[out] a_outOffsets Where each trace's vertices begin, plus one past the end
+/// \param[out] a_outExitReasons Why each trace stopped, one entry per seed
 //------------------------------------------------------------------------------
-void XmGridTraceUnitTests::testBasicTracePoint()
+void XmGridTraceImpl::GetFlatTraceResults(VecDbl& a_outXy,
+                                          VecDbl& a_outTimes,
+                                          std::vector<size_t>& a_outOffsets,
+                                          std::vector<XmGridTraceExitEnum>& a_outExitReasons) const
 {
-  BSHP<XmGridTrace> tracer;
-  iCreateDefaultSingleCell(tracer);
-
-  VecPt3d outTrace;
-  VecDbl outTimes;
-  Pt3d startPoint = {.5, .5, 0};
-  double startTime = .5;
-
-  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
-
-  VecPt3d expectedOutTrace = {{.5, .5, 0}, {1, 1, 0}};
-  VecDbl expectedOutTimes = {.5, 1};
-  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
-  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
-} // XmGridTraceUnitTests::testTracePoint
+  const auto start = std::chrono::steady_clock::now();
+  m_batch.m_vertices.GetFlatVertices(a_outXy, a_outTimes, a_outOffsets);
+  a_outExitReasons = m_batch.m_exitReasons;
+  m_statistics.m_resultCopySeconds += iSecondsSince(start);
+} // XmGridTraceImpl::GetFlatTraceResults
 //------------------------------------------------------------------------------
-/// \brief Speed is limited to .25. It doesnt reach the edge because it goes below min delta time
+/// \brief Hands over the batch's results and frees the batch
+/// \param[out] a_outTraces The positions of each trace, one entry per seed
+/// \param[out] a_outTimes The times of each trace, parallel to a_outTraces
+/// \param[out] a_outExitReasons Why each trace stopped, one entry per seed
 //------------------------------------------------------------------------------
-void XmGridTraceUnitTests::testMaxChangeDistance()
+void XmGridTraceImpl::TakeTraceResults(std::vector<VecPt3d>& a_outTraces,
+                                       std::vector<VecDbl>& a_outTimes,
+                                       std::vector<XmGridTraceExitEnum>& a_outExitReasons)
 {
-  BSHP<XmGridTrace> tracer;
-  iCreateDefaultSingleCell(tracer);
-  tracer->SetMaxChangeDistance(.25);
-
-  VecPt3d outTrace;
-  VecDbl outTimes;
-  Pt3d startPoint = {.5, .5, 0};
-  double startTime = .5;
-
-  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
-
-  VecPt3d expectedOutTrace = {{.5, .5, 0},
-                              {0.67677668424809445, 0.67677668424809445, 0.00000000000000000},
-                              {0.85355336849618890, 0.85355336849618890, 0.00000000000000000},
-                              {1, 1, 0}};
-  VecDbl expectedOutTimes = {.5, 0.67677668424809445, 0.85355336849618890, 1};
-  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
-  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
-} // XmGridTraceUnitTests::testMaxChangeDistance
+  GetTraceResults(a_outTraces, a_outTimes, a_outExitReasons);
+  m_batch.Release();
+  std::vector<size_t>().swap(m_order);
+  std::vector<uint64_t>().swap(m_orderKeys);
+} // XmGridTraceImpl::TakeTraceResults
+//------------------------------------------------------------------------------
+/// \brief Hands over one finished trace of the batch and frees its vertices
+/// \param[in] a_trace The trace, by its seed's index
+/// \param[out] a_outTrace The positions of the trace
+/// \param[out] a_outTimes The times of the trace, parallel to a_outTrace
+/// \param[out] a_outExitReason Why the trace stopped, or that it has not
+/// \return false if the trace is still running or there is no such trace
+//------------------------------------------------------------------------------
+bool XmGridTraceImpl::TakeTraceResult(size_t a_trace,
+                                      VecPt3d& a_outTrace,
+                                      VecDbl& a_outTimes,
+                                      XmGridTraceExitEnum& a_outExitReason)
+{
+  a_outTrace.clear();
+  a_outTimes.clear();
+  if (a_trace >= m_batch.GetSize())
+  {
+    a_outExitReason = GTEXIT_NOT_STARTED;
+    return false;
+  }
+  a_outExitReason = m_batch.m_exitReasons[a_trace];
+  if (!iIsTerminal(a_outExitReason))
+    return false;
+  const auto start = std::chrono::steady_clock::now();
+  m_batch.m_vertices.GetVertices(a_trace, a_outTrace, a_outTimes);
+  m_batch.m_vertices.Free(a_trace);
+  m_statistics.m_resultCopySeconds += iSecondsSince(start);
+  return true;
+} // XmGridTraceImpl::TakeTraceResult
 //------------------------------------------------------------------------------
-/// \brief test with small scalars to create more points
+/// \brief Copies out the cell edge each trace of the batch left the grid through
+/// \param[out] a_outCells The cell each trace left through, one entry per seed; -1 for a
+///             trace that did not stop with GTEXIT_LEFT_GRID
+/// \param[out] a_outCellEdges The edge within that cell, parallel to a_outCells
 //------------------------------------------------------------------------------
-void XmGridTraceUnitTests::testSmallScalarsTracePoint()
+void XmGridTraceImpl::GetTraceExitEdges(VecInt& a_outCells, VecInt& a_outCellEdges) const
 {
-  BSHP<XmGridTrace> tracer;
-  iCreateDefaultSingleCell(tracer);
-
-  // Push on different scalars
-  double time = 0;
-  VecPt3d scalars = {{.1, .1, 0}, {.1, .1, 0}, {.1, .1, 0}, {.1, .1, 0}};
-  DynBitset pointActivity;
-  for (int i = 0; i < 4; ++i)
+  a_outCells = m_batch.m_exitCells;
+  a_outCellEdges = m_batch.m_exitCellEdges;
+} // XmGridTraceImpl::GetTraceExitEdges
+//------------------------------------------------------------------------------
+/// \brief Returns what the tracer has done since its statistics were last reset
+/// \return the statistics
+//------------------------------------------------------------------------------
+const XmGridTraceStatistics& XmGridTraceImpl::GetStatistics() const
+{
+  return m_statistics;
+} // XmGridTraceImpl::GetStatistics
+//------------------------------------------------------------------------------
+/// \brief Zeroes the statistics
+//------------------------------------------------------------------------------
+void XmGridTraceImpl::ResetStatistics()
+{
+  m_statistics = XmGridTraceStatistics();
+} // XmGridTraceImpl::ResetStatistics
+//------------------------------------------------------------------------------
+/// \brief Finds where a step whose end has no data leaves the grid or its active cells.
+///
+/// The grid boundary is found in the boundary edge index, which is built on the first exit
+/// and holds nothing but boundary edges. Inactive cells end a trace too, but they change with
+/// every time step, so they are not indexed: when any cell is inactive the step is also
+/// followed across the triangulation to the first one it enters, and the nearer of the two
+/// stops wins.
+/// \param[in,out] a_ctx Scratch for the calling thread
+/// \param[in,out] a_triangles The trace's last triangle per triangulation; see TraceBatch
+/// \param[in] a_pt0 The start of the step, where the field has data
+/// \param[in] a_pt1 The candidate end of the step, where it has none
+/// \param[in] a_time The time at a_pt1, which says whose cells are active
+/// \param[out] a_t Where the step leaves, as a fraction of the way from a_pt0 to a_pt1
+/// \param[out] a_cellIdx The cell it leaves through
+/// \param[out] a_cellEdgeIdx The edge of a_cellIdx it leaves through, as
+///             XmUGrid::GetCellEdge numbers them
+/// \return false if no crossing was found, which should not happen but can on a step that
+///         grazes the boundary
+//------------------------------------------------------------------------------
+bool XmGridTraceImpl::FindExit(TraceContext& a_ctx,
+                               int a_triangles[2],
+                               const Pt3d& a_pt0,
+                               const Pt3d& a_pt1,
+                               double a_time,
+                               double& a_t,
+                               int& a_cellIdx,
+                               int& a_cellEdgeIdx) const
+{
+  const XmGridTraceBoundary& boundary = m_shared->GetBoundary();
+  bool found = false;
+  const int edgeIdx = boundary.FindExit(a_pt0, a_pt1, a_t);
+  if (edgeIdx >= 0)
   {
-    pointActivity.push_back(true);
+    found = true;
+    a_cellIdx = boundary.GetEdgeCell(edgeIdx);
+    a_cellEdgeIdx = boundary.GetEdgeCellEdge(edgeIdx);
   }
-  tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_POINTS, pointActivity,
-                               DataLocationEnum::LOC_POINTS, time);
-
-  time = 10;
-  // Uses exact same scalars/pointActivity
-  tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_POINTS, pointActivity,
-                               DataLocationEnum::LOC_POINTS, time);
-
-  VecPt3d outTrace;
-  VecDbl outTimes;
-  Pt3d startPoint = {.5, .5, 0};
-  double startTime = .5;
-  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
-
-  VecPt3d expectedOutTrace = {{.5, .5, 0},
-                              {0.60000000149011612, 0.60000000149011612, 0},
-                              {0.72000000327825542, 0.72000000327825542, 0},
-                              {0.86400000542402267, 0.86400000542402267, 0},
-                              {1, 1, 0}};
-  VecDbl expectedOutTimes = {.5, 1.5, 2.7, 4.14, 5.5};
-
-  if (expectedOutTrace.size() == outTrace.size())
+  const WindowStep& step = m_window[WindowStepAt(m_snapshot ? m_snapshotBlendTime : a_time)];
+  const DynBitset& exitActivity = step.m_exitActivity;
+  if (exitActivity.empty())
+    return found;
+
+  const XmGridTraceGeometry& geometry = *step.m_geometry;
+  int& hint = a_triangles[step.m_geometry == m_pointGeometry ? 0 : 1];
+  double weights[3];
+  const int startTri = iLocate(geometry, exitActivity, a_pt0, hint, weights, a_ctx.m_statistics);
+  double t;
+  int triIdx, side;
+  if (startTri >= 0 &&
+      geometry.FindSegmentExit(startTri, a_pt0, a_pt1, exitActivity, t, triIdx, side) &&
+      (!found || t < a_t))
   {
-    for (int i = 0; i < expectedOutTrace.size(); ++i)
-    {
-      TS_ASSERT_DELTA(expectedOutTrace[i].x, outTrace[i].x, .001);
-      TS_ASSERT_DELTA(expectedOutTrace[i].y, outTrace[i].y, .001);
-      TS_ASSERT_DELTA(expectedOutTrace[i].z, outTrace[i].z, .001);
-    }
+    found = true;
+    a_t = t;
+    a_cellIdx = geometry.GetTriangleCell(triIdx);
+    const int* tri = geometry.GetTrianglePoints(triIdx);
+    a_cellEdgeIdx = iCellEdgeBetween(*m_ugrid, a_cellIdx, tri[(side + 1) % 3], tri[(side + 2) % 3]);
   }
-  else
-    TS_FAIL("Expected trace size != actual trace size");
-  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
-  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, 0.001);
-} // XmGridTraceUnitTests::testSmallScalarsTracePoint
+  return found;
+} // XmGridTraceImpl::FindExit
 //------------------------------------------------------------------------------
-/// \brief test behavior when having large changes in direction
+/// \brief Returns the velocity scalar for a given point and time
+/// \param[in,out] a_ctx Scratch for the calling thread
+/// \param[in,out] a_triangles The trace's last triangle per triangulation; see TraceBatch
+/// \param[in] a_pt The point
+/// \param[in] a_currentTime The time at extraction
+/// \param[out] a_data the resultant velocity scalar
 //------------------------------------------------------------------------------
-void XmGridTraceUnitTests::testStrongDirectionChange()
+bool XmGridTraceImpl::GetVectorAtLocationAndTime(TraceContext& a_ctx,
+                                                 int a_triangles[2],
+                                                 const xms::Pt3d& a_pt,
+                                                 double a_currentTime,
+                                                 xms::Pt3d& a_data) const
 {
-  BSHP<XmGridTrace> tracer;
-  iCreateDefaultSingleCell(tracer);
-
-  tracer->SetMaxChangeDirectionInRadians(XM_PI * .2);
-  tracer->SetMinDeltaTime(-1);
-  // Push on different scalars
-  double time = 0;
-  VecPt3d scalars = {{0, 1, 0}, {-1, 0, 0}, {0, -1, 0}, {1, 0, 0}};
-  DynBitset pointActivity;
-  for (int i = 0; i < 4; ++i)
+  if (m_window.size() < 2)
   {
-    pointActivity.push_back(true);
+    // Two time steps are required. This used to dereference a null first extractor when only
+    // one had been supplied.
+    XMGT_LOG(xmlog::error, "Gridtracer: two time steps must be added before tracing.");
+    return false;
   }
-  tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_POINTS, pointActivity,
-                               DataLocationEnum::LOC_POINTS, time);
 
-  time = 10;
-  // Uses exact same scalars/pointActivity
-  tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_POINTS, pointActivity,
-                               DataLocationEnum::LOC_POINTS, time);
+  ++a_ctx.m_statistics.m_evaluations;
+  // A location outside the grid or in an inactive cell in *either* bracketing timestep has no
+  // usable velocity, and the sentinel must be returned rather than blended: blending
+  // XM_NODATA (-9999999) against a real value produces something like -999999.9, which is
+  // neither no-data nor meaningful, and every caller tests for XM_NODATA exactly. Returning
+  // true is correct -- extraction succeeded, and no-data is the answer.
+  auto noData = [&]() {
+    a_data.x = XM_NODATA;
+    a_data.y = XM_NODATA;
+    return true;
+  };
+  if (m_snapshot)
+    a_currentTime = m_snapshotBlendTime;
+  const size_t stepIdx = WindowStepAt(a_currentTime);
+  const WindowStep& step1 = m_window[stepIdx - 1];
+  const WindowStep& step2 = m_window[stepIdx];
+  const XmGridTraceGeometry& geometry1 = *step1.m_geometry;
+  const XmGridTraceGeometry& geometry2 = *step2.m_geometry;
+  const bool shared = step1.m_geometry == step2.m_geometry;
+  if (m_snapshot && shared)
+  {
+    // One field, so one search, against the cells active in both steps.
+    int& hint = a_triangles[step2.m_geometry == m_pointGeometry ? 0 : 1];
+    const int tri =
+      iLocate(geometry2, step2.m_exitActivity, a_pt, hint, a_ctx.m_weights2, a_ctx.m_statistics);
+    if (tri < 0)
+      return noData();
+    const double* c = &m_snapshotCoefficients[(size_t)tri * 6];
+    const double dx = a_pt.x - m_origin.x, dy = a_pt.y - m_origin.y;
+    a_data.x = c[0] + c[1] * dx + c[2] * dy;
+    a_data.y = c[3] + c[4] * dx + c[5] * dy;
+    return true;
+  }
+  const DynBitset& cellActivity2 = step2.m_cellActivity;
+  int& hint1 = a_triangles[step1.m_geometry == m_pointGeometry ? 0 : 1];
+  const int tri1 =
+    iLocate(geometry1, step1.m_cellActivity, a_pt, hint1, a_ctx.m_weights1, a_ctx.m_statistics);
+  if (tri1 < 0)
+    return noData();
+  // One search serves both time steps when they share a triangulation, each step's activity
+  // being a lookup on the found triangle's cell. Otherwise the second step is searched on
+  // its own. On a shared triangulation that is needed only for a point on the edge of a
+  // cell inactive in the second step, where an active neighbor may hold it; the fitted
+  // field is continuous across that edge. A point inside such a cell has no velocity.
+  int tri2 = tri1;
+  const size_t cell1 = (size_t)geometry1.GetTriangleCell(tri1);
+  if (!shared || (cell1 < cellActivity2.size() && !cellActivity2[cell1]))
+  {
+    if (shared && geometry1.IsInterior(tri1, a_pt))
+      return noData();
+    int& hint2 = a_triangles[step2.m_geometry == m_pointGeometry ? 0 : 1];
+    tri2 = iLocate(geometry2, cellActivity2, a_pt, hint2, a_ctx.m_weights2, a_ctx.m_statistics);
+    if (tri2 < 0)
+      return noData();
+  }
 
-  VecPt3d outTrace;
-  VecDbl outTimes;
-  Pt3d startPoint = {0, 0, 0};
-  double startTime = .5;
-  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
+  if (a_currentTime < step1.m_time - XM_ZERO_TOL)
+  {
+    XMGT_LOG(xmlog::warning, "Gridtracer: The given time is before the first time step.");
+    a_currentTime = step1.m_time;
+  }
 
-  VecPt3d expectedOutTrace = {{0, 0, 0},
-                              {0.00000000000000000, 0.25000000000000000, 0.00000000000000000},
-                              {0.074999999999999997, 0.47499999999999998, 0.00000000000000000},
-                              {0.21900000214576720, 0.63699999570846555, 0.00000000000000000},
-                              {0.30928799843788146, 0.66810399758815764, 0.00000000000000000},
-                              {0.40229310507774352, 0.67396399235725402, 0.00000000000000000},
-                              {0.48679361495018003, 0.65024498560905453, 0.00000000000000000},
-                              {0.54780151323509219, 0.59909560095787040, 0.00000000000000000},
-                              {0.55928876277122497, 0.56619817004051198, 0.00000000000000000},
-                              {0.56114558691518779, 0.53247499044700608, 0.00000000000000000},
-                              {0.55189971330840681, 0.50228363992173752, 0.00000000000000000},
-                              {0.53269911067322617, 0.48131557500677169, 0.00000000000000000},
-                              {0.52076836142536975, 0.47806150355091476, 0.00000000000000000},
-                              {0.50886902895577013, 0.47838753608466128, 0.00000000000000000},
-                              {0.49867742691962913, 0.48264835153512164, 0.00000000000000000},
-                              {0.49224616907898289, 0.49014090685121131, 0.00000000000000000},
-                              {0.49173935940609609, 0.49438094923206660, 0.00000000000000000},
-                              {0.49250246625151450, 0.49839053740482164, 0.00000000000000000},
-                              {0.49454361321306389, 0.50154755045413602, 0.00000000000000000},
-                              {0.49745717820065949, 0.50317358562752867, 0.00000000000000000},
-                              {0.49888395770889871, 0.50301615091938545, 0.00000000000000000},
-                              {0.50012160117661586, 0.50244704462921241, 0.00000000000000000},
-                              {0.50095740046883197, 0.50152383477622209, 0.00000000000000000},
-                              {0.50107955145675120, 0.50098875888952354, 0.00000000000000000},
-                              {0.50105605626599747, 0.50045352403892940, 0.00000000000000000},
-                              {0.50086894918345870, 0.49998474718699493, 0.00000000000000000},
-                              {0.50053945884260675, 0.49966662451478433, 0.00000000000000000},
-                              {0.50034430627617277, 0.49962054739305783, 0.00000000000000000},
-                              {0.50015012042108842, 0.49962997721910873, 0.00000000000000000},
-                              {0.49998265395837810, 0.49970077747304897, 0.00000000000000000},
-                              {0.49987374966305814, 0.49982308521808211, 0.00000000000000000},
-                              {0.49986302487024292, 0.49988726006383088, 0.00000000000000000},
-                              {0.49986815504448728, 0.49994012045071656, 0.00000000000000000}};
-  VecDbl expectedOutTimes = {.5,
-                             0.75000000000000000,
-                             1.0500000000000000,
-                             1.4100000000000001,
-                             1.6260000000000001,
-                             1.8852000000000002,
-                             2.1962400000000004,
-                             2.5694880000000002,
-                             2.7934368000000003,
-                             3.0621753600000003,
-                             3.3846616320000003,
-                             3.7716451584000001,
-                             4.0038352742400001,
-                             4.2824634132480002,
-                             4.6168171800576001,
-                             5.0180417002291202,
-                             5.2587764123320317,
-                             5.5476580668555258,
-                             5.8943160522837186,
-                             6.3103056347975501,
-                             6.5598993843058491,
-                             6.8594118837158078,
-                             7.2188268830077584,
-                             7.4344758825829285,
-                             7.6932546820731327,
-                             8.0037892414613783,
-                             8.3764307127272737,
-                             8.6000155954868092,
-                             8.8683174547982535,
-                             9.1902796859719871,
-                             9.5766343633804656,
-                             9.7883171816902319,
-                             10.000000000000000};
-  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
-  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
-} // XmGridTraceUnitTests::testStrongDirectionChange
-//------------------------------------------------------------------------------
-/// \brief test setting max tracing time
+  const double* c1 = step2.GetCoefficients1(tri1);
+  const double* c2 = step2.GetCoefficients2(tri2);
+  iBlendSteps(c1, c2, a_pt.x - m_origin.x, a_pt.y - m_origin.y, a_currentTime, step1.m_time,
+              step2.m_time, a_data.x, a_data.y);
+  return true;
+} // XmGridTraceImpl::GetVectorAtLocationAndTime
 //------------------------------------------------------------------------------
-void XmGridTraceUnitTests::testMaxTracingTime()
+/// \brief Evaluates the field at the candidate point of each of a packet of lanes.
+///
+/// The same answer, lane for lane, as GetVectorAtLocationAndTime at each lane's m_pt1 and
+/// m_evalTime, written to the lane's m_vector. Lanes whose times fall between the same two
+/// time steps are evaluated together, which in a window of two steps, or for traces
+/// released together, is the whole packet.
+/// \param[in,out] a_ctx Scratch for the calling thread
+/// \param[in] a_lanes The lanes to evaluate
+/// \param[in] a_count How many lanes; at most kMaxPacketWidth
+/// \return false if the field could not be extracted at all
+//------------------------------------------------------------------------------
+bool XmGridTraceImpl::EvaluatePacket(TraceContext& a_ctx,
+                                     TraceLane* const* a_lanes,
+                                     int a_count) const
 {
-  BSHP<XmGridTrace> tracer;
-  iCreateDefaultSingleCell(tracer);
-
-  tracer->SetMaxChangeDirectionInRadians(XM_PI * .2);
-  tracer->SetMinDeltaTime(-1);
-  tracer->SetMaxTracingTime(5);
-  // Push on different scalars
-  double time = 0;
-  VecPt3d scalars = {{0, 1, 0}, {-1, 0, 0}, {0, -1, 0}, {1, 0, 0}};
-  DynBitset pointActivity;
-  for (int i = 0; i < 4; ++i)
+  if (m_window.size() < 2)
   {
-    pointActivity.push_back(true);
+    XMGT_LOG(xmlog::error, "Gridtracer: two time steps must be added before tracing.");
+    return false;
+  }
+  if (m_snapshot)
+  {
+    const size_t stepIdx = WindowStepAt(m_snapshotBlendTime);
+    if (m_window[stepIdx - 1].m_geometry == m_window[stepIdx].m_geometry)
+      EvaluateSnapshotPacket(a_ctx, stepIdx, a_lanes, a_count);
+    else
+      EvaluateIntervalPacket(a_ctx, stepIdx, a_lanes, a_count);
+    return true;
   }
-  tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_POINTS, pointActivity,
-                               DataLocationEnum::LOC_POINTS, time);
 
-  time = 10;
-  // Uses exact same scalars/pointActivity
-  tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_POINTS, pointActivity,
-                               DataLocationEnum::LOC_POINTS, time);
+  if (m_window.size() == 2)
+  {
+    EvaluateIntervalPacket(a_ctx, 1, a_lanes, a_count);
+    return true;
+  }
+  size_t steps[kMaxPacketWidth];
+  bool together = true;
+  for (int i = 0; i < a_count; ++i)
+  {
+    steps[i] = WindowStepAt(a_lanes[i]->m_evalTime);
+    together = together && steps[i] == steps[0];
+  }
+  if (together)
+  {
+    EvaluateIntervalPacket(a_ctx, steps[0], a_lanes, a_count);
+    return true;
+  }
+  TraceLane* group[kMaxPacketWidth];
+  bool grouped[kMaxPacketWidth] = {};
+  for (int i = 0; i < a_count; ++i)
+  {
+    if (grouped[i])
+      continue;
+    int groupCount = 0;
+    for (int j = i; j < a_count; ++j)
+    {
+      if (!grouped[j] && steps[j] == steps[i])
+      {
+        grouped[j] = true;
+        group[groupCount++] = a_lanes[j];
+      }
+    }
+    EvaluateIntervalPacket(a_ctx, steps[i], group, groupCount);
+  }
+  return true;
+} // XmGridTraceImpl::EvaluatePacket
+//------------------------------------------------------------------------------
+/// \brief Evaluates the field between two of the window's time steps at the candidate
+///        point of each of a packet of lanes; see EvaluatePacket.
+///
+/// A trace rarely leaves its triangle in one step, so one containment test over the whole
+/// packet places most lanes at once, and only those that moved on walk or search. The
+/// lanes' coefficients are then gathered side by side so the blend is one straight-line
+/// loop the compiler can keep in vector registers.
+/// \param[in,out] a_ctx Scratch for the calling thread
+/// \param[in] a_step The later of the two steps, by its index in m_window
+/// \param[in] a_lanes The lanes to evaluate
+/// \param[in] a_count How many lanes; at most kMaxPacketWidth
+//------------------------------------------------------------------------------
+void XmGridTraceImpl::EvaluateIntervalPacket(TraceContext& a_ctx,
+                                             size_t a_step,
+                                             TraceLane* const* a_lanes,
+                                             int a_count) const
+{
+  if (a_count <= 0)
+    return;
+  const WindowStep& step1 = m_window[a_step - 1];
+  const WindowStep& step2 = m_window[a_step];
+  const XmGridTraceGeometry& geometry1 = *step1.m_geometry;
+  const XmGridTraceGeometry& geometry2 = *step2.m_geometry;
+  const bool shared = step1.m_geometry == step2.m_geometry;
+  const DynBitset& cellActivity1 = step1.m_cellActivity;
+  const DynBitset& cellActivity2 = step2.m_cellActivity;
+  const double time1 = step1.m_time;
+  const double time2 = step2.m_time;
+  const int slot1 = step1.m_geometry == m_pointGeometry ? 0 : 1;
+  const int slot2 = step2.m_geometry == m_pointGeometry ? 0 : 1;
+  double x[kMaxPacketWidth], y[kMaxPacketWidth];
+  int tri1[kMaxPacketWidth], tri2[kMaxPacketWidth];
+  a_ctx.m_statistics.m_evaluations += a_count;
+  for (int i = 0; i < a_count; ++i)
+  {
+    x[i] = a_lanes[i]->m_pt1.x;
+    y[i] = a_lanes[i]->m_pt1.y;
+    tri1[i] = a_lanes[i]->m_batch->m_triangles[2 * a_lanes[i]->m_trace + slot1];
+  }
+  geometry1.TrianglesContain(a_count, tri1, x, y, cellActivity1, tri1);
 
-  VecPt3d outTrace;
-  VecDbl outTimes;
-  Pt3d startPoint = {0, 0, 0};
-  double startTime = .5;
-  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
+  // Placed as GetVectorAtLocationAndTime places a lone point, from the same hints.
+  double coefficients[kMaxPacketWidth][12];
+  double times[kMaxPacketWidth];
+  bool found[kMaxPacketWidth];
+  for (int i = 0; i < a_count; ++i)
+  {
+    TraceLane& lane = *a_lanes[i];
+    int* triangles = &lane.m_batch->m_triangles[2 * lane.m_trace];
+    if (tri1[i] < 0)
+      tri1[i] = iLocate(geometry1, cellActivity1, lane.m_pt1, triangles[slot1],
+                        a_ctx.m_weights1, a_ctx.m_statistics);
+    tri2[i] = tri1[i];
+    if (tri1[i] >= 0)
+    {
+      const size_t cell1 = (size_t)geometry1.GetTriangleCell(tri1[i]);
+      if (shared && cell1 < cellActivity2.size() && !cellActivity2[cell1] &&
+          geometry1.IsInterior(tri1[i], lane.m_pt1))
+        tri2[i] = -1;
+      else if (!shared || (cell1 < cellActivity2.size() && !cellActivity2[cell1]))
+        tri2[i] = iLocate(geometry2, cellActivity2, lane.m_pt1, triangles[slot2],
+                          a_ctx.m_weights2, a_ctx.m_statistics);
+    }
+    found[i] = tri1[i] >= 0 && tri2[i] >= 0;
+    if (!found[i])
+    {
+      std::fill(coefficients[i], coefficients[i] + 12, 0.0);
+      times[i] = time1;
+      continue;
+    }
+    const double* c1 = step2.GetCoefficients1(tri1[i]);
+    const double* c2 = step2.GetCoefficients2(tri2[i]);
+    std::copy(c1, c1 + 6, coefficients[i]);
+    std::copy(c2, c2 + 6, coefficients[i] + 6);
+    times[i] = m_snapshot ? m_snapshotBlendTime : lane.m_evalTime;
+    if (times[i] < time1 - XM_ZERO_TOL)
+    {
+      XMGT_LOG(xmlog::warning, "Gridtracer: The given time is before the first time step.");
+      times[i] = time1;
+    }
+  }
 
-  VecPt3d expectedOutTrace = {{0, 0, 0},
-                              {0.00000000000000000, 0.25000000000000000, 0.00000000000000000},
-                              {0.074999999999999997, 0.47499999999999998, 0.00000000000000000},
-                              {0.21900000214576720, 0.63699999570846555, 0.00000000000000000},
-                              {0.30928799843788146, 0.66810399758815764, 0.00000000000000000},
-                              {0.40229310507774352, 0.67396399235725402, 0.00000000000000000},
-                              {0.48679361495018003, 0.65024498560905453, 0.00000000000000000},
-                              {0.54780151323509219, 0.59909560095787040, 0.00000000000000000},
-                              {0.55928876277122497, 0.56619817004051198, 0.00000000000000000},
-                              {0.56114558691518779, 0.53247499044700608, 0.00000000000000000},
-                              {0.55189971330840681, 0.50228363992173752, 0.00000000000000000},
-                              {0.53269911067322617, 0.48131557500677169, 0.00000000000000000},
-                              {0.52076836142536975, 0.47806150355091476, 0.00000000000000000},
-                              {0.50886902895577013, 0.47838753608466128, 0.00000000000000000},
-                              {0.49867742691962913, 0.48264835153512164, 0.00000000000000000},
-                              {0.49224616907898289, 0.49014090685121131, 0.00000000000000000},
-                              {0.49173935940609609, 0.49438094923206660, 0.00000000000000000},
-                              {0.49237657318600692, 0.49772905815126539, 0.00000000000000000}};
-  VecDbl expectedOutTimes = {.5,
-                             0.75000000000000000,
-                             1.0500000000000000,
-                             1.4100000000000001,
-                             1.6260000000000001,
-                             1.8852000000000002,
-                             2.1962400000000004,
-                             2.5694880000000002,
-                             2.7934368000000003,
-                             3.0621753600000003,
-                             3.3846616320000003,
-                             3.7716451584000001,
-                             4.0038352742400001,
-                             4.2824634132480002,
-                             4.6168171800576001,
-                             5.0180417002291202,
-                             5.2587764123320317,
-                             5.5};
-  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
-  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
-} // XmGridTraceUnitTests::testMaxTracingTime
-//------------------------------------------------------------------------------
-/// \brief test setting the max tracing distance
-//------------------------------------------------------------------------------
-void XmGridTraceUnitTests::testMaxTracingDistance()
+  double vx[kMaxPacketWidth], vy[kMaxPacketWidth];
+  for (int i = 0; i < a_count; ++i)
+  {
+    iBlendSteps(coefficients[i], coefficients[i] + 6, x[i] - m_origin.x, y[i] - m_origin.y,
+                times[i], time1, time2, vx[i], vy[i]);
+  }
+  for (int i = 0; i < a_count; ++i)
+  {
+    // Outside the grid or in an inactive cell in either step: no-data, never a blend of it.
+    a_lanes[i]->m_vector.x = found[i] ? vx[i] : XM_NODATA;
+    a_lanes[i]->m_vector.y = found[i] ? vy[i] : XM_NODATA;
+  }
+} // XmGridTraceImpl::EvaluateIntervalPacket
+//------------------------------------------------------------------------------
+/// \brief Evaluates the snapshot field at the candidate point of each of a packet of
+///        lanes; see EvaluatePacket and PrepareSnapshot.
+/// \param[in,out] a_ctx Scratch for the calling thread
+/// \param[in] a_step The later of the two steps blended, by its index in m_window
+/// \param[in] a_lanes The lanes to evaluate
+/// \param[in] a_count How many lanes; at most kMaxPacketWidth
+//------------------------------------------------------------------------------
+void XmGridTraceImpl::EvaluateSnapshotPacket(TraceContext& a_ctx,
+                                             size_t a_step,
+                                             TraceLane* const* a_lanes,
+                                             int a_count) const
 {
-  BSHP<XmGridTrace> tracer;
-  iCreateDefaultSingleCell(tracer);
-
-  tracer->SetMaxChangeDirectionInRadians(XM_PI * .2);
-  tracer->SetMinDeltaTime(-1);
-  tracer->SetMaxTracingDistance(1.0);
-  // Push on different scalars
-  double time = 0;
-  VecPt3d scalars = {{0, 1, 0}, {-1, 0, 0}, {0, -1, 0}, {1, 0, 0}};
-  DynBitset pointActivity;
-  for (int i = 0; i < 4; ++i)
+  const WindowStep& step = m_window[a_step];
+  const XmGridTraceGeometry& geometry = *step.m_geometry;
+  const int slot = step.m_geometry == m_pointGeometry ? 0 : 1;
+  double x[kMaxPacketWidth], y[kMaxPacketWidth];
+  int tri[kMaxPacketWidth];
+  a_ctx.m_statistics.m_evaluations += a_count;
+  for (int i = 0; i < a_count; ++i)
   {
-    pointActivity.push_back(true);
+    x[i] = a_lanes[i]->m_pt1.x;
+    y[i] = a_lanes[i]->m_pt1.y;
+    tri[i] = a_lanes[i]->m_batch->m_triangles[2 * a_lanes[i]->m_trace + slot];
   }
-  tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_POINTS, pointActivity,
-                               DataLocationEnum::LOC_POINTS, time);
-
-  time = 10;
-  // Uses exact same scalars/pointActivity
-  tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_POINTS, pointActivity,
-                               DataLocationEnum::LOC_POINTS, time);
-
-  VecPt3d outTrace;
-  VecDbl outTimes;
-  Pt3d startPoint = {0, 0, 0};
-  double startTime = .5;
-  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
-
-  VecPt3d expectedOutTrace = {{0, 0, 0},
-                              {0.00000000000000000, 0.25000000000000000, 0.00000000000000000},
-                              {0.074999999999999997, 0.47499999999999998, 0.00000000000000000},
-                              {0.21900000214576720, 0.63699999570846555, 0.00000000000000000},
-                              {0.30928799843788146, 0.66810399758815764, 0.00000000000000000},
-                              {0.40229310507774352, 0.67396399235725402, 0.00000000000000000},
-                              {0.48679361495018003, 0.65024498560905453, 0.00000000000000000},
-                              {0.50183556502673621, 0.63763372523131490, 0.00000000000000000}};
-  VecDbl expectedOutTimes = {.5,
-                             0.75000000000000000,
-                             1.0500000000000000,
-                             1.4100000000000001,
-                             1.6260000000000001,
-                             1.8852000000000002,
-                             2.1962400000000004,
-                             2.4774609356360582};
-  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
-  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
-} // XmGridTraceUnitTests::testMaxTracingDistance
+  geometry.TrianglesContain(a_count, tri, x, y, step.m_exitActivity, tri);
+  for (int i = 0; i < a_count; ++i)
+  {
+    TraceLane& lane = *a_lanes[i];
+    if (tri[i] < 0)
+    {
+      tri[i] = iLocate(geometry, step.m_exitActivity, lane.m_pt1,
+                       lane.m_batch->m_triangles[2 * lane.m_trace + slot], a_ctx.m_weights2,
+                       a_ctx.m_statistics);
+    }
+    if (tri[i] < 0)
+    {
+      lane.m_vector.x = XM_NODATA;
+      lane.m_vector.y = XM_NODATA;
+      continue;
+    }
+    const double* c = &m_snapshotCoefficients[(size_t)tri[i] * 6];
+    const double dx = x[i] - m_origin.x, dy = y[i] - m_origin.y;
+    lane.m_vector.x = c[0] + c[1] * dx + c[2] * dy;
+    lane.m_vector.y = c[3] + c[4] * dx + c[5] * dy;
+  }
+} // XmGridTraceImpl::EvaluateSnapshotPacket
+} // namespace {}
+////////////////////////////////////////////////////////////////////////////////
+/// \class XmGridTrace
+/// \brief Traces points in an XmUGrid following a vector dataset
+////////////////////////////////////////////////////////////////////////////////
 //------------------------------------------------------------------------------
-/// \brief test behavior when starting point is out of the cell
+/// \brief Empty constructer for abstract class
 //------------------------------------------------------------------------------
-void XmGridTraceUnitTests::testStartOutOfCell()
+XmGridTrace::XmGridTrace()
 {
-  BSHP<XmGridTrace> tracer;
-  iCreateDefaultSingleCell(tracer);
-
-  VecPt3d outTrace;
-  VecDbl outTimes;
-  Pt3d startPoint = {-.1, 0, 0};
-  double startTime = .5;
-
-  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
-
-  VecPt3d expectedOutTrace = {};
-  VecDbl expectedOutTimes = {};
-  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
-  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
-} // XmGridTraceUnitTests::testStartOutOfCell
+} // XmGridTrace::XmGridTrace
 //------------------------------------------------------------------------------
-/// \brief test the angle function
+/// \brief Empty destructer for abstract class
 //------------------------------------------------------------------------------
-void XmGridTraceUnitTests::testDotProduct()
+XmGridTrace::~XmGridTrace()
 {
-  TS_ASSERT_DELTA(iGetDirAsCosTheta(0, 1, 1, 0), 0, .1);     // 90 degree angle
-  TS_ASSERT_DELTA(iGetDirAsCosTheta(0, 1, 1, 1), .707, .1);  // 45 degree angle
-  TS_ASSERT_DELTA(iGetDirAsCosTheta(0, 1, 0, -1), -1, .1);   // 180 degree angle
-  TS_ASSERT_DELTA(iGetDirAsCosTheta(1, 1, -1, -1), -1, .1);  // 180 degree angle
-  TS_ASSERT_DELTA(iGetDirAsCosTheta(2, 5, 3, 6), .9965, .1); // almost 0 degree angle
-  TS_ASSERT_DELTA(iGetDirAsCosTheta(0, 1, 0, 1), 1, .1);     // 0 degree angle
-} // XmGridTraceUnitTests::testDotProduct
+} // XmGridTrace::~XmGridTrace
 //------------------------------------------------------------------------------
-/// \brief test behavior when starting beyond the second time step
+/// \brief Empty destructer for abstract class
 //------------------------------------------------------------------------------
-void XmGridTraceUnitTests::testBeyondTimestep()
+XmGridTraceSink::~XmGridTraceSink()
 {
-  BSHP<XmGridTrace> tracer;
-  iCreateDefaultSingleCell(tracer);
-
-  VecPt3d outTrace;
-  VecDbl outTimes;
-  Pt3d startPoint = {.5, .5, 0};
-  double startTime = 10.1; // Just beyond the 2nd time
-
-  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
-
-  VecPt3d expectedOutTrace = {};
-  VecDbl expectedOutTimes = {};
-  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
-  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
-  // An empty trace on its own does not say which of several unrelated things happened, which
-  // is how this case went unnoticed as an extraction failure. The field simply is not known
-  // this far ahead yet, so the trace is waiting -- supplying a later time step starts it.
-  TS_ASSERT_EQUALS((int)GTEXIT_WAITING_FOR_TIME_STEP, (int)tracer->GetExitReason());
-} // XmGridTraceUnitTests::testBeyondTimestep
+} // XmGridTraceSink::~XmGridTraceSink
 //------------------------------------------------------------------------------
-/// \brief test the behavior when starting before the first timestep
+/// \brief Construct from a new XmGridTrace using a UGrid.
+/// \param[in] a_ugrid The UGrid to construct a grid trace for
+/// \return a boost shared pointer to an XmGridTrace
 //------------------------------------------------------------------------------
-void XmGridTraceUnitTests::testBeforeTimestep()
+BSHP<XmGridTrace> XmGridTrace::New(std::shared_ptr<XmUGrid> a_ugrid)
 {
-  BSHP<XmGridTrace> tracer;
-  iCreateDefaultSingleCell(tracer);
-
-  VecPt3d outTrace;
-  VecDbl outTimes;
-  Pt3d startPoint = {.5, .5, 0};
-  double startTime = -0.1; // Just beyond the 2nd time
-
-  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
-
-  VecPt3d expectedOutTrace = {{.5, .5, 0}, {1, 1, 0}};
-  VecDbl expectedOutTimes = {-.1, .4};
-  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
-  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
-} // XmGridTraceUnitTests::testBeforeTimestep
+  return BSHP<XmGridTraceImpl>(new XmGridTraceImpl(a_ugrid));
+} // XmGridTrace::New
 //------------------------------------------------------------------------------
-/// \brief test behavior of the vector multiplier
+/// \brief Returns a human-readable description of an exit reason.
+/// \param[in] a_reason The exit reason
+/// \return a description suitable for a log or a tooltip
 //------------------------------------------------------------------------------
-void XmGridTraceUnitTests::testVectorMultiplier()
+const char* XmGridTraceExitReasonToString(XmGridTraceExitEnum a_reason)
 {
-  BSHP<XmGridTrace> tracer;
-  iCreateDefaultSingleCell(tracer);
-
-  tracer->SetMaxChangeDirectionInRadians(XM_PI * .2);
-  tracer->SetMinDeltaTime(-1);
-  tracer->SetVectorMultiplier(0.5);
-  // Push on different scalars
-  double time = 0;
-  VecPt3d scalars = {{0, 1, 0}, {-1, 0, 0}, {0, -1, 0}, {1, 0, 0}};
-  DynBitset pointActivity;
-  for (int i = 0; i < 4; ++i)
+  switch (a_reason)
   {
-    pointActivity.push_back(true);
+  case GTEXIT_NOT_STARTED:
+    return "Trace has not started.";
+  case GTEXIT_WAITING_FOR_TIME_STEP:
+    return "Trace reached the newest time step and is waiting for a later one.";
+  case GTEXIT_MAX_TRACING_TIME:
+    return "Exceeded or reached max tracing time.";
+  case GTEXIT_MAX_TRACING_DISTANCE:
+    return "Point has reached or exceeded the max tracing distance.";
+  case GTEXIT_LEFT_GRID:
+    return "Point has traveled out of domain.";
+  case GTEXIT_ZERO_VELOCITY:
+    return "Velocity has gone to zero.";
+  case GTEXIT_MIN_DELTA_TIME:
+    return "Delta time was less than min delta time.";
+  case GTEXIT_SEED_NOT_TRACEABLE:
+    return "Point does not start inside an active cell.";
+  case GTEXIT_EXTRACTION_FAILED:
+    return "Error occurred while extracting a vector.";
   }
-  tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_POINTS, pointActivity,
-                               DataLocationEnum::LOC_POINTS, time);
-
-  time = 10;
-  // Uses exact same scalars/pointActivity
-  tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_POINTS, pointActivity,
-                               DataLocationEnum::LOC_POINTS, time);
-
-  VecPt3d outTrace;
-  VecDbl outTimes;
-  Pt3d startPoint = {0, 0, 0};
-  double startTime = .5;
-  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
-
-  VecPt3d expectedOutTrace = {{0, 0, 0},
-                              {0.00000000000000000, 0.25000000000000000, 0.00000000000000000},
-                              {0.074999999999999997, 0.47499999999999998, 0.00000000000000000},
-                              {0.21900000214576720, 0.63699999570846555, 0.00000000000000000},
-                              {0.30928799843788146, 0.66810399758815764, 0.00000000000000000},
-                              {0.40229310507774352, 0.67396399235725402, 0.00000000000000000},
-                              {0.48679361495018003, 0.65024498560905453, 0.00000000000000000},
-                              {0.54780151323509219, 0.59909560095787040, 0.00000000000000000},
-                              {0.55928876277122497, 0.56619817004051198, 0.00000000000000000},
-                              {0.56114558691518779, 0.53247499044700608, 0.00000000000000000},
-                              {0.55189971330840681, 0.50228363992173752, 0.00000000000000000},
-                              {0.53269911067322617, 0.48131557500677169, 0.00000000000000000},
-                              {0.52076836142536975, 0.47806150355091476, 0.00000000000000000},
-                              {0.50886902895577013, 0.47838753608466128, 0.00000000000000000},
-                              {0.49867742691962913, 0.48264835153512164, 0.00000000000000000},
-                              {0.49224616907898289, 0.49014090685121131, 0.00000000000000000},
-                              {0.49175783605462037, 0.49422637094165467, 0.00000000000000000}};
-  VecDbl expectedOutTimes = {.5,
-                             1.0000000000000000,
-                             1.6000000000000001,
-                             2.3200000000000003,
-                             2.7520000000000002,
-                             3.2704000000000004,
-                             3.8924800000000004,
-                             4.6389760000000004,
-                             5.0868736000000006,
-                             5.6243507200000007,
-                             6.2693232640000005,
-                             7.0432903168000003,
-                             7.5076705484800001,
-                             8.0649268264960003,
-                             8.7336343601152002,
-                             9.5360834004582404,
-                             10.000000000000000};
-  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
-  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
-} // XmGridTraceUnitTests::testVectorMultiplier
+  return "Unknown exit reason.";
+} // XmGridTraceExitReasonToString
+////////////////////////////////////////////////////////////////////////////////
+/// \struct XmGridTraceStatistics
+/// \brief What a tracer has done since its statistics were last reset.
+////////////////////////////////////////////////////////////////////////////////
 //------------------------------------------------------------------------------
-/// \brief test behavior of multiple cells
+/// \brief Adds another set of statistics into this one.
+/// \param[in] a_other The statistics to add
 //------------------------------------------------------------------------------
-void XmGridTraceUnitTests::testMultiCell()
+void XmGridTraceStatistics::Add(const XmGridTraceStatistics& a_other)
 {
-  BSHP<XmGridTrace> tracer;
-  iCreateDefaultTwoCell(tracer);
-
-  VecPt3d outTrace;
-  VecDbl outTimes;
-  Pt3d startPoint = {.5, .5, 0};
-  double startTime = 0;
+  m_acceptedSteps += a_other.m_acceptedSteps;
+  m_rejectedSteps += a_other.m_rejectedSteps;
+  m_velocitySplits += a_other.m_velocitySplits;
+  m_directionSplits += a_other.m_directionSplits;
+  m_errorRejections += a_other.m_errorRejections;
+  m_evaluations += a_other.m_evaluations;
+  m_searches += a_other.m_searches;
+  m_boundaryExits += a_other.m_boundaryExits;
+  for (int i = 0; i < EXIT_REASON_COUNT; ++i)
+    m_exitReasons[i] += a_other.m_exitReasons[i];
+  m_timeStepCacheHits += a_other.m_timeStepCacheHits;
+  m_timeStepCacheMisses += a_other.m_timeStepCacheMisses;
+  m_addScalarsSeconds += a_other.m_addScalarsSeconds;
+  m_triangulationSeconds += a_other.m_triangulationSeconds;
+  m_steppingSeconds += a_other.m_steppingSeconds;
+  m_timeStepWaitSeconds += a_other.m_timeStepWaitSeconds;
+  m_resultCopySeconds += a_other.m_resultCopySeconds;
+} // XmGridTraceStatistics::Add
 
-  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
+} // namespace xms
+#ifdef CXX_TEST
+#include <xmsgridtrace/gridtrace/XmGridTrace.t.h>
 
-  VecPt3d expectedOutTrace = {{.5, .5, 0},
-                              {0.60000000149011612, 0.50000000000000000, 0.00000000000000000},
-                              {0.73200000077486038, 0.50000000000000000, 0.00000000000000000},
-                              {0.90940801054239273, 0.50000000000000000, 0.00000000000000000},
-                              {1.1529537134766579, 0.50000000000000000, 0.00000000000000000},
-                              {1.4957102079987525, 0.50000000000000000, 0.00000000000000000},
-                              {1.9923067892670629, 0.50000000000000000, 0.00000000000000000},
-                              {2, .5, 0}};
-  VecDbl expectedOutTimes = {0,
-                             1.0000000000000000,
-                             2.2000000000000002,
-                             3.6400000000000001,
-                             5.3680000000000003,
-                             7.4416000000000002,
-                             9.9299199999999992,
-                             9.9683860530914945};
-  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
-  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
-} // XmGridTraceUnitTests::testMultiCell
-//------------------------------------------------------------------------------
-/// \brief Testing what happens when the maximum change in velocity is low
-////         It reaches a point of high acceleration, and then the delta time
-////         decreases until it goes below the minimum delta time.
-//------------------------------------------------------------------------------
-void XmGridTraceUnitTests::testMaxChangeVelocity()
-{
-  BSHP<XmGridTrace> tracer;
-  iCreateDefaultTwoCell(tracer);
-  tracer->SetMaxChangeVelocity(.01);
-  tracer->SetMinDeltaTime(0.001);
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <algorithm>
+#include <map>
 
-  VecPt3d outTrace;
-  VecDbl outTimes;
-  Pt3d startPoint = {.5, .5, 0};
-  double startTime = 0;
+#include <xmscore/testing/TestTools.h>
+#include <xmsextractor/ugrid/XmUGridTriangles2d.h>
+#include <xmsgrid/ugrid/XmUGrid.h>
 
-  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
+namespace xms
+{
+extern std::atomic<size_t> g_boundaryIndexBuilds; // see XmGridTraceSharedGrid.cpp
+extern std::atomic<size_t> g_triangulationBuilds;  // see XmGridTraceSharedGrid.cpp
+extern std::atomic<int> g_timeStepFailures;        // see the top of this file
+} // namespace xms
 
-  VecPt3d expectedOutTrace = {{.5, .5, 0},
-                              {0.60000000149011612, 0.50000000000000000, 0.00000000000000000},
-                              {0.66600000113248825, 0.50000000000000000, 0.00000000000000000},
-                              {0.74995200067758561, 0.50000000000000000, 0.00000000000000000},
-                              {0.80394992786645891, 0.50000000000000000, 0.00000000000000000},
-                              {0.87154669338464741, 0.50000000000000000, 0.00000000000000000},
-                              {0.95686786960840231, 0.50000000000000000, 0.00000000000000000},
-                              {1.0112451727318765, 0.50000000000000000, 0.00000000000000000},
-                              {1.0789334834771158, 0.50000000000000000, 0.00000000000000000},
-                              {1.1637975516948893, 0.50000000000000000, 0.00000000000000000},
-                              {1.2174527417415202, 0.50000000000000000, 0.00000000000000000},
-                              {1.2839153379250163, 0.50000000000000000, 0.00000000000000000},
-                              {1.3667568384715398, 0.50000000000000000, 0.00000000000000000},
-                              {1.4187699365302351, 0.50000000000000000, 0.00000000000000000},
-                              {1.4829247317645506, 0.50000000000000000, 0.00000000000000000},
-                              {1.5624845364724593, 0.50000000000000000, 0.00000000000000000},
-                              {1.6587784227485147, 0.50000000000000000, 0.00000000000000000},
-                              {1.7743310862797812, 0.50000000000000000, 0.00000000000000000},
-                              {1.9129942825173010, 0.50000000000000000, 0.00000000000000000},
-                              {2, .5, 0}};
-  VecDbl expectedOutTimes = {0,
-                             1.0000000000000000,
-                             1.6000000000000001,
-                             2.3200000000000003,
-                             2.7520000000000002,
-                             3.2704000000000004,
-                             3.8924800000000004,
-                             4.2657280000000002,
-                             4.7136256000000003,
-                             5.2511027200000004,
-                             5.5735889920000004,
-                             5.9605725184000002,
-                             6.4249527500800001,
-                             6.7035808890880002,
-                             7.0379346558976001,
-                             7.4391591760691202,
-                             7.9206286002749442,
-                             8.4983919093219331,
-                             9.1917078801783187,
-                             9.6267364611093829};
-  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
-  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
-} // XmGridTraceUnitTests::testMaxChangeVelocity
+using namespace xms;
+namespace
+{
 //------------------------------------------------------------------------------
-/// \brief Test behavior for unique timesteps
+/// \brief Returns a tracer for a default cell
+/// \param[out] a_tracer The tracer for a default cell
 //------------------------------------------------------------------------------
-void XmGridTraceUnitTests::testUniqueTimeSteps()
+void iCreateDefaultSingleCell(BSHP<XmGridTrace>& a_tracer)
 {
-  BSHP<XmGridTrace> tracer;
-  iCreateDefaultTwoCell(tracer);
+  //  3----2
+  //  | 1 /|
+  //  |  / |
+  //  | /  |
+  //  |/ 0 |
+  //  0----1
+  VecPt3d points = {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}};
+  VecInt cells = {XMU_TRIANGLE, 3, 0, 1, 2, XMU_TRIANGLE, 3, 2, 3, 0};
+  std::shared_ptr<XmUGrid> ugrid = XmUGrid::New(points, cells);
+  a_tracer = XmGridTrace::New(ugrid);
+  const double vm = 1;
+  a_tracer->SetVectorMultiplier(vm);
+  TS_ASSERT_EQUALS(a_tracer->GetVectorMultiplier(), vm);
 
-  double time = 20;
-  VecPt3d scalars = {{.2, 0, 0}, {.3, 0, 0}};
+  const double tt = 100;
+  a_tracer->SetMaxTracingTime(tt);
+  TS_ASSERT_EQUALS(a_tracer->GetMaxTracingTime(), tt);
+
+  const double td = 100;
+  a_tracer->SetMaxTracingDistance(td);
+  TS_ASSERT_EQUALS(a_tracer->GetMaxTracingDistance(), td);
+
+  const double dt = .1;
+  a_tracer->SetMinDeltaTime(dt);
+  TS_ASSERT_EQUALS(a_tracer->GetMinDeltaTime(), dt);
+
+  const double cd = 100;
+  a_tracer->SetMaxChangeDistance(cd);
+  TS_ASSERT_EQUALS(a_tracer->GetMaxChangeDistance(), cd);
+
+  const double cv = 100;
+  a_tracer->SetMaxChangeVelocity(cv);
+  TS_ASSERT_EQUALS(a_tracer->GetMaxChangeVelocity(), cv);
+
+  const double cdir = 1.5 * XM_PI;
+  a_tracer->SetMaxChangeDirectionInRadians(cdir);
+  TS_ASSERT_EQUALS(a_tracer->GetMaxChangeDirectionInRadians(), cdir);
+
+  double time = 0;
+  VecPt3d scalars = {{1, 1, 0}, {1, 1, 0}, {1, 1, 0}, {1, 1, 0}};
   DynBitset pointActivity;
-  for (int i = 0; i < 2; ++i)
+  for (int i = 0; i < 4; ++i)
   {
     pointActivity.push_back(true);
   }
-  tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_CELLS, pointActivity,
-                               DataLocationEnum::LOC_CELLS, time);
-
-  VecPt3d outTrace;
-  VecDbl outTimes;
-  Pt3d startPoint = {.5, .5, 0};
-  double startTime = 10;
-
-  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
+  a_tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_POINTS, pointActivity,
+                                 DataLocationEnum::LOC_POINTS, time);
 
-  VecPt3d expectedOutTrace = {{0.5, 0.5, 0},
-                              {0.60000000149011612, 0.5, 0},
-                              {0.74400000184774395, 0.5, 0},
-                              {0.95481600679159162, 0.5, 0},
-                              {1.2691074101881981, 0.5, 0},
-                              {1.747260385068264, 0.5, 0},
-                              {2, 0.5, 0}};
-  VecDbl expectedOutTimes = {10,
-                             11,
-                             12.199999999999999,
-                             13.640000000000001,
-                             15.368,
-                             17.441600000000001,
-                             18.362609001148471};
-  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
-  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
-} // XmGridTraceUnitTests::testUniqueTimeSteps
+  time = 10;
+  // Uses exact same scalars/pointActivity
+  a_tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_POINTS, pointActivity,
+                                 DataLocationEnum::LOC_POINTS, time);
+} // iCreateDefaultSingleCell
 //------------------------------------------------------------------------------
-/// \brief 2nd cell is inactive in the 2nd time step.
-/////        Thus it does not pull as hard. Also once the point reaches the 2nd cell
-/////        It stops entirely.
+/// \brief Returns a tracer for two default cells
+/// \param[out] a_tracer The tracer for two default cells
 //------------------------------------------------------------------------------
-void XmGridTraceUnitTests::testInactiveCell()
+void iCreateDefaultTwoCell(BSHP<XmGridTrace>& a_tracer)
 {
-  BSHP<XmGridTrace> tracer;
-  iCreateDefaultTwoCell(tracer);
+  // clang-format off
+    //      3========2========5
+    //      |        |        |
+    //      |        |        |
+    //      |        |        |
+    //      0--------1--------4
+  // clang-format on
 
-  double time = 20;
-  VecPt3d scalars = {{.2, 0, 0}, {99999, 0, 0}};
-  DynBitset pointActivity;
-  pointActivity.push_back(true);
-  pointActivity.push_back(false);
-  tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_CELLS, pointActivity,
-                               DataLocationEnum::LOC_CELLS, time);
+  VecPt3d points = {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}, {2, 0, 0}, {2, 1, 0}};
+  VecInt cells = {XMU_QUAD, 4, 0, 1, 2, 3, XMU_QUAD, 4, 1, 4, 5, 2};
+  std::shared_ptr<XmUGrid> ugrid = XmUGrid::New(points, cells);
+  a_tracer = XmGridTrace::New(ugrid);
+  const double vm = 1;
+  a_tracer->SetVectorMultiplier(vm);
 
-  VecPt3d outTrace;
-  VecDbl outTimes;
-  Pt3d startPoint = {.5, .5, 0};
-  double startTime = 10;
+  const double tt = 100;
+  a_tracer->SetMaxTracingTime(tt);
 
-  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
+  const double td = 100;
+  a_tracer->SetMaxTracingDistance(td);
 
-  VecPt3d expectedOutTrace = {{0.5, 0.5, 0},
-                              {0.60000000149011612, 0.5, 0},
-                              {0.74280000120401379, 0.5, 0},
-                              {0.94575130454301826, 0.5, 0},
-                              {1, 0.5, 0}};
-  VecDbl expectedOutTimes = {10,
-                             11,
-                             12.199999999999999,
-                             13.640000000000001,
-                             13.969279307058475};
-  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
-  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
-} // XmGridTraceUnitTests::testInactiveCell
-//------------------------------------------------------------------------------
-/// \brief The point starts in an inactive cell, and doesnt move
-//------------------------------------------------------------------------------
-void XmGridTraceUnitTests::testStartInactiveCell()
-{
-  BSHP<XmGridTrace> tracer;
-  iCreateDefaultTwoCell(tracer);
+  const double dt = .1;
+  a_tracer->SetMinDeltaTime(dt);
 
-  double time = 20;
-  VecPt3d scalars = {{1, 0, 0}, {99999, 0, 0}};
-  DynBitset pointActivity;
-  pointActivity.push_back(false);
-  pointActivity.push_back(true);
-  tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_CELLS, pointActivity,
-                               DataLocationEnum::LOC_CELLS, time);
+  const double cd = 100;
+  a_tracer->SetMaxChangeDistance(cd);
 
-  VecPt3d outTrace;
-  VecDbl outTimes;
-  Pt3d startPoint = {.5, .5, 0};
-  double startTime = 10;
+  const double cv = 100;
+  a_tracer->SetMaxChangeVelocity(cv);
 
-  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
+  const double cdir = 1.5 * XM_PI;
+  a_tracer->SetMaxChangeDirectionInRadians(cdir);
+
+  double time = 0;
+  VecPt3d scalars = {{.1, 0, 0}, {.2, 0, 0}};
+  DynBitset pointActivity;
+  for (int i = 0; i < 2; ++i)
+  {
+    pointActivity.push_back(true);
+  }
+  a_tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_CELLS, pointActivity,
+                                 DataLocationEnum::LOC_CELLS, time);
+
+  time = 10;
+  // Uses exact same scalars/pointActivity
+  a_tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_CELLS, pointActivity,
+                                 DataLocationEnum::LOC_CELLS, time);
+} // iCreateDefaultTwoCell
+
+//------------------------------------------------------------------------------
+/// \brief A structured quad grid plus its point locations, for the tracing benchmark.
+/// The locations are kept alongside the ugrid so the velocity field can be evaluated
+/// without depending on how the ugrid exposes its points.
+//------------------------------------------------------------------------------
+struct BenchmarkGrid
+{
+  std::shared_ptr<XmUGrid> m_ugrid; ///< the grid itself
+  VecPt3d m_points;                 ///< grid point locations, in grid point order
+};
+
+//------------------------------------------------------------------------------
+/// \brief Measurements from one benchmark batch.
+//------------------------------------------------------------------------------
+struct BenchmarkStats
+{
+  int m_seeds = 0;                          ///< seed points handed to TracePoint
+  int m_traced = 0;                         ///< seeds that produced a usable (2+ point) polyline
+  size_t m_tracePoints = 0;                 ///< total polyline points produced
+  size_t m_searchCalls = 0;                 ///< point-location searches consumed
+  size_t m_evaluations = 0;                 ///< field evaluations consumed
+  double m_seconds = 0;                     ///< wall time of the traced batch, excluding setup
+  std::map<std::string, int> m_exitReasons; ///< exit message -> count, over a sample
+};
+
+//------------------------------------------------------------------------------
+/// \brief Everything GetTraceResults reports for a batch, so two runs can be compared.
+//------------------------------------------------------------------------------
+struct BatchResults
+{
+  std::vector<VecPt3d> m_traces;                ///< positions of each trace
+  std::vector<VecDbl> m_times;                  ///< times of each trace
+  std::vector<XmGridTraceExitEnum> m_reasons;   ///< exit reason of each trace
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// A sink that rebuilds the batch's results from what it is handed, and checks it is handed
+/// them in an order a streaming caller can rely on.
+class RecordingSink : public XmGridTraceSink
+{
+public:
+  /// \brief Starts with no traces.
+  /// \param[in] a_traceCount How many traces the batch has
+  explicit RecordingSink(size_t a_traceCount)
+  {
+    m_results.m_traces.resize(a_traceCount);
+    m_results.m_times.resize(a_traceCount);
+    m_results.m_reasons.resize(a_traceCount, GTEXIT_NOT_STARTED);
+  }
+  /// \brief Appends a run to its trace.
+  /// \param[in] a_trace The trace
+  /// \param[in] a_xyt The vertices, x, y and time each
+  /// \param[in] a_count Number of vertices
+  void OnVertices(size_t a_trace, const double* a_xyt, int a_count) override
+  {
+    m_outOfOrder += m_results.m_reasons[a_trace] != GTEXIT_NOT_STARTED;
+    m_outOfOrder += a_count <= 0;
+    m_longestRun = std::max(m_longestRun, a_count);
+    for (int i = 0; i < a_count; ++i, a_xyt += 3)
+    {
+      m_results.m_traces[a_trace].push_back(Pt3d(a_xyt[0], a_xyt[1], 0.0));
+      m_results.m_times[a_trace].push_back(a_xyt[2]);
+    }
+  }
+  /// \brief Records the end of a trace.
+  /// \param[in] a_trace The trace
+  /// \param[in] a_reason Why it stopped
+  void OnTraceEnd(size_t a_trace, XmGridTraceExitEnum a_reason) override
+  {
+    m_outOfOrder += m_results.m_reasons[a_trace] != GTEXIT_NOT_STARTED;
+    m_results.m_reasons[a_trace] = a_reason;
+    if (a_reason == GTEXIT_EXTRACTION_FAILED)
+    {
+      m_results.m_traces[a_trace].clear();
+      m_results.m_times[a_trace].clear();
+    }
+  }
+
+  BatchResults m_results; ///< what the sink was handed
+  int m_outOfOrder = 0;   ///< calls after a trace's end, and empty runs
+  int m_longestRun = 0;   ///< most vertices handed over at once
+};
+
+//------------------------------------------------------------------------------
+/// \brief Builds a structured quad grid standing in for a real hydrodynamic mesh.
+/// \param[in] a_cellsPerSide Number of cells along each axis
+/// \param[in] a_length Length of the square domain along each axis
+/// \return the grid and its point locations
+//------------------------------------------------------------------------------
+BenchmarkGrid iBuildBenchmarkGrid(int a_cellsPerSide, double a_length)
+{
+  const int ptsPerSide = a_cellsPerSide + 1;
+  const double dx = a_length / a_cellsPerSide;
+  BenchmarkGrid grid;
+  grid.m_points.reserve((size_t)ptsPerSide * ptsPerSide);
+  for (int j = 0; j < ptsPerSide; ++j)
+  {
+    for (int i = 0; i < ptsPerSide; ++i)
+      grid.m_points.push_back({i * dx, j * dx, 0.0});
+  }
+
+  VecInt cells;
+  cells.reserve((size_t)a_cellsPerSide * a_cellsPerSide * 6);
+  for (int j = 0; j < a_cellsPerSide; ++j)
+  {
+    for (int i = 0; i < a_cellsPerSide; ++i)
+    {
+      const int p0 = j * ptsPerSide + i;
+      cells.push_back(XMU_QUAD);
+      cells.push_back(4);
+      cells.push_back(p0);
+      cells.push_back(p0 + 1);
+      cells.push_back(p0 + ptsPerSide + 1);
+      cells.push_back(p0 + ptsPerSide);
+    }
+  }
+  grid.m_ugrid = XmUGrid::New(grid.m_points, cells);
+  return grid;
+} // iBuildBenchmarkGrid
+//------------------------------------------------------------------------------
+/// \brief Builds a rotating-plus-drifting velocity field over the grid points.
+/// A vortex is used rather than a uniform field for two reasons: the curvature makes the
+/// adaptive stepping subdivide the way it does on real flow, and the drift carries part
+/// of the seed population off the grid so the out-of-domain exit path -- which builds a
+/// fresh polyline extractor per event -- is measured rather than assumed away.
+/// \param[in] a_points Grid point locations
+/// \param[in] a_omega Angular rate of the vortex; negative reverses the rotation
+/// \param[in] a_drift Uniform velocity added in +x
+/// \param[in] a_length Length of the square domain along each axis
+/// \return velocity vectors, one per grid point
+//------------------------------------------------------------------------------
+VecPt3d iBenchmarkVectors(const VecPt3d& a_points, double a_omega, double a_drift, double a_length)
+{
+  const double cx = a_length / 2, cy = a_length / 2;
+  VecPt3d vectors;
+  vectors.reserve(a_points.size());
+  for (const auto& pt : a_points)
+    vectors.push_back({-a_omega * (pt.y - cy) + a_drift, a_omega * (pt.x - cx), 0.0});
+  return vectors;
+} // iBenchmarkVectors
+//------------------------------------------------------------------------------
+/// \brief Builds seed points scattered inside a rectangular band of the domain.
+/// The scatter is driven by a fixed linear congruential generator rather than std::rand
+/// so that reruns and different machines trace the identical seed set; a benchmark whose
+/// input changes between runs cannot measure a delta.
+/// \param[in] a_count Number of seeds
+/// \param[in] a_lo Low corner of the band, on both axes
+/// \param[in] a_hi High corner of the band, on both axes
+/// \param[in] a_holeLo Low corner of a rectangular hole to reject seeds from
+/// \param[in] a_holeHi High corner of the hole; pass a_holeHi <= a_holeLo for no hole
+/// \return the seed points
+//------------------------------------------------------------------------------
+VecPt3d iBenchmarkSeeds(int a_count, double a_lo, double a_hi, double a_holeLo, double a_holeHi)
+{
+  unsigned int state = 12345u;
+  auto nextUnit = [&state]() {
+    state = state * 1664525u + 1013904223u;
+    return (state >> 8) / 16777216.0;
+  };
+
+  VecPt3d seeds;
+  seeds.reserve(a_count);
+  while ((int)seeds.size() < a_count)
+  {
+    const double x = a_lo + nextUnit() * (a_hi - a_lo);
+    const double y = a_lo + nextUnit() * (a_hi - a_lo);
+    const bool inHole =
+      a_holeHi > a_holeLo && x > a_holeLo && x < a_holeHi && y > a_holeLo && y < a_holeHi;
+    if (!inHole)
+      seeds.push_back({x, y, 0.0});
+  }
+  return seeds;
+} // iBenchmarkSeeds
+//------------------------------------------------------------------------------
+/// \brief Traces every seed and measures the batch.
+/// Timing covers only the TracePoint calls. The exit-reason histogram is gathered in a
+/// separate untimed pass over a sample, because GetExitMessage returns a std::string by
+/// value and a per-seed map insert would show up in a measurement this small.
+/// \param[in] a_tracer The tracer, already loaded with two time steps
+/// \param[in] a_seeds The seed points
+/// \param[out] a_stats The measurements
+//------------------------------------------------------------------------------
+void iRunTraceBenchmark(BSHP<XmGridTrace>& a_tracer,
+                        const VecPt3d& a_seeds,
+                        BenchmarkStats& a_stats)
+{
+  a_stats = BenchmarkStats();
+  a_stats.m_seeds = (int)a_seeds.size();
+
+  VecPt3d trace;
+  VecDbl times;
+  a_tracer->ResetStatistics();
+  const auto start = std::chrono::steady_clock::now();
+  for (const auto& seed : a_seeds)
+  {
+    a_tracer->TracePoint(seed, 0.0, trace, times);
+    if (trace.size() > 1)
+    {
+      ++a_stats.m_traced;
+      a_stats.m_tracePoints += trace.size();
+    }
+  }
+  const auto end = std::chrono::steady_clock::now();
+  a_stats.m_seconds = std::chrono::duration<double>(end - start).count();
+  a_stats.m_searchCalls = a_tracer->GetStatistics().m_searches;
+  a_stats.m_evaluations = a_tracer->GetStatistics().m_evaluations;
+
+  const int sampleSize = std::min((int)a_seeds.size(), 1000);
+  for (int i = 0; i < sampleSize; ++i)
+  {
+    a_tracer->TracePoint(a_seeds[i], 0.0, trace, times);
+    a_stats.m_exitReasons[a_tracer->GetExitMessage()]++;
+  }
+} // iRunTraceBenchmark
+//------------------------------------------------------------------------------
+/// \brief Prints one benchmark batch in a form that can be pasted into a results table.
+/// \param[in] a_label Which seed population this batch was
+/// \param[in] a_stats The measurements
+//------------------------------------------------------------------------------
+void iReportTraceBenchmark(const char* a_label, const BenchmarkStats& a_stats)
+{
+  const double seeds = a_stats.m_seeds ? (double)a_stats.m_seeds : 1.0;
+  const double usPerSeed = a_stats.m_seconds * 1e6 / seeds;
+  const double searchesPerSeed = a_stats.m_searchCalls / seeds;
+  const double usPerExtract =
+    a_stats.m_searchCalls ? a_stats.m_seconds * 1e6 / a_stats.m_searchCalls : 0.0;
+  const double ptsPerTrace =
+    a_stats.m_traced ? (double)a_stats.m_tracePoints / a_stats.m_traced : 0.0;
+
+  std::cout << std::fixed << std::setprecision(3) << "\n  [" << a_label
+            << "] seeds=" << a_stats.m_seeds << " traced=" << a_stats.m_traced << "\n"
+            << "    wall            " << a_stats.m_seconds * 1e3 << " ms\n"
+            << "    per seed        " << usPerSeed << " us\n"
+            << "    searches        " << a_stats.m_searchCalls << " (" << std::setprecision(1)
+            << searchesPerSeed << "/seed, " << std::setprecision(3) << usPerExtract << " us/call)\n"
+            << "    evaluations     " << a_stats.m_evaluations << " (" << std::setprecision(1)
+            << a_stats.m_evaluations / seeds << "/seed)\n"
+            << "    trace points    " << a_stats.m_tracePoints << " (" << std::setprecision(1)
+            << ptsPerTrace << "/trace)\n"
+            << "    exit reasons (sampled):\n";
+  for (const auto& reason : a_stats.m_exitReasons)
+    std::cout << "      " << std::setw(5) << reason.second << "  " << reason.first << "\n";
+  std::cout << std::flush;
+} // iReportTraceBenchmark
+//------------------------------------------------------------------------------
+/// \brief Reads a positive integer from the environment, or returns a fallback.
+/// \param[in] a_name Environment variable name
+/// \param[in] a_fallback Value to use when unset, unparseable, or not positive
+/// \return the resolved value
+//------------------------------------------------------------------------------
+int iEnvInt(const char* a_name, int a_fallback)
+{
+  const char* raw = std::getenv(a_name);
+  if (!raw)
+    return a_fallback;
+  const int value = std::atoi(raw);
+  return value > 0 ? value : a_fallback;
+} // iEnvInt
+//------------------------------------------------------------------------------
+/// \brief Counts the traces whose results differ between two batches in any way at all.
+/// Exact comparison, not a tolerance: threading must not change a single bit of the output.
+/// \param[in] a_expected The reference batch
+/// \param[in] a_actual The batch to compare with it
+/// \return the number of traces that differ, counting a size mismatch as all of them
+//------------------------------------------------------------------------------
+int iCountBatchDifferences(const BatchResults& a_expected, const BatchResults& a_actual)
+{
+  if (a_expected.m_traces.size() != a_actual.m_traces.size() ||
+      a_expected.m_times.size() != a_actual.m_times.size() ||
+      a_expected.m_reasons.size() != a_actual.m_reasons.size())
+    return (int)std::max(a_expected.m_traces.size(), a_actual.m_traces.size());
+
+  int differences = 0;
+  for (size_t i = 0; i < a_expected.m_traces.size(); ++i)
+  {
+    const VecPt3d& expectedPts = a_expected.m_traces[i];
+    const VecPt3d& actualPts = a_actual.m_traces[i];
+    bool same = a_expected.m_reasons[i] == a_actual.m_reasons[i] &&
+                expectedPts.size() == actualPts.size() &&
+                a_expected.m_times[i] == a_actual.m_times[i];
+    for (size_t j = 0; same && j < expectedPts.size(); ++j)
+      same = expectedPts[j].x == actualPts[j].x && expectedPts[j].y == actualPts[j].y;
+    if (!same)
+      ++differences;
+  }
+  return differences;
+} // iCountBatchDifferences
+}
+////////////////////////////////////////////////////////////////////////////////
+/// \class XmGridTraceUnitTests
+/// \brief Tests functionality of XmGridTrace
+////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+/// \brief test the basic functionality of trace point
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testBasicTracePoint()
+{
+  BSHP<XmGridTrace> tracer;
+  iCreateDefaultSingleCell(tracer);
+
+  VecPt3d outTrace;
+  VecDbl outTimes;
+  Pt3d startPoint = {.5, .5, 0};
+  double startTime = .5;
+
+  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
+
+  VecPt3d expectedOutTrace = {{.5, .5, 0}, {1, 1, 0}};
+  VecDbl expectedOutTimes = {.5, 1};
+  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
+  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
+} // XmGridTraceUnitTests::testTracePoint
+//------------------------------------------------------------------------------
+/// \brief Speed is limited to .25. It doesnt reach the edge because it goes below min delta time
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testMaxChangeDistance()
+{
+  BSHP<XmGridTrace> tracer;
+  iCreateDefaultSingleCell(tracer);
+  tracer->SetMaxChangeDistance(.25);
+
+  VecPt3d outTrace;
+  VecDbl outTimes;
+  Pt3d startPoint = {.5, .5, 0};
+  double startTime = .5;
+
+  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
+
+  VecPt3d expectedOutTrace = {{.5, .5, 0},
+                              {0.67677668424809445, 0.67677668424809445, 0.00000000000000000},
+                              {0.85355336849618890, 0.85355336849618890, 0.00000000000000000},
+                              {1, 1, 0}};
+  VecDbl expectedOutTimes = {.5, 0.67677668424809445, 0.85355336849618890, 1};
+  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
+  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
+} // XmGridTraceUnitTests::testMaxChangeDistance
+//------------------------------------------------------------------------------
+/// \brief test with small scalars to create more points
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testSmallScalarsTracePoint()
+{
+  BSHP<XmGridTrace> tracer;
+  iCreateDefaultSingleCell(tracer);
+
+  // Push on different scalars
+  double time = 0;
+  VecPt3d scalars = {{.1, .1, 0}, {.1, .1, 0}, {.1, .1, 0}, {.1, .1, 0}};
+  DynBitset pointActivity;
+  for (int i = 0; i < 4; ++i)
+  {
+    pointActivity.push_back(true);
+  }
+  tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_POINTS, pointActivity,
+                               DataLocationEnum::LOC_POINTS, time);
+
+  time = 10;
+  // Uses exact same scalars/pointActivity
+  tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_POINTS, pointActivity,
+                               DataLocationEnum::LOC_POINTS, time);
+
+  VecPt3d outTrace;
+  VecDbl outTimes;
+  Pt3d startPoint = {.5, .5, 0};
+  double startTime = .5;
+  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
+
+  VecPt3d expectedOutTrace = {{.5, .5, 0},
+                              {0.60000000149011612, 0.60000000149011612, 0},
+                              {0.72000000327825542, 0.72000000327825542, 0},
+                              {0.86400000542402267, 0.86400000542402267, 0},
+                              {1, 1, 0}};
+  VecDbl expectedOutTimes = {.5, 1.5, 2.7, 4.14, 5.5};
+
+  if (expectedOutTrace.size() == outTrace.size())
+  {
+    for (int i = 0; i < expectedOutTrace.size(); ++i)
+    {
+      TS_ASSERT_DELTA(expectedOutTrace[i].x, outTrace[i].x, .001);
+      TS_ASSERT_DELTA(expectedOutTrace[i].y, outTrace[i].y, .001);
+      TS_ASSERT_DELTA(expectedOutTrace[i].z, outTrace[i].z, .001);
+    }
+  }
+  else
+    TS_FAIL("Expected trace size != actual trace size");
+  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
+  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, 0.001);
+} // XmGridTraceUnitTests::testSmallScalarsTracePoint
+//------------------------------------------------------------------------------
+/// \brief test behavior when having large changes in direction
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testStrongDirectionChange()
+{
+  BSHP<XmGridTrace> tracer;
+  iCreateDefaultSingleCell(tracer);
+
+  tracer->SetMaxChangeDirectionInRadians(XM_PI * .2);
+  tracer->SetMinDeltaTime(-1);
+  // Push on different scalars
+  double time = 0;
+  VecPt3d scalars = {{0, 1, 0}, {-1, 0, 0}, {0, -1, 0}, {1, 0, 0}};
+  DynBitset pointActivity;
+  for (int i = 0; i < 4; ++i)
+  {
+    pointActivity.push_back(true);
+  }
+  tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_POINTS, pointActivity,
+                               DataLocationEnum::LOC_POINTS, time);
+
+  time = 10;
+  // Uses exact same scalars/pointActivity
+  tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_POINTS, pointActivity,
+                               DataLocationEnum::LOC_POINTS, time);
+
+  VecPt3d outTrace;
+  VecDbl outTimes;
+  Pt3d startPoint = {0, 0, 0};
+  double startTime = .5;
+  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
+
+  VecPt3d expectedOutTrace = {{0, 0, 0},
+                              {0.00000000000000000, 0.25000000000000000, 0.00000000000000000},
+                              {0.074999999999999997, 0.47499999999999998, 0.00000000000000000},
+                              {0.21900000214576720, 0.63699999570846555, 0.00000000000000000},
+                              {0.30928799843788146, 0.66810399758815764, 0.00000000000000000},
+                              {0.40229310507774352, 0.67396399235725402, 0.00000000000000000},
+                              {0.48679361495018003, 0.65024498560905453, 0.00000000000000000},
+                              {0.54780151323509219, 0.59909560095787040, 0.00000000000000000},
+                              {0.55928876277122497, 0.56619817004051198, 0.00000000000000000},
+                              {0.56114558691518779, 0.53247499044700608, 0.00000000000000000},
+                              {0.55189971330840681, 0.50228363992173752, 0.00000000000000000},
+                              {0.53269911067322617, 0.48131557500677169, 0.00000000000000000},
+                              {0.52076836142536975, 0.47806150355091476, 0.00000000000000000},
+                              {0.50886902895577013, 0.47838753608466128, 0.00000000000000000},
+                              {0.49867742691962913, 0.48264835153512164, 0.00000000000000000},
+                              {0.49224616907898289, 0.49014090685121131, 0.00000000000000000},
+                              {0.49173935940609609, 0.49438094923206660, 0.00000000000000000},
+                              {0.49250246625151450, 0.49839053740482164, 0.00000000000000000},
+                              {0.49454361321306389, 0.50154755045413602, 0.00000000000000000},
+                              {0.49745717820065949, 0.50317358562752867, 0.00000000000000000},
+                              {0.49888395770889871, 0.50301615091938545, 0.00000000000000000},
+                              {0.50012160117661586, 0.50244704462921241, 0.00000000000000000},
+                              {0.50095740046883197, 0.50152383477622209, 0.00000000000000000},
+                              {0.50107955145675120, 0.50098875888952354, 0.00000000000000000},
+                              {0.50105605626599747, 0.50045352403892940, 0.00000000000000000},
+                              {0.50086894918345870, 0.49998474718699493, 0.00000000000000000},
+                              {0.50053945884260675, 0.49966662451478433, 0.00000000000000000},
+                              {0.50034430627617277, 0.49962054739305783, 0.00000000000000000},
+                              {0.50015012042108842, 0.49962997721910873, 0.00000000000000000},
+                              {0.49998265395837810, 0.49970077747304897, 0.00000000000000000},
+                              {0.49987374966305814, 0.49982308521808211, 0.00000000000000000},
+                              {0.49986302487024292, 0.49988726006383088, 0.00000000000000000},
+                              {0.49986815504448728, 0.49994012045071656, 0.00000000000000000}};
+  VecDbl expectedOutTimes = {.5,
+                             0.75000000000000000,
+                             1.0500000000000000,
+                             1.4100000000000001,
+                             1.6260000000000001,
+                             1.8852000000000002,
+                             2.1962400000000004,
+                             2.5694880000000002,
+                             2.7934368000000003,
+                             3.0621753600000003,
+                             3.3846616320000003,
+                             3.7716451584000001,
+                             4.0038352742400001,
+                             4.2824634132480002,
+                             4.6168171800576001,
+                             5.0180417002291202,
+                             5.2587764123320317,
+                             5.5476580668555258,
+                             5.8943160522837186,
+                             6.3103056347975501,
+                             6.5598993843058491,
+                             6.8594118837158078,
+                             7.2188268830077584,
+                             7.4344758825829285,
+                             7.6932546820731327,
+                             8.0037892414613783,
+                             8.3764307127272737,
+                             8.6000155954868092,
+                             8.8683174547982535,
+                             9.1902796859719871,
+                             9.5766343633804656,
+                             9.7883171816902319,
+                             10.000000000000000};
+  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
+  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
+} // XmGridTraceUnitTests::testStrongDirectionChange
+//------------------------------------------------------------------------------
+/// \brief test setting max tracing time
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testMaxTracingTime()
+{
+  BSHP<XmGridTrace> tracer;
+  iCreateDefaultSingleCell(tracer);
+
+  tracer->SetMaxChangeDirectionInRadians(XM_PI * .2);
+  tracer->SetMinDeltaTime(-1);
+  tracer->SetMaxTracingTime(5);
+  // Push on different scalars
+  double time = 0;
+  VecPt3d scalars = {{0, 1, 0}, {-1, 0, 0}, {0, -1, 0}, {1, 0, 0}};
+  DynBitset pointActivity;
+  for (int i = 0; i < 4; ++i)
+  {
+    pointActivity.push_back(true);
+  }
+  tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_POINTS, pointActivity,
+                               DataLocationEnum::LOC_POINTS, time);
+
+  time = 10;
+  // Uses exact same scalars/pointActivity
+  tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_POINTS, pointActivity,
+                               DataLocationEnum::LOC_POINTS, time);
+
+  VecPt3d outTrace;
+  VecDbl outTimes;
+  Pt3d startPoint = {0, 0, 0};
+  double startTime = .5;
+  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
+
+  VecPt3d expectedOutTrace = {{0, 0, 0},
+                              {0.00000000000000000, 0.25000000000000000, 0.00000000000000000},
+                              {0.074999999999999997, 0.47499999999999998, 0.00000000000000000},
+                              {0.21900000214576720, 0.63699999570846555, 0.00000000000000000},
+                              {0.30928799843788146, 0.66810399758815764, 0.00000000000000000},
+                              {0.40229310507774352, 0.67396399235725402, 0.00000000000000000},
+                              {0.48679361495018003, 0.65024498560905453, 0.00000000000000000},
+                              {0.54780151323509219, 0.59909560095787040, 0.00000000000000000},
+                              {0.55928876277122497, 0.56619817004051198, 0.00000000000000000},
+                              {0.56114558691518779, 0.53247499044700608, 0.00000000000000000},
+                              {0.55189971330840681, 0.50228363992173752, 0.00000000000000000},
+                              {0.53269911067322617, 0.48131557500677169, 0.00000000000000000},
+                              {0.52076836142536975, 0.47806150355091476, 0.00000000000000000},
+                              {0.50886902895577013, 0.47838753608466128, 0.00000000000000000},
+                              {0.49867742691962913, 0.48264835153512164, 0.00000000000000000},
+                              {0.49224616907898289, 0.49014090685121131, 0.00000000000000000},
+                              {0.49173935940609609, 0.49438094923206660, 0.00000000000000000},
+                              {0.49237657318600692, 0.49772905815126539, 0.00000000000000000}};
+  VecDbl expectedOutTimes = {.5,
+                             0.75000000000000000,
+                             1.0500000000000000,
+                             1.4100000000000001,
+                             1.6260000000000001,
+                             1.8852000000000002,
+                             2.1962400000000004,
+                             2.5694880000000002,
+                             2.7934368000000003,
+                             3.0621753600000003,
+                             3.3846616320000003,
+                             3.7716451584000001,
+                             4.0038352742400001,
+                             4.2824634132480002,
+                             4.6168171800576001,
+                             5.0180417002291202,
+                             5.2587764123320317,
+                             5.5};
+  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
+  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
+} // XmGridTraceUnitTests::testMaxTracingTime
+//------------------------------------------------------------------------------
+/// \brief test setting the max tracing distance
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testMaxTracingDistance()
+{
+  BSHP<XmGridTrace> tracer;
+  iCreateDefaultSingleCell(tracer);
+
+  tracer->SetMaxChangeDirectionInRadians(XM_PI * .2);
+  tracer->SetMinDeltaTime(-1);
+  tracer->SetMaxTracingDistance(1.0);
+  // Push on different scalars
+  double time = 0;
+  VecPt3d scalars = {{0, 1, 0}, {-1, 0, 0}, {0, -1, 0}, {1, 0, 0}};
+  DynBitset pointActivity;
+  for (int i = 0; i < 4; ++i)
+  {
+    pointActivity.push_back(true);
+  }
+  tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_POINTS, pointActivity,
+                               DataLocationEnum::LOC_POINTS, time);
+
+  time = 10;
+  // Uses exact same scalars/pointActivity
+  tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_POINTS, pointActivity,
+                               DataLocationEnum::LOC_POINTS, time);
+
+  VecPt3d outTrace;
+  VecDbl outTimes;
+  Pt3d startPoint = {0, 0, 0};
+  double startTime = .5;
+  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
+
+  VecPt3d expectedOutTrace = {{0, 0, 0},
+                              {0.00000000000000000, 0.25000000000000000, 0.00000000000000000},
+                              {0.074999999999999997, 0.47499999999999998, 0.00000000000000000},
+                              {0.21900000214576720, 0.63699999570846555, 0.00000000000000000},
+                              {0.30928799843788146, 0.66810399758815764, 0.00000000000000000},
+                              {0.40229310507774352, 0.67396399235725402, 0.00000000000000000},
+                              {0.48679361495018003, 0.65024498560905453, 0.00000000000000000},
+                              {0.50183556502673621, 0.63763372523131490, 0.00000000000000000}};
+  VecDbl expectedOutTimes = {.5,
+                             0.75000000000000000,
+                             1.0500000000000000,
+                             1.4100000000000001,
+                             1.6260000000000001,
+                             1.8852000000000002,
+                             2.1962400000000004,
+                             2.4774609356360582};
+  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
+  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
+} // XmGridTraceUnitTests::testMaxTracingDistance
+//------------------------------------------------------------------------------
+/// \brief test behavior when starting point is out of the cell
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testStartOutOfCell()
+{
+  BSHP<XmGridTrace> tracer;
+  iCreateDefaultSingleCell(tracer);
+
+  VecPt3d outTrace;
+  VecDbl outTimes;
+  Pt3d startPoint = {-.1, 0, 0};
+  double startTime = .5;
+
+  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
+
+  VecPt3d expectedOutTrace = {};
+  VecDbl expectedOutTimes = {};
+  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
+  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
+} // XmGridTraceUnitTests::testStartOutOfCell
+//------------------------------------------------------------------------------
+/// \brief test the angle function
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testDotProduct()
+{
+  TS_ASSERT_DELTA(iGetDirAsCosTheta(0, 1, 1, 0), 0, .1);     // 90 degree angle
+  TS_ASSERT_DELTA(iGetDirAsCosTheta(0, 1, 1, 1), .707, .1);  // 45 degree angle
+  TS_ASSERT_DELTA(iGetDirAsCosTheta(0, 1, 0, -1), -1, .1);   // 180 degree angle
+  TS_ASSERT_DELTA(iGetDirAsCosTheta(1, 1, -1, -1), -1, .1);  // 180 degree angle
+  TS_ASSERT_DELTA(iGetDirAsCosTheta(2, 5, 3, 6), .9965, .1); // almost 0 degree angle
+  TS_ASSERT_DELTA(iGetDirAsCosTheta(0, 1, 0, 1), 1, .1);     // 0 degree angle
+} // XmGridTraceUnitTests::testDotProduct
+//------------------------------------------------------------------------------
+/// \brief test behavior when starting beyond the second time step
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testBeyondTimestep()
+{
+  BSHP<XmGridTrace> tracer;
+  iCreateDefaultSingleCell(tracer);
+
+  VecPt3d outTrace;
+  VecDbl outTimes;
+  Pt3d startPoint = {.5, .5, 0};
+  double startTime = 10.1; // Just beyond the 2nd time
+
+  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
+
+  VecPt3d expectedOutTrace = {};
+  VecDbl expectedOutTimes = {};
+  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
+  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
+  // An empty trace on its own does not say which of several unrelated things happened, which
+  // is how this case went unnoticed as an extraction failure. The field simply is not known
+  // this far ahead yet, so the trace is waiting -- supplying a later time step starts it.
+  TS_ASSERT_EQUALS((int)GTEXIT_WAITING_FOR_TIME_STEP, (int)tracer->GetExitReason());
+} // XmGridTraceUnitTests::testBeyondTimestep
+//------------------------------------------------------------------------------
+/// \brief test the behavior when starting before the first timestep
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testBeforeTimestep()
+{
+  BSHP<XmGridTrace> tracer;
+  iCreateDefaultSingleCell(tracer);
+
+  VecPt3d outTrace;
+  VecDbl outTimes;
+  Pt3d startPoint = {.5, .5, 0};
+  double startTime = -0.1; // Just beyond the 2nd time
+
+  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
+
+  VecPt3d expectedOutTrace = {{.5, .5, 0}, {1, 1, 0}};
+  VecDbl expectedOutTimes = {-.1, .4};
+  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
+  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
+} // XmGridTraceUnitTests::testBeforeTimestep
+//------------------------------------------------------------------------------
+/// \brief test behavior of the vector multiplier
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testVectorMultiplier()
+{
+  BSHP<XmGridTrace> tracer;
+  iCreateDefaultSingleCell(tracer);
+
+  tracer->SetMaxChangeDirectionInRadians(XM_PI * .2);
+  tracer->SetMinDeltaTime(-1);
+  tracer->SetVectorMultiplier(0.5);
+  // Push on different scalars
+  double time = 0;
+  VecPt3d scalars = {{0, 1, 0}, {-1, 0, 0}, {0, -1, 0}, {1, 0, 0}};
+  DynBitset pointActivity;
+  for (int i = 0; i < 4; ++i)
+  {
+    pointActivity.push_back(true);
+  }
+  tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_POINTS, pointActivity,
+                               DataLocationEnum::LOC_POINTS, time);
+
+  time = 10;
+  // Uses exact same scalars/pointActivity
+  tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_POINTS, pointActivity,
+                               DataLocationEnum::LOC_POINTS, time);
+
+  VecPt3d outTrace;
+  VecDbl outTimes;
+  Pt3d startPoint = {0, 0, 0};
+  double startTime = .5;
+  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
+
+  VecPt3d expectedOutTrace = {{0, 0, 0},
+                              {0.00000000000000000, 0.25000000000000000, 0.00000000000000000},
+                              {0.074999999999999997, 0.47499999999999998, 0.00000000000000000},
+                              {0.21900000214576720, 0.63699999570846555, 0.00000000000000000},
+                              {0.30928799843788146, 0.66810399758815764, 0.00000000000000000},
+                              {0.40229310507774352, 0.67396399235725402, 0.00000000000000000},
+                              {0.48679361495018003, 0.65024498560905453, 0.00000000000000000},
+                              {0.54780151323509219, 0.59909560095787040, 0.00000000000000000},
+                              {0.55928876277122497, 0.56619817004051198, 0.00000000000000000},
+                              {0.56114558691518779, 0.53247499044700608, 0.00000000000000000},
+                              {0.55189971330840681, 0.50228363992173752, 0.00000000000000000},
+                              {0.53269911067322617, 0.48131557500677169, 0.00000000000000000},
+                              {0.52076836142536975, 0.47806150355091476, 0.00000000000000000},
+                              {0.50886902895577013, 0.47838753608466128, 0.00000000000000000},
+                              {0.49867742691962913, 0.48264835153512164, 0.00000000000000000},
+                              {0.49224616907898289, 0.49014090685121131, 0.00000000000000000},
+                              {0.49175783605462037, 0.49422637094165467, 0.00000000000000000}};
+  VecDbl expectedOutTimes = {.5,
+                             1.0000000000000000,
+                             1.6000000000000001,
+                             2.3200000000000003,
+                             2.7520000000000002,
+                             3.2704000000000004,
+                             3.8924800000000004,
+                             4.6389760000000004,
+                             5.0868736000000006,
+                             5.6243507200000007,
+                             6.2693232640000005,
+                             7.0432903168000003,
+                             7.5076705484800001,
+                             8.0649268264960003,
+                             8.7336343601152002,
+                             9.5360834004582404,
+                             10.000000000000000};
+  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
+  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
+} // XmGridTraceUnitTests::testVectorMultiplier
+//------------------------------------------------------------------------------
+/// \brief test behavior of multiple cells
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testMultiCell()
+{
+  BSHP<XmGridTrace> tracer;
+  iCreateDefaultTwoCell(tracer);
+
+  VecPt3d outTrace;
+  VecDbl outTimes;
+  Pt3d startPoint = {.5, .5, 0};
+  double startTime = 0;
+
+  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
+
+  VecPt3d expectedOutTrace = {{.5, .5, 0},
+                              {0.60000000149011612, 0.50000000000000000, 0.00000000000000000},
+                              {0.73200000077486038, 0.50000000000000000, 0.00000000000000000},
+                              {0.90940801054239273, 0.50000000000000000, 0.00000000000000000},
+                              {1.1529537134766579, 0.50000000000000000, 0.00000000000000000},
+                              {1.4957102079987525, 0.50000000000000000, 0.00000000000000000},
+                              {1.9923067892670629, 0.50000000000000000, 0.00000000000000000},
+                              {2, .5, 0}};
+  VecDbl expectedOutTimes = {0,
+                             1.0000000000000000,
+                             2.2000000000000002,
+                             3.6400000000000001,
+                             5.3680000000000003,
+                             7.4416000000000002,
+                             9.9299199999999992,
+                             9.9683860530914945};
+  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
+  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
+} // XmGridTraceUnitTests::testMultiCell
+//------------------------------------------------------------------------------
+/// \brief Testing what happens when the maximum change in velocity is low
+////         It reaches a point of high acceleration, and then the delta time
+////         decreases until it goes below the minimum delta time.
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testMaxChangeVelocity()
+{
+  BSHP<XmGridTrace> tracer;
+  iCreateDefaultTwoCell(tracer);
+  tracer->SetMaxChangeVelocity(.01);
+  tracer->SetMinDeltaTime(0.001);
+
+  VecPt3d outTrace;
+  VecDbl outTimes;
+  Pt3d startPoint = {.5, .5, 0};
+  double startTime = 0;
+
+  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
+
+  VecPt3d expectedOutTrace = {{.5, .5, 0},
+                              {0.60000000149011612, 0.50000000000000000, 0.00000000000000000},
+                              {0.66600000113248825, 0.50000000000000000, 0.00000000000000000},
+                              {0.74995200067758561, 0.50000000000000000, 0.00000000000000000},
+                              {0.80394992786645891, 0.50000000000000000, 0.00000000000000000},
+                              {0.87154669338464741, 0.50000000000000000, 0.00000000000000000},
+                              {0.95686786960840231, 0.50000000000000000, 0.00000000000000000},
+                              {1.0112451727318765, 0.50000000000000000, 0.00000000000000000},
+                              {1.0789334834771158, 0.50000000000000000, 0.00000000000000000},
+                              {1.1637975516948893, 0.50000000000000000, 0.00000000000000000},
+                              {1.2174527417415202, 0.50000000000000000, 0.00000000000000000},
+                              {1.2839153379250163, 0.50000000000000000, 0.00000000000000000},
+                              {1.3667568384715398, 0.50000000000000000, 0.00000000000000000},
+                              {1.4187699365302351, 0.50000000000000000, 0.00000000000000000},
+                              {1.4829247317645506, 0.50000000000000000, 0.00000000000000000},
+                              {1.5624845364724593, 0.50000000000000000, 0.00000000000000000},
+                              {1.6587784227485147, 0.50000000000000000, 0.00000000000000000},
+                              {1.7743310862797812, 0.50000000000000000, 0.00000000000000000},
+                              {1.9129942825173010, 0.50000000000000000, 0.00000000000000000},
+                              {2, .5, 0}};
+  VecDbl expectedOutTimes = {0,
+                             1.0000000000000000,
+                             1.6000000000000001,
+                             2.3200000000000003,
+                             2.7520000000000002,
+                             3.2704000000000004,
+                             3.8924800000000004,
+                             4.2657280000000002,
+                             4.7136256000000003,
+                             5.2511027200000004,
+                             5.5735889920000004,
+                             5.9605725184000002,
+                             6.4249527500800001,
+                             6.7035808890880002,
+                             7.0379346558976001,
+                             7.4391591760691202,
+                             7.9206286002749442,
+                             8.4983919093219331,
+                             9.1917078801783187,
+                             9.6267364611093829};
+  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
+  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
+} // XmGridTraceUnitTests::testMaxChangeVelocity
+//------------------------------------------------------------------------------
+/// \brief Test behavior for unique timesteps
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testUniqueTimeSteps()
+{
+  BSHP<XmGridTrace> tracer;
+  iCreateDefaultTwoCell(tracer);
+
+  double time = 20;
+  VecPt3d scalars = {{.2, 0, 0}, {.3, 0, 0}};
+  DynBitset pointActivity;
+  for (int i = 0; i < 2; ++i)
+  {
+    pointActivity.push_back(true);
+  }
+  tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_CELLS, pointActivity,
+                               DataLocationEnum::LOC_CELLS, time);
+
+  VecPt3d outTrace;
+  VecDbl outTimes;
+  Pt3d startPoint = {.5, .5, 0};
+  double startTime = 10;
+
+  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
+
+  VecPt3d expectedOutTrace = {{0.5, 0.5, 0},
+                              {0.60000000149011612, 0.5, 0},
+                              {0.74400000184774395, 0.5, 0},
+                              {0.95481600679159162, 0.5, 0},
+                              {1.2691074101881981, 0.5, 0},
+                              {1.747260385068264, 0.5, 0},
+                              {2, 0.5, 0}};
+  VecDbl expectedOutTimes = {10,
+                             11,
+                             12.199999999999999,
+                             13.640000000000001,
+                             15.368,
+                             17.441600000000001,
+                             18.362609001148471};
+  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
+  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
+} // XmGridTraceUnitTests::testUniqueTimeSteps
+//------------------------------------------------------------------------------
+/// \brief 2nd cell is inactive in the 2nd time step.
+/////        Thus it does not pull as hard. Also once the point reaches the 2nd cell
+/////        It stops entirely.
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testInactiveCell()
+{
+  BSHP<XmGridTrace> tracer;
+  iCreateDefaultTwoCell(tracer);
+
+  double time = 20;
+  VecPt3d scalars = {{.2, 0, 0}, {99999, 0, 0}};
+  DynBitset pointActivity;
+  pointActivity.push_back(true);
+  pointActivity.push_back(false);
+  tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_CELLS, pointActivity,
+                               DataLocationEnum::LOC_CELLS, time);
+
+  VecPt3d outTrace;
+  VecDbl outTimes;
+  Pt3d startPoint = {.5, .5, 0};
+  double startTime = 10;
+
+  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
+
+  VecPt3d expectedOutTrace = {{0.5, 0.5, 0},
+                              {0.60000000149011612, 0.5, 0},
+                              {0.74280000120401379, 0.5, 0},
+                              {0.94575130454301826, 0.5, 0},
+                              {1, 0.5, 0}};
+  VecDbl expectedOutTimes = {10,
+                             11,
+                             12.199999999999999,
+                             13.640000000000001,
+                             13.969279307058475};
+  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
+  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
+} // XmGridTraceUnitTests::testInactiveCell
+//------------------------------------------------------------------------------
+/// \brief The point starts in an inactive cell, and doesnt move
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testStartInactiveCell()
+{
+  BSHP<XmGridTrace> tracer;
+  iCreateDefaultTwoCell(tracer);
+
+  double time = 20;
+  VecPt3d scalars = {{1, 0, 0}, {99999, 0, 0}};
+  DynBitset pointActivity;
+  pointActivity.push_back(false);
+  pointActivity.push_back(true);
+  tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_CELLS, pointActivity,
+                               DataLocationEnum::LOC_CELLS, time);
+
+  VecPt3d outTrace;
+  VecDbl outTimes;
+  Pt3d startPoint = {.5, .5, 0};
+  double startTime = 10;
+
+  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
+
+  VecPt3d expectedOutTrace = {};
+  VecDbl expectedOutTimes = {};
+  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
+  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
+} // XmGridTraceUnitTests::testStartInactiveCell
+//------------------------------------------------------------------------------
+/// \brief 2nd cell is inactive in the 2nd time step.
+/////        Thus it does not pull as hard. Also once the point reaches the 2nd cell
+/////        It stops entirely.
+//------------------------------------------------------------------------------
+//! [snip_test_Example_XmGridTrace]
+void XmGridTraceUnitTests::testTutorial()
+{
+  // Graph with scalar vectors indicated
+  //  ->   ->
+  //  6----7----8|
+  //  |    |    |v
+  //  |    |    |
+  //  |    |    |
+  // ^|    |    |
+  // |3----4----5|
+  //  |    |    |v
+  //  |    |    |
+  //  |    |    |
+  // ^|    |    |
+  // |0----1----2
+  //      <-   <--
+  // Step 1: Create the grid
+  VecPt3d points = {{0, 0, 0}, {1, 0, 0}, {2, 0, 0}, {0, 1, 0}, {1, 1, 0},
+                    {2, 1, 0}, {0, 2, 0}, {1, 2, 0}, {2, 2, 0}};
+  VecInt cells = {XMU_QUAD, 4, 0, 1, 4, 3, XMU_QUAD, 4, 1, 2, 5, 4,
+                  XMU_QUAD, 4, 3, 4, 7, 6, XMU_QUAD, 4, 4, 5, 8, 7};
+  std::shared_ptr<XmUGrid> ugrid = XmUGrid::New(points, cells);
+
+  // Step 2: Create the tracer from the grid
+  BSHP<XmGridTrace> tracer = XmGridTrace::New(ugrid);
+
+  // Step 3: Set up the constraints on the tracer
+  tracer->SetVectorMultiplier(2);
+  tracer->SetMaxTracingTime(-1);
+  tracer->SetMaxTracingDistance(-1);
+  tracer->SetMinDeltaTime(.01);
+  tracer->SetMaxChangeDistance(-1);
+  tracer->SetMaxChangeVelocity(-1);
+  tracer->SetMaxChangeDirectionInRadians(XM_PI / 4);
+
+  // Step 4: Set up the velocity vectors for both time steps. Insert timesteps sequentially
+  double time = 0;
+  // Scalars are set such that they circle around the edge of the graph in a clockwise direction
+  // Z component is not used in scalars
+  VecPt3d scalars1 = {{0, 1, 0},   {-.1, 0, 0}, {-1, 0, 0}, {0, .1, 0}, {0, 0, 0},
+                      {0, -.1, 0}, {1, 0, 0},   {.1, 0, 0}, {0, -1, 0}};
+  DynBitset pointActivity;
+  for (int i = 0; i < 9; ++i)
+  {
+    pointActivity.push_back(true);
+  }
+  tracer->AddGridScalarsAtTime(scalars1, DataLocationEnum::LOC_POINTS, pointActivity,
+                               DataLocationEnum::LOC_POINTS, time);
+
+  // For the second timestep scalars are doubled to indicate an increase in magnitude
+  VecPt3d scalars2 = {{0, 2, 0},   {-.2, 0, 0}, {-2, 0, 0}, {0, .2, 0}, {0, 0, 0},
+                      {0, -.2, 0}, {2, 0, 0},   {.2, 0, 0}, {0, -2, 0}};
+  time = 20;
+  // Uses exact same scalars/pointActivity
+  tracer->AddGridScalarsAtTime(scalars2, DataLocationEnum::LOC_POINTS, pointActivity,
+                               DataLocationEnum::LOC_POINTS, time);
+
+  VecPt3d outTrace;
+  VecDbl outTimes;
+  Pt3d startPoint = {.5, .5, 0};
+  double startTime = 0;
+
+  // Step 5: Trace the point
+  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
+  // show the cause for termination by calling GetExitMessage
+  // std::cout << tracer->GetExitMessage();
+
+  // Expected values for this simulation
+  VecPt3d expectedOutTrace = {{0.5, 0.5, 0},
+                              {0.5, 1.5, 0},
+                              {0.62600000187754634, 1.6260000018775462, 0},
+                              {0.82611968728899965, 1.7455603212296962, 0},
+                              {0.97840008102011689, 1.7810753047635555, 0},
+                              {1.0280095840364933, 1.7824472100312621, 0},
+                              {1.0861189816907613, 1.7608732599310344, 0},
+                              {1.1492686295114336, 1.6802752810470523, 0},
+                              {1.2097920698566107, 1.5101408581884392, 0},
+                              {1.2515951471975522, 1.2181485463468757, 0},
+                              {1.2515951471975522, 0.84053651390559747, 0},
+                              {1.2181758214493843, 0.78780883088769804, 0},
+                              {1.1632869448015855, 0.73137186792498654, 0},
+                              {1.0771209832183524, 0.67899546053648097, 0},
+                              {1.0129487663521615, 0.66357815692798783, 0},
+                              {0.97169356095126669, 0.66199025753694563, 0},
+                              {0.92552080990281416, 0.70419149113367874, 0},
+                              {0.88530832700558759, 0.83950990950827409, 0},
+                              {0.87513974259796246, 1.0941588844381676, 0},
+                              {0.90077009637050098, 1.128146252166127, 0},
+                              {0.943692705404238, 1.1613833261644337, 0},
+                              {0.97709108330292604, 1.1730361561747586, 0},
+                              {0.99894959169213471, 1.1759300874982919, 0},
+                              {1.0124203987349505, 1.1760105163064269, 0},
+                              {1.0275428271398932, 1.1645289800266216, 0},
+                              {1.042848666622334, 1.1337546211004945, 0},
+                              {1.055142468614698, 1.0758075939238765, 0},
+                              {1.0585305184379035, 0.98540145004498747, 0},
+                              {1.0556233679912082, 0.97374570199926891, 0},
+                              {1.0492587242876892, 0.9602613226646981, 0},
+                              {1.0375007181419984, 0.94568649411103145, 0},
+                              {1.017827020259642, 0.93210280494582176, 0},
+                              {1.0175992759724071, 0.93204300863222744, 0}};
+  VecDbl expectedOutTimes = {0,
+                             1,
+                             2.2000000000000002,
+                             3.6400000000000001,
+                             4.5040000000000004,
+                             4.7632000000000003,
+                             5.0742400000000005,
+                             5.4474880000000008,
+                             5.8953856000000009,
+                             6.432862720000001,
+                             7.0778352640000008,
+                             7.8518023168000006,
+                             8.7805627801600004,
+                             9.8950753361920007,
+                             10.563782869811201,
+                             10.96500738998272,
+                             11.446476814188543,
+                             12.024240123235531,
+                             12.717556094091917,
+                             13.54953525911958,
+                             14.547910257152775,
+                             15.146935255972693,
+                             15.506350255264643,
+                             15.721999254839814,
+                             15.980778054330019,
+                             16.291312613718265,
+                             16.663954084984159,
+                             17.111123850503233,
+                             17.647727569126122,
+                             18.291652031473589,
+                             19.064361386290546,
+                             19.991612612070895,
+                             20};
+  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
+  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
+} // XmGridTraceUnitTests::testTutorial
+  //! [snip_test_Example_XmGridTrace]
+//------------------------------------------------------------------------------
+/// \brief A trace through a field that changes between timesteps follows neither timestep.
+///
+/// This is the regression guard for the time interpolation, which is the whole reason this
+/// tracer is worth routing a display option through: a tracer that samples one frozen
+/// timestep would be no better than the render-time drifter it replaces.
+///
+/// The field rotates from +x at the first timestep to +y at the second rather than
+/// reversing, so the interpolated velocity never passes through zero and cannot trip the
+/// "velocity has gone to zero" exit partway along.
+///
+/// The first assertion is the one that catches an inverted interpolation: a particle
+/// released exactly at the first timestep must be advected by that timestep's field alone,
+/// so its first step is due east with y untouched. Weighting each timestep by its own
+/// distance from the current time instead sends that first step due north.
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testTimeVaryingFieldChangesPath()
+{
+  // One cell spanning the whole domain, so cell-located scalars give a spatially uniform
+  // field and any curvature in the path can only have come from time.
+  VecPt3d points = {{0, 0, 0}, {10, 0, 0}, {10, 10, 0}, {0, 10, 0}};
+  VecInt cells = {XMU_QUAD, 4, 0, 1, 2, 3};
+  std::shared_ptr<XmUGrid> ugrid = XmUGrid::New(points, cells);
+
+  DynBitset activity;
+  activity.push_back(true);
+
+  auto traceWithField = [&](const Pt3d& a_first, const Pt3d& a_second, VecPt3d& a_outTrace) {
+    BSHP<XmGridTrace> tracer = XmGridTrace::New(ugrid);
+    tracer->SetVectorMultiplier(1);
+    tracer->SetMaxTracingTime(5);
+    tracer->SetMaxTracingDistance(100);
+    tracer->SetMinDeltaTime(.01);
+    tracer->SetMaxChangeDistance(.5);
+    tracer->SetMaxChangeVelocity(-1);
+    tracer->SetMaxChangeDirectionInRadians(XM_PI); // never subdivide on direction
+    VecPt3d first = {a_first};
+    VecPt3d second = {a_second};
+    tracer->AddGridScalarsAtTime(first, DataLocationEnum::LOC_CELLS, activity,
+                                 DataLocationEnum::LOC_CELLS, 0.0);
+    tracer->AddGridScalarsAtTime(second, DataLocationEnum::LOC_CELLS, activity,
+                                 DataLocationEnum::LOC_CELLS, 10.0);
+    VecDbl outTimes;
+    tracer->TracePoint({1, 1, 0}, 0.0, a_outTrace, outTimes);
+    TS_ASSERT_EQUALS(a_outTrace.size(), outTimes.size());
+  };
+
+  const Pt3d startPoint = {1, 1, 0};
+
+  VecPt3d rotating;
+  traceWithField({1, 0, 0}, {0, 1, 0}, rotating);
+
+  // The same field at both timesteps -- what a single-timestep tracer would produce.
+  VecPt3d frozen;
+  traceWithField({1, 0, 0}, {1, 0, 0}, frozen);
+
+  TS_ASSERT(rotating.size() >= 3);
+  TS_ASSERT(frozen.size() >= 3);
+
+  // Released at the first timestep, so the first step is that timestep's field alone.
+  TS_ASSERT_DELTA(startPoint.y, rotating[1].y, 1e-9);
+  TS_ASSERT(rotating[1].x > startPoint.x);
+
+  // A frozen field never turns.
+  for (size_t i = 0; i < frozen.size(); ++i)
+  {
+    TS_ASSERT_DELTA(startPoint.y, frozen[i].y, 1e-9);
+  }
+
+  // A changing one does, and that difference is the feature.
+  TS_ASSERT(rotating.back().y > startPoint.y + 0.1);
+  TS_ASSERT(rotating.back().x < frozen.back().x);
+} // XmGridTraceUnitTests::testTimeVaryingFieldChangesPath
+//------------------------------------------------------------------------------
+/// \brief A single-window batch returns exactly what serial TracePoint calls return.
+///
+/// The batch exists to cross a language boundary once instead of once per seed, so its value
+/// depends on being a faithful stand-in. Comparing against serial TracePoint on an identical
+/// fixture is a stronger oracle than a recorded baseline, which would drift with the tracer
+/// rather than pin the equivalence.
+///
+/// The seeds cover the shapes a caller has to handle: traces that leave the grid, and a seed
+/// outside the grid entirely, which yields no polyline at all.
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testBatchMatchesSerialTracePoint()
+{
+  const VecPt3d seeds = {{.5, .5, 0}, {.25, .75, 0}, {-.1, 0, 0}};
+  const VecDbl seedTimes = {.5, .5, .5};
+
+  BSHP<XmGridTrace> serialTracer;
+  iCreateDefaultSingleCell(serialTracer);
+  std::vector<VecPt3d> serialTraces(seeds.size());
+  std::vector<VecDbl> serialTimes(seeds.size());
+  std::vector<XmGridTraceExitEnum> serialReasons(seeds.size());
+  for (size_t i = 0; i < seeds.size(); ++i)
+  {
+    serialTracer->TracePoint(seeds[i], seedTimes[i], serialTraces[i], serialTimes[i]);
+    serialReasons[i] = serialTracer->GetExitReason();
+  }
+
+  BSHP<XmGridTrace> batchTracer;
+  iCreateDefaultSingleCell(batchTracer);
+  batchTracer->StartTraces(seeds, seedTimes);
+  batchTracer->ContinueTraces();
+  std::vector<VecPt3d> batchTraces;
+  std::vector<VecDbl> batchTimes;
+  std::vector<XmGridTraceExitEnum> reasons;
+  batchTracer->GetTraceResults(batchTraces, batchTimes, reasons);
+
+  TS_ASSERT_EQUALS(seeds.size(), batchTraces.size());
+  TS_ASSERT_EQUALS(seeds.size(), batchTimes.size());
+  TS_ASSERT_EQUALS(seeds.size(), reasons.size());
+  for (size_t i = 0; i < seeds.size(); ++i)
+  {
+    TS_ASSERT_DELTA_VECPT3D(serialTraces[i], batchTraces[i], 1e-12);
+    TS_ASSERT_DELTA_VEC(serialTimes[i], batchTimes[i], 1e-12);
+    // GetExitReason is the single-point path's answer to what GetTraceResults reports per
+    // seed; if they can disagree, a caller cannot use TracePoint and the batch interchangeably.
+    TS_ASSERT_EQUALS((int)reasons[i], (int)serialReasons[i]);
+    // Positions and times are documented as parallel arrays, so a caller may zip them.
+    TS_ASSERT_EQUALS(batchTraces[i].size(), batchTimes[i].size());
+  }
+
+  // The seed outside the grid produces no polyline -- callers cannot assume one per seed.
+  TS_ASSERT(batchTraces[2].empty());
+  TS_ASSERT_EQUALS((int)GTEXIT_SEED_NOT_TRACEABLE, (int)reasons[2]);
+  TS_ASSERT(batchTraces[0].size() >= 2);
+  TS_ASSERT(batchTraces[1].size() >= 2);
+
+  // A caller supplying the wrong number of start times has a bug; seeding the common prefix
+  // would hide it, so the whole batch is refused.
+  batchTracer->StartTraces(seeds, {.5});
+  batchTracer->GetTraceResults(batchTraces, batchTimes, reasons);
+  TS_ASSERT(batchTraces.empty());
+  TS_ASSERT(batchTimes.empty());
+  TS_ASSERT(reasons.empty());
+} // XmGridTraceUnitTests::testBatchMatchesSerialTracePoint
+//------------------------------------------------------------------------------
+/// \brief A trace continues past the second time step once a later one is supplied.
+///
+/// This is the point of the whole batch design: the field is only known between the two
+/// loaded time steps, so a trace that wants to run further has to stop, ask for more, and
+/// resume where it was -- carrying its budgets, its adaptive step size and its previous
+/// velocity with it.
+///
+/// The strongest assertion here is not that the continued trace is longer. It is that the
+/// trace which never received the third time step is a byte-for-byte *prefix* of the one
+/// that did. That is what shows resuming extends the path rather than recomputing it, and it
+/// is what would fail if any carried-over state were dropped at the window boundary.
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testTracesContinueAcrossTimeSteps()
+{
+  // One cell spanning the domain, so the field is spatially uniform and every change in the
+  // path comes from time. It rotates +x -> +y -> -x across three time steps.
+  VecPt3d points = {{0, 0, 0}, {40, 0, 0}, {40, 40, 0}, {0, 40, 0}};
+  VecInt cells = {XMU_QUAD, 4, 0, 1, 2, 3};
+  std::shared_ptr<XmUGrid> ugrid = XmUGrid::New(points, cells);
+
+  DynBitset activity;
+  activity.push_back(true);
+  const VecPt3d seeds = {{20, 10, 0}};
+  const VecDbl seedTimes = {0};
+
+  auto buildTracer = [&]() {
+    BSHP<XmGridTrace> tracer = XmGridTrace::New(ugrid);
+    tracer->SetVectorMultiplier(1);
+    tracer->SetMaxTracingTime(18);
+    tracer->SetMaxTracingDistance(1000);
+    tracer->SetMinDeltaTime(.01);
+    tracer->SetMaxChangeDistance(.5);
+    tracer->SetMaxChangeVelocity(-1);
+    tracer->SetMaxChangeDirectionInRadians(XM_PI); // never subdivide on direction
+    VecPt3d east = {{1, 0, 0}}, north = {{0, 1, 0}};
+    tracer->AddGridScalarsAtTime(east, DataLocationEnum::LOC_CELLS, activity,
+                                 DataLocationEnum::LOC_CELLS, 0.0);
+    tracer->AddGridScalarsAtTime(north, DataLocationEnum::LOC_CELLS, activity,
+                                 DataLocationEnum::LOC_CELLS, 10.0);
+    return tracer;
+  };
+
+  // Never given the third time step: it must stop at the second and say so.
+  BSHP<XmGridTrace> stopped = buildTracer();
+  stopped->StartTraces(seeds, seedTimes);
+  TS_ASSERT_EQUALS(1, stopped->ContinueTraces());
+  std::vector<VecPt3d> stoppedTraces;
+  std::vector<VecDbl> stoppedTimes;
+  std::vector<XmGridTraceExitEnum> stoppedReasons;
+  stopped->GetTraceResults(stoppedTraces, stoppedTimes, stoppedReasons);
+  TS_ASSERT_EQUALS((int)GTEXIT_WAITING_FOR_TIME_STEP, (int)stoppedReasons[0]);
+  TS_ASSERT_DELTA(10.0, stoppedTimes[0].back(), 1e-9);
+
+  // Given the third: it must resume and run out its tracing time instead.
+  BSHP<XmGridTrace> continued = buildTracer();
+  continued->StartTraces(seeds, seedTimes);
+  TS_ASSERT_EQUALS(1, continued->ContinueTraces());
+  VecPt3d west = {{-1, 0, 0}};
+  continued->AddGridScalarsAtTime(west, DataLocationEnum::LOC_CELLS, activity,
+                                  DataLocationEnum::LOC_CELLS, 20.0);
+  TS_ASSERT_EQUALS(0, continued->ContinueTraces());
+  std::vector<VecPt3d> traces;
+  std::vector<VecDbl> times;
+  std::vector<XmGridTraceExitEnum> reasons;
+  continued->GetTraceResults(traces, times, reasons);
+  TS_ASSERT_EQUALS((int)GTEXIT_MAX_TRACING_TIME, (int)reasons[0]);
+  TS_ASSERT_DELTA(18.0, times[0].back(), 1e-9);
+
+  // Pinned: a trace resumes with the step that was cut short to land on t = 10, whatever the
+  // window's size, and these are the points it has always produced.
+  TS_ASSERT_EQUALS(35, traces[0].size());
+  TS_ASSERT_DELTA(22.336482412555245, traces[0].back().x, 1e-12);
+  TS_ASSERT_DELTA(19.718198249323862, traces[0].back().y, 1e-12);
+
+  // Resuming extends; it does not restart.
+  TS_ASSERT(traces[0].size() > stoppedTraces[0].size());
+  for (size_t i = 0; i < stoppedTraces[0].size(); ++i)
+  {
+    TS_ASSERT_DELTA(stoppedTraces[0][i].x, traces[0][i].x, 1e-12);
+    TS_ASSERT_DELTA(stoppedTraces[0][i].y, traces[0][i].y, 1e-12);
+    TS_ASSERT_DELTA(stoppedTimes[0][i], times[0][i], 1e-12);
+  }
+
+  // The third time step reverses the eastward drift, so the path must turn back on itself --
+  // something no single pair of these time steps can produce.
+  double maxX = traces[0][0].x;
+  for (const auto& pt : traces[0])
+    maxX = std::max(maxX, pt.x);
+  TS_ASSERT(maxX > seeds[0].x);
+  TS_ASSERT(traces[0].back().x < maxX);
+} // XmGridTraceUnitTests::testTracesContinueAcrossTimeSteps
+//------------------------------------------------------------------------------
+/// \brief Returns a tracer whose spatially uniform field rotates +x -> +y across two steps.
+///
+/// One cell spanning the domain, so the field is uniform in space and every change in a path
+/// comes from time. Steps at t = 0 (east) and t = 10 (north) are loaded; supply a third to
+/// let a trace resume past t = 10.
+/// \param[out] a_activity Single-cell activity, for supplying further time steps
+/// \return the tracer
+//------------------------------------------------------------------------------
+BSHP<XmGridTrace> iCreateRotatingFieldTracer(DynBitset& a_activity)
+{
+  VecPt3d points = {{0, 0, 0}, {40, 0, 0}, {40, 40, 0}, {0, 40, 0}};
+  VecInt cells = {XMU_QUAD, 4, 0, 1, 2, 3};
+  std::shared_ptr<XmUGrid> ugrid = XmUGrid::New(points, cells);
+
+  a_activity.clear();
+  a_activity.push_back(true);
+
+  BSHP<XmGridTrace> tracer = XmGridTrace::New(ugrid);
+  tracer->SetVectorMultiplier(1);
+  tracer->SetMaxTracingTime(18);
+  tracer->SetMaxTracingDistance(1000);
+  tracer->SetMinDeltaTime(.01);
+  tracer->SetMaxChangeDistance(.5);
+  tracer->SetMaxChangeVelocity(-1);
+  tracer->SetMaxChangeDirectionInRadians(XM_PI); // never subdivide on direction
+  VecPt3d east = {{1, 0, 0}}, north = {{0, 1, 0}};
+  tracer->AddGridScalarsAtTime(east, DataLocationEnum::LOC_CELLS, a_activity,
+                               DataLocationEnum::LOC_CELLS, 0.0);
+  tracer->AddGridScalarsAtTime(north, DataLocationEnum::LOC_CELLS, a_activity,
+                               DataLocationEnum::LOC_CELLS, 10.0);
+  return tracer;
+} // iCreateRotatingFieldTracer
+//------------------------------------------------------------------------------
+/// \brief A redundant ContinueTraces must not change what the trace does afterwards.
+///
+/// XmGridTrace.h sanctions calling ContinueTraces twice with no time step in between, saying
+/// it does no useful work. It used to do considerably worse than nothing: the first call ends
+/// a window by clamping deltaT to exactly its end - elapsed - ptTime, which for a trace
+/// already sitting on the end is exactly zero, and that zero was carried into the resumed
+/// trace. A zero-length step moves nothing and changes no velocity, so no clamp and no
+/// subdivision test could ever end the loop -- it spun forever, appending nothing, with the
+/// GIL released so Python could not interrupt it.
+///
+/// The assertion is equality with the run that did not make the redundant call. "Does no
+/// useful work" is only true if the outcome is indistinguishable.
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testRedundantContinueDoesNotStallTrace()
+{
+  const VecPt3d seeds = {{20, 10, 0}};
+  const VecDbl seedTimes = {0};
+  VecPt3d west = {{-1, 0, 0}};
+
+  DynBitset plainActivity;
+  BSHP<XmGridTrace> plain = iCreateRotatingFieldTracer(plainActivity);
+  plain->StartTraces(seeds, seedTimes);
+  TS_ASSERT_EQUALS(1, plain->ContinueTraces());
+  plain->AddGridScalarsAtTime(west, DataLocationEnum::LOC_CELLS, plainActivity,
+                              DataLocationEnum::LOC_CELLS, 20.0);
+  TS_ASSERT_EQUALS(0, plain->ContinueTraces());
+  std::vector<VecPt3d> plainTraces;
+  std::vector<VecDbl> plainTimes;
+  std::vector<XmGridTraceExitEnum> plainReasons;
+  plain->GetTraceResults(plainTraces, plainTimes, plainReasons);
+
+  DynBitset activity;
+  BSHP<XmGridTrace> tracer = iCreateRotatingFieldTracer(activity);
+  tracer->StartTraces(seeds, seedTimes);
+  TS_ASSERT_EQUALS(1, tracer->ContinueTraces());
+  // The redundant call. Still waiting, because no new data arrived.
+  TS_ASSERT_EQUALS(1, tracer->ContinueTraces());
+  tracer->AddGridScalarsAtTime(west, DataLocationEnum::LOC_CELLS, activity,
+                               DataLocationEnum::LOC_CELLS, 20.0);
+  // Before the fix this call never returned.
+  TS_ASSERT_EQUALS(0, tracer->ContinueTraces());
+  std::vector<VecPt3d> traces;
+  std::vector<VecDbl> times;
+  std::vector<XmGridTraceExitEnum> reasons;
+  tracer->GetTraceResults(traces, times, reasons);
+
+  TS_ASSERT_EQUALS((int)plainReasons[0], (int)reasons[0]);
+  TS_ASSERT_EQUALS(plainTraces[0].size(), traces[0].size());
+  TS_ASSERT_DELTA_VECPT3D(plainTraces[0], traces[0], 1e-12);
+  TS_ASSERT_DELTA_VEC(plainTimes[0], times[0], 1e-12);
+} // XmGridTraceUnitTests::testRedundantContinueDoesNotStallTrace
+//------------------------------------------------------------------------------
+/// \brief A seed released after the loaded window waits for its data instead of failing.
+///
+/// StartTraces takes a release time per seed so a batch can be staggered, which makes a seed
+/// timed past the current window an ordinary input. It used to be reported as
+/// GTEXIT_EXTRACTION_FAILED, which iIsTerminal treats as terminal, so the seed was dead: the
+/// time step covering it could arrive and ContinueTraces would never look at it again. The
+/// mid-trace clamp had always called this same condition WAITING; only the seed path did not.
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testSeedReleasedAfterWindowWaitsThenTraces()
+{
+  DynBitset activity;
+  BSHP<XmGridTrace> tracer = iCreateRotatingFieldTracer(activity);
+
+  // Steps at t = 0 and t = 10 are loaded; this seed is released at 15.
+  const VecPt3d seeds = {{20, 10, 0}};
+  tracer->StartTraces(seeds, {15});
+  TS_ASSERT_EQUALS(1, tracer->ContinueTraces()); // waiting, not failed
+
+  std::vector<VecPt3d> traces;
+  std::vector<VecDbl> times;
+  std::vector<XmGridTraceExitEnum> reasons;
+  tracer->GetTraceResults(traces, times, reasons);
+  TS_ASSERT_EQUALS((int)GTEXIT_WAITING_FOR_TIME_STEP, (int)reasons[0]);
+  TS_ASSERT(traces[0].empty());
+
+  // Now supply a window that covers t = 15. The seed must start.
+  VecPt3d west = {{-1, 0, 0}};
+  tracer->AddGridScalarsAtTime(west, DataLocationEnum::LOC_CELLS, activity,
+                               DataLocationEnum::LOC_CELLS, 20.0);
+  tracer->ContinueTraces();
+  tracer->GetTraceResults(traces, times, reasons);
+
+  TS_ASSERT(reasons[0] != GTEXIT_EXTRACTION_FAILED);
+  TS_ASSERT(traces[0].size() >= 2);
+  TS_ASSERT_DELTA(15.0, times[0].front(), 1e-9); // started at its own release time
+  TS_ASSERT_DELTA(20.0, traces[0].front().x, 1e-9);
+  TS_ASSERT_DELTA(10.0, traces[0].front().y, 1e-9);
+} // XmGridTraceUnitTests::testSeedReleasedAfterWindowWaitsThenTraces
+//------------------------------------------------------------------------------
+/// \brief Two time steps at different data locations must not share a triangulation.
+///
+/// Sharing does not copy the triangulation, it shares the object, and the second step's
+/// SetGrid*Scalars rebuilds that shared object in place. The shape of the rebuild depends on
+/// the data location -- LOC_CELLS adds a centroid point per cell, LOC_POINTS adds none -- so
+/// sharing across a location change rebuilt the triangulation the first step was still
+/// pointing at, leaving its four-entry scalar array indexed by a centroid index of 4.
+///
+/// Both steps here carry the *same* uniform eastward field, written once as point scalars and
+/// once as cell scalars, so the interpolated field is identical at every time and the path
+/// must be a straight line east. A corrupted first-step lookup cannot produce that.
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testDataLocationChangeIsNotShared()
+{
+  VecPt3d points = {{0, 0, 0}, {40, 0, 0}, {40, 40, 0}, {0, 40, 0}};
+  VecInt cells = {XMU_QUAD, 4, 0, 1, 2, 3};
+  std::shared_ptr<XmUGrid> ugrid = XmUGrid::New(points, cells);
+
+  // Activity is cell-based and identical across both steps, so the data location is the only
+  // term that differs -- which is exactly the term the sharing test used to ignore.
+  DynBitset activity;
+  activity.push_back(true);
+
+  BSHP<XmGridTrace> tracer = XmGridTrace::New(ugrid);
+  tracer->SetVectorMultiplier(1);
+  tracer->SetMaxTracingTime(8);
+  tracer->SetMaxTracingDistance(1000);
+  tracer->SetMinDeltaTime(.01);
+  tracer->SetMaxChangeDistance(.5);
+  tracer->SetMaxChangeVelocity(-1);
+  tracer->SetMaxChangeDirectionInRadians(XM_PI);
+
+  VecPt3d eastAtPoints = {{1, 0, 0}, {1, 0, 0}, {1, 0, 0}, {1, 0, 0}};
+  VecPt3d eastAtCells = {{1, 0, 0}};
+  tracer->AddGridScalarsAtTime(eastAtPoints, DataLocationEnum::LOC_POINTS, activity,
+                               DataLocationEnum::LOC_CELLS, 0.0);
+  tracer->AddGridScalarsAtTime(eastAtCells, DataLocationEnum::LOC_CELLS, activity,
+                               DataLocationEnum::LOC_CELLS, 10.0);
+
+  VecPt3d outTrace;
+  VecDbl outTimes;
+  tracer->TracePoint({5, 20, 0}, 0, outTrace, outTimes);
+
+  TS_ASSERT(outTrace.size() >= 2);
+  for (size_t i = 0; i < outTrace.size(); ++i)
+  {
+    TS_ASSERT_DELTA(20.0, outTrace[i].y, 1e-9); // pure +x field: y never moves
+    if (i > 0)
+      TS_ASSERT(outTrace[i].x > outTrace[i - 1].x);
+  }
+  // 8 time units at unit speed from x = 5.
+  TS_ASSERT_DELTA(13.0, outTrace.back().x, 1e-6);
+} // XmGridTraceUnitTests::testDataLocationChangeIsNotShared
+//------------------------------------------------------------------------------
+/// \brief Verifies the boundary edge index is built once per tracer, not once per exit.
+///
+/// Caching it changes no output, so the construction count is what has to be asserted; the
+/// trace comparison is here to catch the reuse silently changing an answer.
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testBoundaryIndexIsCached()
+{
+  BSHP<XmGridTrace> tracer;
+  iCreateDefaultSingleCell(tracer);
+
+  // The default single cell has a uniform (1, 1) field, so a trace from the middle leaves the
+  // grid on its first step.
+  const Pt3d startPoint = {.5, .5, 0};
+  const double startTime = .5;
+  const std::string outOfDomain = "Point has traveled out of domain.";
+
+  g_boundaryIndexBuilds = 0;
+
+  VecPt3d firstTrace;
+  VecDbl firstTimes;
+  tracer->TracePoint(startPoint, startTime, firstTrace, firstTimes);
+  TS_ASSERT_EQUALS(outOfDomain, tracer->GetExitMessage());
+  TS_ASSERT_EQUALS(size_t(1), (size_t)g_boundaryIndexBuilds);
+  TS_ASSERT(firstTrace.size() >= 2);
+
+  VecPt3d secondTrace;
+  VecDbl secondTimes;
+  tracer->TracePoint(startPoint, startTime, secondTrace, secondTimes);
+  TS_ASSERT_EQUALS(outOfDomain, tracer->GetExitMessage());
+  TS_ASSERT_EQUALS(size_t(1), (size_t)g_boundaryIndexBuilds);
+
+  TS_ASSERT_DELTA_VECPT3D(firstTrace, secondTrace, 1e-12);
+  TS_ASSERT_DELTA_VEC(firstTimes, secondTimes, 1e-12);
+} // XmGridTraceUnitTests::testBoundaryIndexIsCached
+//------------------------------------------------------------------------------
+/// \brief A trace that leaves the grid reports the cell edge it left through.
+///
+/// Covers the three ways there are to end on an edge: through the grid boundary, into an
+/// inactive cell, and through a boundary edge of a cell wound clockwise, where the edge's
+/// outward side is the opposite of what its point order suggests.
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testExitEdgeIsReported()
+{
+  VecPt3d outTrace;
+  VecDbl outTimes;
+  int cellIdx = 0, cellEdgeIdx = 0;
+  DynBitset activity;
+
+  // Out through the +x side of the second cell, whose points are 1, 4, 5, 2: edge 1.
+  BSHP<XmGridTrace> tracer;
+  iCreateDefaultTwoCell(tracer);
+  VecPt3d scalars = {{.1, 0, 0}, {.2, 0, 0}};
+  tracer->AddGridScalarsAtTime(scalars, DataLocationEnum::LOC_CELLS, activity,
+                               DataLocationEnum::LOC_CELLS, 100);
+  tracer->TracePoint({.5, .5, 0}, 10, outTrace, outTimes);
+  TS_ASSERT_EQUALS((int)GTEXIT_LEFT_GRID, (int)tracer->GetExitReason());
+  TS_ASSERT_DELTA(2.0, outTrace.back().x, 1e-9);
+  tracer->GetExitEdge(cellIdx, cellEdgeIdx);
+  TS_ASSERT_EQUALS(1, cellIdx);
+  TS_ASSERT_EQUALS(1, cellEdgeIdx);
+
+  // A batch reports one edge per seed, and none for a seed that never left.
+  tracer->StartTraces({{.5, .5, 0}, {5, 5, 0}}, {10, 10});
+  TS_ASSERT_EQUALS(0, tracer->ContinueTraces());
+  VecInt cells, cellEdges;
+  tracer->GetTraceExitEdges(cells, cellEdges);
+  TS_ASSERT(cells == VecInt({1, -1}));
+  TS_ASSERT(cellEdges == VecInt({1, -1}));
+
+  // Stopped where the first cell, points 0, 1, 2, 3, meets the inactive second: edge 1.
+  iCreateDefaultTwoCell(tracer);
+  DynBitset cellActivity;
+  cellActivity.push_back(true);
+  cellActivity.push_back(false);
+  tracer->AddGridScalarsAtTime({{.2, 0, 0}, {99999, 0, 0}}, DataLocationEnum::LOC_CELLS,
+                               cellActivity, DataLocationEnum::LOC_CELLS, 20);
+  tracer->TracePoint({.5, .5, 0}, 10, outTrace, outTimes);
+  TS_ASSERT_EQUALS((int)GTEXIT_LEFT_GRID, (int)tracer->GetExitReason());
+  TS_ASSERT_DELTA(1.0, outTrace.back().x, 1e-9);
+  tracer->GetExitEdge(cellIdx, cellEdgeIdx);
+  TS_ASSERT_EQUALS(0, cellIdx);
+  TS_ASSERT_EQUALS(1, cellEdgeIdx);
+
+  // A clockwise quad, points 0, 3, 2, 1: the +x side runs from 2 to 1, edge 2.
+  VecPt3d points = {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}};
+  std::shared_ptr<XmUGrid> ugrid = XmUGrid::New(points, {XMU_QUAD, 4, 0, 3, 2, 1});
+  tracer = XmGridTrace::New(ugrid);
+  tracer->SetMaxChangeDistance(.25);
+  VecPt3d pointVectors(points.size(), Pt3d(1, 0, 0));
+  tracer->AddGridScalarsAtTime(pointVectors, DataLocationEnum::LOC_POINTS, activity,
+                               DataLocationEnum::LOC_POINTS, 0);
+  tracer->AddGridScalarsAtTime(pointVectors, DataLocationEnum::LOC_POINTS, activity,
+                               DataLocationEnum::LOC_POINTS, 10);
+  tracer->TracePoint({.3, .6, 0}, 0, outTrace, outTimes);
+  TS_ASSERT_EQUALS((int)GTEXIT_LEFT_GRID, (int)tracer->GetExitReason());
+  TS_ASSERT_DELTA(1.0, outTrace.back().x, 1e-9);
+  TS_ASSERT_DELTA(.7, outTimes.back(), 1e-9);
+  tracer->GetExitEdge(cellIdx, cellEdgeIdx);
+  TS_ASSERT_EQUALS(0, cellIdx);
+  TS_ASSERT_EQUALS(2, cellEdgeIdx);
+
+  // Any other ending reports no edge.
+  tracer->TracePoint({5, 5, 0}, 0, outTrace, outTimes);
+  tracer->GetExitEdge(cellIdx, cellEdgeIdx);
+  TS_ASSERT_EQUALS(-1, cellIdx);
+  TS_ASSERT_EQUALS(-1, cellEdgeIdx);
+} // XmGridTraceUnitTests::testExitEdgeIsReported
+//------------------------------------------------------------------------------
+/// \brief ContinueTraces gives the same answer, to the bit, whatever the thread count.
+///
+/// Run over several windows with staggered release times, so traces that wait, resume,
+/// leave the grid and run out of time are all spread across chunks and workers.
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testParallelContinueMatchesSerial()
+{
+  const double length = 30.0;
+  BenchmarkGrid grid = iBuildBenchmarkGrid(30, length);
+  DynBitset pointActivity;
+  pointActivity.resize(grid.m_points.size(), true);
+  const VecPt3d seeds = iBenchmarkSeeds(300, 0.5, length - 0.5, 0.0, 0.0);
+  VecDbl seedTimes;
+  for (size_t i = 0; i < seeds.size(); ++i)
+    seedTimes.push_back((i % 3) * 4.0);
+
+  auto runBatch = [&](int a_threadCount, BatchResults& a_results, VecInt& a_waiting,
+                      std::vector<XmGridTraceExitEnum>& a_lastReasons) {
+    BSHP<XmGridTrace> tracer = XmGridTrace::New(grid.m_ugrid);
+    tracer->SetThreadCount(a_threadCount);
+    TS_ASSERT_EQUALS(a_threadCount, tracer->GetThreadCount());
+    tracer->SetMaxTracingTime(25);
+    tracer->SetMaxTracingDistance(-1);
+    tracer->SetMinDeltaTime(.01);
+    tracer->SetMaxChangeDistance(1.0);
+    tracer->SetMaxChangeDirectionInRadians(0.2);
+    double omega = 0.3;
+    tracer->AddGridScalarsAtTime(iBenchmarkVectors(grid.m_points, omega, 0.2, length),
+                                 DataLocationEnum::LOC_POINTS, pointActivity,
+                                 DataLocationEnum::LOC_POINTS, 0.0);
+    for (int step = 1; step <= 3; ++step)
+    {
+      omega = -omega;
+      tracer->AddGridScalarsAtTime(iBenchmarkVectors(grid.m_points, omega, 0.2, length),
+                                   DataLocationEnum::LOC_POINTS, pointActivity,
+                                   DataLocationEnum::LOC_POINTS, step * 10.0);
+      if (step == 1)
+        tracer->StartTraces(seeds, seedTimes);
+      a_waiting.push_back(tracer->ContinueTraces());
+      a_lastReasons.push_back(tracer->GetExitReason());
+    }
+    tracer->GetTraceResults(a_results.m_traces, a_results.m_times, a_results.m_reasons);
+  };
+
+  BatchResults serial;
+  VecInt serialWaiting;
+  std::vector<XmGridTraceExitEnum> serialLastReasons;
+  runBatch(1, serial, serialWaiting, serialLastReasons);
+  // The field has to produce a real mix, or agreement would prove little.
+  std::map<XmGridTraceExitEnum, int> reasonCounts;
+  for (auto reason : serial.m_reasons)
+    ++reasonCounts[reason];
+  TS_ASSERT(reasonCounts[GTEXIT_LEFT_GRID] > 0);
+  TS_ASSERT(reasonCounts[GTEXIT_MAX_TRACING_TIME] > 0);
+  TS_ASSERT(serialWaiting[0] > 0);
+
+  for (int threadCount : {2, 3, 8, 0})
+  {
+    BatchResults parallel;
+    VecInt waiting;
+    std::vector<XmGridTraceExitEnum> lastReasons;
+    runBatch(threadCount, parallel, waiting, lastReasons);
+    TS_ASSERT_EQUALS(0, iCountBatchDifferences(serial, parallel));
+    TS_ASSERT(serialWaiting == waiting);
+    // GetExitReason after a batch names the last trace that ran, not whichever finished last.
+    TS_ASSERT(serialLastReasons == lastReasons);
+  }
+} // XmGridTraceUnitTests::testParallelContinueMatchesSerial
+//------------------------------------------------------------------------------
+/// \brief ContinueTraces gives the same answer, to the bit, whatever the packet width.
+///
+/// Run under each integrator, over windows that switch between point- and cell-located
+/// data and put a block of inactive cells in the way, so lanes take every path a lone
+/// trace can: walks, searches, exits from the grid and from inactive cells, splits, and
+/// Runge-Kutta steps that fall back to Euler.
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testPacketContinueMatchesSerial()
+{
+  const double length = 30.0;
+  const int cellsPerSide = 30;
+  BenchmarkGrid grid = iBuildBenchmarkGrid(cellsPerSide, length);
+  VecPt3d centers;
+  for (int j = 0; j < cellsPerSide; ++j)
+  {
+    for (int i = 0; i < cellsPerSide; ++i)
+      centers.push_back({i + 0.5, j + 0.5, 0.0});
+  }
+  DynBitset pointActivity;
+  pointActivity.resize(grid.m_points.size(), true);
+  DynBitset cellActivity;
+  cellActivity.resize(centers.size(), true);
+  for (int j = 12; j < 16; ++j)
+  {
+    for (int i = 12; i < 16; ++i)
+      cellActivity[j * cellsPerSide + i] = false;
+  }
+  const VecPt3d seeds = iBenchmarkSeeds(200, 0.5, length - 0.5, 0.0, 0.0);
+  VecDbl seedTimes;
+  for (size_t i = 0; i < seeds.size(); ++i)
+    seedTimes.push_back((i % 3) * 4.0);
+
+  auto runBatch = [&](XmGridTraceIntegratorEnum a_integrator, int a_packetWidth,
+                      BatchResults& a_results, VecInt& a_waiting) {
+    BSHP<XmGridTrace> tracer = XmGridTrace::New(grid.m_ugrid);
+    tracer->SetPacketWidth(a_packetWidth);
+    TS_ASSERT_EQUALS(a_packetWidth, tracer->GetPacketWidth());
+    tracer->SetIntegrator(a_integrator);
+    tracer->SetMaxTracingTime(25);
+    tracer->SetMinDeltaTime(.01);
+    tracer->SetMaxChangeDistance(1.0);
+    tracer->SetMaxChangeDirectionInRadians(0.2);
+    double omega = 0.3;
+    tracer->AddGridScalarsAtTime(iBenchmarkVectors(grid.m_points, omega, 0.2, length),
+                                 DataLocationEnum::LOC_POINTS, pointActivity,
+                                 DataLocationEnum::LOC_POINTS, 0.0);
+    for (int step = 1; step <= 3; ++step)
+    {
+      omega = -omega;
+      if (step == 2)
+      {
+        tracer->AddGridScalarsAtTime(iBenchmarkVectors(centers, omega, 0.2, length),
+                                     DataLocationEnum::LOC_CELLS, cellActivity,
+                                     DataLocationEnum::LOC_CELLS, step * 10.0);
+      }
+      else
+      {
+        tracer->AddGridScalarsAtTime(iBenchmarkVectors(grid.m_points, omega, 0.2, length),
+                                     DataLocationEnum::LOC_POINTS, pointActivity,
+                                     DataLocationEnum::LOC_POINTS, step * 10.0);
+      }
+      if (step == 1)
+        tracer->StartTraces(seeds, seedTimes);
+      a_waiting.push_back(tracer->ContinueTraces());
+    }
+    tracer->GetTraceResults(a_results.m_traces, a_results.m_times, a_results.m_reasons);
+  };
+
+  for (auto integrator : {GTINT_EULER, GTINT_RK4, GTINT_DORMAND_PRINCE})
+  {
+    BatchResults single;
+    VecInt singleWaiting;
+    runBatch(integrator, 1, single, singleWaiting);
+    std::map<XmGridTraceExitEnum, int> reasonCounts;
+    for (auto reason : single.m_reasons)
+      ++reasonCounts[reason];
+    TS_ASSERT(reasonCounts[GTEXIT_LEFT_GRID] > 0);
+    TS_ASSERT(reasonCounts[GTEXIT_MAX_TRACING_TIME] > 0);
+
+    for (int packetWidth : {2, 4, 8, 13})
+    {
+      BatchResults packed;
+      VecInt waiting;
+      runBatch(integrator, packetWidth, packed, waiting);
+      TS_ASSERT_EQUALS(0, iCountBatchDifferences(single, packed));
+      TS_ASSERT(singleWaiting == waiting);
+    }
+  }
+} // XmGridTraceUnitTests::testPacketContinueMatchesSerial
+//------------------------------------------------------------------------------
+/// \brief GetFlatTraceResults holds exactly what GetTraceResults does, trace by trace.
+///
+/// Traced on several threads over several windows, so traces grow their vertices across
+/// many blocks from different workers, then traced again with fewer seeds to check that a
+/// batch reusing the previous one's storage carries nothing over from it.
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testFlatResultsMatchTraceResults()
+{
+  const double length = 30.0;
+  BenchmarkGrid grid = iBuildBenchmarkGrid(30, length);
+  DynBitset pointActivity;
+  pointActivity.resize(grid.m_points.size(), true);
+  BSHP<XmGridTrace> tracer = XmGridTrace::New(grid.m_ugrid);
+  tracer->SetThreadCount(4);
+  tracer->SetMaxTracingTime(25);
+  tracer->SetMinDeltaTime(.01);
+  tracer->SetMaxChangeDistance(0.25);
+  tracer->SetMaxChangeDirectionInRadians(0.2);
+
+  auto checkFlat = [&](size_t a_seedCount) {
+    BatchResults results;
+    tracer->GetTraceResults(results.m_traces, results.m_times, results.m_reasons);
+    VecDbl xy, times;
+    std::vector<size_t> offsets;
+    std::vector<XmGridTraceExitEnum> reasons;
+    tracer->GetFlatTraceResults(xy, times, offsets, reasons);
+    TS_ASSERT_EQUALS(a_seedCount + 1, offsets.size());
+    TS_ASSERT(results.m_reasons == reasons);
+    TS_ASSERT_EQUALS(0, (int)offsets.front());
+    TS_ASSERT_EQUALS(times.size(), offsets.back());
+    TS_ASSERT_EQUALS(2 * times.size(), xy.size());
+    int differences = 0;
+    for (size_t i = 0; i < a_seedCount && i + 1 < offsets.size(); ++i)
+    {
+      const VecPt3d& trace = results.m_traces[i];
+      if (offsets[i + 1] - offsets[i] != trace.size())
+      {
+        ++differences;
+        continue;
+      }
+      for (size_t j = 0; j < trace.size(); ++j)
+      {
+        const size_t v = offsets[i] + j;
+        if (xy[2 * v] != trace[j].x || xy[2 * v + 1] != trace[j].y ||
+            times[v] != results.m_times[i][j])
+          ++differences;
+      }
+    }
+    TS_ASSERT_EQUALS(0, differences);
+    return offsets.back();
+  };
 
-  VecPt3d expectedOutTrace = {};
-  VecDbl expectedOutTimes = {};
-  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
-  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
-} // XmGridTraceUnitTests::testStartInactiveCell
+  double omega = 0.3;
+  tracer->AddGridScalarsAtTime(iBenchmarkVectors(grid.m_points, omega, 0.2, length),
+                               DataLocationEnum::LOC_POINTS, pointActivity,
+                               DataLocationEnum::LOC_POINTS, 0.0);
+  for (int step = 1; step <= 3; ++step)
+  {
+    omega = -omega;
+    tracer->AddGridScalarsAtTime(iBenchmarkVectors(grid.m_points, omega, 0.2, length),
+                                 DataLocationEnum::LOC_POINTS, pointActivity,
+                                 DataLocationEnum::LOC_POINTS, step * 10.0);
+    if (step == 1)
+      tracer->StartTraces(iBenchmarkSeeds(300, 0.5, length - 0.5, 0.0, 0.0), VecDbl(300, 0.0));
+    tracer->ContinueTraces();
+  }
+  // Long enough traces that most span several blocks.
+  TS_ASSERT(checkFlat(300) > 300 * 64);
+
+  tracer->StartTraces(iBenchmarkSeeds(50, 0.5, length - 0.5, 0.0, 0.0), VecDbl(50, 20.0));
+  tracer->ContinueTraces();
+  checkFlat(50);
+} // XmGridTraceUnitTests::testFlatResultsMatchTraceResults
 //------------------------------------------------------------------------------
-/// \brief 2nd cell is inactive in the 2nd time step.
-/////        Thus it does not pull as hard. Also once the point reaches the 2nd cell
-/////        It stops entirely.
+/// \brief Stepping traces in Hilbert order changes nothing but the order.
+///
+/// The curve has to visit neighbouring cells one after another, or the ordering buys no
+/// locality; then a batch run over several windows, where the order is rebuilt each time
+/// from positions that have drifted, has to match seed order bit for bit on any thread
+/// count.
 //------------------------------------------------------------------------------
-//! [snip_test_Example_XmGridTrace]
-void XmGridTraceUnitTests::testTutorial()
+void XmGridTraceUnitTests::testSpatialOrderingMatchesSeedOrder()
 {
-  // Graph with scalar vectors indicated
-  //  ->   ->
-  //  6----7----8|
-  //  |    |    |v
-  //  |    |    |
-  //  |    |    |
-  // ^|    |    |
-  // |3----4----5|
-  //  |    |    |v
-  //  |    |    |
-  //  |    |    |
-  // ^|    |    |
-  // |0----1----2
-  //      <-   <--
-  // Step 1: Create the grid
-  VecPt3d points = {{0, 0, 0}, {1, 0, 0}, {2, 0, 0}, {0, 1, 0}, {1, 1, 0},
-                    {2, 1, 0}, {0, 2, 0}, {1, 2, 0}, {2, 2, 0}};
-  VecInt cells = {XMU_QUAD, 4, 0, 1, 4, 3, XMU_QUAD, 4, 1, 2, 5, 4,
-                  XMU_QUAD, 4, 3, 4, 7, 6, XMU_QUAD, 4, 4, 5, 8, 7};
-  std::shared_ptr<XmUGrid> ugrid = XmUGrid::New(points, cells);
+  // The first 16 places along the curve fill the 4 by 4 corner, each next to the last.
+  std::vector<int> visited(16, -1);
+  for (uint32_t y = 0; y < 4; ++y)
+  {
+    for (uint32_t x = 0; x < 4; ++x)
+    {
+      const uint32_t d = iHilbertIndex(x, y);
+      TS_ASSERT(d < 16);
+      if (d < 16)
+        visited[d] = (int)(4 * y + x);
+    }
+  }
+  for (int d = 1; d < 16; ++d)
+  {
+    TS_ASSERT(visited[d] >= 0 && visited[d - 1] >= 0);
+    const int dx = std::abs(visited[d] % 4 - visited[d - 1] % 4);
+    const int dy = std::abs(visited[d] / 4 - visited[d - 1] / 4);
+    TS_ASSERT_EQUALS(1, dx + dy);
+  }
 
-  // Step 2: Create the tracer from the grid
-  BSHP<XmGridTrace> tracer = XmGridTrace::New(ugrid);
+  const double length = 30.0;
+  BenchmarkGrid grid = iBuildBenchmarkGrid(30, length);
+  DynBitset pointActivity;
+  pointActivity.resize(grid.m_points.size(), true);
+  const VecPt3d seeds = iBenchmarkSeeds(300, 0.5, length - 0.5, 0.0, 0.0);
+  VecDbl seedTimes;
+  for (size_t i = 0; i < seeds.size(); ++i)
+    seedTimes.push_back((i % 3) * 4.0);
+
+  auto runBatch = [&](bool a_spatialOrdering, int a_threadCount, BatchResults& a_results,
+                      VecInt& a_waiting, std::vector<XmGridTraceExitEnum>& a_lastReasons) {
+    BSHP<XmGridTrace> tracer = XmGridTrace::New(grid.m_ugrid);
+    TS_ASSERT(!tracer->GetSpatialOrdering());
+    tracer->SetSpatialOrdering(a_spatialOrdering);
+    TS_ASSERT_EQUALS(a_spatialOrdering, tracer->GetSpatialOrdering());
+    tracer->SetThreadCount(a_threadCount);
+    tracer->SetPacketWidth(4);
+    tracer->SetMaxTracingTime(25);
+    tracer->SetMinDeltaTime(.01);
+    tracer->SetMaxChangeDistance(1.0);
+    tracer->SetMaxChangeDirectionInRadians(0.2);
+    double omega = 0.3;
+    tracer->AddGridScalarsAtTime(iBenchmarkVectors(grid.m_points, omega, 0.2, length),
+                                 DataLocationEnum::LOC_POINTS, pointActivity,
+                                 DataLocationEnum::LOC_POINTS, 0.0);
+    for (int step = 1; step <= 3; ++step)
+    {
+      omega = -omega;
+      tracer->AddGridScalarsAtTime(iBenchmarkVectors(grid.m_points, omega, 0.2, length),
+                                   DataLocationEnum::LOC_POINTS, pointActivity,
+                                   DataLocationEnum::LOC_POINTS, step * 10.0);
+      if (step == 1)
+        tracer->StartTraces(seeds, seedTimes);
+      a_waiting.push_back(tracer->ContinueTraces());
+      a_lastReasons.push_back(tracer->GetExitReason());
+    }
+    tracer->GetTraceResults(a_results.m_traces, a_results.m_times, a_results.m_reasons);
+  };
 
-  // Step 3: Set up the constraints on the tracer
-  tracer->SetVectorMultiplier(2);
-  tracer->SetMaxTracingTime(-1);
-  tracer->SetMaxTracingDistance(-1);
-  tracer->SetMinDeltaTime(.01);
-  tracer->SetMaxChangeDistance(-1);
-  tracer->SetMaxChangeVelocity(-1);
-  tracer->SetMaxChangeDirectionInRadians(XM_PI / 4);
+  BatchResults seedOrder;
+  VecInt seedOrderWaiting;
+  std::vector<XmGridTraceExitEnum> seedOrderLastReasons;
+  runBatch(false, 1, seedOrder, seedOrderWaiting, seedOrderLastReasons);
+  TS_ASSERT(seedOrderWaiting[0] > 0);
+  for (int threadCount : {1, 4})
+  {
+    BatchResults ordered;
+    VecInt waiting;
+    std::vector<XmGridTraceExitEnum> lastReasons;
+    runBatch(true, threadCount, ordered, waiting, lastReasons);
+    TS_ASSERT_EQUALS(0, iCountBatchDifferences(seedOrder, ordered));
+    TS_ASSERT(seedOrderWaiting == waiting);
+    TS_ASSERT(seedOrderLastReasons == lastReasons);
+  }
+} // XmGridTraceUnitTests::testSpatialOrderingMatchesSeedOrder
+//------------------------------------------------------------------------------
+/// \brief The statistics count what tracing did, the same however many threads did it.
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testStatisticsCountWhatTracingDid()
+{
+  const double length = 30.0;
+  BenchmarkGrid grid = iBuildBenchmarkGrid(30, length);
+  DynBitset pointActivity;
+  pointActivity.resize(grid.m_points.size(), true);
+  const VecPt3d seeds = iBenchmarkSeeds(300, 0.5, length - 0.5, 0.0, 0.0);
+  const VecDbl seedTimes(seeds.size(), 0.0);
 
-  // Step 4: Set up the velocity vectors for both time steps. Insert timesteps sequentially
-  double time = 0;
-  // Scalars are set such that they circle around the edge of the graph in a clockwise direction
-  // Z component is not used in scalars
-  VecPt3d scalars1 = {{0, 1, 0},   {-.1, 0, 0}, {-1, 0, 0}, {0, .1, 0}, {0, 0, 0},
-                      {0, -.1, 0}, {1, 0, 0},   {.1, 0, 0}, {0, -1, 0}};
+  auto runBatch = [&](int a_threadCount, BatchResults& a_results) {
+    BSHP<XmGridTrace> tracer = XmGridTrace::New(grid.m_ugrid);
+    tracer->SetThreadCount(a_threadCount);
+    tracer->SetMaxTracingTime(25);
+    tracer->SetMinDeltaTime(.01);
+    tracer->SetMaxChangeDistance(1.0);
+    tracer->SetMaxChangeVelocity(0.05);
+    tracer->SetMaxChangeDirectionInRadians(0.2);
+    double omega = 0.3;
+    tracer->AddGridScalarsAtTime(iBenchmarkVectors(grid.m_points, omega, 0.2, length),
+                                 DataLocationEnum::LOC_POINTS, pointActivity,
+                                 DataLocationEnum::LOC_POINTS, 0.0);
+    for (int step = 1; step <= 3; ++step)
+    {
+      omega = -omega;
+      tracer->AddGridScalarsAtTime(iBenchmarkVectors(grid.m_points, omega, 0.2, length),
+                                   DataLocationEnum::LOC_POINTS, pointActivity,
+                                   DataLocationEnum::LOC_POINTS, step * 10.0);
+      if (step == 1)
+        tracer->StartTraces(seeds, seedTimes);
+      tracer->ContinueTraces();
+    }
+    tracer->GetTraceResults(a_results.m_traces, a_results.m_times, a_results.m_reasons);
+    return tracer;
+  };
+
+  BatchResults serialResults;
+  BSHP<XmGridTrace> serial = runBatch(1, serialResults);
+  const XmGridTraceStatistics& stats = serial->GetStatistics();
+  size_t vertices = 0;
+  std::map<XmGridTraceExitEnum, size_t> reasonCounts;
+  for (size_t i = 0; i < seeds.size(); ++i)
+  {
+    vertices += serialResults.m_traces[i].size();
+    ++reasonCounts[serialResults.m_reasons[i]];
+  }
+  // Every vertex after a seed is an accepted step; a step too short to add one is not.
+  TS_ASSERT(stats.m_acceptedSteps >= vertices - seeds.size());
+  TS_ASSERT(stats.m_velocitySplits > 0);
+  TS_ASSERT(stats.m_directionSplits > 0);
+  TS_ASSERT_EQUALS(stats.m_velocitySplits + stats.m_directionSplits + stats.m_errorRejections,
+                   stats.m_rejectedSteps);
+  TS_ASSERT(stats.m_evaluations >= stats.m_acceptedSteps + stats.m_rejectedSteps);
+  TS_ASSERT(stats.m_searches >= seeds.size());
+  TS_ASSERT(reasonCounts[GTEXIT_LEFT_GRID] > 0);
+  TS_ASSERT(stats.m_boundaryExits >= reasonCounts[GTEXIT_LEFT_GRID]);
+  // Traces that stopped for good are counted once; the rest waited at the end of each window.
+  TS_ASSERT_EQUALS(reasonCounts[GTEXIT_LEFT_GRID], stats.m_exitReasons[GTEXIT_LEFT_GRID]);
+  TS_ASSERT_EQUALS(reasonCounts[GTEXIT_MAX_TRACING_TIME],
+                   stats.m_exitReasons[GTEXIT_MAX_TRACING_TIME]);
+  TS_ASSERT(stats.m_exitReasons[GTEXIT_WAITING_FOR_TIME_STEP] >=
+            reasonCounts[GTEXIT_WAITING_FOR_TIME_STEP]);
+  TS_ASSERT_EQUALS(size_t(0), stats.m_exitReasons[GTEXIT_NOT_STARTED]);
+  TS_ASSERT(stats.m_addScalarsSeconds > 0);
+  TS_ASSERT(stats.m_triangulationSeconds > 0);
+  TS_ASSERT(stats.m_triangulationSeconds <= stats.m_addScalarsSeconds);
+  TS_ASSERT(stats.m_steppingSeconds > 0);
+  TS_ASSERT(stats.m_resultCopySeconds > 0);
+
+  BatchResults parallelResults;
+  BSHP<XmGridTrace> parallel = runBatch(4, parallelResults);
+  const XmGridTraceStatistics& parallelStats = parallel->GetStatistics();
+  TS_ASSERT_EQUALS(stats.m_acceptedSteps, parallelStats.m_acceptedSteps);
+  TS_ASSERT_EQUALS(stats.m_rejectedSteps, parallelStats.m_rejectedSteps);
+  TS_ASSERT_EQUALS(stats.m_velocitySplits, parallelStats.m_velocitySplits);
+  TS_ASSERT_EQUALS(stats.m_directionSplits, parallelStats.m_directionSplits);
+  TS_ASSERT_EQUALS(stats.m_evaluations, parallelStats.m_evaluations);
+  TS_ASSERT_EQUALS(stats.m_searches, parallelStats.m_searches);
+  TS_ASSERT_EQUALS(stats.m_boundaryExits, parallelStats.m_boundaryExits);
+  for (int i = 0; i < XmGridTraceStatistics::EXIT_REASON_COUNT; ++i)
+    TS_ASSERT_EQUALS(stats.m_exitReasons[i], parallelStats.m_exitReasons[i]);
+
+  serial->ResetStatistics();
+  TS_ASSERT_EQUALS(size_t(0), serial->GetStatistics().m_acceptedSteps);
+  TS_ASSERT_EQUALS(size_t(0), serial->GetStatistics().m_exitReasons[GTEXIT_LEFT_GRID]);
+  TS_ASSERT_EQUALS(0.0, serial->GetStatistics().m_steppingSeconds);
+
+  // A lone trace counts the same way.
+  VecPt3d trace;
+  VecDbl times;
+  serial->TracePoint(seeds[0], 25.0, trace, times);
+  TS_ASSERT_EQUALS(size_t(1), serial->GetStatistics().m_exitReasons[serial->GetExitReason()]);
+  TS_ASSERT(serial->GetStatistics().m_acceptedSteps >= trace.size() - 1);
+} // XmGridTraceUnitTests::testStatisticsCountWhatTracingDid
+//------------------------------------------------------------------------------
+/// \brief Time steps added with AddGridScalarsAtTimeAsync give the same traces, to the
+///        bit, as the same steps added synchronously.
+///
+/// The series switches between point- and cell-located data and puts inactive cells in
+/// the way, so the swap moves coefficients both within a table and between tables.
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testAsyncTimeStepsMatchSynchronous()
+{
+  const double length = 30.0;
+  const int cellsPerSide = 30;
+  BenchmarkGrid grid = iBuildBenchmarkGrid(cellsPerSide, length);
+  VecPt3d centers;
+  for (int j = 0; j < cellsPerSide; ++j)
+  {
+    for (int i = 0; i < cellsPerSide; ++i)
+      centers.push_back({i + 0.5, j + 0.5, 0.0});
+  }
   DynBitset pointActivity;
-  for (int i = 0; i < 9; ++i)
+  pointActivity.resize(grid.m_points.size(), true);
+  DynBitset cellActivity;
+  cellActivity.resize(centers.size(), true);
+  for (int j = 12; j < 16; ++j)
   {
-    pointActivity.push_back(true);
+    for (int i = 12; i < 16; ++i)
+      cellActivity[j * cellsPerSide + i] = false;
   }
-  tracer->AddGridScalarsAtTime(scalars1, DataLocationEnum::LOC_POINTS, pointActivity,
-                               DataLocationEnum::LOC_POINTS, time);
+  const VecPt3d seeds = iBenchmarkSeeds(200, 0.5, length - 0.5, 0.0, 0.0);
+  VecDbl seedTimes;
+  for (size_t i = 0; i < seeds.size(); ++i)
+    seedTimes.push_back((i % 3) * 4.0);
+  const int stepCount = 6;
+  auto addStep = [&](BSHP<XmGridTrace>& a_tracer, int a_step, bool a_async) {
+    const double omega = a_step % 2 ? -0.3 : 0.3;
+    const bool atCells = a_step % 3 == 2;
+    const VecPt3d vectors =
+      iBenchmarkVectors(atCells ? centers : grid.m_points, omega, 0.2, length);
+    const DataLocationEnum loc =
+      atCells ? DataLocationEnum::LOC_CELLS : DataLocationEnum::LOC_POINTS;
+    const DynBitset& activity = atCells ? cellActivity : pointActivity;
+    if (a_async)
+      a_tracer->AddGridScalarsAtTimeAsync(vectors, loc, activity, loc, a_step * 10.0);
+    else
+      a_tracer->AddGridScalarsAtTime(vectors, loc, activity, loc, a_step * 10.0);
+  };
 
-  // For the second timestep scalars are doubled to indicate an increase in magnitude
-  VecPt3d scalars2 = {{0, 2, 0},   {-.2, 0, 0}, {-2, 0, 0}, {0, .2, 0}, {0, 0, 0},
-                      {0, -.2, 0}, {2, 0, 0},   {.2, 0, 0}, {0, -2, 0}};
-  time = 20;
-  // Uses exact same scalars/pointActivity
-  tracer->AddGridScalarsAtTime(scalars2, DataLocationEnum::LOC_POINTS, pointActivity,
-                               DataLocationEnum::LOC_POINTS, time);
+  auto runBatch = [&](bool a_async, int a_threadCount, BatchResults& a_results,
+                      VecInt& a_waiting) {
+    BSHP<XmGridTrace> tracer = XmGridTrace::New(grid.m_ugrid);
+    tracer->SetThreadCount(a_threadCount);
+    tracer->SetMaxTracingTime(45);
+    tracer->SetMinDeltaTime(.01);
+    tracer->SetMaxChangeDistance(1.0);
+    tracer->SetMaxChangeDirectionInRadians(0.2);
+    addStep(tracer, 0, false);
+    addStep(tracer, 1, false);
+    tracer->StartTraces(seeds, seedTimes);
+    int step = 2;
+    if (a_async)
+    {
+      // The loop XmGridTrace.h documents: each step loads while the one before is traced.
+      bool queued;
+      int waiting;
+      do
+      {
+        queued = step < stepCount;
+        if (queued)
+          addStep(tracer, step++, true);
+        waiting = tracer->ContinueTraces();
+        a_waiting.push_back(waiting);
+      } while (waiting > 0 && queued);
+    }
+    else
+    {
+      int waiting = tracer->ContinueTraces();
+      a_waiting.push_back(waiting);
+      while (waiting > 0 && step < stepCount)
+      {
+        addStep(tracer, step++, false);
+        waiting = tracer->ContinueTraces();
+        a_waiting.push_back(waiting);
+      }
+    }
+    tracer->GetTraceResults(a_results.m_traces, a_results.m_times, a_results.m_reasons);
+    TS_ASSERT(tracer->GetStatistics().m_timeStepWaitSeconds >= 0);
+  };
 
-  VecPt3d outTrace;
-  VecDbl outTimes;
-  Pt3d startPoint = {.5, .5, 0};
-  double startTime = 0;
+  BatchResults sync;
+  VecInt syncWaiting;
+  runBatch(false, 1, sync, syncWaiting);
+  std::map<XmGridTraceExitEnum, int> reasonCounts;
+  for (auto reason : sync.m_reasons)
+    ++reasonCounts[reason];
+  TS_ASSERT(reasonCounts[GTEXIT_LEFT_GRID] > 0);
+  TS_ASSERT(reasonCounts[GTEXIT_MAX_TRACING_TIME] > 0);
+  TS_ASSERT(syncWaiting.size() > 2);
+
+  for (int threadCount : {1, 4})
+  {
+    BatchResults async;
+    VecInt waiting;
+    runBatch(true, threadCount, async, waiting);
+    TS_ASSERT_EQUALS(0, iCountBatchDifferences(sync, async));
+    TS_ASSERT(syncWaiting == waiting);
+  }
 
-  // Step 5: Trace the point
-  tracer->TracePoint(startPoint, startTime, outTrace, outTimes);
-  // show the cause for termination by calling GetExitMessage
-  // std::cout << tracer->GetExitMessage();
+  // Anything else that reads the window swaps a pending step in first.
+  BSHP<XmGridTrace> syncTracer = XmGridTrace::New(grid.m_ugrid);
+  BSHP<XmGridTrace> asyncTracer = XmGridTrace::New(grid.m_ugrid);
+  for (int step = 0; step < 3; ++step)
+  {
+    addStep(syncTracer, step, false);
+    addStep(asyncTracer, step, true);
+  }
+  VecPt3d syncTrace, asyncTrace;
+  VecDbl syncTimes, asyncTimes;
+  syncTracer->TracePoint({5, 5, 0}, 12.0, syncTrace, syncTimes);
+  asyncTracer->TracePoint({5, 5, 0}, 12.0, asyncTrace, asyncTimes);
+  TS_ASSERT(syncTrace.size() > 2);
+  TS_ASSERT(syncTrace == asyncTrace);
+  TS_ASSERT(syncTimes == asyncTimes);
+} // XmGridTraceUnitTests::testAsyncTimeStepsMatchSynchronous
+//------------------------------------------------------------------------------
+/// \brief A time step that fails to prepare leaves the tracer as it was, and ContinueTraces
+///        still returns its count, leaving the error for the next call.
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testFailedTimeStepLeavesTracer()
+{
+  const double length = 20.0;
+  BenchmarkGrid grid = iBuildBenchmarkGrid(20, length);
+  const VecPt3d seeds = iBenchmarkSeeds(100, 0.5, length - 0.5, 0.0, 0.0);
+  const VecDbl seedTimes(seeds.size(), 0.0);
+  // Cell-located, so the values a change refits also read the inputs of cells it did not
+  // change.
+  const DataLocationEnum loc = DataLocationEnum::LOC_CELLS;
+  auto vectors = [&](int a_step) {
+    const VecPt3d pointFlow = iBenchmarkVectors(grid.m_points, 0.3 - 0.1 * a_step, 0.2, length);
+    VecPt3d cellFlow;
+    VecInt cellPoints;
+    for (int cellIdx = 0; cellIdx < grid.m_ugrid->GetCellCount(); ++cellIdx)
+    {
+      grid.m_ugrid->GetCellPoints(cellIdx, cellPoints);
+      cellFlow.push_back(pointFlow[cellPoints[0]]);
+    }
+    return cellFlow;
+  };
+  auto newTracer = [&]() {
+    BSHP<XmGridTrace> tracer = XmGridTrace::New(grid.m_ugrid);
+    tracer->SetMaxTracingTime(40);
+    tracer->SetMaxChangeDistance(0.5);
+    tracer->AddGridScalarsAtTime(vectors(0), loc, DynBitset(), loc, 0.0);
+    tracer->AddGridScalarsAtTime(vectors(1), loc, DynBitset(), loc, 10.0);
+    tracer->StartTraces(seeds, seedTimes);
+    return tracer;
+  };
+  // Changes build on the newest step's inputs, so they show whether a failed step's
+  // inputs took their place.
+  VecInt changed;
+  VecPt3d changedScalars;
+  const VecPt3d changes = vectors(2);
+  for (int cellIdx = 0; cellIdx < (int)changes.size(); cellIdx += 3)
+  {
+    changed.push_back(cellIdx);
+    changedScalars.push_back(changes[cellIdx]);
+  }
 
-  // Expected values for this simulation
-  VecPt3d expectedOutTrace = {{0.5, 0.5, 0},
-                              {0.5, 1.5, 0},
-                              {0.62600000187754634, 1.6260000018775462, 0},
-                              {0.82611968728899965, 1.7455603212296962, 0},
-                              {0.97840008102011689, 1.7810753047635555, 0},
-                              {1.0280095840364933, 1.7824472100312621, 0},
-                              {1.0861189816907613, 1.7608732599310344, 0},
-                              {1.1492686295114336, 1.6802752810470523, 0},
-                              {1.2097920698566107, 1.5101408581884392, 0},
-                              {1.2515951471975522, 1.2181485463468757, 0},
-                              {1.2515951471975522, 0.84053651390559747, 0},
-                              {1.2181758214493843, 0.78780883088769804, 0},
-                              {1.1632869448015855, 0.73137186792498654, 0},
-                              {1.0771209832183524, 0.67899546053648097, 0},
-                              {1.0129487663521615, 0.66357815692798783, 0},
-                              {0.97169356095126669, 0.66199025753694563, 0},
-                              {0.92552080990281416, 0.70419149113367874, 0},
-                              {0.88530832700558759, 0.83950990950827409, 0},
-                              {0.87513974259796246, 1.0941588844381676, 0},
-                              {0.90077009637050098, 1.128146252166127, 0},
-                              {0.943692705404238, 1.1613833261644337, 0},
-                              {0.97709108330292604, 1.1730361561747586, 0},
-                              {0.99894959169213471, 1.1759300874982919, 0},
-                              {1.0124203987349505, 1.1760105163064269, 0},
-                              {1.0275428271398932, 1.1645289800266216, 0},
-                              {1.042848666622334, 1.1337546211004945, 0},
-                              {1.055142468614698, 1.0758075939238765, 0},
-                              {1.0585305184379035, 0.98540145004498747, 0},
-                              {1.0556233679912082, 0.97374570199926891, 0},
-                              {1.0492587242876892, 0.9602613226646981, 0},
-                              {1.0375007181419984, 0.94568649411103145, 0},
-                              {1.017827020259642, 0.93210280494582176, 0},
-                              {1.0175992759724071, 0.93204300863222744, 0}};
-  VecDbl expectedOutTimes = {0,
-                             1,
-                             2.2000000000000002,
-                             3.6400000000000001,
-                             4.5040000000000004,
-                             4.7632000000000003,
-                             5.0742400000000005,
-                             5.4474880000000008,
-                             5.8953856000000009,
-                             6.432862720000001,
-                             7.0778352640000008,
-                             7.8518023168000006,
-                             8.7805627801600004,
-                             9.8950753361920007,
-                             10.563782869811201,
-                             10.96500738998272,
-                             11.446476814188543,
-                             12.024240123235531,
-                             12.717556094091917,
-                             13.54953525911958,
-                             14.547910257152775,
-                             15.146935255972693,
-                             15.506350255264643,
-                             15.721999254839814,
-                             15.980778054330019,
-                             16.291312613718265,
-                             16.663954084984159,
-                             17.111123850503233,
-                             17.647727569126122,
-                             18.291652031473589,
-                             19.064361386290546,
-                             19.991612612070895,
-                             20};
-  TS_ASSERT_DELTA_VECPT3D(expectedOutTrace, outTrace, .0001);
-  TS_ASSERT_DELTA_VEC(expectedOutTimes, outTimes, .0001);
-} // XmGridTraceUnitTests::testTutorial
-  //! [snip_test_Example_XmGridTrace]
-//------------------------------------------------------------------------------
-/// \brief A trace through a field that changes between timesteps follows neither timestep.
-///
-/// This is the regression guard for the time interpolation, which is the whole reason this
-/// tracer is worth routing a display option through: a tracer that samples one frozen
-/// timestep would be no better than the render-time drifter it replaces.
-///
-/// The field rotates from +x at the first timestep to +y at the second rather than
-/// reversing, so the interpolated velocity never passes through zero and cannot trip the
-/// "velocity has gone to zero" exit partway along.
+  BSHP<XmGridTrace> expected = newTracer();
+  const int waiting = expected->ContinueTraces();
+  TS_ASSERT(waiting > 0);
+  TS_ASSERT_EQUALS(waiting, expected->ContinueTraces());
+  expected->AddGridScalarChangesAtTime(changed, changedScalars, {}, 20.0);
+  expected->ContinueTraces();
+  BatchResults expectedResults;
+  expected->GetTraceResults(expectedResults.m_traces, expectedResults.m_times,
+                            expectedResults.m_reasons);
+
+  BSHP<XmGridTrace> tracer = newTracer();
+  TS_ASSERT_EQUALS(waiting, tracer->ContinueTraces());
+  g_timeStepFailures = 1;
+  tracer->AddGridScalarsAtTimeAsync(vectors(3), loc, DynBitset(), loc, 20.0);
+  TS_ASSERT_EQUALS(waiting, tracer->ContinueTraces());
+  bool thrown = false;
+  try
+  {
+    tracer->ContinueTraces();
+  }
+  catch (const std::runtime_error&)
+  {
+    thrown = true;
+  }
+  TS_ASSERT(thrown);
+  TS_ASSERT_EQUALS(0, (int)g_timeStepFailures);
+  tracer->AddGridScalarChangesAtTime(changed, changedScalars, {}, 20.0);
+  tracer->ContinueTraces();
+  BatchResults results;
+  tracer->GetTraceResults(results.m_traces, results.m_times, results.m_reasons);
+  TS_ASSERT_EQUALS(0, iCountBatchDifferences(expectedResults, results));
+
+  // Added synchronously, the failure is thrown at once, with the window as it was.
+  g_timeStepFailures = 1;
+  thrown = false;
+  try
+  {
+    tracer->AddGridScalarsAtTime(vectors(3), loc, DynBitset(), loc, 30.0);
+  }
+  catch (const std::runtime_error&)
+  {
+    thrown = true;
+  }
+  TS_ASSERT(thrown);
+  VecPt3d trace, expectedTrace;
+  VecDbl times, expectedTimes;
+  tracer->TracePoint(Pt3d(10.0, 12.0, 0.0), 10.0, trace, times);
+  expected->TracePoint(Pt3d(10.0, 12.0, 0.0), 10.0, expectedTrace, expectedTimes);
+  TS_ASSERT(trace.size() > 2);
+  TS_ASSERT_DELTA_VECPT3D(expectedTrace, trace, 0.0);
+  TS_ASSERT_DELTA_VEC(expectedTimes, times, 0.0);
+} // XmGridTraceUnitTests::testFailedTimeStepLeavesTracer
+//------------------------------------------------------------------------------
+/// \brief Time steps whose activity differs share one triangulation, and a trace costs
+///        one search however often cells wet and dry.
 ///
-/// The first assertion is the one that catches an inverted interpolation: a particle
-/// released exactly at the first timestep must be advected by that timestep's field alone,
-/// so its first step is due east with y untouched. Weighting each timestep by its own
-/// distance from the current time instead sends that first step due north.
+/// A column of cells dries and wets at alternate steps across the path of a uniform flow,
+/// so traces evaluate the field inside cells active in one step of the window and not the
+/// other, and stop on entering one dry in both.
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testActivityChangeNeedsNoSearch()
+{
+  const int cellsPerSide = 20;
+  BenchmarkGrid grid = iBuildBenchmarkGrid(cellsPerSide, 20.0);
+  const VecPt3d east(grid.m_points.size(), Pt3d(0.5, 0.0, 0.0));
+  auto activityAt = [&](int a_step) {
+    DynBitset activity;
+    activity.resize((size_t)cellsPerSide * cellsPerSide, true);
+    const int column = a_step % 2 ? 8 : 14;
+    for (int j = 0; j < cellsPerSide; ++j)
+      activity[j * cellsPerSide + column] = false;
+    return activity;
+  };
+  VecPt3d seeds;
+  for (int j = 0; j < cellsPerSide; ++j)
+    seeds.push_back({2.3, j + 0.5, 0.0});
+  const VecDbl seedTimes(seeds.size(), 0.0);
+
+  BSHP<XmGridTrace> tracer = XmGridTrace::New(grid.m_ugrid);
+  tracer->SetMaxTracingTime(100);
+  tracer->SetMinDeltaTime(.01);
+  tracer->SetMaxChangeDistance(0.3);
+  tracer->AddGridScalarsAtTime(east, DataLocationEnum::LOC_POINTS, activityAt(0),
+                               DataLocationEnum::LOC_CELLS, 0.0);
+  tracer->AddGridScalarsAtTime(east, DataLocationEnum::LOC_POINTS, activityAt(1),
+                               DataLocationEnum::LOC_CELLS, 10.0);
+  tracer->StartTraces(seeds, seedTimes);
+  int waiting = tracer->ContinueTraces();
+  for (int step = 2; waiting > 0 && step < 8; ++step)
+  {
+    tracer->AddGridScalarsAtTime(east, DataLocationEnum::LOC_POINTS, activityAt(step),
+                                 DataLocationEnum::LOC_CELLS, step * 10.0);
+    waiting = tracer->ContinueTraces();
+  }
+  TS_ASSERT_EQUALS(0, waiting);
+
+  std::vector<VecPt3d> traces;
+  std::vector<VecDbl> times;
+  std::vector<XmGridTraceExitEnum> reasons;
+  tracer->GetTraceResults(traces, times, reasons);
+  for (size_t i = 0; i < seeds.size(); ++i)
+  {
+    // Column 8 is dry at every odd step, so it blocks every window; the trace stops at
+    // its edge, having crossed cells that were dry in the step before.
+    TS_ASSERT_EQUALS(GTEXIT_LEFT_GRID, reasons[i]);
+    TS_ASSERT_DELTA(8.0, traces[i].back().x, 1e-6);
+  }
+  const XmGridTraceStatistics& stats = tracer->GetStatistics();
+  TS_ASSERT(stats.m_evaluations > 10 * seeds.size());
+  TS_ASSERT_EQUALS(seeds.size(), stats.m_searches);
+} // XmGridTraceUnitTests::testActivityChangeNeedsNoSearch
 //------------------------------------------------------------------------------
-void XmGridTraceUnitTests::testTimeVaryingFieldChangesPath()
+/// \brief Time steps added as changes to the last one give the same traces, to the bit,
+///        as the whole steps they describe.
+///
+/// Each step changes a scattered few of the vectors and toggles a few points or cells,
+/// for data and activity on points and then on cells, where a toggle changes the values
+/// around it as well as whether a cell can be entered. The tracer adding changes caches
+/// every step, so each change also writes to tables the cache shares.
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testChangesMatchWholeSteps()
 {
-  // One cell spanning the whole domain, so cell-located scalars give a spatially uniform
-  // field and any curvature in the path can only have come from time.
-  VecPt3d points = {{0, 0, 0}, {10, 0, 0}, {10, 10, 0}, {0, 10, 0}};
-  VecInt cells = {XMU_QUAD, 4, 0, 1, 2, 3};
-  std::shared_ptr<XmUGrid> ugrid = XmUGrid::New(points, cells);
-
-  DynBitset activity;
-  activity.push_back(true);
+  const double length = 30.0;
+  const int cellsPerSide = 30;
+  BenchmarkGrid grid = iBuildBenchmarkGrid(cellsPerSide, length);
+  VecPt3d centers;
+  for (int j = 0; j < cellsPerSide; ++j)
+  {
+    for (int i = 0; i < cellsPerSide; ++i)
+      centers.push_back({i + 0.5, j + 0.5, 0.0});
+  }
+  const VecPt3d seeds = iBenchmarkSeeds(200, 0.5, length - 0.5, 0.0, 0.0);
+  const VecDbl seedTimes(seeds.size(), 0.0);
+  const int stepCount = 6;
 
-  auto traceWithField = [&](const Pt3d& a_first, const Pt3d& a_second, VecPt3d& a_outTrace) {
-    BSHP<XmGridTrace> tracer = XmGridTrace::New(ugrid);
-    tracer->SetVectorMultiplier(1);
-    tracer->SetMaxTracingTime(5);
-    tracer->SetMaxTracingDistance(100);
+  for (DataLocationEnum loc : {DataLocationEnum::LOC_POINTS, DataLocationEnum::LOC_CELLS})
+  {
+    const VecPt3d& locations = loc == DataLocationEnum::LOC_POINTS ? grid.m_points : centers;
+    const int count = (int)locations.size();
+    VecPt3d vectors = iBenchmarkVectors(locations, 0.3, 0.2, length);
+    DynBitset activity;
+    activity.resize(count, true);
+    BSHP<XmGridTrace> whole = XmGridTrace::New(grid.m_ugrid);
+    BSHP<XmGridTrace> changes = XmGridTrace::New(grid.m_ugrid);
+    for (BSHP<XmGridTrace>* tracer : {&whole, &changes})
+    {
+      (*tracer)->SetMaxTracingTime(45);
+      (*tracer)->SetMinDeltaTime(.01);
+      (*tracer)->SetMaxChangeDistance(1.0);
+      (*tracer)->SetMaxChangeDirectionInRadians(0.2);
+    }
+    changes->SetTimeStepCacheBytes(size_t(1) << 30);
+
+    // Changes before any whole step, and malformed ones, are refused.
+    changes->AddGridScalarChangesAtTime({0}, {Pt3d()}, {}, 0.0);
+    whole->AddGridScalarsAtTime(vectors, loc, activity, loc, 0.0);
+    changes->AddGridScalarsAtTime(vectors, loc, activity, loc, 0.0);
+    changes->AddGridScalarChangesAtTime({0, 1}, {Pt3d()}, {}, 5.0);
+    changes->AddGridScalarChangesAtTime({count}, {Pt3d()}, {}, 5.0);
+    changes->AddGridScalarChangesAtTime({}, {}, {-1}, 5.0);
+
+    auto addStep = [&](int a_step) {
+      // A changing scatter of about one value in twenty takes the reversed vortex, and a
+      // few activities toggle, some of them back again in a later step.
+      const VecPt3d reversed = iBenchmarkVectors(locations, -0.3, 0.2, length);
+      VecInt indices, flips;
+      VecPt3d changed;
+      for (int i = a_step % 20; i < count; i += 20)
+      {
+        indices.push_back(i);
+        changed.push_back(reversed[i]);
+        vectors[i] = reversed[i];
+      }
+      for (int i = 0; i < 4; ++i)
+      {
+        const int idx = (count / 3 + 37 * i + 101 * (a_step % 3)) % count;
+        flips.push_back(idx);
+        activity[idx].flip();
+      }
+      whole->AddGridScalarsAtTime(vectors, loc, activity, loc, a_step * 10.0);
+      changes->AddGridScalarChangesAtTime(indices, changed, flips, a_step * 10.0);
+    };
+
+    addStep(1);
+    // So are changes at or before the newest step, which would put the window out of order.
+    changes->AddGridScalarChangesAtTime({0}, {Pt3d(5.0, 5.0, 0.0)}, {}, 10.0);
+    changes->AddGridScalarChangesAtTime({0}, {Pt3d(5.0, 5.0, 0.0)}, {}, 5.0);
+    BatchResults expected, actual;
+    int waitingWhole = 0, waitingChanges = 0;
+    whole->StartTraces(seeds, seedTimes);
+    changes->StartTraces(seeds, seedTimes);
+    for (int step = 2; step <= stepCount; ++step)
+    {
+      waitingWhole = whole->ContinueTraces();
+      waitingChanges = changes->ContinueTraces();
+      TS_ASSERT_EQUALS(waitingWhole, waitingChanges);
+      if (waitingWhole == 0)
+        break;
+      addStep(step);
+    }
+    whole->GetTraceResults(expected.m_traces, expected.m_times, expected.m_reasons);
+    changes->GetTraceResults(actual.m_traces, actual.m_times, actual.m_reasons);
+    std::map<XmGridTraceExitEnum, int> reasonCounts;
+    for (auto reason : expected.m_reasons)
+      ++reasonCounts[reason];
+    TS_ASSERT(reasonCounts[GTEXIT_LEFT_GRID] > 0);
+    TS_ASSERT(reasonCounts[GTEXIT_MAX_TRACING_TIME] > 0);
+    TS_ASSERT_EQUALS(0, iCountBatchDifferences(expected, actual));
+  }
+} // XmGridTraceUnitTests::testChangesMatchWholeSteps
+//------------------------------------------------------------------------------
+/// \brief Copies of a SharedChunks share its chunks until one writes, and a write copies
+///        only the chunk written.
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testSharedChunksCopyOnWrite()
+{
+  const size_t rows = 3 * kSharedChunkRows + 5;
+  VecFlt values(2 * rows);
+  for (size_t i = 0; i < values.size(); ++i)
+    values[i] = (float)i;
+  SharedChunks<float> original(2);
+  original.Assign(values);
+  TS_ASSERT_EQUALS(rows, original.GetSize());
+  TS_ASSERT_EQUALS(size_t(4), original.GetChunkCount());
+  TS_ASSERT_EQUALS(rows * 2 * sizeof(float), original.GetBytes());
+  TS_ASSERT_EQUALS(2.0f * (rows - 1), original.GetRow(rows - 1)[0]);
+
+  // Writing a row of a copy copies that row's chunk alone, leaving the original as it was.
+  SharedChunks<float> copy = original;
+  const size_t written = kSharedChunkRows + 7;
+  copy.GetMutableRow(written)[1] = -1.0f;
+  for (size_t chunk = 0; chunk < original.GetChunkCount(); ++chunk)
+  {
+    const bool copied = chunk == written >> kSharedChunkShift;
+    TS_ASSERT_EQUALS(copied, copy.GetChunk(chunk) != original.GetChunk(chunk));
+  }
+  TS_ASSERT_EQUALS(-1.0f, copy.GetRow(written)[1]);
+  TS_ASSERT_EQUALS(2.0f * written + 1, original.GetRow(written)[1]);
+  TS_ASSERT_EQUALS(2.0f * written, copy.GetRow(written)[0]);
+
+  // A chunk held alone is written in place, and a reset lets go of shared chunks unread.
+  const float* alone = copy.GetChunk(1);
+  copy.GetMutableRow(written)[0] = -2.0f;
+  TS_ASSERT_EQUALS(alone, copy.GetChunk(1));
+  const float* shared = original.GetChunk(0);
+  copy.Reset(rows);
+  TS_ASSERT_EQUALS(alone, copy.GetChunk(1));
+  TS_ASSERT(copy.GetChunk(0) != shared);
+  TS_ASSERT_EQUALS(0.0f, original.GetRow(0)[0]);
+  TS_ASSERT_EQUALS(1.0f, original.GetRow(0)[1]);
+
+  SharedChunks<float> other(2);
+  other.Swap(copy);
+  TS_ASSERT_EQUALS(size_t(0), copy.GetSize());
+  TS_ASSERT_EQUALS(rows, other.GetSize());
+  TS_ASSERT_EQUALS(alone, other.GetChunk(1));
+} // XmGridTraceUnitTests::testSharedChunksCopyOnWrite
+//------------------------------------------------------------------------------
+/// \brief Vectors read from the caller's arrays, as rows or as columns of doubles or
+///        floats, trace exactly as the same vectors passed as points.
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testArrayScalarsMatchPoints()
+{
+  const double length = 20.0;
+  BenchmarkGrid grid = iBuildBenchmarkGrid(20, length);
+  const VecPt3d vectors0 = iBenchmarkVectors(grid.m_points, 0.3, 0.2, length);
+  const VecPt3d vectors1 = iBenchmarkVectors(grid.m_points, -0.2, 0.2, length);
+  const int count = (int)grid.m_points.size();
+  const DynBitset activity;
+  const DataLocationEnum loc = DataLocationEnum::LOC_POINTS;
+
+  auto traceWith = [&](const std::function<void(XmGridTrace&, const VecPt3d&, double)>& a_add,
+                       VecPt3d& a_trace, VecDbl& a_times) {
+    BSHP<XmGridTrace> tracer = XmGridTrace::New(grid.m_ugrid);
+    tracer->SetMaxTracingTime(30);
     tracer->SetMinDeltaTime(.01);
-    tracer->SetMaxChangeDistance(.5);
-    tracer->SetMaxChangeVelocity(-1);
-    tracer->SetMaxChangeDirectionInRadians(XM_PI); // never subdivide on direction
-    VecPt3d first = {a_first};
-    VecPt3d second = {a_second};
-    tracer->AddGridScalarsAtTime(first, DataLocationEnum::LOC_CELLS, activity,
-                                 DataLocationEnum::LOC_CELLS, 0.0);
-    tracer->AddGridScalarsAtTime(second, DataLocationEnum::LOC_CELLS, activity,
-                                 DataLocationEnum::LOC_CELLS, 10.0);
-    VecDbl outTimes;
-    tracer->TracePoint({1, 1, 0}, 0.0, a_outTrace, outTimes);
-    TS_ASSERT_EQUALS(a_outTrace.size(), outTimes.size());
+    tracer->SetMaxChangeDistance(1.0);
+    a_add(*tracer, vectors0, 0.0);
+    a_add(*tracer, vectors1, 10.0);
+    tracer->TracePoint({6.3, 7.1, 0.0}, 2.0, a_trace, a_times);
   };
 
-  const Pt3d startPoint = {1, 1, 0};
-
-  VecPt3d rotating;
-  traceWithField({1, 0, 0}, {0, 1, 0}, rotating);
+  VecPt3d expected;
+  VecDbl expectedTimes;
+  traceWith(
+    [&](XmGridTrace& a_tracer, const VecPt3d& a_vectors, double a_time) {
+      a_tracer.AddGridScalarsAtTime(a_vectors, loc, activity, loc, a_time);
+    },
+    expected, expectedTimes);
+  TS_ASSERT(expected.size() > 5);
 
-  // The same field at both timesteps -- what a single-timestep tracer would produce.
-  VecPt3d frozen;
-  traceWithField({1, 0, 0}, {1, 0, 0}, frozen);
+  VecPt3d trace;
+  VecDbl times;
+  traceWith(
+    [&](XmGridTrace& a_tracer, const VecPt3d& a_vectors, double a_time) {
+      VecDbl rows;
+      for (const Pt3d& v : a_vectors)
+      {
+        rows.push_back(v.x);
+        rows.push_back(v.y);
+      }
+      a_tracer.AddGridScalarsAtTime(&rows[0], &rows[1], count, 2, loc, activity, loc, a_time);
+    },
+    trace, times);
+  TS_ASSERT(expected == trace);
+  TS_ASSERT(expectedTimes == times);
+
+  traceWith(
+    [&](XmGridTrace& a_tracer, const VecPt3d& a_vectors, double a_time) {
+      VecFlt u, v;
+      for (const Pt3d& vector : a_vectors)
+      {
+        u.push_back((float)vector.x);
+        v.push_back((float)vector.y);
+      }
+      a_tracer.AddGridScalarsAtTime(&u[0], &v[0], count, 1, loc, activity, loc, a_time);
+    },
+    trace, times);
+  TS_ASSERT(expected == trace);
+  TS_ASSERT(expectedTimes == times);
+} // XmGridTraceUnitTests::testArrayScalarsMatchPoints
+//------------------------------------------------------------------------------
+/// \brief TracePoints gives each point exactly the trace TracePoint gives it, on any
+///        number of threads, and leaves a batch in flight alone.
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testTracePointsMatchTracePoint()
+{
+  const double length = 20.0;
+  BenchmarkGrid grid = iBuildBenchmarkGrid(20, length);
+  BSHP<XmGridTrace> tracer = XmGridTrace::New(grid.m_ugrid);
+  tracer->SetMaxTracingTime(30);
+  tracer->SetMinDeltaTime(.01);
+  tracer->SetMaxChangeDistance(1.0);
+  const DynBitset activity;
+  const DataLocationEnum loc = DataLocationEnum::LOC_POINTS;
+  tracer->AddGridScalarsAtTime(iBenchmarkVectors(grid.m_points, 0.3, 0.2, length), loc,
+                               activity, loc, 0.0);
+  tracer->AddGridScalarsAtTime(iBenchmarkVectors(grid.m_points, -0.2, 0.2, length), loc,
+                               activity, loc, 10.0);
+  // Some seeds start off the grid and some after the window, so every kind of empty or
+  // unfinished trace is in the mix.
+  VecPt3d seeds = iBenchmarkSeeds(150, -1.0, length + 1.0, 0.0, 0.0);
+  VecDbl seedTimes;
+  for (size_t i = 0; i < seeds.size(); ++i)
+    seedTimes.push_back((i % 4) * 4.0);
 
-  TS_ASSERT(rotating.size() >= 3);
-  TS_ASSERT(frozen.size() >= 3);
+  std::vector<VecPt3d> expected(seeds.size());
+  std::vector<VecDbl> expectedTimes(seeds.size());
+  std::vector<XmGridTraceExitEnum> expectedReasons;
+  for (size_t i = 0; i < seeds.size(); ++i)
+  {
+    tracer->TracePoint(seeds[i], seedTimes[i], expected[i], expectedTimes[i]);
+    expectedReasons.push_back(tracer->GetExitReason());
+  }
+  const XmGridTraceExitEnum lastReason = tracer->GetExitReason();
 
-  // Released at the first timestep, so the first step is that timestep's field alone.
-  TS_ASSERT_DELTA(startPoint.y, rotating[1].y, 1e-9);
-  TS_ASSERT(rotating[1].x > startPoint.x);
+  tracer->StartTraces({{5.0, 5.0, 0.0}}, {0.0});
+  tracer->ContinueTraces();
+  std::vector<VecPt3d> batchBefore, batchAfter;
+  std::vector<VecDbl> batchTimes;
+  std::vector<XmGridTraceExitEnum> batchReasons;
+  tracer->GetTraceResults(batchBefore, batchTimes, batchReasons);
 
-  // A frozen field never turns.
-  for (size_t i = 0; i < frozen.size(); ++i)
+  for (int threadCount : {1, 4})
   {
-    TS_ASSERT_DELTA(startPoint.y, frozen[i].y, 1e-9);
+    tracer->SetThreadCount(threadCount);
+    tracer->SetPacketWidth(threadCount);
+    VecDbl xy, times;
+    std::vector<size_t> offsets;
+    std::vector<XmGridTraceExitEnum> reasons;
+    tracer->TracePoints(seeds, seedTimes, xy, times, offsets, reasons);
+    TS_ASSERT(expectedReasons == reasons);
+    TS_ASSERT_EQUALS(lastReason, tracer->GetExitReason());
+    TS_ASSERT_EQUALS(seeds.size() + 1, offsets.size());
+    int differences = 0;
+    for (size_t i = 0; i < seeds.size(); ++i)
+    {
+      bool same = offsets[i + 1] - offsets[i] == expected[i].size();
+      for (size_t v = offsets[i]; same && v < offsets[i + 1]; ++v)
+      {
+        const size_t j = v - offsets[i];
+        same = xy[2 * v] == expected[i][j].x && xy[2 * v + 1] == expected[i][j].y &&
+               times[v] == expectedTimes[i][j];
+      }
+      if (!same)
+        ++differences;
+    }
+    TS_ASSERT_EQUALS(0, differences);
   }
 
-  // A changing one does, and that difference is the feature.
-  TS_ASSERT(rotating.back().y > startPoint.y + 0.1);
-  TS_ASSERT(rotating.back().x < frozen.back().x);
-} // XmGridTraceUnitTests::testTimeVaryingFieldChangesPath
+  tracer->GetTraceResults(batchAfter, batchTimes, batchReasons);
+  TS_ASSERT(batchBefore == batchAfter);
+
+  VecDbl xy, times;
+  std::vector<size_t> offsets;
+  std::vector<XmGridTraceExitEnum> reasons;
+  tracer->TracePoints(seeds, {0.0}, xy, times, offsets, reasons);
+  TS_ASSERT(reasons.empty());
+  TS_ASSERT(xy.empty());
+} // XmGridTraceUnitTests::testTracePointsMatchTracePoint
 //------------------------------------------------------------------------------
-/// \brief A single-window batch returns exactly what serial TracePoint calls return.
-///
-/// The batch exists to cross a language boundary once instead of once per seed, so its value
-/// depends on being a faithful stand-in. Comparing against serial TracePoint on an identical
-/// fixture is a stronger oracle than a recorded baseline, which would drift with the tracer
-/// rather than pin the equivalence.
-///
-/// The seeds cover the shapes a caller has to handle: traces that leave the grid, and a seed
-/// outside the grid entirely, which yields no polyline at all.
+/// \brief Traces taken as they finish are the traces the whole batch gives at the end,
+///        and taking the batch leaves the tracer without one.
 //------------------------------------------------------------------------------
-void XmGridTraceUnitTests::testBatchMatchesSerialTracePoint()
+void XmGridTraceUnitTests::testTakeTraceResults()
 {
-  const VecPt3d seeds = {{.5, .5, 0}, {.25, .75, 0}, {-.1, 0, 0}};
-  const VecDbl seedTimes = {.5, .5, .5};
-
-  BSHP<XmGridTrace> serialTracer;
-  iCreateDefaultSingleCell(serialTracer);
-  std::vector<VecPt3d> serialTraces(seeds.size());
-  std::vector<VecDbl> serialTimes(seeds.size());
-  std::vector<XmGridTraceExitEnum> serialReasons(seeds.size());
+  const double length = 20.0;
+  BenchmarkGrid grid = iBuildBenchmarkGrid(20, length);
+  const VecPt3d seeds = iBenchmarkSeeds(300, 0.5, length - 0.5, 0.0, 0.0);
+  VecDbl seedTimes;
   for (size_t i = 0; i < seeds.size(); ++i)
+    seedTimes.push_back((i % 3) * 4.0);
+  const DynBitset activity;
+  const DataLocationEnum loc = DataLocationEnum::LOC_POINTS;
+  auto addStep = [&](XmGridTrace& a_tracer, int a_step) {
+    const double omega = a_step % 2 ? -0.3 : 0.3;
+    a_tracer.AddGridScalarsAtTime(iBenchmarkVectors(grid.m_points, omega, 0.2, length), loc,
+                                  activity, loc, a_step * 10.0);
+  };
+  auto newTracer = [&]() {
+    BSHP<XmGridTrace> tracer = XmGridTrace::New(grid.m_ugrid);
+    tracer->SetMaxTracingTime(25);
+    tracer->SetMinDeltaTime(.01);
+    tracer->SetMaxChangeDistance(1.0);
+    addStep(*tracer, 0);
+    addStep(*tracer, 1);
+    tracer->StartTraces(seeds, seedTimes);
+    return tracer;
+  };
+
+  BSHP<XmGridTrace> whole = newTracer();
+  BSHP<XmGridTrace> taking = newTracer();
+  // Threads growing traces into blocks freed by the ones taken.
+  taking->SetThreadCount(4);
+  BatchResults expected, taken;
+  taken.m_traces.resize(seeds.size());
+  taken.m_times.resize(seeds.size());
+  taken.m_reasons.resize(seeds.size(), GTEXIT_NOT_STARTED);
+  std::vector<char> isTaken(seeds.size(), 0);
+  int takenEarly = 0;
+  for (int step = 2; step < 8; ++step)
   {
-    serialTracer->TracePoint(seeds[i], seedTimes[i], serialTraces[i], serialTimes[i]);
-    serialReasons[i] = serialTracer->GetExitReason();
+    const int waiting = whole->ContinueTraces();
+    TS_ASSERT_EQUALS(waiting, taking->ContinueTraces());
+    for (size_t i = 0; i < seeds.size(); ++i)
+    {
+      XmGridTraceExitEnum reason;
+      if (!isTaken[i] &&
+          taking->TakeTraceResult(i, taken.m_traces[i], taken.m_times[i], reason))
+      {
+        isTaken[i] = 1;
+        taken.m_reasons[i] = reason;
+        takenEarly += waiting > 0;
+      }
+      else if (!isTaken[i])
+      {
+        TS_ASSERT(reason == GTEXIT_WAITING_FOR_TIME_STEP || reason == GTEXIT_NOT_STARTED);
+      }
+    }
+    if (waiting == 0)
+      break;
+    addStep(*whole, step);
+    addStep(*taking, step);
   }
+  TS_ASSERT(takenEarly > 0);
+  TS_ASSERT_EQUALS(seeds.size(), (size_t)std::count(isTaken.begin(), isTaken.end(), 1));
+  whole->GetTraceResults(expected.m_traces, expected.m_times, expected.m_reasons);
+  TS_ASSERT_EQUALS(0, iCountBatchDifferences(expected, taken));
+
+  // A taken trace keeps its reason but not its vertices.
+  BatchResults left;
+  taking->GetTraceResults(left.m_traces, left.m_times, left.m_reasons);
+  TS_ASSERT(left.m_reasons == expected.m_reasons);
+  TS_ASSERT(left.m_traces[0].empty());
+  VecPt3d trace;
+  VecDbl times;
+  XmGridTraceExitEnum reason;
+  TS_ASSERT(!taking->TakeTraceResult(seeds.size(), trace, times, reason));
 
-  BSHP<XmGridTrace> batchTracer;
-  iCreateDefaultSingleCell(batchTracer);
-  batchTracer->StartTraces(seeds, seedTimes);
-  batchTracer->ContinueTraces();
-  std::vector<VecPt3d> batchTraces;
-  std::vector<VecDbl> batchTimes;
-  std::vector<XmGridTraceExitEnum> reasons;
-  batchTracer->GetTraceResults(batchTraces, batchTimes, reasons);
-
-  TS_ASSERT_EQUALS(seeds.size(), batchTraces.size());
-  TS_ASSERT_EQUALS(seeds.size(), batchTimes.size());
-  TS_ASSERT_EQUALS(seeds.size(), reasons.size());
+  BatchResults all;
+  whole->TakeTraceResults(all.m_traces, all.m_times, all.m_reasons);
+  TS_ASSERT_EQUALS(0, iCountBatchDifferences(expected, all));
+  whole->GetTraceResults(left.m_traces, left.m_times, left.m_reasons);
+  TS_ASSERT(left.m_traces.empty());
+  TS_ASSERT_EQUALS(0, whole->ContinueTraces());
+} // XmGridTraceUnitTests::testTakeTraceResults
+//------------------------------------------------------------------------------
+/// \brief A sink is handed every trace the batch would otherwise keep, on any number of
+///        threads and across windows, and the batch keeps none of it.
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testTraceSinkMatchesResults()
+{
+  const double length = 20.0;
+  BenchmarkGrid grid = iBuildBenchmarkGrid(20, length);
+  const VecPt3d seeds = iBenchmarkSeeds(300, 0.5, length - 0.5, 0.0, 0.0);
+  VecDbl seedTimes;
   for (size_t i = 0; i < seeds.size(); ++i)
+    seedTimes.push_back((i % 3) * 4.0);
+  const DynBitset activity;
+  const DataLocationEnum loc = DataLocationEnum::LOC_POINTS;
+  auto addStep = [&](XmGridTrace& a_tracer, int a_step) {
+    const double omega = a_step % 2 ? -0.3 : 0.3;
+    a_tracer.AddGridScalarsAtTime(iBenchmarkVectors(grid.m_points, omega, 0.2, length), loc,
+                                  activity, loc, a_step * 10.0);
+  };
+  auto newTracer = [&](BSHP<XmGridTraceSink> a_sink, int a_threadCount) {
+    BSHP<XmGridTrace> tracer = XmGridTrace::New(grid.m_ugrid);
+    tracer->SetMaxTracingTime(25);
+    tracer->SetMinDeltaTime(.01);
+    tracer->SetMaxChangeDistance(1.0);
+    tracer->SetThreadCount(a_threadCount);
+    tracer->SetPacketWidth(4);
+    tracer->SetTraceSink(a_sink);
+    addStep(*tracer, 0);
+    addStep(*tracer, 1);
+    tracer->StartTraces(seeds, seedTimes);
+    return tracer;
+  };
+
+  BSHP<XmGridTrace> keeping = newTracer(nullptr, 1);
+  for (int threadCount : {1, 4})
   {
-    TS_ASSERT_DELTA_VECPT3D(serialTraces[i], batchTraces[i], 1e-12);
-    TS_ASSERT_DELTA_VEC(serialTimes[i], batchTimes[i], 1e-12);
-    // GetExitReason is the single-point path's answer to what GetTraceResults reports per
-    // seed; if they can disagree, a caller cannot use TracePoint and the batch interchangeably.
-    TS_ASSERT_EQUALS((int)reasons[i], (int)serialReasons[i]);
-    // Positions and times are documented as parallel arrays, so a caller may zip them.
-    TS_ASSERT_EQUALS(batchTraces[i].size(), batchTimes[i].size());
+    BSHP<RecordingSink> sink(new RecordingSink(seeds.size()));
+    BSHP<XmGridTrace> streaming = newTracer(sink, threadCount);
+    TS_ASSERT(streaming->GetTraceSink() == sink);
+    // Once a batch is under way, changing the sink is for the next one.
+    streaming->SetTraceSink(nullptr);
+    for (int step = 2; step < 8; ++step)
+    {
+      const int waiting = streaming->ContinueTraces();
+      if (threadCount == 1)
+        TS_ASSERT_EQUALS(waiting, keeping->ContinueTraces());
+      if (waiting == 0)
+        break;
+      addStep(*streaming, step);
+      if (threadCount == 1)
+        addStep(*keeping, step);
+    }
+    BatchResults expected, kept;
+    keeping->GetTraceResults(expected.m_traces, expected.m_times, expected.m_reasons);
+    TS_ASSERT_EQUALS(0, iCountBatchDifferences(expected, sink->m_results));
+    TS_ASSERT_EQUALS(0, sink->m_outOfOrder);
+    TS_ASSERT(sink->m_longestRun > 1);
+
+    streaming->GetTraceResults(kept.m_traces, kept.m_times, kept.m_reasons);
+    TS_ASSERT(kept.m_reasons == expected.m_reasons);
+    size_t keptVertices = 0;
+    for (const VecPt3d& trace : kept.m_traces)
+      keptVertices += trace.size();
+    TS_ASSERT_EQUALS((size_t)0, keptVertices);
   }
-
-  // The seed outside the grid produces no polyline -- callers cannot assume one per seed.
-  TS_ASSERT(batchTraces[2].empty());
-  TS_ASSERT_EQUALS((int)GTEXIT_SEED_NOT_TRACEABLE, (int)reasons[2]);
-  TS_ASSERT(batchTraces[0].size() >= 2);
-  TS_ASSERT(batchTraces[1].size() >= 2);
-
-  // A caller supplying the wrong number of start times has a bug; seeding the common prefix
-  // would hide it, so the whole batch is refused.
-  batchTracer->StartTraces(seeds, {.5});
-  batchTracer->GetTraceResults(batchTraces, batchTimes, reasons);
-  TS_ASSERT(batchTraces.empty());
-  TS_ASSERT(batchTimes.empty());
-  TS_ASSERT(reasons.empty());
-} // XmGridTraceUnitTests::testBatchMatchesSerialTracePoint
+} // XmGridTraceUnitTests::testTraceSinkMatchesResults
 //------------------------------------------------------------------------------
-/// \brief A trace continues past the second time step once a later one is supplied.
-///
-/// This is the point of the whole batch design: the field is only known between the two
-/// loaded time steps, so a trace that wants to run further has to stop, ask for more, and
-/// resume where it was -- carrying its budgets, its adaptive step size and its previous
-/// velocity with it.
-///
-/// The strongest assertion here is not that the continued trace is longer. It is that the
-/// trace which never received the third time step is a byte-for-byte *prefix* of the one
-/// that did. That is what shows resuming extends the path rather than recomputing it, and it
-/// is what would fail if any carried-over state were dropped at the window boundary.
+/// \brief A simplified trace keeps a subset of the vertices, with their times, and stays
+///        within the tolerance of every one it drops; streaming it changes nothing.
 //------------------------------------------------------------------------------
-void XmGridTraceUnitTests::testTracesContinueAcrossTimeSteps()
+void XmGridTraceUnitTests::testSimplifiedTracesStayWithinTolerance()
 {
-  // One cell spanning the domain, so the field is spatially uniform and every change in the
-  // path comes from time. It rotates +x -> +y -> -x across three time steps.
-  VecPt3d points = {{0, 0, 0}, {40, 0, 0}, {40, 40, 0}, {0, 40, 0}};
-  VecInt cells = {XMU_QUAD, 4, 0, 1, 2, 3};
-  std::shared_ptr<XmUGrid> ugrid = XmUGrid::New(points, cells);
+  const double length = 20.0;
+  const double tolerance = 0.01;
+  BenchmarkGrid grid = iBuildBenchmarkGrid(20, length);
+  const VecPt3d seeds = iBenchmarkSeeds(100, 0.5, length - 0.5, 0.0, 0.0);
+  const VecDbl seedTimes(seeds.size(), 0.0);
+  const DynBitset activity;
+  const DataLocationEnum loc = DataLocationEnum::LOC_POINTS;
+  // Slow, gently curving flow, traced in short steps: the case simplifying is for.
+  auto addStep = [&](XmGridTrace& a_tracer, int a_step) {
+    const double omega = a_step % 2 ? -0.01 : 0.01;
+    a_tracer.AddGridScalarsAtTime(iBenchmarkVectors(grid.m_points, omega, 0.2, length), loc,
+                                  activity, loc, a_step * 10.0);
+  };
+  auto trace = [&](double a_tolerance, BSHP<XmGridTraceSink> a_sink, int a_threadCount) {
+    BSHP<XmGridTrace> tracer = XmGridTrace::New(grid.m_ugrid);
+    tracer->SetMaxTracingTime(40);
+    tracer->SetMinDeltaTime(.001);
+    tracer->SetMaxChangeDistance(0.05);
+    tracer->SetSimplificationTolerance(a_tolerance);
+    TS_ASSERT_EQUALS(a_tolerance, tracer->GetSimplificationTolerance());
+    tracer->SetThreadCount(a_threadCount);
+    tracer->SetTraceSink(a_sink);
+    addStep(*tracer, 0);
+    addStep(*tracer, 1);
+    tracer->StartTraces(seeds, seedTimes);
+    for (int step = 2; tracer->ContinueTraces() > 0; ++step)
+      addStep(*tracer, step);
+    BatchResults results;
+    tracer->GetTraceResults(results.m_traces, results.m_times, results.m_reasons);
+    return results;
+  };
 
-  DynBitset activity;
-  activity.push_back(true);
-  const VecPt3d seeds = {{20, 10, 0}};
-  const VecDbl seedTimes = {0};
+  const BatchResults full = trace(0.0, nullptr, 1);
+  const BatchResults simplified = trace(tolerance, nullptr, 1);
+  BSHP<RecordingSink> sink(new RecordingSink(seeds.size()));
+  const BatchResults streamed = trace(tolerance, sink, 4);
+  TS_ASSERT_EQUALS(0, iCountBatchDifferences(simplified, sink->m_results));
+  TS_ASSERT(streamed.m_reasons == simplified.m_reasons);
+  TS_ASSERT(simplified.m_reasons == full.m_reasons);
 
-  auto buildTracer = [&]() {
-    BSHP<XmGridTrace> tracer = XmGridTrace::New(ugrid);
-    tracer->SetVectorMultiplier(1);
-    tracer->SetMaxTracingTime(18);
-    tracer->SetMaxTracingDistance(1000);
+  size_t fullCount = 0, simplifiedCount = 0;
+  int strays = 0, notSubsets = 0;
+  for (size_t i = 0; i < seeds.size(); ++i)
+  {
+    const VecPt3d& all = full.m_traces[i];
+    const VecPt3d& kept = simplified.m_traces[i];
+    fullCount += all.size();
+    simplifiedCount += kept.size();
+    if (all.empty())
+    {
+      notSubsets += !kept.empty();
+      continue;
+    }
+    // Walk the full trace, matching each kept vertex by its time and measuring every
+    // dropped one against the segment between the kept vertices either side.
+    size_t k = 0;
+    for (size_t j = 0; j < all.size(); ++j)
+    {
+      if (k < kept.size() && full.m_times[i][j] == simplified.m_times[i][k])
+      {
+        notSubsets += all[j] != kept[k];
+        ++k;
+        continue;
+      }
+      if (k == 0 || k == kept.size())
+      {
+        ++notSubsets;
+        continue;
+      }
+      const Pt3d& a = kept[k - 1];
+      const Pt3d& b = kept[k];
+      const double dx = b.x - a.x, dy = b.y - a.y;
+      const double lengthSq = dx * dx + dy * dy;
+      double t = lengthSq > 0 ? ((all[j].x - a.x) * dx + (all[j].y - a.y) * dy) / lengthSq : 0;
+      t = std::max(0.0, std::min(1.0, t));
+      const double ex = a.x + t * dx - all[j].x, ey = a.y + t * dy - all[j].y;
+      strays += sqrt(ex * ex + ey * ey) > tolerance * (1 + 1e-9);
+    }
+    notSubsets += k != kept.size();
+    notSubsets += kept.front() != all.front() || kept.back() != all.back();
+  }
+  TS_ASSERT_EQUALS(0, notSubsets);
+  TS_ASSERT_EQUALS(0, strays);
+  TS_ASSERT(simplifiedCount * 10 < fullCount);
+} // XmGridTraceUnitTests::testSimplifiedTracesStayWithinTolerance
+//------------------------------------------------------------------------------
+/// \brief A snapshot traces the field frozen at one time: the same paths as a window whose
+///        steps both hold that field, without ever waiting for another step.
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testSnapshotTracesFrozenField()
+{
+  const double length = 20.0;
+  BenchmarkGrid grid = iBuildBenchmarkGrid(20, length);
+  const VecPt3d seeds = iBenchmarkSeeds(200, 0.5, length - 0.5, 0.0, 0.0);
+  const VecDbl seedTimes(seeds.size(), 2.0);
+  const DynBitset activity;
+  const DataLocationEnum loc = DataLocationEnum::LOC_POINTS;
+  // The benchmark field is linear in omega, so the field at 3/4 of the way from a step with
+  // 0.2 to one with -0.2 is the field with -0.1.
+  auto newTracer = [&](double a_omega1, double a_omega2, double a_time2) {
+    BSHP<XmGridTrace> tracer = XmGridTrace::New(grid.m_ugrid);
+    tracer->SetMaxTracingTime(30);
     tracer->SetMinDeltaTime(.01);
-    tracer->SetMaxChangeDistance(.5);
-    tracer->SetMaxChangeVelocity(-1);
-    tracer->SetMaxChangeDirectionInRadians(XM_PI); // never subdivide on direction
-    VecPt3d east = {{1, 0, 0}}, north = {{0, 1, 0}};
-    tracer->AddGridScalarsAtTime(east, DataLocationEnum::LOC_CELLS, activity,
-                                 DataLocationEnum::LOC_CELLS, 0.0);
-    tracer->AddGridScalarsAtTime(north, DataLocationEnum::LOC_CELLS, activity,
-                                 DataLocationEnum::LOC_CELLS, 10.0);
+    tracer->SetMaxChangeDistance(0.5);
+    tracer->SetIntegrator(GTINT_RK4);
+    tracer->AddGridScalarsAtTime(iBenchmarkVectors(grid.m_points, a_omega1, 0.2, length), loc,
+                                 activity, loc, 0.0);
+    tracer->AddGridScalarsAtTime(iBenchmarkVectors(grid.m_points, a_omega2, 0.2, length), loc,
+                                 activity, loc, a_time2);
     return tracer;
   };
+  auto traceBatch = [&](XmGridTrace& a_tracer, int& a_waiting) {
+    a_tracer.StartTraces(seeds, seedTimes);
+    a_waiting = a_tracer.ContinueTraces();
+    BatchResults results;
+    a_tracer.GetTraceResults(results.m_traces, results.m_times, results.m_reasons);
+    return results;
+  };
 
-  // Never given the third time step: it must stop at the second and say so.
-  BSHP<XmGridTrace> stopped = buildTracer();
-  stopped->StartTraces(seeds, seedTimes);
-  TS_ASSERT_EQUALS(1, stopped->ContinueTraces());
-  std::vector<VecPt3d> stoppedTraces;
-  std::vector<VecDbl> stoppedTimes;
-  std::vector<XmGridTraceExitEnum> stoppedReasons;
-  stopped->GetTraceResults(stoppedTraces, stoppedTimes, stoppedReasons);
-  TS_ASSERT_EQUALS((int)GTEXIT_WAITING_FOR_TIME_STEP, (int)stoppedReasons[0]);
-  TS_ASSERT_DELTA(10.0, stoppedTimes[0].back(), 1e-9);
+  BSHP<XmGridTrace> snapshot = newTracer(0.2, -0.2, 10.0);
+  double time = -1;
+  TS_ASSERT(!snapshot->GetSnapshotTime(time));
+  snapshot->SetSnapshotTime(7.5);
+  TS_ASSERT(snapshot->GetSnapshotTime(time));
+  TS_ASSERT_EQUALS(7.5, time);
+  BSHP<XmGridTrace> steady = newTracer(-0.1, -0.1, 1e6);
+  int snapshotWaiting = -1, steadyWaiting = -1;
+  const BatchResults frozen = traceBatch(*snapshot, snapshotWaiting);
+  const BatchResults expected = traceBatch(*steady, steadyWaiting);
+  TS_ASSERT_EQUALS(0, snapshotWaiting);
+  TS_ASSERT_EQUALS(0, steadyWaiting);
+  TS_ASSERT(frozen.m_reasons == expected.m_reasons);
+  // The snapshot blends fitted coefficients where the steady window fits blended floats,
+  // so the paths agree to rounding, not bit for bit.
+  double worst = 0;
+  int reachedPastWindow = 0;
+  for (size_t i = 0; i < seeds.size(); ++i)
+  {
+    TS_ASSERT_EQUALS(expected.m_traces[i].size(), frozen.m_traces[i].size());
+    if (frozen.m_traces[i].empty() || expected.m_traces[i].empty())
+      continue;
+    const Pt3d& a = frozen.m_traces[i].back();
+    const Pt3d& b = expected.m_traces[i].back();
+    worst = std::max(worst, std::max(fabs(a.x - b.x), fabs(a.y - b.y)));
+    reachedPastWindow += frozen.m_times[i].back() > 10.0;
+  }
+  TS_ASSERT_DELTA(0.0, worst, 1e-4);
+  TS_ASSERT(reachedPastWindow > 0);
 
-  // Given the third: it must resume and run out its tracing time instead.
-  BSHP<XmGridTrace> continued = buildTracer();
-  continued->StartTraces(seeds, seedTimes);
-  TS_ASSERT_EQUALS(1, continued->ContinueTraces());
-  VecPt3d west = {{-1, 0, 0}};
-  continued->AddGridScalarsAtTime(west, DataLocationEnum::LOC_CELLS, activity,
-                                  DataLocationEnum::LOC_CELLS, 20.0);
-  TS_ASSERT_EQUALS(0, continued->ContinueTraces());
-  std::vector<VecPt3d> traces;
-  std::vector<VecDbl> times;
-  std::vector<XmGridTraceExitEnum> reasons;
-  continued->GetTraceResults(traces, times, reasons);
-  TS_ASSERT_EQUALS((int)GTEXIT_MAX_TRACING_TIME, (int)reasons[0]);
-  TS_ASSERT_DELTA(18.0, times[0].back(), 1e-9);
+  // Without time or distance budgets a snapshot trace stops after the window's length.
+  snapshot->SetMaxTracingTime(-1);
+  VecPt3d trace;
+  VecDbl times;
+  snapshot->TracePoint(Pt3d(10.0, 12.0, 0.0), 2.0, trace, times);
+  TS_ASSERT_EQUALS(GTEXIT_MAX_TRACING_TIME, snapshot->GetExitReason());
+  TS_ASSERT_DELTA(12.0, times.back(), 1e-9);
+
+  // Clearing the snapshot traces through the window again, exactly as if it never had one.
+  snapshot->SetMaxTracingTime(30);
+  snapshot->ClearSnapshotTime();
+  TS_ASSERT(!snapshot->GetSnapshotTime(time));
+  BSHP<XmGridTrace> plain = newTracer(0.2, -0.2, 10.0);
+  const BatchResults cleared = traceBatch(*snapshot, snapshotWaiting);
+  const BatchResults through = traceBatch(*plain, steadyWaiting);
+  TS_ASSERT(snapshotWaiting > 0);
+  TS_ASSERT_EQUALS(snapshotWaiting, steadyWaiting);
+  TS_ASSERT_EQUALS(0, iCountBatchDifferences(through, cleared));
+
+  // Steps at different data locations share no triangulation; the snapshot then blends
+  // each evaluation instead, to the same effect.
+  BSHP<XmGridTrace> mixed = XmGridTrace::New(grid.m_ugrid);
+  mixed->SetMaxTracingTime(30);
+  mixed->SetMaxChangeDistance(0.5);
+  const Pt3d drift(0.2, 0.1, 0.0);
+  mixed->AddGridScalarsAtTime(VecPt3d(grid.m_points.size(), drift), loc, activity, loc, 0.0);
+  mixed->AddGridScalarsAtTime(VecPt3d(grid.m_ugrid->GetCellCount(), drift),
+                              DataLocationEnum::LOC_CELLS, activity, loc, 10.0);
+  mixed->SetSnapshotTime(20.0);
+  mixed->TracePoint(Pt3d(2.0, 2.0, 0.0), 2.0, trace, times);
+  TS_ASSERT_EQUALS(GTEXIT_MAX_TRACING_TIME, mixed->GetExitReason());
+  TS_ASSERT_DELTA(32.0, times.back(), 1e-9);
+  TS_ASSERT_DELTA(8.0, trace.back().x, 1e-4);
+  TS_ASSERT_DELTA(5.0, trace.back().y, 1e-4);
+} // XmGridTraceUnitTests::testSnapshotTracesFrozenField
+//------------------------------------------------------------------------------
+/// \brief A window of more than two time steps traces through its interior steps without
+///        stopping, and otherwise traces exactly as a window of two.
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testWindowTracesThroughInteriorSteps()
+{
+  const double length = 20.0;
+  BenchmarkGrid grid = iBuildBenchmarkGrid(20, length);
+  const VecPt3d seeds = iBenchmarkSeeds(200, 0.5, length - 0.5, 0.0, 0.0);
+  const VecDbl seedTimes(seeds.size(), 0.0);
+  const DynBitset activity;
+  const DataLocationEnum loc = DataLocationEnum::LOC_POINTS;
+  const double omegas[] = {0.2, 0.1, 0.0, -0.1}; // vortex rate of each step
+  auto newTracer = [&](int a_windowTimeSteps) {
+    BSHP<XmGridTrace> tracer = XmGridTrace::New(grid.m_ugrid);
+    TS_ASSERT_EQUALS(2, tracer->GetWindowTimeSteps());
+    tracer->SetWindowTimeSteps(a_windowTimeSteps);
+    tracer->SetMaxTracingTime(30);
+    tracer->SetMinDeltaTime(.01);
+    tracer->SetMaxChangeDistance(0.5);
+    tracer->SetIntegrator(GTINT_RK4);
+    return tracer;
+  };
+  auto addStep = [&](XmGridTrace& a_tracer, int a_step) {
+    a_tracer.AddGridScalarsAtTime(iBenchmarkVectors(grid.m_points, omegas[a_step], 0.2, length),
+                                  loc, activity, loc, a_step * 5.0);
+  };
+  auto results = [](const XmGridTrace& a_tracer) {
+    BatchResults batch;
+    a_tracer.GetTraceResults(batch.m_traces, batch.m_times, batch.m_reasons);
+    return batch;
+  };
 
-  // Resuming extends; it does not restart.
-  TS_ASSERT(traces[0].size() > stoppedTraces[0].size());
-  for (size_t i = 0; i < stoppedTraces[0].size(); ++i)
+  // Loaded a step at a time, a wider window traces exactly as two steps do: every trace
+  // waits at the newest step, and the steps before it are the same either way.
+  BSHP<XmGridTrace> stepped = newTracer(2);
+  BSHP<XmGridTrace> wide = newTracer(4);
+  for (BSHP<XmGridTrace>* tracer : {&stepped, &wide})
   {
-    TS_ASSERT_DELTA(stoppedTraces[0][i].x, traces[0][i].x, 1e-12);
-    TS_ASSERT_DELTA(stoppedTraces[0][i].y, traces[0][i].y, 1e-12);
-    TS_ASSERT_DELTA(stoppedTimes[0][i], times[0][i], 1e-12);
+    addStep(**tracer, 0);
+    addStep(**tracer, 1);
+    (*tracer)->StartTraces(seeds, seedTimes);
+    (*tracer)->ContinueTraces();
+    addStep(**tracer, 2);
+    (*tracer)->ContinueTraces();
+    addStep(**tracer, 3);
+  }
+  const int steppedWaiting = stepped->ContinueTraces();
+  TS_ASSERT_EQUALS(steppedWaiting, wide->ContinueTraces());
+  TS_ASSERT(steppedWaiting > 0);
+  const BatchResults expected = results(*stepped);
+  TS_ASSERT_EQUALS(0, iCountBatchDifferences(expected, results(*wide)));
+
+  // Loaded all at once, one call traces through both interior steps, and each trace waits
+  // once rather than once per step. Packets then hold traces on either side of a step.
+  BSHP<XmGridTrace> ahead = newTracer(4);
+  ahead->SetPacketWidth(8);
+  for (int step = 0; step < 4; ++step)
+    addStep(*ahead, step);
+  ahead->StartTraces(seeds, seedTimes);
+  const int aheadWaiting = ahead->ContinueTraces();
+  TS_ASSERT(aheadWaiting > 0);
+  TS_ASSERT_EQUALS((size_t)aheadWaiting,
+                   ahead->GetStatistics().m_exitReasons[GTEXIT_WAITING_FOR_TIME_STEP]);
+  TS_ASSERT(stepped->GetStatistics().m_exitReasons[GTEXIT_WAITING_FOR_TIME_STEP] >
+            2 * (size_t)steppedWaiting);
+  // The vortex's rate changes linearly in time, so two steps at the window's ends blend to
+  // the same field as the four do, and its traces, never cut short at 5 and 10, match.
+  BSHP<XmGridTrace> span = newTracer(2);
+  span->AddGridScalarsAtTime(iBenchmarkVectors(grid.m_points, omegas[0], 0.2, length), loc,
+                             activity, loc, 0.0);
+  span->AddGridScalarsAtTime(iBenchmarkVectors(grid.m_points, omegas[3], 0.2, length), loc,
+                             activity, loc, 15.0);
+  span->StartTraces(seeds, seedTimes);
+  TS_ASSERT_EQUALS(aheadWaiting, span->ContinueTraces());
+  const BatchResults throughSteps = results(*ahead);
+  const BatchResults spanned = results(*span);
+  TS_ASSERT(throughSteps.m_reasons == spanned.m_reasons);
+  double worst = 0;
+  for (size_t i = 0; i < seeds.size(); ++i)
+  {
+    TS_ASSERT_EQUALS(spanned.m_traces[i].size(), throughSteps.m_traces[i].size());
+    if (throughSteps.m_traces[i].empty() || spanned.m_traces[i].empty())
+      continue;
+    const Pt3d& a = throughSteps.m_traces[i].back();
+    const Pt3d& b = spanned.m_traces[i].back();
+    worst = std::max(worst, std::max(fabs(a.x - b.x), fabs(a.y - b.y)));
   }
+  TS_ASSERT_DELTA(0.0, worst, 1e-5);
+
+  // A change builds on the newest step in any window, as a whole step would.
+  BSHP<XmGridTrace> changes = newTracer(4);
+  for (int step = 0; step < 3; ++step)
+    addStep(*changes, step);
+  const VecPt3d last = iBenchmarkVectors(grid.m_points, omegas[3], 0.2, length);
+  VecInt indices;
+  for (int i = 0; i < (int)last.size(); ++i)
+    indices.push_back(i);
+  changes->AddGridScalarChangesAtTime(indices, last, {}, 15.0);
+  changes->StartTraces(seeds, seedTimes);
+  changes->ContinueTraces();
+  TS_ASSERT_EQUALS(0, iCountBatchDifferences(throughSteps, results(*changes)));
+
+  // Shrinking the window drops its oldest steps at once, leaving what two steps would hold.
+  ahead->SetWindowTimeSteps(1);
+  TS_ASSERT_EQUALS(2, ahead->GetWindowTimeSteps());
+  VecPt3d trace, expectedTrace;
+  VecDbl times, expectedTimes;
+  ahead->TracePoint(Pt3d(10.0, 12.0, 0.0), 10.0, trace, times);
+  stepped->TracePoint(Pt3d(10.0, 12.0, 0.0), 10.0, expectedTrace, expectedTimes);
+  TS_ASSERT_EQUALS(GTEXIT_WAITING_FOR_TIME_STEP, ahead->GetExitReason());
+  TS_ASSERT_DELTA_VECPT3D(expectedTrace, trace, 0.0);
+  TS_ASSERT_DELTA_VEC(expectedTimes, times, 0.0);
+
+  // Steps at alternating data locations share no triangulation with their neighbors.
+  BSHP<XmGridTrace> mixed = newTracer(3);
+  const Pt3d drift(0.2, 0.1, 0.0);
+  mixed->AddGridScalarsAtTime(VecPt3d(grid.m_points.size(), drift), loc, activity, loc, 0.0);
+  mixed->AddGridScalarsAtTime(VecPt3d(grid.m_ugrid->GetCellCount(), drift),
+                              DataLocationEnum::LOC_CELLS, activity, loc, 5.0);
+  mixed->AddGridScalarsAtTime(VecPt3d(grid.m_points.size(), drift), loc, activity, loc, 10.0);
+  mixed->TracePoint(Pt3d(2.0, 2.0, 0.0), 0.0, trace, times);
+  TS_ASSERT_EQUALS(GTEXIT_WAITING_FOR_TIME_STEP, mixed->GetExitReason());
+  TS_ASSERT_DELTA(10.0, times.back(), 1e-9);
+  TS_ASSERT_DELTA(4.0, trace.back().x, 1e-4);
+  TS_ASSERT_DELTA(3.0, trace.back().y, 1e-4);
+} // XmGridTraceUnitTests::testWindowTracesThroughInteriorSteps
+//------------------------------------------------------------------------------
+/// \brief Steps taken from the time step cache trace exactly as the steps first added, and
+///        the cache keeps to its budget.
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testTimeStepCacheReplaysSteps()
+{
+  const double length = 20.0;
+  BenchmarkGrid grid = iBuildBenchmarkGrid(20, length);
+  const VecPt3d seeds = iBenchmarkSeeds(200, 0.5, length - 0.5, 0.0, 0.0);
+  const VecDbl seedTimes(seeds.size(), 0.0);
+  const DynBitset activity;
+  const DataLocationEnum loc = DataLocationEnum::LOC_POINTS;
+  const double omegas[] = {0.2, 0.1, 0.0, -0.1}; // vortex rate of each step
+  auto newTracer = [&]() {
+    BSHP<XmGridTrace> tracer = XmGridTrace::New(grid.m_ugrid);
+    tracer->SetMaxTracingTime(30);
+    tracer->SetMinDeltaTime(.01);
+    tracer->SetMaxChangeDistance(0.5);
+    return tracer;
+  };
+  auto addStep = [&](XmGridTrace& a_tracer, int a_step) {
+    a_tracer.AddGridScalarsAtTime(iBenchmarkVectors(grid.m_points, omegas[a_step], 0.2, length),
+                                  loc, activity, loc, a_step * 5.0);
+  };
+  auto traceBatch = [&](XmGridTrace& a_tracer) {
+    a_tracer.StartTraces(seeds, seedTimes);
+    a_tracer.ContinueTraces();
+    BatchResults batch;
+    a_tracer.GetTraceResults(batch.m_traces, batch.m_times, batch.m_reasons);
+    return batch;
+  };
 
-  // The third time step reverses the eastward drift, so the path must turn back on itself --
-  // something no single pair of these time steps can produce.
-  double maxX = traces[0][0].x;
-  for (const auto& pt : traces[0])
-    maxX = std::max(maxX, pt.x);
-  TS_ASSERT(maxX > seeds[0].x);
-  TS_ASSERT(traces[0].back().x < maxX);
-} // XmGridTraceUnitTests::testTracesContinueAcrossTimeSteps
+  BSHP<XmGridTrace> fresh = newTracer();
+  addStep(*fresh, 0);
+  addStep(*fresh, 1);
+  const BatchResults expected = traceBatch(*fresh);
+
+  // Without a budget nothing is kept.
+  BSHP<XmGridTrace> scrubbed = newTracer();
+  TS_ASSERT_EQUALS(size_t(0), scrubbed->GetTimeStepCacheBytes());
+  addStep(*scrubbed, 0);
+  TS_ASSERT(!scrubbed->AddCachedGridScalarsAtTime(0.0));
+
+  // Scrubbing back to the first two steps takes both from the cache, and the first of them
+  // starts the window over.
+  scrubbed->SetWindowTimeSteps(3);
+  scrubbed->SetTimeStepCacheBytes(size_t(1) << 30);
+  scrubbed->SetTimeStepDataset("vortex");
+  TS_ASSERT_EQUALS("vortex", scrubbed->GetTimeStepDataset());
+  for (int step = 0; step < 4; ++step)
+    addStep(*scrubbed, step);
+  scrubbed->ResetStatistics();
+  const bool hit0 = scrubbed->AddCachedGridScalarsAtTime(0.0);
+  const bool hit1 = scrubbed->AddCachedGridScalarsAtTime(5.0);
+  const bool hitMissing = scrubbed->AddCachedGridScalarsAtTime(2.5);
+  TS_ASSERT(hit0 && hit1 && !hitMissing);
+  TS_ASSERT_EQUALS(size_t(2), scrubbed->GetStatistics().m_timeStepCacheHits);
+  TS_ASSERT_EQUALS(size_t(1), scrubbed->GetStatistics().m_timeStepCacheMisses);
+  TS_ASSERT_EQUALS(0, iCountBatchDifferences(expected, traceBatch(*scrubbed)));
+
+  // A change builds on a step from the cache as on the step first added, and steps of
+  // another dataset at the same times are kept apart.
+  const VecPt3d last = iBenchmarkVectors(grid.m_points, omegas[3], 0.2, length);
+  VecInt indices;
+  for (int i = 0; i < (int)last.size(); ++i)
+    indices.push_back(i);
+  addStep(*fresh, 2);
+  fresh->AddGridScalarChangesAtTime(indices, last, {}, 15.0);
+  const bool hit2 = scrubbed->AddCachedGridScalarsAtTime(10.0);
+  TS_ASSERT(hit2);
+  scrubbed->AddGridScalarChangesAtTime(indices, last, {}, 15.0);
+  VecPt3d trace, expectedTrace;
+  VecDbl times, expectedTimes;
+  fresh->TracePoint(Pt3d(10.0, 12.0, 0.0), 10.0, expectedTrace, expectedTimes);
+  scrubbed->TracePoint(Pt3d(10.0, 12.0, 0.0), 10.0, trace, times);
+  TS_ASSERT_DELTA_VECPT3D(expectedTrace, trace, 0.0);
+  TS_ASSERT_DELTA_VEC(expectedTimes, times, 0.0);
+
+  scrubbed->SetTimeStepDataset("drift");
+  const bool hitOther = scrubbed->AddCachedGridScalarsAtTime(0.0);
+  TS_ASSERT(!hitOther);
+  const Pt3d drift(0.2, 0.1, 0.0);
+  scrubbed->AddGridScalarsAtTime(VecPt3d(grid.m_ugrid->GetCellCount(), drift),
+                                 DataLocationEnum::LOC_CELLS, activity, loc, 0.0);
+  scrubbed->AddGridScalarsAtTime(VecPt3d(grid.m_ugrid->GetCellCount(), drift),
+                                 DataLocationEnum::LOC_CELLS, activity, loc, 10.0);
+  scrubbed->SetTimeStepDataset("vortex");
+  const bool hitVortex = scrubbed->AddCachedGridScalarsAtTime(0.0);
+  scrubbed->SetTimeStepDataset("drift");
+  const bool hitDrift = scrubbed->AddCachedGridScalarsAtTime(10.0);
+  TS_ASSERT(hitVortex && hitDrift);
+  addStep(*fresh, 0);
+  fresh->AddGridScalarsAtTime(VecPt3d(grid.m_ugrid->GetCellCount(), drift),
+                              DataLocationEnum::LOC_CELLS, activity, loc, 10.0);
+  fresh->TracePoint(Pt3d(10.0, 12.0, 0.0), 0.0, expectedTrace, expectedTimes);
+  scrubbed->TracePoint(Pt3d(10.0, 12.0, 0.0), 0.0, trace, times);
+  TS_ASSERT_DELTA_VECPT3D(expectedTrace, trace, 0.0);
+  TS_ASSERT_DELTA_VEC(expectedTimes, times, 0.0);
+
+  // A smaller budget drops steps at once, and a step larger than the budget is not kept.
+  scrubbed->SetTimeStepCacheBytes(1);
+  const bool hitDropped = scrubbed->AddCachedGridScalarsAtTime(10.0);
+  scrubbed->AddGridScalarsAtTime(VecPt3d(grid.m_ugrid->GetCellCount(), drift),
+                                 DataLocationEnum::LOC_CELLS, activity, loc, 20.0);
+  const bool hitTooLarge = scrubbed->AddCachedGridScalarsAtTime(20.0);
+  TS_ASSERT(!hitDropped && !hitTooLarge);
+
+  scrubbed->SetTimeStepCacheBytes(size_t(1) << 30);
+  addStep(*scrubbed, 0);
+  scrubbed->ClearTimeStepCache();
+  const bool hitCleared = scrubbed->AddCachedGridScalarsAtTime(0.0);
+  TS_ASSERT(!hitCleared);
+} // XmGridTraceUnitTests::testTimeStepCacheReplaysSteps
+//------------------------------------------------------------------------------
+/// \brief Tracers on one grid build its triangulations and boundary index once between
+///        them, however many there are and whichever threads they are used on.
+//------------------------------------------------------------------------------
+void XmGridTraceUnitTests::testTracersShareGridGeometry()
+{
+  const double length = 20.0;
+  const DynBitset activity;
+  const Pt3d flow(1.0, 0.0, 0.0);
+  const Pt3d seed(18.5, 10.5, 0.0); // leaves the grid through its +x side
+  auto newTracer = [&](const BenchmarkGrid& a_grid, DataLocationEnum a_loc) {
+    BSHP<XmGridTrace> tracer = XmGridTrace::New(a_grid.m_ugrid);
+    tracer->SetMaxTracingTime(-1);
+    tracer->SetMaxChangeDistance(0.5);
+    const size_t count = a_loc == DataLocationEnum::LOC_POINTS
+                           ? a_grid.m_points.size()
+                           : (size_t)a_grid.m_ugrid->GetCellCount();
+    tracer->AddGridScalarsAtTime(VecPt3d(count, flow), a_loc, activity, a_loc, 0.0);
+    tracer->AddGridScalarsAtTime(VecPt3d(count, flow), a_loc, activity, a_loc, 10.0);
+    return tracer;
+  };
+
+  BenchmarkGrid grid = iBuildBenchmarkGrid(20, length);
+  g_boundaryIndexBuilds = 0;
+  BSHP<XmGridTrace> first = newTracer(grid, DataLocationEnum::LOC_POINTS);
+  TS_ASSERT(first->GetStatistics().m_triangulationSeconds > 0);
+  VecPt3d expectedTrace, trace;
+  VecDbl expectedTimes, times;
+  first->TracePoint(seed, 0.0, expectedTrace, expectedTimes);
+  TS_ASSERT_EQUALS(GTEXIT_LEFT_GRID, first->GetExitReason());
+  TS_ASSERT_EQUALS(size_t(1), (size_t)g_boundaryIndexBuilds);
+
+  BSHP<XmGridTrace> second = newTracer(grid, DataLocationEnum::LOC_POINTS);
+  TS_ASSERT_EQUALS(0.0, second->GetStatistics().m_triangulationSeconds);
+  second->TracePoint(seed, 0.0, trace, times);
+  TS_ASSERT_EQUALS(size_t(1), (size_t)g_boundaryIndexBuilds);
+  TS_ASSERT_DELTA_VECPT3D(expectedTrace, trace, 0.0);
+  TS_ASSERT_DELTA_VEC(expectedTimes, times, 0.0);
+
+  // Each data location has its own triangulation, built once too.
+  BSHP<XmGridTrace> cells = newTracer(grid, DataLocationEnum::LOC_CELLS);
+  TS_ASSERT(cells->GetStatistics().m_triangulationSeconds > 0);
+  BSHP<XmGridTrace> moreCells = newTracer(grid, DataLocationEnum::LOC_CELLS);
+  TS_ASSERT_EQUALS(0.0, moreCells->GetStatistics().m_triangulationSeconds);
+
+  // Another grid shares nothing with this one, and once the last tracer on a grid is gone
+  // its next tracer builds afresh.
+  BenchmarkGrid other = iBuildBenchmarkGrid(20, length);
+  BSHP<XmGridTrace> onOther = newTracer(other, DataLocationEnum::LOC_POINTS);
+  TS_ASSERT(onOther->GetStatistics().m_triangulationSeconds > 0);
+  first.reset();
+  second.reset();
+  cells.reset();
+  moreCells.reset();
+  BSHP<XmGridTrace> again = newTracer(grid, DataLocationEnum::LOC_POINTS);
+  TS_ASSERT(again->GetStatistics().m_triangulationSeconds > 0);
+  again->TracePoint(seed, 0.0, trace, times);
+  TS_ASSERT_EQUALS(size_t(2), (size_t)g_boundaryIndexBuilds);
+  TS_ASSERT_DELTA_VECPT3D(expectedTrace, trace, 0.0);
+  again.reset();
+
+  // Tracers made and loaded on several threads at once still build each thing once, and
+  // trace alike.
+  const int threadCount = 4;
+  std::vector<BSHP<XmGridTrace>> tracers(threadCount);
+  std::vector<VecPt3d> traces(threadCount);
+  std::vector<VecDbl> traceTimes(threadCount);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < threadCount; ++i)
+  {
+    threads.emplace_back([&, i]() {
+      tracers[i] = newTracer(grid, DataLocationEnum::LOC_POINTS);
+      tracers[i]->TracePoint(seed, 0.0, traces[i], traceTimes[i]);
+    });
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+  int built = 0;
+  for (int i = 0; i < threadCount; ++i)
+  {
+    if (tracers[i]->GetStatistics().m_triangulationSeconds > 0)
+      ++built;
+    TS_ASSERT_DELTA_VECPT3D(expectedTrace, traces[i], 0.0);
+    TS_ASSERT_DELTA_VEC(expectedTimes, traceTimes[i], 0.0);
+  }
+  TS_ASSERT_EQUALS(1, built);
+  TS_ASSERT_EQUALS(size_t(3), (size_t)g_boundaryIndexBuilds);
+} // XmGridTraceUnitTests::testTracersShareGridGeometry
 //------------------------------------------------------------------------------
-/// \brief Returns a tracer whose spatially uniform field rotates +x -> +y across two steps.
-///
-/// One cell spanning the domain, so the field is uniform in space and every change in a path
-/// comes from time. Steps at t = 0 (east) and t = 10 (north) are loaded; supply a third to
-/// let a trace resume past t = 10.
-/// \param[out] a_activity Single-cell activity, for supplying further time steps
-/// \return the tracer
+/// \brief A grid opened again loads its triangulations from the geometry cache directory
+///        instead of building them, and traces as it did when they were built; a cache
+///        file that is damaged or for another grid is rebuilt.
 //------------------------------------------------------------------------------
-BSHP<XmGridTrace> iCreateRotatingFieldTracer(DynBitset& a_activity)
+void XmGridTraceUnitTests::testGeometryCacheSkipsTriangulation()
 {
-  VecPt3d points = {{0, 0, 0}, {40, 0, 0}, {40, 40, 0}, {0, 40, 0}};
-  VecInt cells = {XMU_QUAD, 4, 0, 1, 2, 3};
-  std::shared_ptr<XmUGrid> ugrid = XmUGrid::New(points, cells);
+  const double length = 20.0;
+  const std::string directory = ".";
+  BenchmarkGrid grid = iBuildBenchmarkGrid(20, length);
+  const VecPt3d pointFlow = iBenchmarkVectors(grid.m_points, 0.3, 0.2, length);
+  VecPt3d cellFlow;
+  VecInt cellPoints;
+  for (int cellIdx = 0; cellIdx < grid.m_ugrid->GetCellCount(); ++cellIdx)
+  {
+    grid.m_ugrid->GetCellPoints(cellIdx, cellPoints);
+    cellFlow.push_back(pointFlow[cellPoints[0]]);
+  }
+  // A few inactive cells, with vectors that would show if cell-located values at points
+  // were averaged over them too.
+  DynBitset cellActivity;
+  cellActivity.resize(cellFlow.size(), true);
+  for (size_t cellIdx = 0; cellIdx < cellFlow.size(); cellIdx += 7)
+  {
+    cellActivity[cellIdx] = false;
+    cellFlow[cellIdx] = Pt3d(-5.0, 5.0, 0.0);
+  }
 
-  a_activity.clear();
-  a_activity.push_back(true);
+  auto newTracer = [&](DataLocationEnum a_loc, bool a_cached) {
+    BSHP<XmGridTrace> tracer = XmGridTrace::New(grid.m_ugrid);
+    tracer->SetMaxTracingTime(-1);
+    tracer->SetMaxChangeDistance(0.5);
+    if (a_cached)
+      tracer->SetGeometryCacheDirectory(directory);
+    const bool pointData = a_loc == DataLocationEnum::LOC_POINTS;
+    const VecPt3d& flow = pointData ? pointFlow : cellFlow;
+    const DynBitset& activity = pointData ? DynBitset() : cellActivity;
+    tracer->AddGridScalarsAtTime(flow, a_loc, activity, a_loc, 0.0);
+    tracer->AddGridScalarsAtTime(flow, a_loc, activity, a_loc, 10.0);
+    return tracer;
+  };
+  const VecPt3d seeds = {{5.5, 5.5, 0.0}, {12.25, 3.5, 0.0}, {15.0, 16.5, 0.0}};
+  auto trace = [&](XmGridTrace& a_tracer, VecPt3d& a_trace) {
+    a_trace.clear();
+    VecPt3d seedTrace;
+    VecDbl times;
+    for (const Pt3d& seed : seeds)
+    {
+      a_tracer.TracePoint(seed, 0.0, seedTrace, times);
+      a_trace.insert(a_trace.end(), seedTrace.begin(), seedTrace.end());
+    }
+  };
 
-  BSHP<XmGridTrace> tracer = XmGridTrace::New(ugrid);
-  tracer->SetVectorMultiplier(1);
-  tracer->SetMaxTracingTime(18);
-  tracer->SetMaxTracingDistance(1000);
-  tracer->SetMinDeltaTime(.01);
-  tracer->SetMaxChangeDistance(.5);
-  tracer->SetMaxChangeVelocity(-1);
-  tracer->SetMaxChangeDirectionInRadians(XM_PI); // never subdivide on direction
-  VecPt3d east = {{1, 0, 0}}, north = {{0, 1, 0}};
-  tracer->AddGridScalarsAtTime(east, DataLocationEnum::LOC_CELLS, a_activity,
-                               DataLocationEnum::LOC_CELLS, 0.0);
-  tracer->AddGridScalarsAtTime(north, DataLocationEnum::LOC_CELLS, a_activity,
-                               DataLocationEnum::LOC_CELLS, 10.0);
-  return tracer;
-} // iCreateRotatingFieldTracer
-//------------------------------------------------------------------------------
-/// \brief A redundant ContinueTraces must not change what the trace does afterwards.
-///
-/// XmGridTrace.h sanctions calling ContinueTraces twice with no time step in between, saying
-/// it does no useful work. It used to do considerably worse than nothing: the first call ends
-/// a window by clamping deltaT to exactly m_time2 - elapsed - ptTime, which for a trace
-/// already sitting on m_time2 is exactly zero, and that zero was carried into the resumed
-/// trace. A zero-length step moves nothing and changes no velocity, so no clamp and no
-/// subdivision test could ever end the loop -- it spun forever, appending nothing, with the
-/// GIL released so Python could not interrupt it.
+  const std::string pointsPath =
+    XmGridTraceSharedGrid::Get(grid.m_ugrid)->GetCachePath(directory, true);
+  const std::string cellsPath =
+    XmGridTraceSharedGrid::Get(grid.m_ugrid)->GetCachePath(directory, false);
+  std::remove(pointsPath.c_str());
+  std::remove(cellsPath.c_str());
+  TS_ASSERT_EQUALS("", XmGridTraceSharedGrid::Get(grid.m_ugrid)->GetCachePath("", true));
+
+  // Built without a cache directory, for the traces to compare with.
+  VecPt3d expectedPoints, expectedCells, traced;
+  g_triangulationBuilds = 0;
+  trace(*newTracer(DataLocationEnum::LOC_POINTS, false), expectedPoints);
+  trace(*newTracer(DataLocationEnum::LOC_CELLS, false), expectedCells);
+  TS_ASSERT_EQUALS(size_t(2), (size_t)g_triangulationBuilds);
+  TS_ASSERT(expectedCells.size() > 10 * seeds.size());
+  TS_ASSERT(!std::ifstream(pointsPath).good());
+
+  // The first run with the directory builds and saves; the next loads.
+  trace(*newTracer(DataLocationEnum::LOC_POINTS, true), traced);
+  TS_ASSERT_EQUALS(size_t(3), (size_t)g_triangulationBuilds);
+  TS_ASSERT(std::ifstream(pointsPath).good());
+  TS_ASSERT_DELTA_VECPT3D(expectedPoints, traced, 0.0);
+  BSHP<XmGridTrace> loaded = newTracer(DataLocationEnum::LOC_POINTS, true);
+  TS_ASSERT_EQUALS(size_t(3), (size_t)g_triangulationBuilds);
+  TS_ASSERT(loaded->GetStatistics().m_triangulationSeconds > 0);
+  trace(*loaded, traced);
+  TS_ASSERT_DELTA_VECPT3D(expectedPoints, traced, 0.0);
+  loaded.reset();
+
+  trace(*newTracer(DataLocationEnum::LOC_CELLS, true), traced);
+  TS_ASSERT_EQUALS(size_t(4), (size_t)g_triangulationBuilds);
+  trace(*newTracer(DataLocationEnum::LOC_CELLS, true), traced);
+  TS_ASSERT_EQUALS(size_t(4), (size_t)g_triangulationBuilds);
+  TS_ASSERT_DELTA_VECPT3D(expectedCells, traced, 0.0);
+
+  // A file for another grid, or of the wrong counts, is refused.
+  const int pointCount = grid.m_ugrid->GetPointCount();
+  const int cellCount = grid.m_ugrid->GetCellCount();
+  TS_ASSERT(!XmGridTraceGeometry::Load(pointsPath, 12345, pointCount, cellCount));
+  {
+    std::ifstream file(pointsPath, std::ios::binary);
+    file.seekg(16);
+    uint64_t hash = 0;
+    file.read(reinterpret_cast<char*>(&hash), sizeof(hash));
+    TS_ASSERT(XmGridTraceGeometry::Load(pointsPath, hash, pointCount, cellCount));
+    TS_ASSERT(!XmGridTraceGeometry::Load(pointsPath, hash, pointCount + 1, cellCount));
+  }
+
+  // A truncated file is rebuilt, and saved over.
+  {
+    std::ifstream in(pointsPath, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    std::ofstream out(pointsPath, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), (std::streamsize)(bytes.size() / 2));
+  }
+  trace(*newTracer(DataLocationEnum::LOC_POINTS, true), traced);
+  TS_ASSERT_EQUALS(size_t(5), (size_t)g_triangulationBuilds);
+  TS_ASSERT_DELTA_VECPT3D(expectedPoints, traced, 0.0);
+  trace(*newTracer(DataLocationEnum::LOC_POINTS, true), traced);
+  TS_ASSERT_EQUALS(size_t(5), (size_t)g_triangulationBuilds);
+  TS_ASSERT_DELTA_VECPT3D(expectedPoints, traced, 0.0);
+
+  std::remove(pointsPath.c_str());
+  std::remove(cellsPath.c_str());
+} // XmGridTraceUnitTests::testGeometryCacheSkipsTriangulation
+//------------------------------------------------------------------------------
+/// \brief The shared grid triangulates as the extractor does and converts to exactly the
+///        values the extractor holds at each triangulation point.
 ///
-/// The assertion is equality with the run that did not make the redundant call. "Does no
-/// useful work" is only true if the outcome is indistinguishable.
+/// The conversion applies the extractor's rules to the geometry rather than asking an
+/// extractor, so that a triangulation loaded from the cache gives the same values as one
+/// built; this is what holds those rules to the extractor's, bit for bit. The grid mixes
+/// quads, triangles and a polygon, and each data location is converted with everything
+/// active, with inactive points, and with inactive cells.
 //------------------------------------------------------------------------------
-void XmGridTraceUnitTests::testRedundantContinueDoesNotStallTrace()
+void XmGridTraceUnitTests::testConvertMatchesExtractor()
 {
-  const VecPt3d seeds = {{20, 10, 0}};
-  const VecDbl seedTimes = {0};
-  VecPt3d west = {{-1, 0, 0}};
+  // clang-format off
+  VecPt3d points = {{0, 0, 0}, {10, 0, 0}, {20, 0, 0}, {30, 0, 0},
+                    {0, 10, 0}, {10, 10, 0}, {20, 10, 0}, {30, 10, 0},
+                    {0, 20, 0}, {10, 20, 0}, {20, 20, 0}, {30, 20, 0},
+                    {15, 25, 0}};
+  VecInt cells = {XMU_QUAD, 4, 0, 1, 5, 4,
+                  XMU_TRIANGLE, 3, 1, 2, 6,
+                  XMU_TRIANGLE, 3, 1, 6, 5,
+                  XMU_QUAD, 4, 2, 3, 7, 6,
+                  XMU_QUAD, 4, 4, 5, 9, 8,
+                  XMU_POLYGON, 5, 5, 6, 10, 12, 9,
+                  XMU_TRIANGLE, 3, 6, 7, 11,
+                  XMU_TRIANGLE, 3, 6, 11, 10};
+  // clang-format on
+  std::shared_ptr<XmUGrid> ugrid = XmUGrid::New(points, cells);
+  std::shared_ptr<XmGridTraceSharedGrid> shared = XmGridTraceSharedGrid::Get(ugrid);
 
-  DynBitset plainActivity;
-  BSHP<XmGridTrace> plain = iCreateRotatingFieldTracer(plainActivity);
-  plain->StartTraces(seeds, seedTimes);
-  TS_ASSERT_EQUALS(1, plain->ContinueTraces());
-  plain->AddGridScalarsAtTime(west, DataLocationEnum::LOC_CELLS, plainActivity,
-                              DataLocationEnum::LOC_CELLS, 20.0);
-  TS_ASSERT_EQUALS(0, plain->ContinueTraces());
-  std::vector<VecPt3d> plainTraces;
-  std::vector<VecDbl> plainTimes;
-  std::vector<XmGridTraceExitEnum> plainReasons;
-  plain->GetTraceResults(plainTraces, plainTimes, plainReasons);
+  DynBitset pointActivity, cellActivity;
+  pointActivity.resize(points.size(), true);
+  pointActivity[6] = false;
+  cellActivity.resize(ugrid->GetCellCount(), true);
+  cellActivity[2] = false;
+  cellActivity[5] = false;
+  const DynBitset allActive;
 
-  DynBitset activity;
-  BSHP<XmGridTrace> tracer = iCreateRotatingFieldTracer(activity);
-  tracer->StartTraces(seeds, seedTimes);
-  TS_ASSERT_EQUALS(1, tracer->ContinueTraces());
-  // The redundant call. Still waiting, because no new data arrived.
-  TS_ASSERT_EQUALS(1, tracer->ContinueTraces());
-  tracer->AddGridScalarsAtTime(west, DataLocationEnum::LOC_CELLS, activity,
-                               DataLocationEnum::LOC_CELLS, 20.0);
-  // Before the fix this call never returned.
-  TS_ASSERT_EQUALS(0, tracer->ContinueTraces());
-  std::vector<VecPt3d> traces;
-  std::vector<VecDbl> times;
-  std::vector<XmGridTraceExitEnum> reasons;
-  tracer->GetTraceResults(traces, times, reasons);
+  for (DataLocationEnum loc : {DataLocationEnum::LOC_POINTS, DataLocationEnum::LOC_CELLS})
+  {
+    const bool pointData = loc == DataLocationEnum::LOC_POINTS;
+    const size_t count = pointData ? points.size() : (size_t)ugrid->GetCellCount();
+    VecFlt x, y;
+    for (size_t i = 0; i < count; ++i)
+    {
+      // Values with no exact float sum, so any difference in how they are averaged shows.
+      x.push_back((float)(1.0 / (i + 3)));
+      y.push_back((float)(-0.7 * i + 0.1));
+    }
+    const std::pair<const DynBitset*, DataLocationEnum> activities[] = {
+      {&allActive, DataLocationEnum::LOC_CELLS},
+      {&pointActivity, DataLocationEnum::LOC_POINTS},
+      {&cellActivity, DataLocationEnum::LOC_CELLS}};
+    for (const auto& activity : activities)
+    {
+      VecFlt vectors;
+      double seconds = 0;
+      std::shared_ptr<const XmGridTraceGeometry> geometry =
+        shared->Convert(loc, x, y, *activity.first, activity.second,
+                        iCellActivity(*ugrid, *activity.first, activity.second), "", vectors,
+                        seconds);
+
+      BSHP<XmUGrid2dDataExtractor> extractor = XmUGrid2dDataExtractor::New(ugrid);
+      VecFlt expectedX, expectedY;
+      for (int component = 0; component < 2; ++component)
+      {
+        const VecFlt& scalars = component == 0 ? x : y;
+        if (pointData)
+          extractor->SetGridPointScalars(scalars, *activity.first, activity.second);
+        else
+          extractor->SetGridCellScalars(scalars, *activity.first, activity.second);
+        (component == 0 ? expectedX : expectedY) = extractor->GetScalars();
+      }
 
-  TS_ASSERT_EQUALS((int)plainReasons[0], (int)reasons[0]);
-  TS_ASSERT_EQUALS(plainTraces[0].size(), traces[0].size());
-  TS_ASSERT_DELTA_VECPT3D(plainTraces[0], traces[0], 1e-12);
-  TS_ASSERT_DELTA_VEC(plainTimes[0], times[0], 1e-12);
-} // XmGridTraceUnitTests::testRedundantContinueDoesNotStallTrace
+      const XmUGridTriangles2d& triangles = *extractor->GetUGridTriangles();
+      TS_ASSERT_EQUALS(triangles.GetPoints().size(), (size_t)geometry->GetPointCount());
+      TS_ASSERT_EQUALS(triangles.GetTriangles().size(), 3 * (size_t)geometry->GetTriangleCount());
+      if (triangles.GetTriangles().size() != 3 * (size_t)geometry->GetTriangleCount())
+        continue;
+      for (int triIdx = 0; triIdx < geometry->GetTriangleCount(); ++triIdx)
+      {
+        for (int corner = 0; corner < 3; ++corner)
+        {
+          TS_ASSERT_EQUALS(triangles.GetTriangles()[3 * triIdx + corner],
+                           geometry->GetTrianglePoints(triIdx)[corner]);
+        }
+      }
+      TS_ASSERT_EQUALS(expectedX.size(), vectors.size() / 2);
+      for (size_t ptIdx = 0; ptIdx < expectedX.size() && 2 * ptIdx < vectors.size(); ++ptIdx)
+      {
+        TS_ASSERT_EQUALS(expectedX[ptIdx], vectors[2 * ptIdx]);
+        TS_ASSERT_EQUALS(expectedY[ptIdx], vectors[2 * ptIdx + 1]);
+      }
+    }
+  }
+} // XmGridTraceUnitTests::testConvertMatchesExtractor
 //------------------------------------------------------------------------------
-/// \brief A seed released after the loaded window waits for its data instead of failing.
+/// \brief Steps walk from the trace's last triangle instead of searching the grid.
 ///
-/// StartTraces takes a release time per seed so a batch can be staggered, which makes a seed
-/// timed past the current window an ordinary input. It used to be reported as
-/// GTEXIT_EXTRACTION_FAILED, which iIsTerminal treats as terminal, so the seed was dead: the
-/// time step covering it could arrive and ContinueTraces would never look at it again. The
-/// mid-trace clamp had always called this same condition WAITING; only the seed path did not.
+/// A trace crossing many cells must search only to locate its seed, must still find the
+/// same path it would by searching, and must keep working across a window change where
+/// the data location, and so the triangulation, changes.
 //------------------------------------------------------------------------------
-void XmGridTraceUnitTests::testSeedReleasedAfterWindowWaitsThenTraces()
+void XmGridTraceUnitTests::testNeighborWalkSkipsSearches()
 {
+  const double length = 20.0;
+  BenchmarkGrid grid = iBuildBenchmarkGrid(20, length);
+  BSHP<XmGridTrace> tracer = XmGridTrace::New(grid.m_ugrid);
+  tracer->SetMaxTracingTime(-1);
+  tracer->SetMaxTracingDistance(-1);
+  tracer->SetMinDeltaTime(.01);
+  tracer->SetMaxChangeDistance(.5);
+  tracer->SetMaxChangeDirectionInRadians(XM_PI);
+
+  // Uniform +x flow: the trace runs straight across 15 cells, and its path is known exactly.
   DynBitset activity;
-  BSHP<XmGridTrace> tracer = iCreateRotatingFieldTracer(activity);
+  VecPt3d pointVectors(grid.m_points.size(), Pt3d(1, 0, 0));
+  tracer->AddGridScalarsAtTime(pointVectors, DataLocationEnum::LOC_POINTS, activity,
+                               DataLocationEnum::LOC_POINTS, 0.0);
+  tracer->AddGridScalarsAtTime(pointVectors, DataLocationEnum::LOC_POINTS, activity,
+                               DataLocationEnum::LOC_POINTS, 15.0);
 
-  // Steps at t = 0 and t = 10 are loaded; this seed is released at 15.
-  const VecPt3d seeds = {{20, 10, 0}};
-  tracer->StartTraces(seeds, {15});
-  TS_ASSERT_EQUALS(1, tracer->ContinueTraces()); // waiting, not failed
+  const VecPt3d seeds = {{2.3, 7.7, 0}};
+  tracer->ResetStatistics();
+  tracer->StartTraces(seeds, {0.0});
+  TS_ASSERT_EQUALS(1, tracer->ContinueTraces());
+  // One search for the seed; every later step, across 15 cells, is a walk.
+  TS_ASSERT_EQUALS(size_t(1), tracer->GetStatistics().m_searches);
+
+  // The next window is cell-located, so it is searched in another triangulation, which the
+  // trace has no triangle in yet: one search there, then walks again. A walk that reaches the
+  // boundary cannot tell a concave edge from the end of the grid, so the step that leaves
+  // the grid is confirmed with a search -- in the first step's triangulation only, since
+  // no data there is no data for the window.
+  VecPt3d cellVectors(grid.m_ugrid->GetCellCount(), Pt3d(1, 0, 0));
+  tracer->AddGridScalarsAtTime(cellVectors, DataLocationEnum::LOC_CELLS, activity,
+                               DataLocationEnum::LOC_CELLS, 25.0);
+  tracer->ResetStatistics();
+  TS_ASSERT_EQUALS(0, tracer->ContinueTraces());
+  TS_ASSERT_EQUALS(size_t(2), tracer->GetStatistics().m_searches);
 
   std::vector<VecPt3d> traces;
   std::vector<VecDbl> times;
   std::vector<XmGridTraceExitEnum> reasons;
   tracer->GetTraceResults(traces, times, reasons);
-  TS_ASSERT_EQUALS((int)GTEXIT_WAITING_FOR_TIME_STEP, (int)reasons[0]);
-  TS_ASSERT(traces[0].empty());
-
-  // Now supply a window that covers t = 15. The seed must start.
-  VecPt3d west = {{-1, 0, 0}};
-  tracer->AddGridScalarsAtTime(west, DataLocationEnum::LOC_CELLS, activity,
-                               DataLocationEnum::LOC_CELLS, 20.0);
-  tracer->ContinueTraces();
-  tracer->GetTraceResults(traces, times, reasons);
-
-  TS_ASSERT(reasons[0] != GTEXIT_EXTRACTION_FAILED);
-  TS_ASSERT(traces[0].size() >= 2);
-  TS_ASSERT_DELTA(15.0, times[0].front(), 1e-9); // started at its own release time
-  TS_ASSERT_DELTA(20.0, traces[0].front().x, 1e-9);
-  TS_ASSERT_DELTA(10.0, traces[0].front().y, 1e-9);
-} // XmGridTraceUnitTests::testSeedReleasedAfterWindowWaitsThenTraces
+  TS_ASSERT_EQUALS((int)GTEXIT_LEFT_GRID, (int)reasons[0]);
+  TS_ASSERT_DELTA(length, traces[0].back().x, 1e-6);
+  TS_ASSERT_DELTA(length - 2.3, times[0].back(), 1e-6);
+  for (const auto& pt : traces[0])
+    TS_ASSERT_DELTA(7.7, pt.y, 1e-9);
+} // XmGridTraceUnitTests::testNeighborWalkSkipsSearches
 //------------------------------------------------------------------------------
-/// \brief Two time steps at different data locations must not share a triangulation.
-///
-/// Sharing does not copy the triangulation, it shares the object, and the second step's
-/// SetGrid*Scalars rebuilds that shared object in place. The shape of the rebuild depends on
-/// the data location -- LOC_CELLS adds a centroid point per cell, LOC_POINTS adds none -- so
-/// sharing across a location change rebuilt the triangulation the first step was still
-/// pointing at, leaving its four-entry scalar array indexed by a centroid index of 4.
+/// \brief The Runge-Kutta integrators follow curved flow more accurately, for fewer field
+///        evaluations, than Euler does.
 ///
-/// Both steps here carry the *same* uniform eastward field, written once as point scalars and
-/// once as cell scalars, so the interpolated field is identical at every time and the path
-/// must be a straight line east. A corrupted first-step lookup cannot produce that.
+/// A steady solid-body vortex is linear in x and y, so the triangulated field reproduces it
+/// exactly and every exact path is a circle about the centre: how far a trace drifts off its
+/// starting radius measures the integrator alone.
 //------------------------------------------------------------------------------
-void XmGridTraceUnitTests::testDataLocationChangeIsNotShared()
+void XmGridTraceUnitTests::testRungeKuttaIntegrators()
 {
-  VecPt3d points = {{0, 0, 0}, {40, 0, 0}, {40, 40, 0}, {0, 40, 0}};
-  VecInt cells = {XMU_QUAD, 4, 0, 1, 2, 3};
-  std::shared_ptr<XmUGrid> ugrid = XmUGrid::New(points, cells);
-
-  // Activity is cell-based and identical across both steps, so the data location is the only
-  // term that differs -- which is exactly the term the sharing test used to ignore.
+  const double length = 40.0;
+  const double omega = 0.1; // one revolution takes 2 pi / omega, about 63
+  BenchmarkGrid grid = iBuildBenchmarkGrid(20, length);
   DynBitset activity;
-  activity.push_back(true);
-
-  BSHP<XmGridTrace> tracer = XmGridTrace::New(ugrid);
-  tracer->SetVectorMultiplier(1);
-  tracer->SetMaxTracingTime(8);
-  tracer->SetMaxTracingDistance(1000);
-  tracer->SetMinDeltaTime(.01);
-  tracer->SetMaxChangeDistance(.5);
-  tracer->SetMaxChangeVelocity(-1);
-  tracer->SetMaxChangeDirectionInRadians(XM_PI);
+  const VecPt3d vectors = iBenchmarkVectors(grid.m_points, omega, 0.0, length);
+  const Pt3d center(length / 2, length / 2, 0);
+  const Pt3d seed(center.x + 10, center.y, 0);
 
-  VecPt3d eastAtPoints = {{1, 0, 0}, {1, 0, 0}, {1, 0, 0}, {1, 0, 0}};
-  VecPt3d eastAtCells = {{1, 0, 0}};
-  tracer->AddGridScalarsAtTime(eastAtPoints, DataLocationEnum::LOC_POINTS, activity,
-                               DataLocationEnum::LOC_CELLS, 0.0);
-  tracer->AddGridScalarsAtTime(eastAtCells, DataLocationEnum::LOC_CELLS, activity,
-                               DataLocationEnum::LOC_CELLS, 10.0);
+  struct Run
+  {
+    VecPt3d m_trace;
+    VecDbl m_times;
+    XmGridTraceExitEnum m_reason;
+    size_t m_evaluations;
+    double m_radiusError;
+  };
+  auto run = [&](XmGridTraceIntegratorEnum a_integrator, double a_tolerance) {
+    BSHP<XmGridTrace> tracer = XmGridTrace::New(grid.m_ugrid);
+    TS_ASSERT_EQUALS((int)GTINT_EULER, (int)tracer->GetIntegrator());
+    tracer->SetIntegrator(a_integrator);
+    TS_ASSERT_EQUALS((int)a_integrator, (int)tracer->GetIntegrator());
+    tracer->SetAbsoluteTolerance(a_tolerance);
+    tracer->SetRelativeTolerance(a_tolerance);
+    TS_ASSERT_EQUALS(a_tolerance, tracer->GetAbsoluteTolerance());
+    TS_ASSERT_EQUALS(a_tolerance, tracer->GetRelativeTolerance());
+    tracer->SetMaxTracingTime(60);
+    tracer->SetMaxTracingDistance(-1);
+    tracer->SetMinDeltaTime(.001);
+    tracer->SetMaxChangeDistance(-1);
+    tracer->SetMaxChangeVelocity(-1);
+    tracer->SetMaxChangeDirectionInRadians(0.05);
+    tracer->AddGridScalarsAtTime(vectors, DataLocationEnum::LOC_POINTS, activity,
+                                 DataLocationEnum::LOC_POINTS, 0.0);
+    tracer->AddGridScalarsAtTime(vectors, DataLocationEnum::LOC_POINTS, activity,
+                                 DataLocationEnum::LOC_POINTS, 100.0);
+    Run result;
+    tracer->ResetStatistics();
+    tracer->TracePoint(seed, 0.0, result.m_trace, result.m_times);
+    result.m_evaluations = tracer->GetStatistics().m_evaluations;
+    result.m_reason = tracer->GetExitReason();
+    result.m_radiusError = 0;
+    for (const auto& pt : result.m_trace)
+    {
+      const double radius = Mdist(pt.x, pt.y, center.x, center.y);
+      result.m_radiusError = std::max(result.m_radiusError, fabs(radius - 10.0));
+    }
+    return result;
+  };
 
-  VecPt3d outTrace;
-  VecDbl outTimes;
-  tracer->TracePoint({5, 20, 0}, 0, outTrace, outTimes);
+  const Run euler = run(GTINT_EULER, 1e-5);
+  const Run rk4 = run(GTINT_RK4, 1e-5);
+  const Run dp = run(GTINT_DORMAND_PRINCE, 1e-5);
+  const Run dpTight = run(GTINT_DORMAND_PRINCE, 1e-8);
 
-  TS_ASSERT(outTrace.size() >= 2);
-  for (size_t i = 0; i < outTrace.size(); ++i)
+  // The time budget ends every trace the same way, exactly on time, whatever the scheme.
+  for (const Run* r : {&euler, &rk4, &dp, &dpTight})
   {
-    TS_ASSERT_DELTA(20.0, outTrace[i].y, 1e-9); // pure +x field: y never moves
-    if (i > 0)
-      TS_ASSERT(outTrace[i].x > outTrace[i - 1].x);
+    TS_ASSERT_EQUALS((int)GTEXIT_MAX_TRACING_TIME, (int)r->m_reason);
+    TS_ASSERT_DELTA(60.0, r->m_times.back(), 1e-9);
+    TS_ASSERT_EQUALS(r->m_trace.size(), r->m_times.size());
   }
-  // 8 time units at unit speed from x = 5.
-  TS_ASSERT_DELTA(13.0, outTrace.back().x, 1e-6);
-} // XmGridTraceUnitTests::testDataLocationChangeIsNotShared
-//------------------------------------------------------------------------------
-/// \brief Verifies the boundary-exit extractor is built once per tracer, not once per exit.
-///
-/// The extractor's constructor triangulates the whole grid and its first SetPolyline indexes
-/// every triangle into a GmMultiPolyIntersector -- both grid-only work, and both measured at
-/// ~40 ms per exit event when rebuilt inside the stepping loop. Caching it changes no output,
-/// so the construction count is what has to be asserted; the trace comparison is here to
-/// catch the reuse silently changing an answer.
-//------------------------------------------------------------------------------
-void XmGridTraceUnitTests::testBoundaryExtractorIsCached()
-{
-  BSHP<XmGridTrace> tracer;
-  iCreateDefaultSingleCell(tracer);
 
-  // The default single cell has a uniform (1, 1) field, so a trace from the middle leaves the
-  // grid on its first step.
-  const Pt3d startPoint = {.5, .5, 0};
-  const double startTime = .5;
-  const std::string outOfDomain = "Point has traveled out of domain.";
-
-  g_boundaryExtractorBuilds = 0;
-
-  VecPt3d firstTrace;
-  VecDbl firstTimes;
-  tracer->TracePoint(startPoint, startTime, firstTrace, firstTimes);
-  TS_ASSERT_EQUALS(outOfDomain, tracer->GetExitMessage());
-  TS_ASSERT_EQUALS(size_t(1), g_boundaryExtractorBuilds);
-  TS_ASSERT(firstTrace.size() >= 2);
-
-  VecPt3d secondTrace;
-  VecDbl secondTimes;
-  tracer->TracePoint(startPoint, startTime, secondTrace, secondTimes);
-  TS_ASSERT_EQUALS(outOfDomain, tracer->GetExitMessage());
-  TS_ASSERT_EQUALS(size_t(1), g_boundaryExtractorBuilds);
+  // Euler spirals outward, by over a tenth of the radius in one revolution even with its
+  // direction test at 0.05 radians. The Runge-Kutta schemes hold the circle thousands of
+  // times more closely, and Dormand-Prince does it on fewer evaluations than Euler used.
+  TS_ASSERT(euler.m_radiusError > 0.1);
+  TS_ASSERT(rk4.m_radiusError < euler.m_radiusError / 1000);
+  TS_ASSERT(dp.m_radiusError < euler.m_radiusError / 1000);
+  TS_ASSERT(dp.m_evaluations < euler.m_evaluations);
 
-  TS_ASSERT_DELTA_VECPT3D(firstTrace, secondTrace, 1e-12);
-  TS_ASSERT_DELTA_VEC(firstTimes, secondTimes, 1e-12);
-} // XmGridTraceUnitTests::testBoundaryExtractorIsCached
+  // Tightening the tolerance buys accuracy with evaluations.
+  TS_ASSERT(dpTight.m_radiusError < dp.m_radiusError);
+  TS_ASSERT(dpTight.m_evaluations > dp.m_evaluations);
+} // XmGridTraceUnitTests::testRungeKuttaIntegrators
 //------------------------------------------------------------------------------
 /// \brief Measures the cost of tracing many seed points over a realistic grid.
 ///
@@ -2554,15 +7555,21 @@ void XmGridTraceUnitTests::testBoundaryExtractorIsCached()
 /// measured separately because they exercise different code:
 ///
 ///   interior  seeds far enough from the edge that no trace can reach it -- the pure
-///             stepping cost, one point-location search per triangulation per step
+///             stepping cost; each step walks from the trace's last triangle, so the
+///             searches counted are only the one locating each seed
 ///   boundary  seeds in a band along the edge, so traces run out of the domain and pay for
-///             the XmUGrid2dPolylineDataExtractor path -- a whole-grid triangulation plus a
-///             GmMultiPolyIntersector, once per tracer since that extractor is cached
-///             (it was once per exit event, inside the stepping loop)
+///             finding the exit point -- a lookup in the boundary edge index, which is
+///             built once per tracer on the first exit
 ///   mixed     seeds spread over the whole domain -- what the display actually does
 ///
-/// Reported alongside wall time is the point-location search count, so a later optimization
-/// can be shown to have removed searches rather than merely found a faster machine.
+/// Reported alongside wall time is the count of whole-grid point-location searches -- the
+/// ones a triangle walk could not replace -- so a later optimization can be shown to have
+/// removed searches rather than merely found a faster machine.
+///
+/// The mixed set is then run once more through StartTraces/ContinueTraces at doubling thread
+/// counts, up to XMGT_BENCH_THREADS (default: the hardware's, and at least 4), then on one
+/// thread at packet widths of 2, 4 and 8, and then in Hilbert order, checking each against
+/// the single-threaded batch bit for bit and reporting the speedup.
 ///
 /// Seed count and grid size come from XMGT_BENCH_SEEDS and XMGT_BENCH_CELLS so a sweep
 /// needs no recompile; the defaults are small enough to leave in the regular suite. The
@@ -2657,6 +7664,94 @@ void XmGridTraceUnitTests::testTraceBenchmark()
   iRunTraceBenchmark(tracer, mixedSeeds, mixed);
   iReportTraceBenchmark("mixed", mixed);
 
+  // The same set under each higher-order integrator, at the tracer's default tolerances.
+  BenchmarkStats mixedRk4, mixedDp;
+  tracer->SetIntegrator(GTINT_RK4);
+  iRunTraceBenchmark(tracer, mixedSeeds, mixedRk4);
+  iReportTraceBenchmark("mixed, RK4", mixedRk4);
+  tracer->SetIntegrator(GTINT_DORMAND_PRINCE);
+  iRunTraceBenchmark(tracer, mixedSeeds, mixedDp);
+  iReportTraceBenchmark("mixed, Dormand-Prince", mixedDp);
+  tracer->SetIntegrator(GTINT_EULER);
+  TS_ASSERT(mixedDp.m_traced >= seedCount - 1 - seedCount / 1000);
+
+  const int maxThreads =
+    iEnvInt("XMGT_BENCH_THREADS", std::max(4, (int)std::thread::hardware_concurrency()));
+  const VecDbl mixedTimes(mixedSeeds.size(), 0.0);
+  BatchResults serialBatch;
+  double serialSeconds = 0;
+  std::cout << "\n  [mixed, ContinueTraces] hardware threads="
+            << std::thread::hardware_concurrency() << "\n";
+  for (int threads = 1; threads <= maxThreads; threads *= 2)
+  {
+    tracer->SetThreadCount(threads);
+    tracer->StartTraces(mixedSeeds, mixedTimes);
+    const auto batchStart = std::chrono::steady_clock::now();
+    tracer->ContinueTraces();
+    const auto batchEnd = std::chrono::steady_clock::now();
+    const double seconds = std::chrono::duration<double>(batchEnd - batchStart).count();
+    BatchResults batch;
+    tracer->GetTraceResults(batch.m_traces, batch.m_times, batch.m_reasons);
+    if (threads == 1)
+    {
+      serialBatch = batch;
+      serialSeconds = seconds;
+    }
+    const int differences = iCountBatchDifferences(serialBatch, batch);
+    std::cout << std::fixed << std::setprecision(3) << "    threads " << std::setw(3) << threads
+              << "  " << seconds * 1e3 << " ms  speedup "
+              << (seconds > 0 ? serialSeconds / seconds : 0.0) << "x  differing traces "
+              << differences << "\n";
+    // Threads may only change how long the batch takes, never what it produces.
+    TS_ASSERT_EQUALS(0, differences);
+  }
+  tracer->SetThreadCount(1);
+
+  std::cout << "\n  [mixed, ContinueTraces] one thread\n";
+  for (int width = 2; width <= 8; width *= 2)
+  {
+    tracer->SetPacketWidth(width);
+    tracer->StartTraces(mixedSeeds, mixedTimes);
+    const auto batchStart = std::chrono::steady_clock::now();
+    tracer->ContinueTraces();
+    const auto batchEnd = std::chrono::steady_clock::now();
+    const double seconds = std::chrono::duration<double>(batchEnd - batchStart).count();
+    BatchResults batch;
+    tracer->GetTraceResults(batch.m_traces, batch.m_times, batch.m_reasons);
+    const int differences = iCountBatchDifferences(serialBatch, batch);
+    std::cout << std::fixed << std::setprecision(3) << "    packet  " << std::setw(3) << width
+              << "  " << seconds * 1e3 << " ms  speedup "
+              << (seconds > 0 ? serialSeconds / seconds : 0.0) << "x  differing traces "
+              << differences << "\n";
+    // Nor may packets.
+    TS_ASSERT_EQUALS(0, differences);
+  }
+  tracer->SetPacketWidth(1);
+
+  // Hilbert ordering matters most where seeds are scattered over a grid too large for cache.
+  tracer->SetSpatialOrdering(true);
+  for (int width : {1, 8})
+  {
+    tracer->SetPacketWidth(width);
+    tracer->StartTraces(mixedSeeds, mixedTimes);
+    const auto batchStart = std::chrono::steady_clock::now();
+    tracer->ContinueTraces();
+    const auto batchEnd = std::chrono::steady_clock::now();
+    const double seconds = std::chrono::duration<double>(batchEnd - batchStart).count();
+    BatchResults batch;
+    tracer->GetTraceResults(batch.m_traces, batch.m_times, batch.m_reasons);
+    const int differences = iCountBatchDifferences(serialBatch, batch);
+    std::cout << std::fixed << std::setprecision(3) << "    hilbert, packet " << width << "  "
+              << seconds * 1e3 << " ms  speedup "
+              << (seconds > 0 ? serialSeconds / seconds : 0.0) << "x  differing traces "
+              << differences << "\n";
+    // Nor may the order traces are stepped in.
+    TS_ASSERT_EQUALS(0, differences);
+  }
+  std::cout << std::flush;
+  tracer->SetSpatialOrdering(false);
+  tracer->SetPacketWidth(1);
+
   // Interior seeds cannot reach a boundary, so every one of them must trace.
   TS_ASSERT_EQUALS(interior.m_traced, seedCount);
   // Seeds that can leave the grid are not guaranteed a usable polyline: a seed that exits
@@ -2665,10 +7760,12 @@ void XmGridTraceUnitTests::testTraceBenchmark()
   // 100,000, so allow a small tail rather than asserting a false invariant -- but keep the
   // bound tight enough that a real breakage in tracing still fails here.
   TS_ASSERT(mixed.m_traced >= seedCount - 1 - seedCount / 1000);
-  // The instrumentation itself has to be working, or the search counts mean nothing.
-  TS_ASSERT(interior.m_searchCalls > (size_t)seedCount);
+  // The instrumentation itself has to be working, or the search counts mean nothing: every
+  // seed needs one search to be located. Past that, interior steps are walks, not searches.
+  TS_ASSERT(interior.m_searchCalls >= (size_t)seedCount);
+  TS_ASSERT(interior.m_searchCalls < (size_t)seedCount * 2);
   // The boundary set must actually leave the grid, otherwise this benchmark silently
-  // stops measuring the per-exit extractor construction it exists to measure.
+  // stops measuring the exit-point lookup it exists to measure.
   const std::string outOfDomain = "Point has traveled out of domain.";
   TS_ASSERT(boundary.m_exitReasons.count(outOfDomain) > 0);
   TS_ASSERT_EQUALS(interior.m_exitReasons.count(outOfDomain), 0);
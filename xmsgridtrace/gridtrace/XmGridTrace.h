@@ -42,7 +42,8 @@ class dyn_bitset;
 /// composed by appending, so no fixed string identified a case.
 enum XmGridTraceExitEnum {
   GTEXIT_NOT_STARTED,           ///< no stepping has happened yet
-  GTEXIT_WAITING_FOR_TIME_STEP, ///< reached the 2nd loaded step; supply a later one to resume
+  /// reached the newest loaded time step in the window; supply a later one to resume
+  GTEXIT_WAITING_FOR_TIME_STEP,
   GTEXIT_MAX_TRACING_TIME,      ///< the trace spent its time budget
   GTEXIT_MAX_TRACING_DISTANCE,  ///< the trace spent its distance budget
   GTEXIT_LEFT_GRID,             ///< stepped out of the grid; the path stops at the boundary
@@ -52,13 +53,104 @@ enum XmGridTraceExitEnum {
   GTEXIT_EXTRACTION_FAILED      ///< a field lookup failed; the trace is discarded
 };
 
+/// \brief How a trace is advanced from one point to the next.
+///
+/// Forward Euler is the default and the behaviour traces have always had. The Runge-Kutta
+/// schemes evaluate the field more times per step but take far longer steps for the same
+/// accuracy, which in curved flow is a net saving. Whatever the scheme, the time and
+/// distance budgets, the time step window and the exit reasons behave the same.
+enum XmGridTraceIntegratorEnum {
+  /// forward Euler; halves the step on a large change in velocity or direction
+  GTINT_EULER,
+  GTINT_RK4, ///< classical 4th-order Runge-Kutta with the same step control as Euler
+  /// Dormand-Prince 4(5); step size from its error estimate and the tolerances
+  GTINT_DORMAND_PRINCE
+};
+
 //----- Structs / Classes ------------------------------------------------------
 
+////////////////////////////////////////////////////////////////////////////////
+/// \brief What a tracer has done since its statistics were last reset.
+///
+/// Always collected, so a slow refresh can be explained in a release build. Each tracing
+/// thread counts into its own copy and the copies are added up when ContinueTraces returns,
+/// so counting costs an increment of a local and never an atomic or a lock.
+struct XmGridTraceStatistics
+{
+  /// Number of exit reasons, and the size of m_exitReasons.
+  static const int EXIT_REASON_COUNT = GTEXIT_EXTRACTION_FAILED + 1;
+
+  void Add(const XmGridTraceStatistics& a_other);
+
+  size_t m_acceptedSteps = 0; ///< steps that advanced a trace
+  /// Steps thrown away and retried smaller; the sum of the three counts below.
+  size_t m_rejectedSteps = 0;
+  size_t m_velocitySplits = 0;  ///< steps halved for changing speed too much
+  size_t m_directionSplits = 0; ///< steps halved for turning too far
+  size_t m_errorRejections = 0; ///< Dormand-Prince steps shrunk for their error estimate
+  size_t m_evaluations = 0;     ///< points the field was evaluated at
+  /// Whole-grid point-location searches: the ones a walk from the trace's last triangle
+  /// could not replace, which is mostly one per seed.
+  size_t m_searches = 0;
+  size_t m_boundaryExits = 0; ///< steps that left the grid or an active cell and were cut back
+  /// Traces stopped, by exit reason. A trace waiting at the end of a window counts under
+  /// GTEXIT_WAITING_FOR_TIME_STEP each time it waits.
+  size_t m_exitReasons[EXIT_REASON_COUNT] = {};
+  /// AddCachedGridScalarsAtTime calls that found their step in the time step cache, and so
+  /// added it without converting or fitting anything.
+  size_t m_timeStepCacheHits = 0;
+  size_t m_timeStepCacheMisses = 0; ///< AddCachedGridScalarsAtTime calls that did not
+  /// Wall time in AddGridScalarsAtTime, including its triangulation, or preparing a step
+  /// on the background thread of AddGridScalarsAtTimeAsync.
+  double m_addScalarsSeconds = 0;
+  /// Wall time building the triangulation and search index for a data location, or loading
+  /// them from the geometry cache directory, which happens on the first time step at each
+  /// location that any tracer on the grid adds.
+  double m_triangulationSeconds = 0;
+  double m_steppingSeconds = 0;   ///< wall time advancing traces
+  /// Wall time spent waiting for a time step added with AddGridScalarsAtTimeAsync to finish
+  /// preparing, mostly by ContinueTraces after tracing. Near zero when loading keeps up.
+  double m_timeStepWaitSeconds = 0;
+  double m_resultCopySeconds = 0; ///< wall time copying traces out to the caller
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Receives the vertices of a batch as they are traced, instead of the tracer
+///        keeping them; see XmGridTrace::SetTraceSink.
+///
+/// A trace's vertices arrive in runs, in order, and are followed by exactly one OnTraceEnd
+/// once it stops for good. Runs of different traces interleave. Calls are never made
+/// concurrently, whatever the thread count, but they may come from any of the threads of
+/// ContinueTraces, and the tracer is stepping while they run: a sink must not call back
+/// into the tracer.
+class XmGridTraceSink
+{
+public:
+  virtual ~XmGridTraceSink();
+
+  /// \brief Receives the next vertices of a trace.
+  /// \param[in] a_trace The trace, by its seed's index
+  /// \param[in] a_xyt The vertices, three doubles each: x, y and time. Valid only for the
+  ///            duration of the call.
+  /// \param[in] a_count Number of vertices
+  virtual void OnVertices(size_t a_trace, const double* a_xyt, int a_count) = 0;
+  /// \brief Receives the end of a trace. A trace ending with GTEXIT_EXTRACTION_FAILED is
+  ///        one the tracer discards, so the sink should drop what it was sent of it.
+  /// \param[in] a_trace The trace, by its seed's index
+  /// \param[in] a_reason Why it stopped
+  virtual void OnTraceEnd(size_t a_trace, XmGridTraceExitEnum a_reason) = 0;
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 class XmGridTrace
 {
 public:
   /// \brief Construct XmGridTrace for a UGrid.
+  ///
+  /// Every tracer on the same XmUGrid instance shares one triangulation and search index per
+  /// data location and one boundary index, built by whichever tracer needs each first and
+  /// freed with the last tracer on the grid. The grid must not change while any tracer on
+  /// it is alive.
   /// \param[in] a_ugrid a ugrid
   static BSHP<XmGridTrace> New(std::shared_ptr<XmUGrid> a_ugrid);
 
@@ -114,9 +206,179 @@ public:
   /// \param[in] a_maxChangeDirection the new max change in direction in radians
   virtual void SetMaxChangeDirectionInRadians(const double a_maxChangeDirection) = 0;
 
+  /// \brief Returns the integration scheme
+  /// \return the integration scheme
+  virtual XmGridTraceIntegratorEnum GetIntegrator() const = 0;
+  /// \brief Sets the integration scheme. GTINT_DORMAND_PRINCE sizes its steps from the
+  ///        absolute and relative tolerances, and ignores the max change in velocity and
+  ///        direction; the max change distance still caps every step.
+  /// \param[in] a_integrator the integration scheme
+  virtual void SetIntegrator(XmGridTraceIntegratorEnum a_integrator) = 0;
+
+  /// \brief Returns the absolute tolerance on the position error of a step
+  /// \return the absolute tolerance, in grid units
+  virtual double GetAbsoluteTolerance() const = 0;
+  /// \brief Sets the absolute tolerance on the position error of a step. Used only by
+  ///        GTINT_DORMAND_PRINCE.
+  /// \param[in] a_tolerance the absolute tolerance, in grid units
+  virtual void SetAbsoluteTolerance(double a_tolerance) = 0;
+
+  /// \brief Returns the relative tolerance on the position error of a step
+  /// \return the relative tolerance, as a fraction of the step's length
+  virtual double GetRelativeTolerance() const = 0;
+  /// \brief Sets the relative tolerance on the position error of a step, as a fraction of the
+  ///        distance the step covers. Used only by GTINT_DORMAND_PRINCE. Relative to the step
+  ///        rather than to the coordinates, so a grid far from the origin is not traced more
+  ///        coarsely than the same grid near it.
+  /// \param[in] a_tolerance the relative tolerance
+  virtual void SetRelativeTolerance(double a_tolerance) = 0;
+
+  /// \brief Returns the number of threads ContinueTraces spreads a batch across
+  /// \return the thread count as set; zero or less means one per hardware thread
+  virtual int GetThreadCount() const = 0;
+  /// \brief Sets the number of threads ContinueTraces spreads a batch across. Results are
+  ///        identical for every thread count; only the wall time changes.
+  /// \param[in] a_threadCount the thread count; 1, the default, traces on the calling thread,
+  ///            and zero or less uses one per hardware thread
+  virtual void SetThreadCount(int a_threadCount) = 0;
+
+  /// \brief Returns how many traces ContinueTraces advances in lockstep on each thread
+  /// \return the packet width as set
+  virtual int GetPacketWidth() const = 0;
+  /// \brief Sets how many traces ContinueTraces advances in lockstep on each thread. The
+  ///        traces of a packet share each step's point location and field evaluation,
+  ///        which pays most when many seeds sit in the same region. Results are identical
+  ///        for every width; only the wall time changes.
+  /// \param[in] a_packetWidth the packet width; 1, the default, steps one trace at a time,
+  ///            and widths are used clamped to 1..8
+  virtual void SetPacketWidth(int a_packetWidth) = 0;
+
+  /// \brief Returns whether ContinueTraces steps traces in order of where they are
+  /// \return true if traces are stepped in Hilbert order of their positions
+  virtual bool GetSpatialOrdering() const = 0;
+  /// \brief Sets whether ContinueTraces steps traces in order of where they are rather than
+  ///        in seed order. The unfinished traces are sorted along a Hilbert curve at the
+  ///        start of every ContinueTraces, so traces stepped one after another search the
+  ///        same part of the grid; this pays on large grids with scattered seeds. Results
+  ///        are identical either way, and are always returned in seed order.
+  /// \param[in] a_spatialOrdering true to step traces in Hilbert order; false, the default,
+  ///            steps them in seed order
+  virtual void SetSpatialOrdering(bool a_spatialOrdering) = 0;
+
+  /// \brief Returns how many time steps the window keeps
+  /// \return the time step count
+  virtual int GetWindowTimeSteps() const = 0;
+  /// \brief Sets how many time steps the window keeps, so a series can be loaded several
+  ///        steps ahead of the traces.
+  ///
+  /// Traces run from one loaded step into the next without stopping, each evaluation
+  /// blending the two steps either side of its time, and wait only at the newest. With
+  /// output intervals short next to how long particles travel, loading N steps before each
+  /// ContinueTraces then takes one call, with one step cut short at the end of the window,
+  /// where two steps would take N - 1. Adding a step to a full window drops the oldest.
+  /// Results are identical for every count as long as each ContinueTraces is given the same
+  /// newest step; only how far a call can trace changes.
+  /// \param[in] a_timeSteps the time step count; 2, the default, keeps the newest step and
+  ///            the one before it, and counts are used clamped to at least 2. A smaller count
+  ///            drops the oldest steps at once.
+  virtual void SetWindowTimeSteps(int a_timeSteps) = 0;
+
+  /// \brief Returns whether traces follow the field frozen at one time, and which
+  /// \param[out] a_time The time the field is frozen at, if it is
+  /// \return true if traces follow a frozen field; see SetSnapshotTime
+  virtual bool GetSnapshotTime(double& a_time) const = 0;
+  /// \brief Traces against the loaded window's field frozen at one time: streamlines of
+  ///        that instant rather than the paths particles take through the window.
+  ///
+  /// The loaded time steps either side of a_time are blended into one field once, before
+  /// the next trace, and every step of every trace then evaluates that field alone: one
+  /// search and one triangle's coefficients per evaluation rather than a search and
+  /// coefficients per time step, and no blend in time. That is most of the work of a step.
+  /// The field is blended again whenever a time step is added.
+  ///
+  /// Traces ignore the window's time bounds: they are not stopped at the newest time step
+  /// and never wait for another, and their release times only set the times their vertices
+  /// are stamped with. They still stop on their time and distance budgets; with neither set,
+  /// they are stopped after the window's length of time, as a streamline round a closed
+  /// eddy would otherwise never end. A cell is active where it is active in both blended
+  /// steps.
+  /// \param[in] a_time The time to freeze the field at; clamped to the loaded window
+  virtual void SetSnapshotTime(double a_time) = 0;
+  /// \brief Goes back to tracing through the window as the field changes, as by default.
+  virtual void ClearSnapshotTime() = 0;
+
+  /// \brief Returns how far a simplified trace may stray from the path traced
+  /// \return the tolerance, in grid units; zero or less means traces are not simplified
+  virtual double GetSimplificationTolerance() const = 0;
+  /// \brief Sets how far a trace's polyline may stray from the path traced, so that a
+  ///        vertex is kept only where leaving it out would stray further.
+  ///
+  /// Traces are simplified as they are traced, before any vertex is stored or handed to a
+  /// sink: a vertex is held back until the next step shows whether the straight line on
+  /// from the last kept vertex still passes within the tolerance of every step since. Slow,
+  /// straight flow then keeps a handful of vertices where it used to keep hundreds. Each
+  /// kept vertex keeps its own time, and stepping is unchanged, so exit reasons, exit edges
+  /// and every trace's first and last vertex are exactly as without simplifying. A trace
+  /// waiting for a time step keeps where it waits, too.
+  /// \param[in] a_tolerance the tolerance, in grid units; zero or less, the default, keeps
+  ///            every step
+  virtual void SetSimplificationTolerance(double a_tolerance) = 0;
+
+  /// \brief Returns the sink batches stream their vertices to
+  /// \return the sink, or null if the tracer keeps the vertices
+  virtual BSHP<XmGridTraceSink> GetTraceSink() const = 0;
+  /// \brief Sets a sink that a batch's vertices are handed to as they are traced.
+  ///
+  /// With a sink, a batch keeps no vertices: only each trace's current state, and a few
+  /// dozen vertices per tracing thread waiting to be handed over. A batch of any length
+  /// then runs in constant memory, with the caller writing the vertices wherever they are
+  /// going. GetTraceResults and its kin still report exit reasons and exit edges, but every
+  /// trace's vertices are empty. TracePoint and TracePoints return their vertices as before.
+  /// \param[in] a_sink The sink, or null to keep vertices again. Takes effect at the next
+  ///            StartTraces, so a batch in flight keeps the sink it started with.
+  virtual void SetTraceSink(BSHP<XmGridTraceSink> a_sink) = 0;
+
+  /// \brief Returns how much memory the time step cache may hold
+  /// \return the budget, in bytes; 0 means steps are not cached
+  virtual size_t GetTimeStepCacheBytes() const = 0;
+  /// \brief Sets how much memory the time step cache may hold, so a step added again can be
+  ///        taken from it by AddCachedGridScalarsAtTime instead of converted and fitted.
+  ///
+  /// With a budget, every step added is kept, converted and fitted, under the time step
+  /// dataset and its time, replacing any step already kept under both. When the steps kept
+  /// would take more than the budget, the ones least recently added or taken are dropped;
+  /// a step that alone takes more is not kept. A step takes about 100 bytes per triangle of
+  /// the grid's triangulation.
+  /// \param[in] a_bytes the budget; 0, the default, keeps no steps and drops any kept. A
+  ///            smaller budget drops the least recently used steps at once.
+  virtual void SetTimeStepCacheBytes(size_t a_bytes) = 0;
+  /// \brief Returns the name of the dataset the steps added are cached under
+  /// \return the name; empty by default
+  virtual const std::string& GetTimeStepDataset() const = 0;
+  /// \brief Names the dataset the steps added from now on belong to, so that steps of
+  ///        different datasets at the same time are cached apart.
+  /// \param[in] a_dataset The name; any string that tells the caller's datasets apart
+  virtual void SetTimeStepDataset(const std::string& a_dataset) = 0;
+
+  /// \brief Returns the directory triangulations of the grid are saved to between runs
+  /// \return the directory; empty, the default, when they are not saved
+  virtual const std::string& GetGeometryCacheDirectory() const = 0;
+  /// \brief Sets a directory to save the grid's triangulations to, so the next run that
+  ///        opens the same grid loads them instead of triangulating again.
+  ///
+  /// Each data location's triangulation, with its search index, is saved to its own file,
+  /// named for a hash of the grid's points and cells, the first time a step there is added
+  /// to any tracer on the grid; a file that is missing, of another version, or not for this
+  /// grid is rebuilt and saved over. Traces are the same, to the bit, whether a
+  /// triangulation was loaded or built. A triangulation another tracer on the grid already
+  /// holds is used as it is.
+  /// \param[in] a_directory An existing, writable directory; empty saves nothing
+  virtual void SetGeometryCacheDirectory(const std::string& a_directory) = 0;
+
   /// \brief Assigns velocity vectors to each point or cell for a time step,
-  ///        keeping the previous step, and dropping the one before that
-  ///        for a maximum of two time steps.
+  ///        keeping the previous steps, and dropping the oldest once the window
+  ///        holds GetWindowTimeSteps of them. Steps are added in order of time; a step
+  ///        at or before the newest starts the window over.
   /// \param[in] a_scalars The velocity vectors
   /// \param[in] a_scalarLoc Whether the vectors are assigned to cells or points
   /// \param[in] a_activity Whether each cell or point is active
@@ -128,6 +390,130 @@ public:
                                     DataLocationEnum a_activityLoc,
                                     double a_time) = 0;
 
+  /// \brief Assigns velocity vectors for a time step as the overload taking points does,
+  ///        reading them from the caller's arrays where they lie.
+  ///
+  /// The components are read once, into the floats the extractor takes, so arrays held in
+  /// another layout, such as rows of (x, y, z) or separate x and y columns, need no copy
+  /// into points first.
+  /// \param[in] a_vx The first vector's x
+  /// \param[in] a_vy The first vector's y
+  /// \param[in] a_count Number of vectors
+  /// \param[in] a_stride Values from one vector's x, or y, to the next's: 1 for separate
+  ///            columns, 2 or 3 for rows
+  /// \param[in] a_scalarLoc Whether the vectors are assigned to cells or points
+  /// \param[in] a_activity Whether each cell or point is active
+  /// \param[in] a_activityLoc Whether the activities are assigned to cells or points
+  /// \param[in] a_time The time of the scalars
+  virtual void AddGridScalarsAtTime(const double* a_vx,
+                                    const double* a_vy,
+                                    int a_count,
+                                    int a_stride,
+                                    DataLocationEnum a_scalarLoc,
+                                    const xms::DynBitset& a_activity,
+                                    DataLocationEnum a_activityLoc,
+                                    double a_time) = 0;
+
+  /// \brief Assigns velocity vectors for a time step from arrays of floats; see the
+  ///        overload taking doubles.
+  /// \param[in] a_vx The first vector's x
+  /// \param[in] a_vy The first vector's y
+  /// \param[in] a_count Number of vectors
+  /// \param[in] a_stride Values from one vector's x, or y, to the next's
+  /// \param[in] a_scalarLoc Whether the vectors are assigned to cells or points
+  /// \param[in] a_activity Whether each cell or point is active
+  /// \param[in] a_activityLoc Whether the activities are assigned to cells or points
+  /// \param[in] a_time The time of the scalars
+  virtual void AddGridScalarsAtTime(const float* a_vx,
+                                    const float* a_vy,
+                                    int a_count,
+                                    int a_stride,
+                                    DataLocationEnum a_scalarLoc,
+                                    const xms::DynBitset& a_activity,
+                                    DataLocationEnum a_activityLoc,
+                                    double a_time) = 0;
+
+  /// \brief Adds a time step as AddGridScalarsAtTime does, but converts and fits it on a
+  ///        background thread while the current window is traced.
+  ///
+  /// The arguments are copied before returning, so the caller may reuse them at once. The
+  /// step joins the window when the next ContinueTraces returns, after that call has traced
+  /// the window as it was; anything else that adds a step or traces against the window
+  /// first waits for it and swaps it in. A time series then costs the slower of loading
+  /// and tracing per step rather than the sum of the two:
+  ///
+  /// \code
+  /// tracer->StartTraces(seeds, seedTimes);
+  /// bool queued;
+  /// do
+  /// {
+  ///   queued = series.HasNext();
+  ///   if (queued)
+  ///     tracer->AddGridScalarsAtTimeAsync(series.Next(), ...);
+  /// } while (tracer->ContinueTraces() > 0 && queued);
+  /// \endcode
+  ///
+  /// The results are identical to adding each step with AddGridScalarsAtTime before the
+  /// ContinueTraces that follows it. While both run, the background thread is one more than
+  /// the SetThreadCount threads tracing.
+  ///
+  /// A step that fails to prepare is dropped, leaving the tracer as it was, and what it
+  /// threw is rethrown by the next call that waits for it. ContinueTraces, which waits for
+  /// it only once it has traced, returns its count and leaves the exception to the call
+  /// after it.
+  /// \param[in] a_scalars The velocity vectors
+  /// \param[in] a_scalarLoc Whether the vectors are assigned to cells or points
+  /// \param[in] a_activity Whether each cell or point is active
+  /// \param[in] a_activityLoc Whether the activities are assigned to cells or points
+  /// \param[in] a_time The time of the scalars
+  virtual void AddGridScalarsAtTimeAsync(const VecPt3d& a_scalars,
+                                         DataLocationEnum a_scalarLoc,
+                                         const xms::DynBitset& a_activity,
+                                         DataLocationEnum a_activityLoc,
+                                         double a_time) = 0;
+
+  /// \brief Adds a time step made from the last one added and a sparse set of changes.
+  ///
+  /// The step has the last step's data location and activity location, with the listed
+  /// scalars replaced and the listed activities toggled. Only the triangles whose values the
+  /// changes reach are refitted, so a step in which a small part of the grid changes costs
+  /// in proportion to that part rather than to the grid. Equivalent to passing the whole
+  /// arrays to AddGridScalarsAtTime.
+  ///
+  /// Refused, with an error logged and no step added, if no step has been added yet, if
+  /// a_time is not after the newest step's, if a_changedIndices and a_changedScalars differ
+  /// in length, or if an index is out of range.
+  /// \param[in] a_changedIndices The points or cells whose vectors changed
+  /// \param[in] a_changedScalars The new vector of each, parallel to a_changedIndices
+  /// \param[in] a_activityFlips The points or cells whose activity toggled
+  /// \param[in] a_time The time of the scalars
+  virtual void AddGridScalarChangesAtTime(const VecInt& a_changedIndices,
+                                          const VecPt3d& a_changedScalars,
+                                          const VecInt& a_activityFlips,
+                                          double a_time) = 0;
+
+  /// \brief Adds the time step of the time step dataset at a time from the time step cache,
+  ///        if it is there.
+  ///
+  /// A step taken from the cache joins the window exactly as it did when it was first added,
+  /// for a copy of its fitted table rather than a conversion and a fit, so scrubbing back
+  /// and forth through a series re-establishes each window from steps already prepared:
+  ///
+  /// \code
+  /// if (!tracer->AddCachedGridScalarsAtTime(time))
+  ///   tracer->AddGridScalarsAtTime(series.At(time), ..., time);
+  /// \endcode
+  ///
+  /// Counted as a hit or a miss in the statistics. Changes can be added to a step taken
+  /// from the cache as to any other.
+  /// \param[in] a_time The time of the step
+  /// \return true if the step was cached and has been added; false, with nothing added, if
+  ///         it was not
+  virtual bool AddCachedGridScalarsAtTime(double a_time) = 0;
+  /// \brief Drops every step in the time step cache, as when a dataset's values have been
+  ///        edited and the steps kept for it are no longer its steps.
+  virtual void ClearTimeStepCache() = 0;
+
   /// \brief Runs the Grid Trace for a point
   /// \param[in] a_pt The starting point of the trace
   /// \param[in] a_ptTime The starting time of the trace
@@ -138,13 +524,34 @@ public:
                           VecPt3d& a_outTrace,
                           VecDbl& a_outTimes) = 0;
 
+  /// \brief Runs the Grid Trace for many points, each exactly as TracePoint would.
+  ///
+  /// The points are stepped together, as ContinueTraces steps a batch: on SetThreadCount
+  /// threads, a packet at a time, in spatial order if asked. Any batch begun with StartTraces
+  /// is left as it was. Afterwards GetExitReason and GetExitEdge report the last point, as
+  /// they would after tracing each in turn. Refused, with an error logged and no traces, if
+  /// the counts differ.
+  /// \param[in] a_pts The starting point of each trace
+  /// \param[in] a_ptTimes The starting time of each trace; must be one per point
+  /// \param[out] a_outXy The position of each vertex, x and y interleaved
+  /// \param[out] a_outTimes The time of each vertex
+  /// \param[out] a_outOffsets Where each trace's vertices begin, one entry per point plus
+  ///             one past the last vertex; see GetFlatTraceResults
+  /// \param[out] a_outExitReasons Why each trace stopped, one entry per point
+  virtual void TracePoints(const VecPt3d& a_pts,
+                           const VecDbl& a_ptTimes,
+                           VecDbl& a_outXy,
+                           VecDbl& a_outTimes,
+                           std::vector<size_t>& a_outOffsets,
+                           std::vector<XmGridTraceExitEnum>& a_outExitReasons) = 0;
+
   /// \brief Begins tracing a batch of seeds against the currently loaded time steps.
   ///
-  /// A trace runs only as far as the second loaded time step, because that is as far as the
-  /// field is known. Supply the next time step with AddGridScalarsAtTime and call
-  /// ContinueTraces to carry every unfinished trace onward; the two-step window means memory
-  /// stays bounded however long the series is, and the caller reads time steps only as the
-  /// traces actually need them:
+  /// A trace runs only as far as the newest loaded time step in the window, because that is
+  /// as far as the field is known. Supply the next time step with AddGridScalarsAtTime and
+  /// call ContinueTraces to carry every unfinished trace onward; the window of
+  /// GetWindowTimeSteps steps means memory stays bounded however long the series is, and the
+  /// caller reads time steps only as the traces actually need them:
   ///
   /// \code
   /// tracer->StartTraces(seeds, seedTimes);
@@ -153,6 +560,9 @@ public:
   /// tracer->GetTraceResults(traces, times, reasons);
   /// \endcode
   ///
+  /// AddGridScalarsAtTimeAsync runs the same loop with each step loaded while the one before
+  /// it is traced.
+  ///
   /// Stopping early is legitimate: traces still waiting simply end where they got to, with
   /// GTEXIT_WAITING_FOR_TIME_STEP. Calling ContinueTraces twice without supplying a time step
   /// in between does no useful work.
@@ -161,8 +571,8 @@ public:
   /// itself state on the tracer. Starting a batch discards any previous one.
   ///
   /// Release times may be staggered, including past the loaded window: a seed whose time is
-  /// later than the second loaded step simply waits, with GTEXIT_WAITING_FOR_TIME_STEP, and
-  /// starts once a window covering it is supplied.
+  /// later than the newest loaded time step in the window simply waits, with
+  /// GTEXIT_WAITING_FOR_TIME_STEP, and starts once a window covering it is supplied.
   ///
   /// \param[in] a_pts The starting point of each trace
   /// \param[in] a_ptTimes The starting time of each trace; must be one per point, or the
@@ -189,12 +599,68 @@ public:
                                std::vector<VecDbl>& a_outTimes,
                                std::vector<XmGridTraceExitEnum>& a_outExitReasons) const = 0;
 
+  /// \brief Copies out the batch traced so far as flat arrays: every trace's vertices one
+  ///        after another, and where each trace begins.
+  ///
+  /// Trace i is vertices a_outOffsets[i] up to but not including a_outOffsets[i + 1]. The
+  /// same results as GetTraceResults, but in four allocations however many traces the batch
+  /// has, and in the layout a vertex buffer wants.
+  ///
+  /// \param[out] a_outXy The position of each vertex, x and y interleaved
+  /// \param[out] a_outTimes The time of each vertex
+  /// \param[out] a_outOffsets Where each trace's vertices begin, one entry per seed plus one
+  ///             past the last vertex
+  /// \param[out] a_outExitReasons Why each trace stopped, one entry per seed
+  virtual void GetFlatTraceResults(VecDbl& a_outXy,
+                                   VecDbl& a_outTimes,
+                                   std::vector<size_t>& a_outOffsets,
+                                   std::vector<XmGridTraceExitEnum>& a_outExitReasons) const = 0;
+
+  /// \brief Hands over the batch's results, as GetTraceResults copies them, and frees the
+  ///        batch.
+  ///
+  /// Afterwards the tracer holds no batch, as if StartTraces had been given no seeds.
+  /// \param[out] a_outTraces The positions of each trace, one entry per seed
+  /// \param[out] a_outTimes The times of each trace, parallel to a_outTraces
+  /// \param[out] a_outExitReasons Why each trace stopped, one entry per seed
+  virtual void TakeTraceResults(std::vector<VecPt3d>& a_outTraces,
+                                std::vector<VecDbl>& a_outTimes,
+                                std::vector<XmGridTraceExitEnum>& a_outExitReasons) = 0;
+
+  /// \brief Hands over one finished trace of the batch and frees its vertices.
+  ///
+  /// A long run over many time steps can take each trace as soon as it stops, rather than
+  /// holding every trace until the last one does; the memory a taken trace used goes to the
+  /// traces still running. A taken trace keeps its exit reason but has no vertices in later
+  /// results, so taking it again gives an empty trace.
+  /// \param[in] a_trace The trace, by its seed's index
+  /// \param[out] a_outTrace The positions of the trace
+  /// \param[out] a_outTimes The times of the trace, parallel to a_outTrace
+  /// \param[out] a_outExitReason Why the trace stopped, or that it has not
+  /// \return false, leaving the trace as it was, if the trace is still running or there is
+  ///         no such trace
+  virtual bool TakeTraceResult(size_t a_trace,
+                               VecPt3d& a_outTrace,
+                               VecDbl& a_outTimes,
+                               XmGridTraceExitEnum& a_outExitReason) = 0;
+
+  /// \brief Copies out the cell edge each trace of the batch left the grid through.
+  ///
+  /// An edge is named by its cell and its index within the cell, as XmUGrid::GetCellEdge
+  /// numbers them. For a trace that stopped on entering an inactive cell, it is the edge of
+  /// the last active cell the trace was in.
+  ///
+  /// \param[out] a_outCells The cell each trace left through, one entry per seed; -1 for a
+  ///             trace that did not stop with GTEXIT_LEFT_GRID
+  /// \param[out] a_outCellEdges The edge within that cell, parallel to a_outCells
+  virtual void GetTraceExitEdges(VecInt& a_outCells, VecInt& a_outCellEdges) const = 0;
+
   /// \brief Returns why the last trace operation ended.
   ///
   /// The single-point TracePoint reports through this what GetTraceResults reports per seed.
   /// GTEXIT_WAITING_FOR_TIME_STEP means the path stops early because the field is not known
-  /// past the second loaded time step, not that the particle came to rest -- a distinction
-  /// TracePoint cannot otherwise express.
+  /// past the newest loaded time step in the window, not that the particle came to rest -- a
+  /// distinction TracePoint cannot otherwise express.
   /// \return the exit reason of the last trace operation
   virtual XmGridTraceExitEnum GetExitReason() const = 0;
 
@@ -203,6 +669,19 @@ public:
   /// \return the exit message of the last trace operation
   virtual const std::string& GetExitMessage() const = 0;
 
+  /// \brief Returns the cell edge the last trace operation left the grid through, as
+  ///        GetTraceExitEdges reports it per seed.
+  /// \param[out] a_cellIdx The cell, or -1 if the trace did not stop with GTEXIT_LEFT_GRID
+  /// \param[out] a_cellEdgeIdx The edge within a_cellIdx, or -1
+  virtual void GetExitEdge(int& a_cellIdx, int& a_cellEdgeIdx) const = 0;
+
+  /// \brief Returns what the tracer has done since it was made or its statistics were last
+  ///        reset. Counts from the threads of ContinueTraces are added in when it returns.
+  /// \return the statistics
+  virtual const XmGridTraceStatistics& GetStatistics() const = 0;
+  /// \brief Zeroes the statistics.
+  virtual void ResetStatistics() = 0;
+
 private:
   XM_DISALLOW_COPY_AND_ASSIGN(XmGridTrace)
 
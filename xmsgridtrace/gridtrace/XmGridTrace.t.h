@@ -44,7 +44,31 @@ public:
   void testRedundantContinueDoesNotStallTrace();
   void testSeedReleasedAfterWindowWaitsThenTraces();
   void testDataLocationChangeIsNotShared();
-  void testBoundaryExtractorIsCached();
+  void testBoundaryIndexIsCached();
+  void testExitEdgeIsReported();
+  void testParallelContinueMatchesSerial();
+  void testPacketContinueMatchesSerial();
+  void testFlatResultsMatchTraceResults();
+  void testSpatialOrderingMatchesSeedOrder();
+  void testStatisticsCountWhatTracingDid();
+  void testAsyncTimeStepsMatchSynchronous();
+  void testFailedTimeStepLeavesTracer();
+  void testActivityChangeNeedsNoSearch();
+  void testChangesMatchWholeSteps();
+  void testSharedChunksCopyOnWrite();
+  void testArrayScalarsMatchPoints();
+  void testTracePointsMatchTracePoint();
+  void testTakeTraceResults();
+  void testTraceSinkMatchesResults();
+  void testSimplifiedTracesStayWithinTolerance();
+  void testSnapshotTracesFrozenField();
+  void testWindowTracesThroughInteriorSteps();
+  void testTimeStepCacheReplaysSteps();
+  void testTracersShareGridGeometry();
+  void testGeometryCacheSkipsTriangulation();
+  void testConvertMatchesExtractor();
+  void testNeighborWalkSkipsSearches();
+  void testRungeKuttaIntegrators();
   void testTraceBenchmark();
 
 }; // XmGridTraceUnitTests
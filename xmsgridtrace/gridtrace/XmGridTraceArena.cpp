@@ -0,0 +1,278 @@
+//------------------------------------------------------------------------------
+/// \file
+/// \ingroup extractor
+/// \copyright (C) Copyright Aquaveo 2018. Distributed under FreeBSD License
+/// (See accompanying file LICENSE or https://aqaveo.com/bsd/license.txt)
+//------------------------------------------------------------------------------
+
+//----- Included files ---------------------------------------------------------
+
+// 1. Precompiled header
+
+// 2. My own header
+#include <xmsgridtrace/gridtrace/XmGridTraceArena.h>
+
+// 3. Standard library headers
+#include <algorithm>
+
+// 4. External library headers
+
+// 5. Shared code headers
+#include <xmscore/points/pt.h>
+
+// 6. Non-shared code headers
+
+//----- Forward declarations ---------------------------------------------------
+
+//----- External globals -------------------------------------------------------
+
+//----- Namespace declaration --------------------------------------------------
+namespace xms
+{
+//----- Constants / Enumerations -----------------------------------------------
+
+//----- Classes / Structs ------------------------------------------------------
+
+//----- Internal functions -----------------------------------------------------
+namespace
+{
+/// Vertices in a trace's first block. Enough for a short glyph trace without wasting much
+/// on a seed that stops at once.
+const int kFirstBlockVertices = 8;
+/// Most vertices in one block. Past this a longer trace just takes more blocks; doubling
+/// further would leave up to half of a very large block unused.
+const int kMaxBlockVertices = 1024;
+/// Vertices in the first slab, and the most in any slab. Slabs double between the two, so a
+/// tracer that only ever traces one point at a time holds a few kilobytes, while a large
+/// batch allocates once per 1.5 MB.
+const int kFirstSlabVertices = 1024;
+const int kMaxSlabVertices = 65536;
+
+//------------------------------------------------------------------------------
+/// \brief Numbers the block sizes from the smallest: kFirstBlockVertices doubled n times.
+/// \param[in] a_capacity A block's capacity
+/// \return its size's number
+//------------------------------------------------------------------------------
+size_t iBlockSize(int a_capacity)
+{
+  size_t size = 0;
+  while ((kFirstBlockVertices << size) < a_capacity)
+    ++size;
+  return size;
+} // iBlockSize
+} // namespace
+
+//----- Class / Function definitions -------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class XmGridTraceArena
+/// \brief The vertices of every trace of a batch: x, y and time, held in shared slabs.
+////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+/// \brief Constructs an arena holding no traces.
+//------------------------------------------------------------------------------
+XmGridTraceArena::XmGridTraceArena()
+{
+} // XmGridTraceArena::XmGridTraceArena
+//------------------------------------------------------------------------------
+/// \brief Empties the arena and makes room for a new batch of traces.
+///
+/// The slabs are kept and carved again from the start, so a tracer that traces batch after
+/// batch stops allocating once it has seen its largest one. Release gives them back.
+/// \param[in] a_traceCount How many traces the new batch has
+//------------------------------------------------------------------------------
+void XmGridTraceArena::Reset(size_t a_traceCount)
+{
+  m_chains.assign(a_traceCount, Chain());
+  m_blocks.clear();
+  m_freeBlocks.clear();
+  m_slab = 0;
+  m_slabUsed = 0;
+} // XmGridTraceArena::Reset
+//------------------------------------------------------------------------------
+/// \brief Empties the arena and frees all its memory.
+//------------------------------------------------------------------------------
+void XmGridTraceArena::Release()
+{
+  std::vector<Chain>().swap(m_chains);
+  std::deque<Block>().swap(m_blocks);
+  std::vector<Block*>().swap(m_freeBlocks);
+  std::vector<std::unique_ptr<double[]>>().swap(m_slabs);
+  VecInt().swap(m_slabVertices);
+  m_slab = 0;
+  m_slabUsed = 0;
+} // XmGridTraceArena::Release
+//------------------------------------------------------------------------------
+/// \brief Returns the number of vertices over every trace.
+/// \return the vertex count
+//------------------------------------------------------------------------------
+size_t XmGridTraceArena::GetTotalVertexCount() const
+{
+  size_t count = 0;
+  for (const Chain& chain : m_chains)
+    count += chain.m_count;
+  return count;
+} // XmGridTraceArena::GetTotalVertexCount
+//------------------------------------------------------------------------------
+/// \brief Removes every vertex of a trace, keeping its blocks for the vertices that follow.
+/// \param[in] a_trace The trace
+//------------------------------------------------------------------------------
+void XmGridTraceArena::Clear(size_t a_trace)
+{
+  Chain& chain = m_chains[a_trace];
+  for (Block* block = chain.m_first; block; block = block->m_next)
+    block->m_count = 0;
+  chain.m_last = chain.m_first;
+  chain.m_count = 0;
+} // XmGridTraceArena::Clear
+//------------------------------------------------------------------------------
+/// \brief Removes every vertex of a trace and gives its blocks to the traces still growing.
+///
+/// The memory stays in the arena, but a batch whose finished traces are freed as they
+/// finish holds only about what its unfinished ones need.
+/// \param[in] a_trace The trace
+//------------------------------------------------------------------------------
+void XmGridTraceArena::Free(size_t a_trace)
+{
+  Chain& chain = m_chains[a_trace];
+  for (Block* block = chain.m_first; block;)
+  {
+    Block* next = block->m_next;
+    const size_t size = iBlockSize(block->m_capacity);
+    if (size >= m_freeBlocks.size())
+      m_freeBlocks.resize(size + 1, nullptr);
+    block->m_count = 0;
+    block->m_next = m_freeBlocks[size];
+    m_freeBlocks[size] = block;
+    block = next;
+  }
+  chain = Chain();
+} // XmGridTraceArena::Free
+//------------------------------------------------------------------------------
+/// \brief Adds a vertex to the end of a trace.
+/// \param[in] a_trace The trace
+/// \param[in] a_x The vertex's x
+/// \param[in] a_y The vertex's y
+/// \param[in] a_time The time the trace reached it
+//------------------------------------------------------------------------------
+void XmGridTraceArena::Append(size_t a_trace, double a_x, double a_y, double a_time)
+{
+  Chain& chain = m_chains[a_trace];
+  Block* block = chain.m_last;
+  if (!block)
+  {
+    block = NewBlock(kFirstBlockVertices);
+    chain.m_first = chain.m_last = block;
+  }
+  else if (block->m_count == block->m_capacity)
+  {
+    // A cleared trace already has the blocks it grew before; only past those is one carved.
+    if (!block->m_next)
+      block->m_next = NewBlock(std::min(2 * block->m_capacity, kMaxBlockVertices));
+    block = chain.m_last = block->m_next;
+  }
+  double* xyt = block->m_xyt + 3 * block->m_count++;
+  xyt[0] = a_x;
+  xyt[1] = a_y;
+  xyt[2] = a_time;
+  ++chain.m_count;
+} // XmGridTraceArena::Append
+//------------------------------------------------------------------------------
+/// \brief Copies out the vertices of one trace.
+/// \param[in] a_trace The trace
+/// \param[out] a_points The positions, z zero
+/// \param[out] a_times The times, parallel to a_points
+//------------------------------------------------------------------------------
+void XmGridTraceArena::GetVertices(size_t a_trace, VecPt3d& a_points, VecDbl& a_times) const
+{
+  const Chain& chain = m_chains[a_trace];
+  a_points.clear();
+  a_times.clear();
+  a_points.reserve(chain.m_count);
+  a_times.reserve(chain.m_count);
+  for (const Block* block = chain.m_first; block && block->m_count > 0; block = block->m_next)
+  {
+    for (int i = 0; i < block->m_count; ++i)
+    {
+      const double* xyt = block->m_xyt + 3 * i;
+      a_points.push_back(Pt3d(xyt[0], xyt[1], 0.0));
+      a_times.push_back(xyt[2]);
+    }
+  }
+} // XmGridTraceArena::GetVertices
+//------------------------------------------------------------------------------
+/// \brief Copies out the vertices of every trace into flat arrays.
+///
+/// Trace i's vertices are [a_offsets[i], a_offsets[i + 1]) of a_times, and twice that range
+/// of a_xy. Four allocations for the whole batch, however many traces it has.
+/// \param[out] a_xy The positions, x and y interleaved
+/// \param[out] a_times The times, one per vertex
+/// \param[out] a_offsets Where each trace's vertices begin, plus one past the end
+//------------------------------------------------------------------------------
+void XmGridTraceArena::GetFlatVertices(VecDbl& a_xy,
+                                       VecDbl& a_times,
+                                       std::vector<size_t>& a_offsets) const
+{
+  const size_t total = GetTotalVertexCount();
+  a_xy.resize(2 * total);
+  a_times.resize(total);
+  a_offsets.resize(m_chains.size() + 1);
+  size_t v = 0;
+  for (size_t trace = 0; trace < m_chains.size(); ++trace)
+  {
+    a_offsets[trace] = v;
+    const Chain& chain = m_chains[trace];
+    for (const Block* block = chain.m_first; block && block->m_count > 0; block = block->m_next)
+    {
+      for (int i = 0; i < block->m_count; ++i, ++v)
+      {
+        const double* xyt = block->m_xyt + 3 * i;
+        a_xy[2 * v] = xyt[0];
+        a_xy[2 * v + 1] = xyt[1];
+        a_times[v] = xyt[2];
+      }
+    }
+  }
+  a_offsets.back() = v;
+} // XmGridTraceArena::GetFlatVertices
+//------------------------------------------------------------------------------
+/// \brief Hands out a freed block, or carves a new one from the slabs, adding a slab if
+///        the current one is full.
+/// \param[in] a_capacity Vertices the block must have room for
+/// \return the block, which the arena owns
+//------------------------------------------------------------------------------
+XmGridTraceArena::Block* XmGridTraceArena::NewBlock(int a_capacity)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  const size_t size = iBlockSize(a_capacity);
+  if (size < m_freeBlocks.size() && m_freeBlocks[size])
+  {
+    Block* block = m_freeBlocks[size];
+    m_freeBlocks[size] = block->m_next;
+    block->m_next = nullptr;
+    return block;
+  }
+  // Move on to the next slab, or add one, if the rest of this one is too small. What is left
+  // behind in it is at most one block's worth.
+  while (m_slab < m_slabs.size() && m_slabUsed + a_capacity > (size_t)m_slabVertices[m_slab])
+  {
+    ++m_slab;
+    m_slabUsed = 0;
+  }
+  if (m_slab == m_slabs.size())
+  {
+    const int vertices =
+      m_slabVertices.empty() ? kFirstSlabVertices
+                             : std::min(2 * m_slabVertices.back(), kMaxSlabVertices);
+    m_slabs.emplace_back(new double[3 * (size_t)vertices]);
+    m_slabVertices.push_back(vertices);
+  }
+  m_blocks.emplace_back();
+  Block* block = &m_blocks.back();
+  block->m_xyt = m_slabs[m_slab].get() + 3 * m_slabUsed;
+  block->m_capacity = a_capacity;
+  m_slabUsed += a_capacity;
+  return block;
+} // XmGridTraceArena::NewBlock
+
+} // namespace xms
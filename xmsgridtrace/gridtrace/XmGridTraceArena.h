@@ -0,0 +1,108 @@
+#pragma once
+//------------------------------------------------------------------------------
+/// \file
+/// \brief Contains XmGridTraceArena, the vertex storage of a batch of traces.
+/// \ingroup ugrid
+/// \copyright (C) Copyright Aquaveo 2018. Distributed under FreeBSD License
+/// (See accompanying file LICENSE or https://aqaveo.com/bsd/license.txt)
+//------------------------------------------------------------------------------
+
+//----- Included files ---------------------------------------------------------
+
+// 3. Standard library headers
+#include <deque>
+#include <memory>
+#include <mutex>
+
+// 4. External library headers
+
+// 5. Shared code headers
+#include <xmscore/misc/base_macros.h>
+#include <xmscore/stl/vector.h>
+
+//----- Forward declarations ---------------------------------------------------
+
+//----- Namespace declaration --------------------------------------------------
+
+/// XMS Namespace
+namespace xms
+{
+//----- Forward declarations ---------------------------------------------------
+
+//----- Constants / Enumerations -----------------------------------------------
+
+//----- Structs / Classes ------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The vertices of every trace of a batch: x, y and time, held in shared slabs.
+///
+/// A vector of points and a vector of times per trace costs two heap allocations per trace
+/// and a reallocation every time either doubles, which is what makes a batch of a million
+/// seeds impractical. Here each trace is a chain of blocks carved from a few large slabs.
+/// Blocks start small, since most traces are short, and double up to a limit, so a trace
+/// of n vertices spans O(log n) blocks and the batch makes O(vertices / slab) allocations.
+///
+/// Appending to different traces from different threads is safe: a trace's blocks are
+/// written only by whoever appends to that trace, and carving a new block is locked.
+/// Everything else expects the batch not to be stepping.
+class XmGridTraceArena
+{
+public:
+  XmGridTraceArena();
+
+  void Reset(size_t a_traceCount);
+  void Release();
+
+  /// \brief Returns the number of traces.
+  /// \return the number of traces
+  size_t GetTraceCount() const { return m_chains.size(); }
+  /// \brief Returns the number of vertices of a trace.
+  /// \param[in] a_trace The trace
+  /// \return the vertex count
+  size_t GetVertexCount(size_t a_trace) const { return m_chains[a_trace].m_count; }
+  size_t GetTotalVertexCount() const;
+
+  void Clear(size_t a_trace);
+  void Free(size_t a_trace);
+  void Append(size_t a_trace, double a_x, double a_y, double a_time);
+  void GetVertices(size_t a_trace, VecPt3d& a_points, VecDbl& a_times) const;
+  void GetFlatVertices(VecDbl& a_xy, VecDbl& a_times, std::vector<size_t>& a_offsets) const;
+
+private:
+  XM_DISALLOW_COPY_AND_ASSIGN(XmGridTraceArena)
+
+  /// A run of one trace's vertices, three doubles each: x, y and time.
+  struct Block
+  {
+    double* m_xyt = nullptr; ///< the run's storage, in a slab
+    int m_capacity = 0;      ///< vertices m_xyt has room for
+    int m_count = 0;         ///< vertices in use
+    Block* m_next = nullptr; ///< the trace's next block, or null
+  };
+  /// The blocks of one trace.
+  struct Chain
+  {
+    Block* m_first = nullptr; ///< first block, or null if the trace never had a vertex
+    Block* m_last = nullptr;  ///< block being appended to
+    size_t m_count = 0;       ///< vertices over all the blocks
+  };
+
+  Block* NewBlock(int a_capacity);
+
+  std::vector<Chain> m_chains; ///< one per trace
+  /// Every block carved so far. A deque, because a trace holds pointers to its blocks and
+  /// growing a deque at the end never moves what it already holds.
+  std::deque<Block> m_blocks;
+  /// Blocks of freed traces, for NewBlock to hand out again: per block size, from the
+  /// smallest, the first of a list linked through Block::m_next.
+  std::vector<Block*> m_freeBlocks;
+  std::vector<std::unique_ptr<double[]>> m_slabs; ///< the storage blocks are carved from
+  VecInt m_slabVertices;       ///< vertices each slab has room for
+  size_t m_slab = 0;           ///< slab being carved from
+  size_t m_slabUsed = 0;       ///< vertices of m_slab already carved
+  std::mutex m_mutex;          ///< locks carving, so traces can grow on several threads
+};
+
+//----- Function prototypes ----------------------------------------------------
+
+} // namespace xms
@@ -0,0 +1,237 @@
+//------------------------------------------------------------------------------
+/// \file
+/// \ingroup extractor
+/// \copyright (C) Copyright Aquaveo 2018. Distributed under FreeBSD License
+/// (See accompanying file LICENSE or https://aqaveo.com/bsd/license.txt)
+//------------------------------------------------------------------------------
+
+//----- Included files ---------------------------------------------------------
+
+// 1. Precompiled header
+
+// 2. My own header
+#include <xmsgridtrace/gridtrace/XmGridTraceBoundary.h>
+
+// 3. Standard library headers
+#include <algorithm>
+#include <cmath>
+
+// 4. External library headers
+
+// 5. Shared code headers
+#include <xmscore/points/pt.h>
+#include <xmsgrid/ugrid/XmUGrid.h>
+
+// 6. Non-shared code headers
+
+//----- Forward declarations ---------------------------------------------------
+
+//----- External globals -------------------------------------------------------
+
+//----- Namespace declaration --------------------------------------------------
+namespace xms
+{
+//----- Constants / Enumerations -----------------------------------------------
+
+//----- Classes / Structs ------------------------------------------------------
+
+//----- Internal functions -----------------------------------------------------
+namespace
+{
+/// How far past either end of an edge, as a fraction of its length, a crossing still counts.
+/// A trace leaving exactly through a boundary corner must hit one of the two edges there,
+/// not slip between them on rounding.
+const double kEdgeTol = 1.0e-9;
+} // namespace
+
+//----- Class / Function definitions -------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class XmGridTraceBoundary
+/// \brief The boundary edges of a grid, binned for segment intersection.
+////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+/// \brief Collects and indexes the boundary edges of a grid.
+/// \param[in] a_ugrid The grid
+//------------------------------------------------------------------------------
+XmGridTraceBoundary::XmGridTraceBoundary(const XmUGrid& a_ugrid)
+{
+  const VecPt3d& locations = a_ugrid.GetLocations();
+  const int cellCount = a_ugrid.GetCellCount();
+  VecInt cellPoints;
+  for (int cellIdx = 0; cellIdx < cellCount; ++cellIdx)
+  {
+    const int edgeCount = a_ugrid.GetCellEdgeCount(cellIdx);
+    bool winding = false;
+    bool clockwise = false;
+    for (int edgeIdx = 0; edgeIdx < edgeCount; ++edgeIdx)
+    {
+      if (a_ugrid.GetCell2dEdgeAdjacentCell(cellIdx, edgeIdx) >= 0)
+        continue;
+      if (!winding)
+      {
+        // Twice the signed area; only its sign is wanted. Worked out only for cells on the
+        // boundary, which are the only ones whose winding matters here.
+        a_ugrid.GetCellPoints(cellIdx, cellPoints);
+        double area = 0;
+        for (size_t i = 0; i < cellPoints.size(); ++i)
+        {
+          const Pt3d& p = locations[cellPoints[i]];
+          const Pt3d& q = locations[cellPoints[(i + 1) % cellPoints.size()]];
+          area += p.x * q.y - q.x * p.y;
+        }
+        clockwise = area < 0;
+        winding = true;
+      }
+      XmEdge edge = a_ugrid.GetCellEdge(cellIdx, edgeIdx);
+      const Pt3d& start = locations[clockwise ? edge.GetSecond() : edge.GetFirst()];
+      const Pt3d& end = locations[clockwise ? edge.GetFirst() : edge.GetSecond()];
+      m_xy.push_back(start.x);
+      m_xy.push_back(start.y);
+      m_xy.push_back(end.x);
+      m_xy.push_back(end.y);
+      m_edgeCells.push_back(cellIdx);
+      m_edgeCellEdges.push_back(edgeIdx);
+    }
+  }
+  BuildBins();
+} // XmGridTraceBoundary::XmGridTraceBoundary
+//------------------------------------------------------------------------------
+/// \brief Builds the uniform bins used to find candidate edges for a segment.
+///
+/// The edges lie along curves, so most bins of a grid covering their extents are empty.
+/// Bins are sized at about twice the mean edge length, which keeps a bin's run short, but
+/// never so small that there are more than four bins per edge.
+//------------------------------------------------------------------------------
+void XmGridTraceBoundary::BuildBins()
+{
+  const int edgeCount = GetEdgeCount();
+  m_binStarts.assign(1, 0);
+  m_binEdges.clear();
+  m_binsX = m_binsY = 0;
+  if (edgeCount == 0)
+    return;
+
+  double xMax = m_xy[0], yMax = m_xy[1], totalLength = 0;
+  m_xMin = xMax;
+  m_yMin = yMax;
+  for (size_t i = 0; i < m_xy.size(); i += 4)
+  {
+    for (size_t k = i; k < i + 4; k += 2)
+    {
+      m_xMin = std::min(m_xMin, m_xy[k]);
+      xMax = std::max(xMax, m_xy[k]);
+      m_yMin = std::min(m_yMin, m_xy[k + 1]);
+      yMax = std::max(yMax, m_xy[k + 1]);
+    }
+    totalLength += std::hypot(m_xy[i + 2] - m_xy[i], m_xy[i + 3] - m_xy[i + 1]);
+  }
+  const double width = std::max(xMax - m_xMin, 0.0);
+  const double height = std::max(yMax - m_yMin, 0.0);
+  const double span = std::max(std::max(width, height), 1.0e-12);
+  m_binSize =
+    std::max(2.0 * totalLength / edgeCount, std::sqrt(width * height / (4.0 * edgeCount)));
+  m_binSize = std::max(m_binSize, span * 1.0e-6);
+  m_binsX = std::max(1, (int)std::ceil(width / m_binSize));
+  m_binsY = std::max(1, (int)std::ceil(height / m_binSize));
+
+  const double pad = span * 1.0e-9;
+  auto binRange = [&](int a_edgeIdx, int& a_i0, int& a_i1, int& a_j0, int& a_j1) {
+    const double* xy = &m_xy[4 * a_edgeIdx];
+    a_i0 = std::max(0, (int)std::floor((std::min(xy[0], xy[2]) - pad - m_xMin) / m_binSize));
+    a_i1 = std::min(m_binsX - 1,
+                    (int)std::floor((std::max(xy[0], xy[2]) + pad - m_xMin) / m_binSize));
+    a_j0 = std::max(0, (int)std::floor((std::min(xy[1], xy[3]) - pad - m_yMin) / m_binSize));
+    a_j1 = std::min(m_binsY - 1,
+                    (int)std::floor((std::max(xy[1], xy[3]) + pad - m_yMin) / m_binSize));
+  };
+
+  // Count, then fill, as XmGridTraceGeometry does for its triangles.
+  const size_t binCount = (size_t)m_binsX * m_binsY;
+  m_binStarts.assign(binCount + 1, 0);
+  int i0, i1, j0, j1;
+  for (int e = 0; e < edgeCount; ++e)
+  {
+    binRange(e, i0, i1, j0, j1);
+    for (int j = j0; j <= j1; ++j)
+    {
+      for (int i = i0; i <= i1; ++i)
+        ++m_binStarts[(size_t)j * m_binsX + i + 1];
+    }
+  }
+  for (size_t b = 0; b < binCount; ++b)
+    m_binStarts[b + 1] += m_binStarts[b];
+  m_binEdges.resize(m_binStarts[binCount]);
+  VecInt fill(m_binStarts.begin(), m_binStarts.end() - 1);
+  for (int e = 0; e < edgeCount; ++e)
+  {
+    binRange(e, i0, i1, j0, j1);
+    for (int j = j0; j <= j1; ++j)
+    {
+      for (int i = i0; i <= i1; ++i)
+        m_binEdges[fill[(size_t)j * m_binsX + i]++] = e;
+    }
+  }
+} // XmGridTraceBoundary::BuildBins
+//------------------------------------------------------------------------------
+/// \brief Finds where a segment starting inside the grid first leaves it.
+///
+/// Only crossings from the grid side of an edge to the outside count, so a segment that
+/// starts exactly on the boundary and heads inward is not stopped where it starts, and one
+/// that crosses a concave notch is stopped where it first goes out. The first such crossing
+/// along the segment wins; at a corner, either of its two edges may be reported.
+/// \param[in] a_from The start of the segment, inside the grid or on its boundary
+/// \param[in] a_to The end of the segment
+/// \param[out] a_t Where the segment leaves, as a fraction of the way from a_from to a_to
+/// \return the boundary edge crossed, or -1 if the segment does not leave the grid
+//------------------------------------------------------------------------------
+int XmGridTraceBoundary::FindExit(const Pt3d& a_from, const Pt3d& a_to, double& a_t) const
+{
+  if (m_binsX == 0)
+    return -1;
+  const double dx = a_to.x - a_from.x;
+  const double dy = a_to.y - a_from.y;
+  const int i0 = std::max(0, (int)std::floor((std::min(a_from.x, a_to.x) - m_xMin) / m_binSize));
+  const int i1 =
+    std::min(m_binsX - 1, (int)std::floor((std::max(a_from.x, a_to.x) - m_xMin) / m_binSize));
+  const int j0 = std::max(0, (int)std::floor((std::min(a_from.y, a_to.y) - m_yMin) / m_binSize));
+  const int j1 =
+    std::min(m_binsY - 1, (int)std::floor((std::max(a_from.y, a_to.y) - m_yMin) / m_binSize));
+
+  int found = -1;
+  double bestT = 2.0;
+  for (int j = j0; j <= j1; ++j)
+  {
+    for (int i = i0; i <= i1; ++i)
+    {
+      const size_t bin = (size_t)j * m_binsX + i;
+      for (int k = m_binStarts[bin]; k < m_binStarts[bin + 1]; ++k)
+      {
+        // An edge overlapping several bins is tested once per bin; the repeats find the
+        // same crossing, so they are cheaper to redo than to filter out.
+        const int edgeIdx = m_binEdges[k];
+        const double* xy = &m_xy[4 * edgeIdx];
+        const double ex = xy[2] - xy[0], ey = xy[3] - xy[1];
+        // How far left of the edge each end of the segment is, scaled by the edge length.
+        const double side0 = ex * (a_from.y - xy[1]) - ey * (a_from.x - xy[0]);
+        const double side1 = ex * (a_to.y - xy[1]) - ey * (a_to.x - xy[0]);
+        if (side1 >= 0 || side0 <= side1)
+          continue; // ends on the grid side, or is not heading out through this edge
+        const double t = side0 / (side0 - side1);
+        if (t < -kEdgeTol || t >= bestT)
+          continue;
+        const double px = a_from.x + t * dx - xy[0], py = a_from.y + t * dy - xy[1];
+        const double along = (px * ex + py * ey) / (ex * ex + ey * ey);
+        if (along < -kEdgeTol || along > 1.0 + kEdgeTol)
+          continue;
+        bestT = t;
+        found = edgeIdx;
+      }
+    }
+  }
+  if (found >= 0)
+    a_t = std::max(0.0, bestT);
+  return found;
+} // XmGridTraceBoundary::FindExit
+
+} // namespace xms
@@ -0,0 +1,84 @@
+#pragma once
+//------------------------------------------------------------------------------
+/// \file
+/// \brief Contains XmGridTraceBoundary, the index of a grid's boundary edges.
+/// \ingroup ugrid
+/// \copyright (C) Copyright Aquaveo 2018. Distributed under FreeBSD License
+/// (See accompanying file LICENSE or https://aqaveo.com/bsd/license.txt)
+//------------------------------------------------------------------------------
+
+//----- Included files ---------------------------------------------------------
+
+// 3. Standard library headers
+
+// 4. External library headers
+
+// 5. Shared code headers
+#include <xmscore/misc/base_macros.h>
+#include <xmscore/stl/vector.h>
+
+//----- Forward declarations ---------------------------------------------------
+
+//----- Namespace declaration --------------------------------------------------
+
+/// XMS Namespace
+namespace xms
+{
+//----- Forward declarations ---------------------------------------------------
+class XmUGrid;
+
+//----- Constants / Enumerations -----------------------------------------------
+
+//----- Structs / Classes ------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The boundary edges of a grid, binned for segment intersection.
+///
+/// Finding where a trace leaves the grid only needs the edges a trace can leave through.
+/// Those are the cell edges with no cell on their other side, so this holds only them: its
+/// size grows with the length of the boundary, not with the number of cells.
+///
+/// Each edge is stored with the grid on its left, whatever the winding of the cell it came
+/// from, so a crossing can be told apart as leaving or entering. Queries are const and write
+/// only to their arguments, so any number of threads can share one instance.
+class XmGridTraceBoundary
+{
+public:
+  explicit XmGridTraceBoundary(const XmUGrid& a_ugrid);
+
+  /// \brief Returns the number of boundary edges.
+  /// \return the number of boundary edges
+  int GetEdgeCount() const { return (int)m_edgeCells.size(); }
+  /// \brief Returns the cell a boundary edge belongs to.
+  /// \param[in] a_edgeIdx The boundary edge
+  /// \return the cell index
+  int GetEdgeCell(int a_edgeIdx) const { return m_edgeCells[a_edgeIdx]; }
+  /// \brief Returns which of its cell's edges a boundary edge is, as XmUGrid::GetCellEdge
+  ///        numbers them.
+  /// \param[in] a_edgeIdx The boundary edge
+  /// \return the edge index within the cell
+  int GetEdgeCellEdge(int a_edgeIdx) const { return m_edgeCellEdges[a_edgeIdx]; }
+
+  int FindExit(const Pt3d& a_from, const Pt3d& a_to, double& a_t) const;
+
+private:
+  XM_DISALLOW_COPY_AND_ASSIGN(XmGridTraceBoundary)
+
+  void BuildBins();
+
+  /// Four per edge: start x and y, end x and y, ordered so the grid is on the left.
+  VecDbl m_xy;
+  VecInt m_edgeCells;     ///< cell of each boundary edge
+  VecInt m_edgeCellEdges; ///< edge index within its cell of each boundary edge
+  double m_xMin = 0;      ///< low x of the binned extents
+  double m_yMin = 0;      ///< low y of the binned extents
+  double m_binSize = 1;   ///< width and height of one bin
+  int m_binsX = 0;        ///< bins along x
+  int m_binsY = 0;        ///< bins along y
+  VecInt m_binStarts;     ///< offset of each bin's run in m_binEdges, plus one past the end
+  VecInt m_binEdges;      ///< boundary edges overlapping each bin
+};
+
+//----- Function prototypes ----------------------------------------------------
+
+} // namespace xms
@@ -0,0 +1,862 @@
+//------------------------------------------------------------------------------
+/// \file
+/// \ingroup extractor
+/// \copyright (C) Copyright Aquaveo 2018. Distributed under FreeBSD License
+/// (See accompanying file LICENSE or https://aqaveo.com/bsd/license.txt)
+//------------------------------------------------------------------------------
+
+//----- Included files ---------------------------------------------------------
+
+// 1. Precompiled header
+
+// 2. My own header
+#include <xmsgridtrace/gridtrace/XmGridTraceGeometry.h>
+
+// 3. Standard library headers
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+// 4. External library headers
+
+// 5. Shared code headers
+#include <xmscore/misc/XmError.h>
+#include <xmscore/points/pt.h>
+#include <xmsextractor/ugrid/XmUGridTriangles2d.h>
+#include <xmsgrid/ugrid/XmUGrid.h>
+
+// 6. Non-shared code headers
+#include <xmsgridtrace/gridtrace/XmGridTraceLog.h>
+
+//----- Forward declarations ---------------------------------------------------
+
+//----- External globals -------------------------------------------------------
+
+//----- Namespace declaration --------------------------------------------------
+namespace xms
+{
+//----- Constants / Enumerations -----------------------------------------------
+
+//----- Classes / Structs ------------------------------------------------------
+
+//----- Internal functions -----------------------------------------------------
+namespace
+{
+/// How far outside a triangle, in barycentric units, a point may lie and still be found in
+/// it. Traces end exactly on grid edges and corners -- a boundary exit, or a seed on a grid
+/// point -- and rounding must not push those off the grid.
+const double kBaryTol = 1.0e-9;
+/// Triangles a walk may cross before giving up and leaving the query to the binned search.
+/// A trace step rarely crosses more than a handful; the cap is for the rare long step, and
+/// for the cycles a visibility walk can fall into on a non-Delaunay triangulation.
+const int kMaxWalkSteps = 32;
+/// How far inside a triangle, in barycentric units, a point must be for no other triangle
+/// to hold it. A thousand times kBaryTol, so a neighbor up to a thousand times the size
+/// cannot claim the point within its own tolerance.
+const double kInteriorTol = 1.0e-6;
+
+//------------------------------------------------------------------------------
+/// \brief Whether a triangle's points all belong to a cell.
+/// \param[in] a_tri The triangle's three point indices
+/// \param[in] a_cellPoints The cell's grid point indices
+/// \param[in] a_gridPointCount Number of grid points; higher indices are added points
+/// \param[in] a_centroid The cell's centroid point index, or -1 if it has none
+/// \return true if the triangle could have been cut from the cell
+//------------------------------------------------------------------------------
+bool iTriangleInCell(const int* a_tri,
+                     const VecInt& a_cellPoints,
+                     int a_gridPointCount,
+                     int a_centroid)
+{
+  for (int i = 0; i < 3; ++i)
+  {
+    const int pt = a_tri[i];
+    if (pt >= a_gridPointCount)
+    {
+      if (pt != a_centroid)
+        return false;
+    }
+    else if (std::find(a_cellPoints.begin(), a_cellPoints.end(), pt) == a_cellPoints.end())
+    {
+      return false;
+    }
+  }
+  return true;
+} // iTriangleInCell
+
+/// Starts every saved geometry file.
+const char kFileMagic[8] = {'X', 'M', 'G', 'T', 'G', 'E', 'O', '\0'};
+/// Layout of the saved geometry files this reads and writes. A file of any other version is
+/// refused and rebuilt; bump it with any change to iFileHeader or the sections.
+const uint32_t kFileVersion = 1;
+/// Written as is, so a file carried to a machine of the other byte order reads back
+/// differently and is refused.
+const uint32_t kByteOrderMark = 0x01020304;
+
+/// The arrays of a saved geometry file, in the order they follow the header.
+enum iFileSectionEnum {
+  FS_XY,
+  FS_TRIANGLES,
+  FS_TRIANGLE_CELLS,
+  FS_CELL_CENTROIDS,
+  FS_TRIANGLE_NEIGHBORS,
+  FS_BIN_STARTS,
+  FS_BIN_TRIANGLES,
+  FS_COUNT
+};
+/// Where one array of a saved geometry file lies.
+struct iFileSection
+{
+  uint64_t m_offset; ///< bytes from the start of the file; a multiple of 8
+  uint64_t m_count;  ///< number of values
+};
+/// The start of a saved geometry file. Fixed-width fields only, laid out without padding.
+struct iFileHeader
+{
+  char m_magic[8];          ///< kFileMagic
+  uint32_t m_version;       ///< kFileVersion
+  uint32_t m_byteOrder;     ///< kByteOrderMark, in the writer's byte order
+  uint64_t m_gridHash;      ///< hash of the grid's points and cells the geometry is for
+  int64_t m_gridPointCount; ///< the grid's point count
+  int64_t m_cellCount;      ///< the grid's cell count
+  double m_xMin;            ///< XmGridTraceGeometry::m_xMin
+  double m_yMin;            ///< XmGridTraceGeometry::m_yMin
+  double m_binSize;         ///< XmGridTraceGeometry::m_binSize
+  int32_t m_binsX;          ///< XmGridTraceGeometry::m_binsX
+  int32_t m_binsY;          ///< XmGridTraceGeometry::m_binsY
+  iFileSection m_sections[FS_COUNT]; ///< each array, by iFileSectionEnum
+};
+static_assert(sizeof(iFileHeader) == 72 + 16 * FS_COUNT, "iFileHeader must not be padded");
+static_assert(sizeof(int) == 4, "saved geometry stores indices as 32-bit ints");
+
+//------------------------------------------------------------------------------
+/// \brief Reads one array of a saved geometry file.
+/// \param[in] a_file The file
+/// \param[in] a_fileSize The file's size in bytes
+/// \param[in] a_section Where the array lies, from the file's header
+/// \param[out] a_values The array
+/// \return false if the section is misaligned, runs past the end of the file, or can't be
+///         read
+//------------------------------------------------------------------------------
+template <typename T>
+bool iReadSection(std::ifstream& a_file,
+                  uint64_t a_fileSize,
+                  const iFileSection& a_section,
+                  std::vector<T>& a_values)
+{
+  if (a_section.m_offset % 8 != 0 || a_section.m_offset > a_fileSize ||
+      a_section.m_count > (a_fileSize - a_section.m_offset) / sizeof(T))
+    return false;
+  a_values.resize((size_t)a_section.m_count);
+  if (a_values.empty())
+    return true;
+  a_file.seekg((std::streamoff)a_section.m_offset);
+  return (bool)a_file.read(reinterpret_cast<char*>(a_values.data()),
+                           (std::streamsize)(a_values.size() * sizeof(T)));
+} // iReadSection
+//------------------------------------------------------------------------------
+/// \brief Whether every value in an array is in a range.
+/// \param[in] a_values The array
+/// \param[in] a_min The lowest allowed
+/// \param[in] a_max One past the highest allowed
+/// \return true if all are in [a_min, a_max)
+//------------------------------------------------------------------------------
+bool iAllInRange(const VecInt& a_values, int a_min, int a_max)
+{
+  for (int value : a_values)
+  {
+    if (value < a_min || value >= a_max)
+      return false;
+  }
+  return true;
+} // iAllInRange
+} // namespace
+
+//----- Class / Function definitions -------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class XmGridTraceGeometry
+/// \brief The triangulation of a grid for one data location, indexed for point location.
+////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+/// \brief Copies and indexes a triangulation.
+/// \param[in] a_ugrid The grid the triangulation was built from
+/// \param[in] a_triangles The triangulation, already built; its point order is kept, so
+///            scalars indexed for it index this the same way
+//------------------------------------------------------------------------------
+XmGridTraceGeometry::XmGridTraceGeometry(const XmUGrid& a_ugrid, XmUGridTriangles2d& a_triangles)
+{
+  const VecPt3d& points = a_triangles.GetPoints();
+  m_xy.reserve(points.size() * 2);
+  for (const auto& pt : points)
+  {
+    m_xy.push_back(pt.x);
+    m_xy.push_back(pt.y);
+  }
+  m_triangles = a_triangles.GetTriangles();
+  MapTrianglesToCells(a_ugrid, a_triangles);
+  BuildBins();
+  BuildNeighbors();
+} // XmGridTraceGeometry::XmGridTraceGeometry
+//------------------------------------------------------------------------------
+/// \brief Construct empty, for Load to fill.
+//------------------------------------------------------------------------------
+XmGridTraceGeometry::XmGridTraceGeometry()
+{
+} // XmGridTraceGeometry::XmGridTraceGeometry
+//------------------------------------------------------------------------------
+/// \brief Reads a geometry saved by Save.
+///
+/// Everything in the file is checked before it is used -- the header against this build and
+/// the grid, each array against the file's size, and every index against what it indexes --
+/// so a stale, truncated, or foreign file is refused rather than trusted.
+/// \param[in] a_path The file
+/// \param[in] a_gridHash Hash of the grid's points and cells; the file must have been saved
+///            with the same one
+/// \param[in] a_gridPointCount The grid's point count
+/// \param[in] a_cellCount The grid's cell count
+/// \return the geometry, or null if there is no such file or it can't be used
+//------------------------------------------------------------------------------
+std::shared_ptr<XmGridTraceGeometry> XmGridTraceGeometry::Load(const std::string& a_path,
+                                                               uint64_t a_gridHash,
+                                                               int a_gridPointCount,
+                                                               int a_cellCount)
+{
+  std::ifstream file(a_path, std::ios::binary);
+  if (!file)
+    return nullptr;
+  file.seekg(0, std::ios::end);
+  const std::streamoff end = file.tellg();
+  file.seekg(0);
+  iFileHeader header;
+  if (end < (std::streamoff)sizeof(header) ||
+      !file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    return nullptr;
+  if (std::memcmp(header.m_magic, kFileMagic, sizeof(kFileMagic)) != 0 ||
+      header.m_version != kFileVersion || header.m_byteOrder != kByteOrderMark ||
+      header.m_gridHash != a_gridHash || header.m_gridPointCount != a_gridPointCount ||
+      header.m_cellCount != a_cellCount)
+    return nullptr;
+
+  const uint64_t fileSize = (uint64_t)end;
+  std::shared_ptr<XmGridTraceGeometry> geometry(new XmGridTraceGeometry());
+  XmGridTraceGeometry& g = *geometry;
+  const iFileSection* sections = header.m_sections;
+  if (!iReadSection(file, fileSize, sections[FS_XY], g.m_xy) ||
+      !iReadSection(file, fileSize, sections[FS_TRIANGLES], g.m_triangles) ||
+      !iReadSection(file, fileSize, sections[FS_TRIANGLE_CELLS], g.m_triangleCells) ||
+      !iReadSection(file, fileSize, sections[FS_CELL_CENTROIDS], g.m_cellCentroids) ||
+      !iReadSection(file, fileSize, sections[FS_TRIANGLE_NEIGHBORS], g.m_triangleNeighbors) ||
+      !iReadSection(file, fileSize, sections[FS_BIN_STARTS], g.m_binStarts) ||
+      !iReadSection(file, fileSize, sections[FS_BIN_TRIANGLES], g.m_binTriangles))
+    return nullptr;
+  g.m_xMin = header.m_xMin;
+  g.m_yMin = header.m_yMin;
+  g.m_binSize = header.m_binSize;
+  g.m_binsX = header.m_binsX;
+  g.m_binsY = header.m_binsY;
+  if (!g.IsConsistent(a_gridPointCount, a_cellCount))
+    return nullptr;
+  return geometry;
+} // XmGridTraceGeometry::Load
+//------------------------------------------------------------------------------
+/// \brief Writes the geometry to a file Load can read.
+///
+/// The file is written beside the target and renamed over it once complete, so a reader
+/// never sees a partly written one.
+/// \param[in] a_path The file, replaced if it exists
+/// \param[in] a_gridHash Hash of the grid's points and cells, for Load to check
+/// \param[in] a_gridPointCount The grid's point count
+/// \param[in] a_cellCount The grid's cell count
+/// \return true if the file was written
+//------------------------------------------------------------------------------
+bool XmGridTraceGeometry::Save(const std::string& a_path,
+                               uint64_t a_gridHash,
+                               int a_gridPointCount,
+                               int a_cellCount) const
+{
+  iFileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.m_magic, kFileMagic, sizeof(kFileMagic));
+  header.m_version = kFileVersion;
+  header.m_byteOrder = kByteOrderMark;
+  header.m_gridHash = a_gridHash;
+  header.m_gridPointCount = a_gridPointCount;
+  header.m_cellCount = a_cellCount;
+  header.m_xMin = m_xMin;
+  header.m_yMin = m_yMin;
+  header.m_binSize = m_binSize;
+  header.m_binsX = m_binsX;
+  header.m_binsY = m_binsY;
+
+  const char* data[FS_COUNT] = {reinterpret_cast<const char*>(m_xy.data()),
+                                reinterpret_cast<const char*>(m_triangles.data()),
+                                reinterpret_cast<const char*>(m_triangleCells.data()),
+                                reinterpret_cast<const char*>(m_cellCentroids.data()),
+                                reinterpret_cast<const char*>(m_triangleNeighbors.data()),
+                                reinterpret_cast<const char*>(m_binStarts.data()),
+                                reinterpret_cast<const char*>(m_binTriangles.data())};
+  const size_t counts[FS_COUNT] = {m_xy.size(),
+                                   m_triangles.size(),
+                                   m_triangleCells.size(),
+                                   m_cellCentroids.size(),
+                                   m_triangleNeighbors.size(),
+                                   m_binStarts.size(),
+                                   m_binTriangles.size()};
+  uint64_t bytes[FS_COUNT];
+  uint64_t offset = sizeof(header);
+  for (int section = 0; section < FS_COUNT; ++section)
+  {
+    bytes[section] = counts[section] * (section == FS_XY ? sizeof(double) : sizeof(int));
+    header.m_sections[section].m_offset = offset;
+    header.m_sections[section].m_count = counts[section];
+    offset = (offset + bytes[section] + 7) / 8 * 8;
+  }
+
+  const std::string tempPath = a_path + ".tmp";
+  bool written;
+  {
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file)
+      return false;
+    const char padding[8] = {};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (int section = 0; section < FS_COUNT; ++section)
+    {
+      if (bytes[section] > 0)
+        file.write(data[section], (std::streamsize)bytes[section]);
+      file.write(padding, (std::streamsize)((8 - bytes[section] % 8) % 8));
+    }
+    file.flush();
+    written = (bool)file;
+  }
+  std::remove(a_path.c_str());
+  if (!written || std::rename(tempPath.c_str(), a_path.c_str()) != 0)
+  {
+    std::remove(tempPath.c_str());
+    return false;
+  }
+  return true;
+} // XmGridTraceGeometry::Save
+//------------------------------------------------------------------------------
+/// \brief Whether every array agrees with the others and with the grid, so no query can
+///        index outside one.
+/// \param[in] a_gridPointCount The grid's point count
+/// \param[in] a_cellCount The grid's cell count
+/// \return true if the geometry can be searched
+//------------------------------------------------------------------------------
+bool XmGridTraceGeometry::IsConsistent(int a_gridPointCount, int a_cellCount) const
+{
+  if (m_xy.size() % 2 != 0 || m_triangles.size() % 3 != 0 ||
+      m_xy.size() / 2 > (size_t)std::numeric_limits<int>::max())
+    return false;
+  const int pointCount = GetPointCount();
+  const int triCount = (int)(m_triangles.size() / 3);
+  if (pointCount < a_gridPointCount || m_triangleCells.size() != (size_t)triCount ||
+      m_cellCentroids.size() != (size_t)a_cellCount ||
+      m_triangleNeighbors.size() != m_triangles.size())
+    return false;
+  if (!iAllInRange(m_triangles, 0, pointCount) ||
+      !iAllInRange(m_triangleCells, -1, a_cellCount) ||
+      !iAllInRange(m_triangleNeighbors, -1, triCount) ||
+      !iAllInRange(m_binTriangles, 0, triCount))
+    return false;
+  for (int centroid : m_cellCentroids)
+  {
+    if (centroid != -1 && (centroid < a_gridPointCount || centroid >= pointCount))
+      return false;
+  }
+
+  if (m_binsX < 0 || m_binsY < 0 || !(m_binSize > 0) ||
+      m_binStarts.size() != (uint64_t)m_binsX * (uint64_t)m_binsY + 1 ||
+      m_binStarts.front() != 0 || m_binStarts.back() != (int)m_binTriangles.size())
+    return false;
+  for (size_t bin = 0; bin + 1 < m_binStarts.size(); ++bin)
+  {
+    if (m_binStarts[bin] > m_binStarts[bin + 1])
+      return false;
+  }
+  return true;
+} // XmGridTraceGeometry::IsConsistent
+//------------------------------------------------------------------------------
+/// \brief Finds the cell each triangle was cut from.
+///
+/// XmUGridTriangles2d emits triangles cell by cell, in cell order, so walking both lists
+/// together finds each triangle's cell in amortized constant time. A triangle that does not
+/// fit the walk -- which would mean that order changed -- is matched against the cells
+/// around one of its points instead, so the mapping stays right either way.
+/// \param[in] a_ugrid The grid the triangulation was built from
+/// \param[in] a_triangles The triangulation
+//------------------------------------------------------------------------------
+void XmGridTraceGeometry::MapTrianglesToCells(const XmUGrid& a_ugrid,
+                                              XmUGridTriangles2d& a_triangles)
+{
+  const int gridPointCount = a_ugrid.GetPointCount();
+  const int cellCount = a_ugrid.GetCellCount();
+  const int triCount = (int)m_triangles.size() / 3;
+  m_triangleCells.assign(triCount, -1);
+  m_cellCentroids.resize(cellCount);
+  for (int cellIdx = 0; cellIdx < cellCount; ++cellIdx)
+    m_cellCentroids[cellIdx] = a_triangles.GetCellCentroid(cellIdx);
+
+  int cellIdx = 0;
+  VecInt cellPoints;
+  if (cellCount > 0)
+    a_ugrid.GetCellPoints(cellIdx, cellPoints);
+  for (int triIdx = 0; triIdx < triCount; ++triIdx)
+  {
+    const int* tri = &m_triangles[3 * triIdx];
+    int scanIdx = cellIdx;
+    while (scanIdx < cellCount &&
+           !iTriangleInCell(tri, cellPoints, gridPointCount, a_triangles.GetCellCentroid(scanIdx)))
+    {
+      if (++scanIdx < cellCount)
+        a_ugrid.GetCellPoints(scanIdx, cellPoints);
+    }
+    if (scanIdx < cellCount)
+    {
+      cellIdx = scanIdx;
+      m_triangleCells[triIdx] = cellIdx;
+      continue;
+    }
+
+    // Out of order: search the cells around one of the triangle's grid points.
+    a_ugrid.GetCellPoints(cellIdx, cellPoints);
+    const int gridPt = tri[0] < gridPointCount ? tri[0] : tri[1];
+    VecInt candidates = a_ugrid.GetPointAdjacentCells(gridPt);
+    VecInt candidatePoints;
+    for (int candidate : candidates)
+    {
+      a_ugrid.GetCellPoints(candidate, candidatePoints);
+      if (iTriangleInCell(tri, candidatePoints, gridPointCount,
+                          a_triangles.GetCellCentroid(candidate)))
+      {
+        m_triangleCells[triIdx] = candidate;
+        break;
+      }
+    }
+    if (m_triangleCells[triIdx] < 0)
+      XMGT_LOG(xmlog::error, "Gridtracer: a triangle could not be matched to a grid cell.");
+  }
+} // XmGridTraceGeometry::MapTrianglesToCells
+//------------------------------------------------------------------------------
+/// \brief Builds the uniform bins used to find candidate triangles for a point.
+///
+/// Roughly two triangles per bin, each triangle listed in every bin its bounding box
+/// touches. Boxes are padded slightly so a point exactly on a bin boundary still finds the
+/// triangles on both sides.
+//------------------------------------------------------------------------------
+void XmGridTraceGeometry::BuildBins()
+{
+  const int triCount = GetTriangleCount();
+  m_binStarts.assign(1, 0);
+  m_binTriangles.clear();
+  m_binsX = m_binsY = 0;
+  if (triCount == 0)
+    return;
+
+  double xMax = m_xy[0], yMax = m_xy[1];
+  m_xMin = xMax;
+  m_yMin = yMax;
+  for (size_t i = 0; i < m_xy.size(); i += 2)
+  {
+    m_xMin = std::min(m_xMin, m_xy[i]);
+    xMax = std::max(xMax, m_xy[i]);
+    m_yMin = std::min(m_yMin, m_xy[i + 1]);
+    yMax = std::max(yMax, m_xy[i + 1]);
+  }
+  const double width = std::max(xMax - m_xMin, 0.0);
+  const double height = std::max(yMax - m_yMin, 0.0);
+  const double span = std::max(std::max(width, height), 1.0e-12);
+  const double targetBins = std::max(1.0, triCount / 2.0);
+  double area = width * height;
+  if (area <= 0)
+    area = span * span;
+  m_binSize = std::max(std::sqrt(area / targetBins), span * 1.0e-6);
+  m_binsX = std::max(1, (int)std::ceil(width / m_binSize));
+  m_binsY = std::max(1, (int)std::ceil(height / m_binSize));
+
+  const double pad = span * 1.0e-9;
+  auto binRange = [&](int a_triIdx, int& a_i0, int& a_i1, int& a_j0, int& a_j1) {
+    const int* tri = &m_triangles[3 * a_triIdx];
+    double x0 = m_xy[2 * tri[0]], x1 = x0, y0 = m_xy[2 * tri[0] + 1], y1 = y0;
+    for (int k = 1; k < 3; ++k)
+    {
+      x0 = std::min(x0, m_xy[2 * tri[k]]);
+      x1 = std::max(x1, m_xy[2 * tri[k]]);
+      y0 = std::min(y0, m_xy[2 * tri[k] + 1]);
+      y1 = std::max(y1, m_xy[2 * tri[k] + 1]);
+    }
+    a_i0 = std::max(0, (int)std::floor((x0 - pad - m_xMin) / m_binSize));
+    a_i1 = std::min(m_binsX - 1, (int)std::floor((x1 + pad - m_xMin) / m_binSize));
+    a_j0 = std::max(0, (int)std::floor((y0 - pad - m_yMin) / m_binSize));
+    a_j1 = std::min(m_binsY - 1, (int)std::floor((y1 + pad - m_yMin) / m_binSize));
+  };
+
+  // Count, then fill: two passes over the triangles instead of a vector per bin.
+  const size_t binCount = (size_t)m_binsX * m_binsY;
+  m_binStarts.assign(binCount + 1, 0);
+  int i0, i1, j0, j1;
+  for (int t = 0; t < triCount; ++t)
+  {
+    binRange(t, i0, i1, j0, j1);
+    for (int j = j0; j <= j1; ++j)
+    {
+      for (int i = i0; i <= i1; ++i)
+        ++m_binStarts[(size_t)j * m_binsX + i + 1];
+    }
+  }
+  for (size_t b = 0; b < binCount; ++b)
+    m_binStarts[b + 1] += m_binStarts[b];
+  m_binTriangles.resize(m_binStarts[binCount]);
+  VecInt fill(m_binStarts.begin(), m_binStarts.end() - 1);
+  for (int t = 0; t < triCount; ++t)
+  {
+    binRange(t, i0, i1, j0, j1);
+    for (int j = j0; j <= j1; ++j)
+    {
+      for (int i = i0; i <= i1; ++i)
+        m_binTriangles[fill[(size_t)j * m_binsX + i]++] = t;
+    }
+  }
+} // XmGridTraceGeometry::BuildBins
+//------------------------------------------------------------------------------
+/// \brief Finds each triangle's neighbor across each of its edges.
+///
+/// Every edge is listed once per triangle using it, keyed by its two point indices, and the
+/// sorted list puts the two uses of an interior edge side by side. Edges between cells are
+/// shared like any other -- both cells' triangles use the same grid points -- so walks cross
+/// cell boundaries freely.
+//------------------------------------------------------------------------------
+void XmGridTraceGeometry::BuildNeighbors()
+{
+  struct Side
+  {
+    int m_lo;   ///< lower point index of the edge
+    int m_hi;   ///< higher point index of the edge
+    int m_side; ///< 3 * triangle + the point the edge is opposite
+  };
+  const int triCount = GetTriangleCount();
+  std::vector<Side> sides;
+  sides.reserve((size_t)triCount * 3);
+  for (int t = 0; t < triCount; ++t)
+  {
+    const int* tri = &m_triangles[3 * t];
+    for (int k = 0; k < 3; ++k)
+    {
+      const int a = tri[(k + 1) % 3], b = tri[(k + 2) % 3];
+      sides.push_back({std::min(a, b), std::max(a, b), 3 * t + k});
+    }
+  }
+  std::sort(sides.begin(), sides.end(), [](const Side& a_lhs, const Side& a_rhs) {
+    return a_lhs.m_lo != a_rhs.m_lo ? a_lhs.m_lo < a_rhs.m_lo
+                                    : (a_lhs.m_hi != a_rhs.m_hi ? a_lhs.m_hi < a_rhs.m_hi
+                                                                : a_lhs.m_side < a_rhs.m_side);
+  });
+  m_triangleNeighbors.assign((size_t)triCount * 3, -1);
+  for (size_t i = 0; i + 1 < sides.size(); ++i)
+  {
+    if (sides[i].m_lo == sides[i + 1].m_lo && sides[i].m_hi == sides[i + 1].m_hi)
+    {
+      m_triangleNeighbors[sides[i].m_side] = sides[i + 1].m_side / 3;
+      m_triangleNeighbors[sides[i + 1].m_side] = sides[i].m_side / 3;
+      ++i;
+    }
+  }
+} // XmGridTraceGeometry::BuildNeighbors
+//------------------------------------------------------------------------------
+/// \brief Lists the triangles using each point, for GetPointTriangles.
+//------------------------------------------------------------------------------
+void XmGridTraceGeometry::BuildPointTriangles() const
+{
+  const int pointCount = GetPointCount();
+  m_pointTriangleStarts.assign((size_t)pointCount + 1, 0);
+  for (int pt : m_triangles)
+    ++m_pointTriangleStarts[pt + 1];
+  for (int i = 0; i < pointCount; ++i)
+    m_pointTriangleStarts[i + 1] += m_pointTriangleStarts[i];
+  m_pointTriangles.resize(m_triangles.size());
+  VecInt next(m_pointTriangleStarts.begin(), m_pointTriangleStarts.end() - 1);
+  for (size_t i = 0; i < m_triangles.size(); ++i)
+    m_pointTriangles[next[m_triangles[i]]++] = (int)(i / 3);
+} // XmGridTraceGeometry::BuildPointTriangles
+//------------------------------------------------------------------------------
+/// \brief Returns the triangles that use a point, whose fit depends on its value.
+///
+/// The first call builds the lists for every point; any number of threads may call this
+/// at once.
+/// \param[in] a_ptIdx The triangulation point
+/// \param[out] a_count How many triangles use it
+/// \return the first of a_count triangle indices
+//------------------------------------------------------------------------------
+const int* XmGridTraceGeometry::GetPointTriangles(int a_ptIdx, int& a_count) const
+{
+  std::call_once(m_pointTrianglesOnce, [this]() { BuildPointTriangles(); });
+  const int begin = m_pointTriangleStarts[a_ptIdx];
+  a_count = m_pointTriangleStarts[a_ptIdx + 1] - begin;
+  return m_pointTriangles.data() + begin;
+} // XmGridTraceGeometry::GetPointTriangles
+//------------------------------------------------------------------------------
+/// \brief Computes a point's barycentric weights in a triangle.
+/// \param[in] a_triIdx The triangle
+/// \param[in] a_pt The point
+/// \param[out] a_weights Weights of the triangle's three points; meaningful even when the
+///             point is outside, where at least one is negative
+/// \return true if the point is inside the triangle or on its edge
+//------------------------------------------------------------------------------
+bool XmGridTraceGeometry::TriangleWeights(int a_triIdx, const Pt3d& a_pt, double a_weights[3]) const
+{
+  const int* tri = &m_triangles[3 * a_triIdx];
+  const double ax = m_xy[2 * tri[0]], ay = m_xy[2 * tri[0] + 1];
+  const double bx = m_xy[2 * tri[1]], by = m_xy[2 * tri[1] + 1];
+  const double cx = m_xy[2 * tri[2]], cy = m_xy[2 * tri[2] + 1];
+  const double det = (by - cy) * (ax - cx) + (cx - bx) * (ay - cy);
+  if (det == 0)
+  {
+    a_weights[0] = a_weights[1] = a_weights[2] = -1;
+    return false;
+  }
+  a_weights[0] = ((by - cy) * (a_pt.x - cx) + (cx - bx) * (a_pt.y - cy)) / det;
+  a_weights[1] = ((cy - ay) * (a_pt.x - cx) + (ax - cx) * (a_pt.y - cy)) / det;
+  a_weights[2] = 1.0 - a_weights[0] - a_weights[1];
+  return a_weights[0] >= -kBaryTol && a_weights[1] >= -kBaryTol && a_weights[2] >= -kBaryTol;
+} // XmGridTraceGeometry::TriangleWeights
+//------------------------------------------------------------------------------
+/// \brief Whether a point is far enough inside a triangle that no other triangle holds it.
+///
+/// Then the triangle's cell alone decides whether the point is active in a time step, and a
+/// query masked by another step's activity can be answered by a bitset lookup on that cell
+/// instead of a search. A point near an edge or corner is not interior, since a neighbor
+/// active where this triangle is not may hold it too.
+/// \param[in] a_triIdx The triangle
+/// \param[in] a_pt The point
+/// \return true if the point is inside the triangle and clear of all its edges
+//------------------------------------------------------------------------------
+bool XmGridTraceGeometry::IsInterior(int a_triIdx, const Pt3d& a_pt) const
+{
+  double weights[3];
+  TriangleWeights(a_triIdx, a_pt, weights);
+  return weights[0] > kInteriorTol && weights[1] > kInteriorTol && weights[2] > kInteriorTol;
+} // XmGridTraceGeometry::IsInterior
+//------------------------------------------------------------------------------
+/// \brief Finds the triangle containing a point.
+///
+/// The lowest-numbered active containing triangle wins, so a point on a shared edge gets the
+/// same answer however the query was reached. Inactive triangles are skipped rather than
+/// reported, so a point on the edge between an active and an inactive cell is found in the
+/// active one.
+/// \param[in] a_pt The point
+/// \param[in] a_cellActivity Which cells may be returned; empty, or too short to cover a
+///            cell, means active
+/// \param[out] a_weights Barycentric weights of the found triangle's three points
+/// \return the triangle index, or -1 if the point is outside every active triangle
+//------------------------------------------------------------------------------
+int XmGridTraceGeometry::LocateTriangle(const Pt3d& a_pt,
+                                        const DynBitset& a_cellActivity,
+                                        double a_weights[3]) const
+{
+  if (m_binsX == 0)
+    return -1;
+  const double fx = (a_pt.x - m_xMin) / m_binSize;
+  const double fy = (a_pt.y - m_yMin) / m_binSize;
+  const double binTol = 1.0e-6;
+  if (fx < -binTol || fy < -binTol || fx > m_binsX + binTol || fy > m_binsY + binTol)
+    return -1;
+  const int i = std::min(m_binsX - 1, std::max(0, (int)std::floor(fx)));
+  const int j = std::min(m_binsY - 1, std::max(0, (int)std::floor(fy)));
+  const size_t bin = (size_t)j * m_binsX + i;
+  for (int k = m_binStarts[bin]; k < m_binStarts[bin + 1]; ++k)
+  {
+    const int triIdx = m_binTriangles[k];
+    const size_t cellIdx = (size_t)m_triangleCells[triIdx];
+    if (cellIdx < a_cellActivity.size() && !a_cellActivity[cellIdx])
+      continue;
+    if (TriangleWeights(triIdx, a_pt, a_weights))
+      return triIdx;
+  }
+  return -1;
+} // XmGridTraceGeometry::LocateTriangle
+//------------------------------------------------------------------------------
+/// \brief Finds the triangle containing a point by walking from a nearby one.
+///
+/// Each step crosses the edge the point lies furthest beyond, so a point a step or two from
+/// a_startTri is found after evaluating only the triangles between them. The walk gives up
+/// -- returning -1, not an answer -- when it reaches the grid boundary, ends in an inactive
+/// triangle, or runs too long. None of those means the point is off the grid: a concave
+/// boundary or an inactive cell can stand between two active triangles. The caller falls
+/// back to LocateTriangle, which is exact.
+/// \param[in] a_startTri The triangle to start from, typically where the last query ended
+/// \param[in] a_pt The point
+/// \param[in] a_cellActivity Which cells may be returned; as for LocateTriangle
+/// \param[out] a_weights Barycentric weights of the found triangle's three points
+/// \return the triangle index, or -1 if the walk did not find an active triangle
+//------------------------------------------------------------------------------
+int XmGridTraceGeometry::WalkToTriangle(int a_startTri,
+                                        const Pt3d& a_pt,
+                                        const DynBitset& a_cellActivity,
+                                        double a_weights[3]) const
+{
+  if (a_startTri < 0 || a_startTri >= GetTriangleCount())
+    return -1;
+  int triIdx = a_startTri;
+  for (int step = 0; step < kMaxWalkSteps; ++step)
+  {
+    if (TriangleWeights(triIdx, a_pt, a_weights))
+    {
+      const size_t cellIdx = (size_t)m_triangleCells[triIdx];
+      if (cellIdx < a_cellActivity.size() && !a_cellActivity[cellIdx])
+        return -1;
+      return triIdx;
+    }
+    int side = 0;
+    if (a_weights[1] < a_weights[side])
+      side = 1;
+    if (a_weights[2] < a_weights[side])
+      side = 2;
+    triIdx = m_triangleNeighbors[3 * triIdx + side];
+    if (triIdx < 0)
+      return -1;
+  }
+  return -1;
+} // XmGridTraceGeometry::WalkToTriangle
+//------------------------------------------------------------------------------
+/// \brief Tests a packet of points against one triangle each.
+///
+/// For each point, the answer WalkToTriangle gives when the point is in its start triangle:
+/// that triangle if it is active, otherwise -1. A point outside its triangle also gets -1,
+/// where the walk would go on to a neighbor; the caller walks for just those points. The
+/// triangles' corners are gathered first, so the weights of every point are computed by one
+/// straight-line loop with the arithmetic of TriangleWeights.
+/// \param[in] a_count How many points
+/// \param[in] a_triIdx The triangle to test each point against, or -1
+/// \param[in] a_x The x of each point
+/// \param[in] a_y The y of each point
+/// \param[in] a_cellActivity Which cells may be returned; as for LocateTriangle
+/// \param[out] a_found For each point, its triangle or -1; may be a_triIdx itself
+//------------------------------------------------------------------------------
+void XmGridTraceGeometry::TrianglesContain(int a_count,
+                                           const int* a_triIdx,
+                                           const double* a_x,
+                                           const double* a_y,
+                                           const DynBitset& a_cellActivity,
+                                           int* a_found) const
+{
+  const int kBlock = 8;
+  const int triCount = GetTriangleCount();
+  for (int first = 0; first < a_count; first += kBlock)
+  {
+    const int count = std::min(kBlock, a_count - first);
+    double corners[6][kBlock];
+    int tris[kBlock];
+    for (int i = 0; i < count; ++i)
+    {
+      tris[i] = a_triIdx[first + i];
+      if (tris[i] < 0 || tris[i] >= triCount)
+      {
+        tris[i] = -1;
+        for (int k = 0; k < 6; ++k)
+          corners[k][i] = 0.0; // a degenerate triangle, which contains nothing
+        continue;
+      }
+      const int* tri = &m_triangles[3 * tris[i]];
+      for (int k = 0; k < 3; ++k)
+      {
+        corners[2 * k][i] = m_xy[2 * tri[k]];
+        corners[2 * k + 1][i] = m_xy[2 * tri[k] + 1];
+      }
+    }
+    bool inside[kBlock];
+    for (int i = 0; i < count; ++i)
+    {
+      const double ax = corners[0][i], ay = corners[1][i];
+      const double bx = corners[2][i], by = corners[3][i];
+      const double cx = corners[4][i], cy = corners[5][i];
+      const double px = a_x[first + i], py = a_y[first + i];
+      const double det = (by - cy) * (ax - cx) + (cx - bx) * (ay - cy);
+      const double w0 = ((by - cy) * (px - cx) + (cx - bx) * (py - cy)) / det;
+      const double w1 = ((cy - ay) * (px - cx) + (ax - cx) * (py - cy)) / det;
+      const double w2 = 1.0 - w0 - w1;
+      inside[i] = det != 0 && w0 >= -kBaryTol && w1 >= -kBaryTol && w2 >= -kBaryTol;
+    }
+    for (int i = 0; i < count; ++i)
+    {
+      int found = inside[i] ? tris[i] : -1;
+      if (found >= 0)
+      {
+        const size_t cellIdx = (size_t)m_triangleCells[found];
+        if (cellIdx < a_cellActivity.size() && !a_cellActivity[cellIdx])
+          found = -1;
+      }
+      a_found[first + i] = found;
+    }
+  }
+} // XmGridTraceGeometry::TrianglesContain
+//------------------------------------------------------------------------------
+/// \brief Follows a segment from triangle to triangle to where it first leaves the
+///        active triangles.
+///
+/// Each barycentric weight is linear along the segment, so the segment leaves a triangle
+/// through the side whose weight first falls to zero. Unlike WalkToTriangle this never
+/// skips ahead, so the first inactive or boundary edge on the segment is the one found.
+/// \param[in] a_startTri An active triangle containing a_from
+/// \param[in] a_from The start of the segment
+/// \param[in] a_to The end of the segment
+/// \param[in] a_cellActivity Which cells the segment may pass through; as for LocateTriangle
+/// \param[out] a_t Where the segment leaves, as a fraction of the way from a_from to a_to
+/// \param[out] a_triIdx The last active triangle the segment was in
+/// \param[out] a_side The edge of a_triIdx it leaves through: the one opposite that point
+/// \return true if the segment leaves the active triangles before reaching a_to
+//------------------------------------------------------------------------------
+bool XmGridTraceGeometry::FindSegmentExit(int a_startTri,
+                                          const Pt3d& a_from,
+                                          const Pt3d& a_to,
+                                          const DynBitset& a_cellActivity,
+                                          double& a_t,
+                                          int& a_triIdx,
+                                          int& a_side) const
+{
+  if (a_startTri < 0 || a_startTri >= GetTriangleCount())
+    return false;
+  int triIdx = a_startTri;
+  double t = 0;
+  // A straight segment enters each triangle at most once, so the triangle count bounds the
+  // walk; only a degenerate triangulation could make it loop.
+  for (int step = 0, stepCount = GetTriangleCount(); step < stepCount; ++step)
+  {
+    double w0[3], w1[3];
+    TriangleWeights(triIdx, a_from, w0);
+    TriangleWeights(triIdx, a_to, w1);
+    int side = -1;
+    double tExit = 1.0;
+    for (int k = 0; k < 3; ++k)
+    {
+      if (w1[k] >= w0[k] || w1[k] >= -kBaryTol)
+        continue;
+      const double tk = w0[k] / (w0[k] - w1[k]);
+      if (tk < tExit)
+      {
+        tExit = tk;
+        side = k;
+      }
+    }
+    if (side < 0)
+      return false; // a_to is in this triangle
+    t = std::max(t, tExit);
+    const int next = m_triangleNeighbors[3 * triIdx + side];
+    const size_t nextCell = next < 0 ? 0 : (size_t)m_triangleCells[next];
+    if (next < 0 || (nextCell < a_cellActivity.size() && !a_cellActivity[nextCell]))
+    {
+      a_t = t;
+      a_triIdx = triIdx;
+      a_side = side;
+      return true;
+    }
+    triIdx = next;
+  }
+  return false;
+} // XmGridTraceGeometry::FindSegmentExit
+
+} // namespace xms
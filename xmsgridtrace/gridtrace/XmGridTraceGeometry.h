@@ -0,0 +1,163 @@
+#pragma once
+//------------------------------------------------------------------------------
+/// \file
+/// \brief Contains XmGridTraceGeometry, the read-only triangulation a tracer searches.
+/// \ingroup ugrid
+/// \copyright (C) Copyright Aquaveo 2018. Distributed under FreeBSD License
+/// (See accompanying file LICENSE or https://aqaveo.com/bsd/license.txt)
+//------------------------------------------------------------------------------
+
+//----- Included files ---------------------------------------------------------
+
+// 3. Standard library headers
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// 4. External library headers
+
+// 5. Shared code headers
+#include <xmscore/misc/DynBitset.h>
+#include <xmscore/misc/base_macros.h>
+#include <xmscore/stl/vector.h>
+
+//----- Forward declarations ---------------------------------------------------
+
+//----- Namespace declaration --------------------------------------------------
+
+/// XMS Namespace
+namespace xms
+{
+//----- Forward declarations ---------------------------------------------------
+class XmUGrid;
+class XmUGridTriangles2d;
+
+//----- Constants / Enumerations -----------------------------------------------
+
+//----- Structs / Classes ------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The triangulation of a grid for one data location, indexed for point location.
+///
+/// GmTriSearch, behind XmUGridTriangles2d::GetIntersectedCell, keeps per-query state on the
+/// search object, so one triangulation cannot serve two threads at once. This holds a copy of
+/// the same triangles in flat arrays with a binned index over them, and every query is const
+/// and writes only to its arguments -- so any number of threads can search one instance.
+///
+/// Activity is deliberately not part of it. The triangles depend only on the grid and the
+/// data location, while activity changes per time step; callers pass their own cell
+/// activity mask with each query.
+///
+/// Save and Load keep a copy on disk, so a grid opened again need not be triangulated or
+/// indexed again. The file is a fixed header followed by each array, 8-byte aligned at an
+/// offset the header gives, in the byte order it was written in -- laid out so a reader can
+/// map it and use the arrays where they lie.
+class XmGridTraceGeometry
+{
+public:
+  XmGridTraceGeometry(const XmUGrid& a_ugrid, XmUGridTriangles2d& a_triangles);
+
+  static std::shared_ptr<XmGridTraceGeometry> Load(const std::string& a_path,
+                                                   uint64_t a_gridHash,
+                                                   int a_gridPointCount,
+                                                   int a_cellCount);
+  bool Save(const std::string& a_path,
+            uint64_t a_gridHash,
+            int a_gridPointCount,
+            int a_cellCount) const;
+
+  /// \brief Returns the number of triangles.
+  /// \return the number of triangles
+  int GetTriangleCount() const { return (int)m_triangleCells.size(); }
+  /// \brief Returns the triangulation point indices of a triangle.
+  /// \param[in] a_triIdx The triangle
+  /// \return pointer to the triangle's three point indices
+  const int* GetTrianglePoints(int a_triIdx) const { return &m_triangles[3 * a_triIdx]; }
+  /// \brief Returns the number of triangulation points: the grid's points, then any added.
+  /// \return the number of points
+  int GetPointCount() const { return (int)m_xy.size() / 2; }
+  /// \brief Returns the x coordinate of a triangulation point.
+  /// \param[in] a_ptIdx The point
+  /// \return the x coordinate
+  double GetPointX(int a_ptIdx) const { return m_xy[2 * a_ptIdx]; }
+  /// \brief Returns the y coordinate of a triangulation point.
+  /// \param[in] a_ptIdx The point
+  /// \return the y coordinate
+  double GetPointY(int a_ptIdx) const { return m_xy[2 * a_ptIdx + 1]; }
+  /// \brief Returns the grid cell a triangle was cut from.
+  /// \param[in] a_triIdx The triangle
+  /// \return the cell index
+  int GetTriangleCell(int a_triIdx) const { return m_triangleCells[a_triIdx]; }
+  /// \brief Returns the triangulation point added at a cell's centroid.
+  /// \param[in] a_cellIdx The cell
+  /// \return the point index, or -1 if the cell was triangulated without one
+  int GetCellCentroid(int a_cellIdx) const { return m_cellCentroids[a_cellIdx]; }
+  /// \brief Returns the triangle across one edge of a triangle.
+  /// \param[in] a_triIdx The triangle
+  /// \param[in] a_side Which edge: the one opposite the triangle's point a_side
+  /// \return the neighboring triangle, or -1 if that edge is on the grid boundary
+  int GetTriangleNeighbor(int a_triIdx, int a_side) const
+  {
+    return m_triangleNeighbors[3 * a_triIdx + a_side];
+  }
+
+  int LocateTriangle(const Pt3d& a_pt, const DynBitset& a_cellActivity, double a_weights[3]) const;
+  int WalkToTriangle(int a_startTri,
+                     const Pt3d& a_pt,
+                     const DynBitset& a_cellActivity,
+                     double a_weights[3]) const;
+  const int* GetPointTriangles(int a_ptIdx, int& a_count) const;
+  bool TriangleWeights(int a_triIdx, const Pt3d& a_pt, double a_weights[3]) const;
+  bool IsInterior(int a_triIdx, const Pt3d& a_pt) const;
+  void TrianglesContain(int a_count,
+                        const int* a_triIdx,
+                        const double* a_x,
+                        const double* a_y,
+                        const DynBitset& a_cellActivity,
+                        int* a_found) const;
+  bool FindSegmentExit(int a_startTri,
+                       const Pt3d& a_from,
+                       const Pt3d& a_to,
+                       const DynBitset& a_cellActivity,
+                       double& a_t,
+                       int& a_triIdx,
+                       int& a_side) const;
+
+private:
+  XM_DISALLOW_COPY_AND_ASSIGN(XmGridTraceGeometry)
+
+  XmGridTraceGeometry();
+  bool IsConsistent(int a_gridPointCount, int a_cellCount) const;
+  void MapTrianglesToCells(const XmUGrid& a_ugrid, XmUGridTriangles2d& a_triangles);
+  void BuildBins();
+  void BuildNeighbors();
+  void BuildPointTriangles() const;
+
+  VecDbl m_xy;           ///< triangulation point locations, x and y interleaved
+  VecInt m_triangles;    ///< three point indices per triangle
+  VecInt m_triangleCells; ///< grid cell of each triangle
+  VecInt m_cellCentroids; ///< triangulation point at each cell's centroid, or -1
+  /// Three per triangle: the triangle across the edge opposite each point, or -1.
+  VecInt m_triangleNeighbors;
+  double m_xMin = 0;     ///< low x of the binned extents
+  double m_yMin = 0;     ///< low y of the binned extents
+  double m_binSize = 1;  ///< width and height of one bin
+  int m_binsX = 0;       ///< bins along x
+  int m_binsY = 0;       ///< bins along y
+  /// Offset of each bin's run in m_binTriangles, plus one past the end. Flat arrays rather
+  /// than a vector per bin: a million-cell grid would otherwise make a million allocations.
+  VecInt m_binStarts;
+  VecInt m_binTriangles; ///< triangles overlapping each bin, in ascending triangle order
+  /// Offset of each point's run in m_pointTriangles, plus one past the end. Only updating a
+  /// time step from sparse changes needs these, so they are built on its first use;
+  /// mutable, and built under m_pointTrianglesOnce, because the geometry is otherwise
+  /// read-only and shared.
+  mutable VecInt m_pointTriangleStarts;
+  mutable VecInt m_pointTriangles; ///< triangles using each point, in ascending order
+  mutable std::once_flag m_pointTrianglesOnce; ///< builds m_pointTriangles exactly once
+};
+
+//----- Function prototypes ----------------------------------------------------
+
+} // namespace xms
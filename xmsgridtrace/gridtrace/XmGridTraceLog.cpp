@@ -0,0 +1,40 @@
+//------------------------------------------------------------------------------
+/// \file
+/// \ingroup extractor
+/// \copyright (C) Copyright Aquaveo 2018. Distributed under FreeBSD License
+/// (See accompanying file LICENSE or https://aqaveo.com/bsd/license.txt)
+//------------------------------------------------------------------------------
+
+//----- Included files ---------------------------------------------------------
+
+// 1. Precompiled header
+
+// 2. My own header
+#include <xmsgridtrace/gridtrace/XmGridTraceLog.h>
+
+// 3. Standard library headers
+
+// 4. External library headers
+
+// 5. Shared code headers
+
+// 6. Non-shared code headers
+
+//----- Forward declarations ---------------------------------------------------
+
+//----- External globals -------------------------------------------------------
+
+//----- Namespace declaration --------------------------------------------------
+namespace xms
+{
+//----- Constants / Enumerations -----------------------------------------------
+
+//----- Classes / Structs ------------------------------------------------------
+
+//----- Internal functions -----------------------------------------------------
+
+//----- Class / Function definitions -------------------------------------------
+
+std::mutex g_logMutex;
+
+} // namespace xms
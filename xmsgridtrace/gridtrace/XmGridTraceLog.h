@@ -0,0 +1,48 @@
+#pragma once
+//------------------------------------------------------------------------------
+/// \file
+/// \brief Contains XMGT_LOG, the thread-safe form of XM_LOG that tracing code uses.
+/// \ingroup ugrid
+/// \copyright (C) Copyright Aquaveo 2018. Distributed under FreeBSD License
+/// (See accompanying file LICENSE or https://aqaveo.com/bsd/license.txt)
+//------------------------------------------------------------------------------
+
+//----- Included files ---------------------------------------------------------
+
+// 3. Standard library headers
+#include <mutex>
+
+// 4. External library headers
+
+// 5. Shared code headers
+#include <xmscore/misc/XmLog.h>
+
+//----- Forward declarations ---------------------------------------------------
+
+//----- Namespace declaration --------------------------------------------------
+
+/// XMS Namespace
+namespace xms
+{
+//----- Forward declarations ---------------------------------------------------
+
+//----- Constants / Enumerations -----------------------------------------------
+
+/// Serializes the log calls tracing makes. The log is a process-wide singleton with no
+/// locking of its own, and both the tracing threads of ContinueTraces and the loader thread
+/// of AddGridScalarsAtTimeAsync may write to it.
+extern std::mutex g_logMutex;
+
+/// \brief XM_LOG, safe to call from any tracing or loader thread.
+#define XMGT_LOG(a_type, a_msg)                          \
+  do                                                     \
+  {                                                      \
+    std::lock_guard<std::mutex> logLock(xms::g_logMutex); \
+    XM_LOG(a_type, a_msg);                               \
+  } while (0)
+
+//----- Structs / Classes ------------------------------------------------------
+
+//----- Function prototypes ----------------------------------------------------
+
+} // namespace xms
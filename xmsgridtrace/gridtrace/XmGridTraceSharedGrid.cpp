@@ -0,0 +1,370 @@
+//------------------------------------------------------------------------------
+/// \file
+/// \ingroup extractor
+/// \copyright (C) Copyright Aquaveo 2018. Distributed under FreeBSD License
+/// (See accompanying file LICENSE or https://aqaveo.com/bsd/license.txt)
+//------------------------------------------------------------------------------
+
+//----- Included files ---------------------------------------------------------
+
+// 1. Precompiled header
+
+// 2. My own header
+#include <xmsgridtrace/gridtrace/XmGridTraceSharedGrid.h>
+
+// 3. Standard library headers
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <map>
+
+// 4. External library headers
+
+// 5. Shared code headers
+#include <xmscore/misc/xmstype.h>
+#include <xmsextractor/ugrid/XmUGridTriangles2d.h>
+#include <xmsgrid/ugrid/XmUGrid.h>
+
+// 6. Non-shared code headers
+#include <xmsgridtrace/gridtrace/XmGridTraceBoundary.h>
+#include <xmsgridtrace/gridtrace/XmGridTraceGeometry.h>
+#include <xmsgridtrace/gridtrace/XmGridTraceLog.h>
+
+//----- Forward declarations ---------------------------------------------------
+
+//----- External globals -------------------------------------------------------
+
+//----- Namespace declaration --------------------------------------------------
+namespace xms
+{
+#ifdef CXX_TEST
+/// \brief Count of XmGridTraceBoundary constructions since it was last zeroed.
+/// Test-build-only instrumentation for testBoundaryIndexIsCached. Caching the index is a
+/// pure performance change with no effect on trace output, so a construction count is the
+/// only thing that can tell a cached run from an uncached one.
+std::atomic<size_t> g_boundaryIndexBuilds(0);
+/// \brief Records one boundary index construction. Compiles away outside test builds.
+#define XMGT_COUNT_BOUNDARY_INDEX_BUILD() (++g_boundaryIndexBuilds)
+/// \brief Count of triangulations built since it was last zeroed. Test-build
+/// only, for testGeometryCacheSkipsTriangulation: a triangulation loaded from the cache
+/// directory traces the same as a built one, so only the count tells them apart.
+std::atomic<size_t> g_triangulationBuilds(0);
+/// \brief Records one triangulation built. Compiles away outside test builds.
+#define XMGT_COUNT_TRIANGULATION_BUILD() (++g_triangulationBuilds)
+#else
+/// \brief No-op outside test builds, so production traces pay nothing for instrumentation.
+#define XMGT_COUNT_BOUNDARY_INDEX_BUILD() ((void)0)
+/// \brief No-op outside test builds.
+#define XMGT_COUNT_TRIANGULATION_BUILD() ((void)0)
+#endif
+
+//----- Constants / Enumerations -----------------------------------------------
+
+//----- Classes / Structs ------------------------------------------------------
+
+//----- Internal functions -----------------------------------------------------
+namespace
+{
+/// Locks iSharedGrids.
+std::mutex& iSharedGridsMutex()
+{
+  static std::mutex mutex;
+  return mutex;
+} // iSharedGridsMutex
+/// \brief The instance shared for each grid, while any tracer holds it. Keyed by address:
+///        an instance keeps its grid alive, so no other grid can be at that address while
+///        the entry is live.
+/// \return the map
+std::map<const XmUGrid*, std::weak_ptr<XmGridTraceSharedGrid>>& iSharedGrids()
+{
+  static std::map<const XmUGrid*, std::weak_ptr<XmGridTraceSharedGrid>> grids;
+  return grids;
+} // iSharedGrids
+//------------------------------------------------------------------------------
+/// \brief Folds bytes into a 64-bit FNV-1a hash.
+/// \param[in] a_data The bytes
+/// \param[in] a_size How many
+/// \param[in,out] a_hash The hash so far
+//------------------------------------------------------------------------------
+void iHashBytes(const void* a_data, size_t a_size, uint64_t& a_hash)
+{
+  const unsigned char* bytes = static_cast<const unsigned char*>(a_data);
+  for (size_t i = 0; i < a_size; ++i)
+  {
+    a_hash ^= bytes[i];
+    a_hash *= 1099511628211ull;
+  }
+} // iHashBytes
+//------------------------------------------------------------------------------
+/// \brief Hashes a grid's point locations and cells: everything its triangulation is made
+///        from, so two grids with the same hash triangulate the same.
+/// \param[in] a_ugrid The grid
+/// \return the hash
+//------------------------------------------------------------------------------
+uint64_t iGridHash(const XmUGrid& a_ugrid)
+{
+  uint64_t hash = 14695981039346656037ull;
+  const VecPt3d& points = a_ugrid.GetLocations();
+  const VecInt& cellstream = a_ugrid.GetCellstream();
+  const uint64_t sizes[2] = {points.size(), cellstream.size()};
+  iHashBytes(sizes, sizeof(sizes), hash);
+  for (const Pt3d& pt : points)
+  {
+    const double xyz[3] = {pt.x, pt.y, pt.z};
+    iHashBytes(xyz, sizeof(xyz), hash);
+  }
+  if (!cellstream.empty())
+    iHashBytes(cellstream.data(), cellstream.size() * sizeof(int), hash);
+  return hash;
+} // iGridHash
+//------------------------------------------------------------------------------
+/// \brief Converts vectors to the values at a triangulation's points by the rules
+///        XmUGrid2dDataExtractor applies to its own triangulation.
+///
+/// testConvertMatchesExtractor holds these to the extractor's own values, bit for bit, for
+/// either data location, mixed cell shapes, and inactive points and cells.
+/// \param[in] a_ugrid The grid
+/// \param[in] a_geometry The triangulation
+/// \param[in] a_pointData Whether the vectors are assigned to points rather than cells
+/// \param[in] a_x The vectors' x
+/// \param[in] a_y The vectors' y
+/// \param[in] a_activity Whether each cell or point is active
+/// \param[in] a_activityLoc Whether the activities are assigned to cells or points
+/// \param[in] a_cellActivity Activity per cell; empty when all are active
+/// \param[out] a_vectors The values, x and y interleaved per triangulation point
+//------------------------------------------------------------------------------
+void iConvertByRules(const XmUGrid& a_ugrid,
+                     const XmGridTraceGeometry& a_geometry,
+                     bool a_pointData,
+                     const VecFlt& a_x,
+                     const VecFlt& a_y,
+                     const DynBitset& a_activity,
+                     DataLocationEnum a_activityLoc,
+                     const DynBitset& a_cellActivity,
+                     VecFlt& a_vectors)
+{
+  const float noData = (float)XM_NODATA;
+  const int gridPointCount = a_ugrid.GetPointCount();
+  const int cellCount = a_ugrid.GetCellCount();
+  const int count = (int)std::min(a_x.size(), a_y.size());
+  a_vectors.assign(2 * (size_t)a_geometry.GetPointCount(), noData);
+  VecInt cellPoints;
+  if (a_pointData)
+  {
+    // An inactive point has no value, and neither has the centroid of a cell around it.
+    const bool pointActivity = a_activityLoc == DataLocationEnum::LOC_POINTS;
+    for (int ptIdx = 0; ptIdx < gridPointCount && ptIdx < count; ++ptIdx)
+    {
+      if (pointActivity && (size_t)ptIdx < a_activity.size() && !a_activity[ptIdx])
+        continue;
+      a_vectors[2 * ptIdx] = a_x[ptIdx];
+      a_vectors[2 * ptIdx + 1] = a_y[ptIdx];
+    }
+    for (int cellIdx = 0; cellIdx < cellCount; ++cellIdx)
+    {
+      const int centroid = a_geometry.GetCellCentroid(cellIdx);
+      if (centroid < 0)
+        continue;
+      a_ugrid.GetCellPoints(cellIdx, cellPoints);
+      double sumX = 0, sumY = 0;
+      bool noValue = cellPoints.empty();
+      for (int ptIdx : cellPoints)
+      {
+        noValue = noValue || a_vectors[2 * ptIdx] == noData;
+        sumX += a_vectors[2 * ptIdx];
+        sumY += a_vectors[2 * ptIdx + 1];
+      }
+      if (noValue)
+        continue;
+      a_vectors[2 * centroid] = (float)(sumX / cellPoints.size());
+      a_vectors[2 * centroid + 1] = (float)(sumY / cellPoints.size());
+    }
+    return;
+  }
+
+  for (int ptIdx = 0; ptIdx < gridPointCount; ++ptIdx)
+  {
+    double sumX = 0, sumY = 0;
+    int active = 0;
+    for (int cellIdx : a_ugrid.GetPointAdjacentCells(ptIdx))
+    {
+      if (cellIdx < count && (a_cellActivity.empty() || a_cellActivity[cellIdx]))
+      {
+        sumX += a_x[cellIdx];
+        sumY += a_y[cellIdx];
+        ++active;
+      }
+    }
+    if (active)
+    {
+      a_vectors[2 * ptIdx] = (float)(sumX / active);
+      a_vectors[2 * ptIdx + 1] = (float)(sumY / active);
+    }
+  }
+  for (int cellIdx = 0; cellIdx < cellCount && cellIdx < count; ++cellIdx)
+  {
+    const int centroid = a_geometry.GetCellCentroid(cellIdx);
+    if (centroid < 0)
+      continue;
+    a_vectors[2 * centroid] = a_x[cellIdx];
+    a_vectors[2 * centroid + 1] = a_y[cellIdx];
+  }
+} // iConvertByRules
+} // namespace
+
+//----- Class / Function definitions -------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class XmGridTraceSharedGrid
+/// \brief What every tracer on one grid shares.
+////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+/// \brief Returns the instance shared by every tracer on a grid, making it if there is
+///        none.
+/// \param[in] a_ugrid The grid
+/// \return the instance, which nothing has been built in if it is new
+//------------------------------------------------------------------------------
+std::shared_ptr<XmGridTraceSharedGrid> XmGridTraceSharedGrid::Get(
+  const std::shared_ptr<XmUGrid>& a_ugrid)
+{
+  std::lock_guard<std::mutex> lock(iSharedGridsMutex());
+  auto& grids = iSharedGrids();
+  std::shared_ptr<XmGridTraceSharedGrid> shared = grids[a_ugrid.get()].lock();
+  if (shared)
+    return shared;
+  // Entries of grids no tracer holds any longer go as new ones come, so the map holds
+  // about as many entries as there are grids being traced.
+  for (auto it = grids.begin(); it != grids.end();)
+  {
+    if (it->second.expired())
+      it = grids.erase(it);
+    else
+      ++it;
+  }
+  shared = std::make_shared<XmGridTraceSharedGrid>(a_ugrid);
+  grids[a_ugrid.get()] = shared;
+  return shared;
+} // XmGridTraceSharedGrid::Get
+//------------------------------------------------------------------------------
+/// \brief Construct for a grid, building nothing yet. Use Get, which shares it.
+/// \param[in] a_ugrid The grid
+//------------------------------------------------------------------------------
+XmGridTraceSharedGrid::XmGridTraceSharedGrid(const std::shared_ptr<XmUGrid>& a_ugrid)
+: m_ugrid(a_ugrid)
+{
+} // XmGridTraceSharedGrid::XmGridTraceSharedGrid
+//------------------------------------------------------------------------------
+/// \brief Destructor.
+//------------------------------------------------------------------------------
+XmGridTraceSharedGrid::~XmGridTraceSharedGrid()
+{
+} // XmGridTraceSharedGrid::~XmGridTraceSharedGrid
+//------------------------------------------------------------------------------
+/// \brief Converts a time step's vectors to the values at the points of the triangulation
+///        for their data location, loading or triangulating the grid there if no tracer has
+///        yet.
+/// \param[in] a_scalarLoc Whether the vectors are assigned to cells or points
+/// \param[in] a_x The vectors' x
+/// \param[in] a_y The vectors' y
+/// \param[in] a_activity Whether each cell or point is active
+/// \param[in] a_activityLoc Whether the activities are assigned to cells or points
+/// \param[in] a_cellActivity a_activity per cell; empty when all are active
+/// \param[in] a_cacheDirectory Where triangulations are saved between runs; empty for none
+/// \param[out] a_vectors The values, x and y interleaved per triangulation point
+/// \param[in,out] a_triangulationSeconds Counts the time spent triangulating, or loading a
+///                saved triangulation, if this call did
+/// \return the searchable triangulation the values are for
+//------------------------------------------------------------------------------
+std::shared_ptr<const XmGridTraceGeometry> XmGridTraceSharedGrid::Convert(
+  DataLocationEnum a_scalarLoc,
+  const VecFlt& a_x,
+  const VecFlt& a_y,
+  const DynBitset& a_activity,
+  DataLocationEnum a_activityLoc,
+  const DynBitset& a_cellActivity,
+  const std::string& a_cacheDirectory,
+  VecFlt& a_vectors,
+  double& a_triangulationSeconds)
+{
+  const bool pointData = a_scalarLoc == DataLocationEnum::LOC_POINTS;
+  Location& location = pointData ? m_points : m_cells;
+  std::shared_ptr<const XmGridTraceGeometry> geometry;
+  {
+    std::lock_guard<std::mutex> lock(location.m_mutex);
+    if (!location.m_geometry)
+    {
+      const auto start = std::chrono::steady_clock::now();
+      const std::string cachePath =
+        a_cacheDirectory.empty() ? "" : GetCachePath(a_cacheDirectory, pointData);
+      if (!cachePath.empty())
+      {
+        location.m_geometry = XmGridTraceGeometry::Load(cachePath, m_gridHash,
+                                                        m_ugrid->GetPointCount(),
+                                                        m_ugrid->GetCellCount());
+      }
+      if (!location.m_geometry)
+      {
+        // Triangulated as the extractor triangulates for the data location, without also
+        // having it convert a component nothing would read: values are worked out below
+        // whether the triangulation was built or loaded, so a cache file never changes them.
+        BSHP<XmUGridTriangles2d> triangles = XmUGridTriangles2d::New();
+        triangles->BuildTriangles(*m_ugrid, pointData ? XmUGridTriangles2d::PO_NO_POINTS
+                                                      : XmUGridTriangles2d::PO_CENTROIDS_ONLY);
+        location.m_geometry = std::make_shared<XmGridTraceGeometry>(*m_ugrid, *triangles);
+        XMGT_COUNT_TRIANGULATION_BUILD();
+        if (!cachePath.empty() &&
+            !location.m_geometry->Save(cachePath, m_gridHash, m_ugrid->GetPointCount(),
+                                       m_ugrid->GetCellCount()))
+        {
+          XMGT_LOG(xmlog::warning, "Gridtracer: could not save the triangulation to the "
+                                   "geometry cache directory.");
+        }
+      }
+      a_triangulationSeconds +=
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    geometry = location.m_geometry;
+  }
+  iConvertByRules(*m_ugrid, *geometry, pointData, a_x, a_y, a_activity, a_activityLoc,
+                  a_cellActivity, a_vectors);
+  return geometry;
+} // XmGridTraceSharedGrid::Convert
+//------------------------------------------------------------------------------
+/// \brief Returns the grid's boundary edge index, building it if no tracer has yet.
+/// \return the index
+//------------------------------------------------------------------------------
+const XmGridTraceBoundary& XmGridTraceSharedGrid::GetBoundary() const
+{
+  std::call_once(m_boundaryOnce, [this]() {
+    m_boundary.reset(new XmGridTraceBoundary(*m_ugrid));
+    XMGT_COUNT_BOUNDARY_INDEX_BUILD();
+  });
+  return *m_boundary;
+} // XmGridTraceSharedGrid::GetBoundary
+//------------------------------------------------------------------------------
+/// \brief Returns the file a triangulation of the grid is saved to in a cache directory.
+///
+/// The name holds a hash of the grid's points and cells, so a grid that changed is never
+/// matched with a stale file, and grids that share a directory don't collide. The grid is
+/// hashed on the first call.
+/// \param[in] a_cacheDirectory The directory
+/// \param[in] a_pointData Whether the triangulation is the one for point-located data
+/// \return the path; empty if a_cacheDirectory is
+//------------------------------------------------------------------------------
+std::string XmGridTraceSharedGrid::GetCachePath(const std::string& a_cacheDirectory,
+                                                bool a_pointData)
+{
+  if (a_cacheDirectory.empty())
+    return std::string();
+  std::call_once(m_gridHashOnce, [this]() { m_gridHash = iGridHash(*m_ugrid); });
+  char name[64];
+  std::snprintf(name, sizeof(name), "xmgridtrace-%016llx-%s.geom",
+                (unsigned long long)m_gridHash, a_pointData ? "points" : "cells");
+  std::string path = a_cacheDirectory;
+  if (path.back() != '/' && path.back() != '\\')
+    path += '/';
+  return path + name;
+} // XmGridTraceSharedGrid::GetCachePath
+
+} // namespace xms
@@ -0,0 +1,111 @@
+#pragma once
+//------------------------------------------------------------------------------
+/// \file
+/// \brief Contains XmGridTraceSharedGrid, what every tracer on one grid shares.
+/// \ingroup ugrid
+/// \copyright (C) Copyright Aquaveo 2018. Distributed under FreeBSD License
+/// (See accompanying file LICENSE or https://aqaveo.com/bsd/license.txt)
+//------------------------------------------------------------------------------
+
+//----- Included files ---------------------------------------------------------
+
+// 3. Standard library headers
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// 4. External library headers
+
+// 5. Shared code headers
+#include <xmscore/misc/DynBitset.h>
+#include <xmscore/misc/base_macros.h>
+#include <xmscore/misc/boost_defines.h>
+#include <xmscore/stl/vector.h>
+#include <xmsextractor/extractor/XmUGrid2dDataExtractor.h>
+
+//----- Forward declarations ---------------------------------------------------
+
+//----- Namespace declaration --------------------------------------------------
+
+/// XMS Namespace
+namespace xms
+{
+//----- Forward declarations ---------------------------------------------------
+class XmUGrid;
+class XmGridTraceBoundary;
+class XmGridTraceGeometry;
+
+//----- Constants / Enumerations -----------------------------------------------
+
+//----- Structs / Classes ------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief What every tracer on one grid shares: per data location, the searchable geometry
+///        of the grid's triangulation, and the boundary index.
+///
+/// Each is built by the first tracer to need it and then used by every tracer on the grid,
+/// so a grid shown by several tracers -- one per dataset and per view -- is triangulated
+/// and indexed once and held in memory once. Get hands out one instance per grid for as
+/// long as any tracer holds it; the last tracer to let go frees it, and the grid with it.
+///
+/// The data location decides whether cells are triangulated about their centroids, as the
+/// extractor triangulates cell-located data about them and point-located data without, so
+/// it is the only option per triangulation.
+///
+/// The grid is triangulated as XmUGrid2dDataExtractor triangulates it, but no extractor is
+/// made. Values at the triangulation's points are worked out from the geometry by the
+/// extractor's own rules: a point-located value at its point and averaged over a cell's
+/// points at its centroid, a cell-located value at its centroid and averaged over a point's
+/// active cells at the point. So the values are the same whether the geometry was built or
+/// loaded, and the same as the extractor's. Given a cache directory, a triangulation
+/// is first looked for there, saved by an earlier run on a grid with the same points and
+/// cells, and saved there once built if it was not.
+///
+/// All of it is safe to use from any thread. The geometry and the boundary are read-only
+/// once built, and a conversion writes only to its arguments.
+class XmGridTraceSharedGrid
+{
+public:
+  static std::shared_ptr<XmGridTraceSharedGrid> Get(const std::shared_ptr<XmUGrid>& a_ugrid);
+
+  explicit XmGridTraceSharedGrid(const std::shared_ptr<XmUGrid>& a_ugrid);
+  ~XmGridTraceSharedGrid();
+
+  std::shared_ptr<const XmGridTraceGeometry> Convert(DataLocationEnum a_scalarLoc,
+                                                     const VecFlt& a_x,
+                                                     const VecFlt& a_y,
+                                                     const DynBitset& a_activity,
+                                                     DataLocationEnum a_activityLoc,
+                                                     const DynBitset& a_cellActivity,
+                                                     const std::string& a_cacheDirectory,
+                                                     VecFlt& a_vectors,
+                                                     double& a_triangulationSeconds);
+  const XmGridTraceBoundary& GetBoundary() const;
+  std::string GetCachePath(const std::string& a_cacheDirectory, bool a_pointData);
+
+private:
+  XM_DISALLOW_COPY_AND_ASSIGN(XmGridTraceSharedGrid)
+
+  /// What is shared for one data location.
+  struct Location
+  {
+    std::mutex m_mutex; ///< locks building or loading m_geometry
+    /// Searchable copy of the grid's triangulation, built or loaded on the first
+    /// conversion.
+    std::shared_ptr<const XmGridTraceGeometry> m_geometry;
+  };
+
+  std::shared_ptr<XmUGrid> m_ugrid; ///< the grid, kept alive while it is shared
+  Location m_points;                ///< shared for point-located scalars
+  Location m_cells;                 ///< shared for cell-located scalars
+  /// The grid's boundary edges, built on the first exit any tracer on the grid finds.
+  mutable std::unique_ptr<XmGridTraceBoundary> m_boundary;
+  mutable std::once_flag m_boundaryOnce; ///< builds m_boundary exactly once
+  uint64_t m_gridHash = 0;               ///< hash of the grid's points and cells
+  std::once_flag m_gridHashOnce;         ///< computes m_gridHash exactly once
+};
+
+//----- Function prototypes ----------------------------------------------------
+
+} // namespace xms
@@ -19,6 +19,322 @@
 //----- Namespace declaration --------------------------------------------------
 namespace py = pybind11;
 
+//----- Internal functions -----------------------------------------------------
+namespace {
+//------------------------------------------------------------------------------
+/// \brief Converts a data location name to its enum.
+/// \param[in] a_loc One of 'points', 'cells' or 'unknown'
+/// \return the data location
+//------------------------------------------------------------------------------
+xms::DataLocationEnum iDataLocationFromString(const std::string& a_loc)
+{
+  if (a_loc == "points")
+    return xms::DataLocationEnum::LOC_POINTS;
+  else if (a_loc == "cells")
+    return xms::DataLocationEnum::LOC_CELLS;
+  else if (a_loc == "unknown")
+    return xms::DataLocationEnum::LOC_UNKNOWN;
+  std::string msg = "nodal_func_type string must be one of 'points', 'cells', "
+                    "'unknown' not " + a_loc;
+  throw py::value_error(msg);
+} // iDataLocationFromString
+//------------------------------------------------------------------------------
+/// \brief Views a NumPy array as C-contiguous float32 or float64, copying only if it is
+///        neither already.
+/// \param[in] a_values The array
+/// \param[in] a_double Convert to float64 even if it is float32
+/// \return the array, or a converted copy
+//------------------------------------------------------------------------------
+py::array iComponentArray(const py::object& a_values, bool a_double)
+{
+  py::array values;
+  if (!a_double && py::isinstance<py::array_t<float>>(a_values))
+    values = py::array_t<float, py::array::c_style | py::array::forcecast>::ensure(a_values);
+  else
+    values = py::array_t<double, py::array::c_style | py::array::forcecast>::ensure(a_values);
+  if (!values)
+    throw py::value_error("scalars must convert to an array of numbers");
+  return values;
+} // iComponentArray
+//------------------------------------------------------------------------------
+/// \brief Views activity given as a NumPy array as C-contiguous bools.
+/// \param[in] a_activity The array
+/// \return the array, or a converted copy
+//------------------------------------------------------------------------------
+py::array iActivityArray(const py::object& a_activity)
+{
+  py::array activity =
+    py::array_t<bool, py::array::c_style | py::array::forcecast>::ensure(a_activity);
+  if (!activity)
+    throw py::value_error("cell_activity must convert to an array of bools");
+  return activity;
+} // iActivityArray
+//------------------------------------------------------------------------------
+/// \brief Adds a time step read in place from NumPy arrays, with the GIL released.
+///
+/// Only the tracer's own conversion to floats copies the vectors. Anything not a NumPy
+/// array falls back to the element-by-element conversion of iterables.
+/// \param[in] a_self The tracer
+/// \param[in] a_x The x components, or rows of (x, y[, z]) when a_y is None
+/// \param[in] a_y The y components, or None
+/// \param[in] a_scalarLoc Whether the vectors are assigned to cells or points
+/// \param[in] a_activity Whether each cell or point is active
+/// \param[in] a_activityLoc Whether the activities are assigned to cells or points
+/// \param[in] a_time The time of the scalars
+//------------------------------------------------------------------------------
+void iAddArrayScalars(xms::XmGridTrace& a_self,
+                      const py::object& a_x,
+                      const py::object& a_y,
+                      const std::string& a_scalarLoc,
+                      const py::object& a_activity,
+                      const std::string& a_activityLoc,
+                      double a_time)
+{
+  const xms::DataLocationEnum scalarLoc = iDataLocationFromString(a_scalarLoc);
+  const xms::DataLocationEnum activityLoc = iDataLocationFromString(a_activityLoc);
+  py::array x, y;
+  int count, stride;
+  const char* xData;
+  const char* yData;
+  if (a_y.is_none())
+  {
+    x = iComponentArray(a_x, false);
+    if (x.ndim() != 2 || (x.shape(1) != 2 && x.shape(1) != 3))
+      throw py::value_error("scalars must be an N x 2 or N x 3 array");
+    count = (int)x.shape(0);
+    stride = (int)x.shape(1);
+    xData = static_cast<const char*>(x.data());
+    yData = xData + x.itemsize();
+  }
+  else
+  {
+    // Both columns must be one type to be read by one overload; mixed ones are read as
+    // float64.
+    const bool mixed = py::isinstance<py::array_t<float>>(a_x) !=
+                       py::isinstance<py::array_t<float>>(a_y);
+    x = iComponentArray(a_x, mixed);
+    y = iComponentArray(a_y, mixed);
+    if (x.ndim() != 1 || y.ndim() != 1 || x.shape(0) != y.shape(0))
+      throw py::value_error("u and v must be one-dimensional arrays of one length");
+    count = (int)x.shape(0);
+    stride = 1;
+    xData = static_cast<const char*>(x.data());
+    yData = static_cast<const char*>(y.data());
+  }
+  const bool isFloat = x.itemsize() == sizeof(float);
+
+  py::array flags;
+  const bool activityIsArray = py::isinstance<py::array>(a_activity);
+  xms::DynBitset activity;
+  if (activityIsArray)
+    flags = iActivityArray(a_activity);
+  else
+    activity = xms::DynamicBitsetFromPyIter(py::iterable(a_activity));
+
+  py::gil_scoped_release release;
+  if (activityIsArray)
+  {
+    const bool* active = static_cast<const bool*>(flags.data());
+    activity.resize((size_t)flags.size());
+    for (size_t i = 0; i < activity.size(); ++i)
+      activity[i] = active[i];
+  }
+  if (isFloat)
+  {
+    a_self.AddGridScalarsAtTime(reinterpret_cast<const float*>(xData),
+                                reinterpret_cast<const float*>(yData), count, stride,
+                                scalarLoc, activity, activityLoc, a_time);
+  }
+  else
+  {
+    a_self.AddGridScalarsAtTime(reinterpret_cast<const double*>(xData),
+                                reinterpret_cast<const double*>(yData), count, stride,
+                                scalarLoc, activity, activityLoc, a_time);
+  }
+} // iAddArrayScalars
+//------------------------------------------------------------------------------
+/// \brief Hands a vector to NumPy without copying it; the array owns it from then on.
+/// \param[in] a_values The values, moved from
+/// \param[in] a_shape The array's shape, covering every value
+/// \return the array
+//------------------------------------------------------------------------------
+template <typename T>
+py::array iArrayFromVector(std::vector<T>&& a_values, std::vector<py::ssize_t> a_shape)
+{
+  auto* values = new std::vector<T>(std::move(a_values));
+  py::capsule owner(values, [](void* a_values) {
+    delete static_cast<std::vector<T>*>(a_values);
+  });
+  return py::array_t<T>(a_shape, values->data(), owner);
+} // iArrayFromVector
+//------------------------------------------------------------------------------
+/// \brief Hands flat trace results to NumPy; see XmGridTrace::GetFlatTraceResults.
+/// \param[in] a_xy The position of each vertex, moved from
+/// \param[in] a_times The time of each vertex, moved from
+/// \param[in] a_offsets Where each trace's vertices begin, moved from
+/// \param[in] a_reasons Why each trace stopped
+/// \return the N x 2 positions, the times, the offsets and the exit reasons as int32
+//------------------------------------------------------------------------------
+py::tuple iFlatResults(xms::VecDbl&& a_xy,
+                       xms::VecDbl&& a_times,
+                       std::vector<size_t>&& a_offsets,
+                       const std::vector<xms::XmGridTraceExitEnum>& a_reasons)
+{
+  const py::ssize_t vertexCount = (py::ssize_t)a_times.size();
+  const py::ssize_t offsetCount = (py::ssize_t)a_offsets.size();
+  py::array_t<int32_t> reasons((py::ssize_t)a_reasons.size());
+  int32_t* reasonData = reasons.mutable_data();
+  for (size_t i = 0; i < a_reasons.size(); ++i)
+    reasonData[i] = (int32_t)a_reasons[i];
+  return py::make_tuple(iArrayFromVector(std::move(a_xy), {vertexCount, 2}),
+                        iArrayFromVector(std::move(a_times), {vertexCount}),
+                        iArrayFromVector(std::move(a_offsets), {offsetCount}), reasons);
+} // iFlatResults
+////////////////////////////////////////////////////////////////////////////////
+/// Seeds and start times from Python. NumPy arrays are held as given and read by Read,
+/// which needs no GIL; anything else is converted element by element on construction.
+class SeedReader
+{
+public:
+  //----------------------------------------------------------------------------
+  /// \brief Takes the seeds, raising ValueError if the counts differ.
+  /// \param[in] a_pts The starting points: an N x 2 or N x 3 array, or an iterable
+  /// \param[in] a_times The starting times: an array, an iterable, or one number for all
+  /// \param[in] a_function The Python function, for the error message
+  //----------------------------------------------------------------------------
+  SeedReader(const py::object& a_pts, const py::object& a_times, const char* a_function)
+  {
+    if (py::isinstance<py::array>(a_pts))
+    {
+      m_ptArray = Array::ensure(a_pts);
+      m_hasPtArray = true;
+      if (!m_ptArray || m_ptArray.ndim() != 2 ||
+          (m_ptArray.shape(1) != 2 && m_ptArray.shape(1) != 3))
+        throw py::value_error(std::string(a_function) + " needs an N x 2 or N x 3 array");
+      m_count = (size_t)m_ptArray.shape(0);
+    }
+    else
+    {
+      m_pts = *xms::VecPt3dFromPyIter(py::iterable(a_pts));
+      m_count = m_pts.size();
+    }
+    size_t timeCount;
+    if (py::isinstance<py::float_>(a_times) || py::isinstance<py::int_>(a_times))
+    {
+      m_times.assign(m_count, a_times.cast<double>());
+      timeCount = m_count;
+    }
+    else if (py::isinstance<py::array>(a_times))
+    {
+      m_timeArray = Array::ensure(a_times);
+      m_hasTimeArray = true;
+      if (!m_timeArray || m_timeArray.ndim() != 1)
+        throw py::value_error(std::string(a_function) + " needs a 1-D array of times");
+      timeCount = (size_t)m_timeArray.shape(0);
+    }
+    else
+    {
+      m_times = *xms::VecDblFromPyIter(py::iterable(a_times));
+      timeCount = m_times.size();
+    }
+    if (timeCount != m_count)
+    {
+      // Raised rather than logged: the C++ side refuses the batch and returns empty,
+      // which from Python would look like a tracer that silently did nothing.
+      throw py::value_error(std::string(a_function) + " needs one start time per point, got " +
+                            std::to_string(m_count) + " points and " +
+                            std::to_string(timeCount) + " times");
+    }
+  } // SeedReader::SeedReader
+  //----------------------------------------------------------------------------
+  /// \brief Reads any arrays into the points and times. Safe with the GIL released.
+  //----------------------------------------------------------------------------
+  void Read()
+  {
+    if (m_hasPtArray)
+    {
+      const double* values = m_ptArray.data();
+      const size_t stride = (size_t)m_ptArray.shape(1);
+      m_pts.resize(m_count);
+      for (size_t i = 0; i < m_count; ++i)
+        m_pts[i] = xms::Pt3d(values[i * stride], values[i * stride + 1], 0.0);
+    }
+    if (m_hasTimeArray)
+      m_times.assign(m_timeArray.data(), m_timeArray.data() + m_count);
+  } // SeedReader::Read
+
+  xms::VecPt3d m_pts;  ///< the starting points, once read
+  xms::VecDbl m_times; ///< the starting times, once read
+
+private:
+  /// Double arrays, C-contiguous, as NumPy is asked to supply them.
+  typedef py::array_t<double, py::array::c_style | py::array::forcecast> Array;
+  Array m_ptArray;             ///< the points, if m_hasPtArray
+  Array m_timeArray;           ///< the times, if m_hasTimeArray
+  bool m_hasPtArray = false;   ///< the points were given as an array
+  bool m_hasTimeArray = false; ///< the times were given as an array
+  size_t m_count = 0;          ///< number of seeds
+};
+////////////////////////////////////////////////////////////////////////////////
+/// A trace sink calling Python functions. The tracer calls it from whichever thread is
+/// stepping, with the GIL released, so every call takes the GIL for itself.
+class PyTraceSink : public xms::XmGridTraceSink
+{
+public:
+  //----------------------------------------------------------------------------
+  /// \brief Takes the functions to call.
+  /// \param[in] a_onVertices Called with a trace's index and an N x 3 array of x, y and
+  ///            time, or None
+  /// \param[in] a_onTraceEnd Called with a trace's index and its exit_reason_enum, or None
+  //----------------------------------------------------------------------------
+  PyTraceSink(py::object a_onVertices, py::object a_onTraceEnd)
+  : m_onVertices(a_onVertices)
+  , m_onTraceEnd(a_onTraceEnd)
+  {
+  } // PyTraceSink::PyTraceSink
+  //----------------------------------------------------------------------------
+  /// \brief Drops the functions, which needs the GIL wherever the last owner lets go.
+  //----------------------------------------------------------------------------
+  ~PyTraceSink()
+  {
+    py::gil_scoped_acquire gil;
+    m_onVertices = py::object();
+    m_onTraceEnd = py::object();
+  } // PyTraceSink::~PyTraceSink
+  //----------------------------------------------------------------------------
+  /// \brief Hands a run of vertices to the Python function as a new array.
+  /// \param[in] a_trace The trace
+  /// \param[in] a_xyt The vertices, x, y and time each
+  /// \param[in] a_count Number of vertices
+  //----------------------------------------------------------------------------
+  void OnVertices(size_t a_trace, const double* a_xyt, int a_count) override
+  {
+    py::gil_scoped_acquire gil;
+    if (m_onVertices.is_none())
+      return;
+    // Copied: the run is the tracer's buffer, and is reused once this returns.
+    py::array_t<double> xyt({(py::ssize_t)a_count, (py::ssize_t)3});
+    std::copy(a_xyt, a_xyt + 3 * a_count, xyt.mutable_data());
+    m_onVertices(a_trace, xyt);
+  } // PyTraceSink::OnVertices
+  //----------------------------------------------------------------------------
+  /// \brief Hands the end of a trace to the Python function.
+  /// \param[in] a_trace The trace
+  /// \param[in] a_reason Why it stopped
+  //----------------------------------------------------------------------------
+  void OnTraceEnd(size_t a_trace, xms::XmGridTraceExitEnum a_reason) override
+  {
+    py::gil_scoped_acquire gil;
+    if (!m_onTraceEnd.is_none())
+      m_onTraceEnd(a_trace, a_reason);
+  } // PyTraceSink::OnTraceEnd
+
+private:
+  py::object m_onVertices; ///< called with each run of vertices, or None
+  py::object m_onTraceEnd; ///< called with each trace's end, or None
+};
+} // namespace
+
 //----- Python Interface -------------------------------------------------------
 PYBIND11_DECLARE_HOLDER_TYPE(T, boost::shared_ptr<T>);
 
@@ -210,6 +526,269 @@ void initXmGridTrace(py::module &m) {
       },
       max_change_direction_in_radians_doc);
 
+  // ---------------------------------------------------------------------------
+  // property: integrator
+  // ---------------------------------------------------------------------------
+  const char* integrator_doc = R"pydoc(
+      The integration scheme, an integrator_enum. EULER, the default, halves its step on a
+      large change in velocity or direction; RK4 uses the same step control;
+      DORMAND_PRINCE sizes its steps from absolute_tolerance and relative_tolerance.
+  )pydoc";
+  gridtrace.def_property("integrator",
+      [](xms::XmGridTrace &self) -> xms::XmGridTraceIntegratorEnum
+      {
+        return self.GetIntegrator();
+      },
+      [](xms::XmGridTrace &self, xms::XmGridTraceIntegratorEnum integrator)
+      {
+        self.SetIntegrator(integrator);
+      },
+      integrator_doc);
+
+  // ---------------------------------------------------------------------------
+  // property: absolute_tolerance
+  // ---------------------------------------------------------------------------
+  const char* absolute_tolerance_doc = R"pydoc(
+      The absolute tolerance on the position error of a DORMAND_PRINCE step, in grid units.
+  )pydoc";
+  gridtrace.def_property("absolute_tolerance",
+      [](xms::XmGridTrace &self) -> double
+      {
+        return self.GetAbsoluteTolerance();
+      },
+      [](xms::XmGridTrace &self, double absolute_tolerance)
+      {
+        self.SetAbsoluteTolerance(absolute_tolerance);
+      },
+      absolute_tolerance_doc);
+
+  // ---------------------------------------------------------------------------
+  // property: relative_tolerance
+  // ---------------------------------------------------------------------------
+  const char* relative_tolerance_doc = R"pydoc(
+      The relative tolerance on the position error of a DORMAND_PRINCE step, as a fraction
+      of the distance the step covers.
+  )pydoc";
+  gridtrace.def_property("relative_tolerance",
+      [](xms::XmGridTrace &self) -> double
+      {
+        return self.GetRelativeTolerance();
+      },
+      [](xms::XmGridTrace &self, double relative_tolerance)
+      {
+        self.SetRelativeTolerance(relative_tolerance);
+      },
+      relative_tolerance_doc);
+
+  // ---------------------------------------------------------------------------
+  // property: thread_count
+  // ---------------------------------------------------------------------------
+  const char* thread_count_doc = R"pydoc(
+      The number of threads continue_traces spreads a batch across. 1, the default, traces
+      on the calling thread; 0 or less uses one per hardware thread. Results are identical
+      for every thread count.
+  )pydoc";
+  gridtrace.def_property("thread_count",
+      [](xms::XmGridTrace &self) -> int
+      {
+        return self.GetThreadCount();
+      },
+      [](xms::XmGridTrace &self, int thread_count)
+      {
+        self.SetThreadCount(thread_count);
+      },
+      thread_count_doc);
+
+  // ---------------------------------------------------------------------------
+  // property: packet_width
+  // ---------------------------------------------------------------------------
+  const char* packet_width_doc = R"pydoc(
+      The number of traces continue_traces advances in lockstep on each thread, sharing
+      each step's point location and field evaluation. 1, the default, steps one trace at
+      a time; widths are used clamped to 1..8. Results are identical for every width.
+  )pydoc";
+  gridtrace.def_property("packet_width",
+      [](xms::XmGridTrace &self) -> int
+      {
+        return self.GetPacketWidth();
+      },
+      [](xms::XmGridTrace &self, int packet_width)
+      {
+        self.SetPacketWidth(packet_width);
+      },
+      packet_width_doc);
+
+  // ---------------------------------------------------------------------------
+  // property: spatial_ordering
+  // ---------------------------------------------------------------------------
+  const char* spatial_ordering_doc = R"pydoc(
+      Whether continue_traces steps traces in Hilbert order of where they are rather than
+      in seed order, re-sorting them on every call as they drift. Pays on large grids with
+      scattered seeds. False by default. Results are identical either way, and always come
+      back in seed order.
+  )pydoc";
+  gridtrace.def_property("spatial_ordering",
+      [](xms::XmGridTrace &self) -> bool
+      {
+        return self.GetSpatialOrdering();
+      },
+      [](xms::XmGridTrace &self, bool spatial_ordering)
+      {
+        self.SetSpatialOrdering(spatial_ordering);
+      },
+      spatial_ordering_doc);
+  // ---------------------------------------------------------------------------
+  // property: window_time_steps
+  // ---------------------------------------------------------------------------
+  const char* window_time_steps_doc = R"pydoc(
+      How many time steps the window keeps; 2 by default, and at least 2. Traces run
+      from one loaded step into the next without stopping and wait only at the newest,
+      so a series loaded several steps ahead is traced in one continue_traces call
+      rather than one per step. Adding a step to a full window drops the oldest, and a
+      smaller count drops the oldest at once.
+  )pydoc";
+  gridtrace.def_property("window_time_steps",
+      [](xms::XmGridTrace &self) -> int
+      {
+        return self.GetWindowTimeSteps();
+      },
+      [](xms::XmGridTrace &self, int window_time_steps)
+      {
+        self.SetWindowTimeSteps(window_time_steps);
+      },
+      window_time_steps_doc);
+  // ---------------------------------------------------------------------------
+  // property: snapshot_time
+  // ---------------------------------------------------------------------------
+  const char* snapshot_time_doc = R"pydoc(
+      The time the loaded window's field is frozen at, or None to trace through the
+      window as the field changes, which is the default. With a time, the loaded steps
+      either side of it are blended once and traces follow that one field: streamlines of that
+      instant, at close to half the cost per step. Such traces never wait for a later
+      time step; with neither a time nor a distance budget they stop after the window's
+      length of time. The time is clamped to the loaded window.
+  )pydoc";
+  gridtrace.def_property("snapshot_time",
+      [](xms::XmGridTrace &self) -> py::object
+      {
+        double time;
+        if (!self.GetSnapshotTime(time))
+          return py::none();
+        return py::float_(time);
+      },
+      [](xms::XmGridTrace &self, py::object snapshot_time)
+      {
+        if (snapshot_time.is_none())
+          self.ClearSnapshotTime();
+        else
+          self.SetSnapshotTime(snapshot_time.cast<double>());
+      },
+      snapshot_time_doc);
+  // ---------------------------------------------------------------------------
+  // property: simplification_tolerance
+  // ---------------------------------------------------------------------------
+  const char* simplification_tolerance_doc = R"pydoc(
+      How far a trace's polyline may stray from the path traced, in grid units. Vertices
+      are dropped as they are traced wherever the line between the ones kept stays this
+      close to them, so slow, straight flow keeps a handful of vertices instead of
+      hundreds. Kept vertices keep their times, and each trace's first and last vertex
+      and its exit reason are unchanged. Zero, the default, keeps every step.
+  )pydoc";
+  gridtrace.def_property("simplification_tolerance",
+      [](xms::XmGridTrace &self) -> double
+      {
+        return self.GetSimplificationTolerance();
+      },
+      [](xms::XmGridTrace &self, double simplification_tolerance)
+      {
+        self.SetSimplificationTolerance(simplification_tolerance);
+      },
+      simplification_tolerance_doc);
+  // ---------------------------------------------------------------------------
+  // property: time_step_cache_bytes
+  // ---------------------------------------------------------------------------
+  const char* time_step_cache_bytes_doc = R"pydoc(
+      How much memory, in bytes, the time step cache may hold; 0, the default, caches
+      nothing. With a budget every step added is kept, converted and fitted, under
+      time_step_dataset and its time, for add_cached_grid_scalars_at_time to add again.
+      The least recently used steps are dropped to stay within the budget.
+  )pydoc";
+  gridtrace.def_property("time_step_cache_bytes",
+      [](xms::XmGridTrace &self) -> size_t
+      {
+        return self.GetTimeStepCacheBytes();
+      },
+      [](xms::XmGridTrace &self, size_t time_step_cache_bytes)
+      {
+        self.SetTimeStepCacheBytes(time_step_cache_bytes);
+      },
+      time_step_cache_bytes_doc);
+  // ---------------------------------------------------------------------------
+  // property: time_step_dataset
+  // ---------------------------------------------------------------------------
+  const char* time_step_dataset_doc = R"pydoc(
+      The name of the dataset the steps added from now on belong to, so steps of
+      different datasets at the same time are cached apart. Empty by default.
+  )pydoc";
+  gridtrace.def_property("time_step_dataset",
+      [](xms::XmGridTrace &self) -> std::string
+      {
+        return self.GetTimeStepDataset();
+      },
+      [](xms::XmGridTrace &self, std::string time_step_dataset)
+      {
+        self.SetTimeStepDataset(time_step_dataset);
+      },
+      time_step_dataset_doc);
+  // ---------------------------------------------------------------------------
+  // property: geometry_cache_directory
+  // ---------------------------------------------------------------------------
+  const char* geometry_cache_directory_doc = R"pydoc(
+      A directory the grid's triangulations are saved to, so the next run that opens
+      the same grid loads them instead of triangulating again. Each data location's
+      triangulation is saved to its own file, named for a hash of the grid's points
+      and cells; a file that is missing or not for this grid is rebuilt and saved
+      over. Empty, the default, saves nothing.
+  )pydoc";
+  gridtrace.def_property("geometry_cache_directory",
+      [](xms::XmGridTrace &self) -> std::string
+      {
+        return self.GetGeometryCacheDirectory();
+      },
+      [](xms::XmGridTrace &self, std::string geometry_cache_directory)
+      {
+        self.SetGeometryCacheDirectory(geometry_cache_directory);
+      },
+      geometry_cache_directory_doc);
+  // ---------------------------------------------------------------------------
+  // function: set_trace_sink
+  // ---------------------------------------------------------------------------
+  const char* set_trace_sink_doc = R"pydoc(
+      Streams the vertices of every batch started from now on to Python functions
+      instead of keeping them, so a batch of any length runs in constant memory.
+      get_trace_results then still reports exit reasons, but no positions.
+
+      The functions are called from the tracing threads, one call at a time, while
+      continue_traces runs; they must not call back into the tracer. A trace's
+      vertices arrive in order, in runs, followed by exactly one end.
+
+      Args:
+          on_vertices (callable): Called with a trace's index and an N x 3 float64
+          array of x, y and time, or None.
+
+          on_trace_end (callable): Called with a trace's index and its
+          exit_reason_enum once it has stopped for good, or None. A trace ending with
+          EXTRACTION_FAILED is discarded; drop what was sent of it.
+  )pydoc";
+  gridtrace.def("set_trace_sink", [](xms::XmGridTrace &self, py::object on_vertices,
+    py::object on_trace_end) {
+          if (on_vertices.is_none() && on_trace_end.is_none())
+            self.SetTraceSink(BSHP<xms::XmGridTraceSink>());
+          else
+            self.SetTraceSink(BSHP<xms::XmGridTraceSink>(
+              new PyTraceSink(on_vertices, on_trace_end)));
+        }, set_trace_sink_doc, py::arg("on_vertices"), py::arg("on_trace_end"));
+
 
 
 
@@ -221,8 +800,13 @@ void initXmGridTrace(py::module &m) {
   // ---------------------------------------------------------------------------
   const char* add_grid_scalars_at_time_doc = R"pydoc(
       Assigns velocity vectors to each point or cell for a time step,
-      keeping the previous step, and dropping the one before that
-      for a maximum of two time steps.
+      keeping the previous steps, and dropping the oldest once the window
+      holds window_time_steps of them. A step at or before the newest starts the
+      window over.
+
+      NumPy arrays are read where they lie, with the GIL released: an N x 2 or N x 3
+      float32 or float64 array of vectors, and a bool array of activity. Other
+      iterables are converted element by element.
 
       Args:
           scalars (iterable): The velocity vectors.
@@ -236,50 +820,152 @@ void initXmGridTrace(py::module &m) {
           time (float): The time of the scalars.
   )pydoc";
   gridtrace.def("add_grid_scalars_at_time", [](xms::XmGridTrace &self, 
-          py::iterable vel_scalars,
+          py::object vel_scalars,
           std::string scalar_loc,
-          py::iterable cell_activity,
+          py::object cell_activity,
           std::string activity_loc,
           double time) {
-
-            xms::DataLocationEnum scalar_loc_e;
-            if (scalar_loc == "points")
-              scalar_loc_e = xms::DataLocationEnum::LOC_POINTS;
-            else if (scalar_loc == "cells")
-              scalar_loc_e = xms::DataLocationEnum::LOC_CELLS;
-            else if (scalar_loc == "unknown")
-              scalar_loc_e = xms::DataLocationEnum::LOC_UNKNOWN;
-            else
-            {
-              std::string msg = "nodal_func_type string must be one of 'points', 'cells', "
-                                "'unknown' not " + scalar_loc;
-              throw py::value_error(msg);
-            }
-
-            xms::DataLocationEnum activity_loc_e;
-            if (activity_loc == "points")
-              activity_loc_e = xms::DataLocationEnum::LOC_POINTS;
-            else if (activity_loc == "cells")
-              activity_loc_e = xms::DataLocationEnum::LOC_CELLS;
-            else if (activity_loc == "unknown")
-              activity_loc_e = xms::DataLocationEnum::LOC_UNKNOWN;
-            else
+            if (py::isinstance<py::array>(vel_scalars))
             {
-              std::string msg = "nodal_func_type string must be one of 'points', 'cells', "
-                                "'unknown' not " + activity_loc;
-              throw py::value_error(msg);
+              iAddArrayScalars(self, vel_scalars, py::none(), scalar_loc, cell_activity,
+                               activity_loc, time);
+              return;
             }
-
             boost::shared_ptr<xms::VecPt3d> scalars = 
               xms::VecPt3dFromPyIter(vel_scalars);
             xms::DynBitset activity = xms::DynamicBitsetFromPyIter(cell_activity);
-            self.AddGridScalarsAtTime(*scalars, scalar_loc_e, activity,
-              activity_loc_e, time);
+            self.AddGridScalarsAtTime(*scalars, iDataLocationFromString(scalar_loc), activity,
+              iDataLocationFromString(activity_loc), time);
             return;
           }, add_grid_scalars_at_time_doc, py::arg("scalars"), 
           py::arg("scalar_loc"), py::arg("cell_activity"), py::arg("activity_loc"),
            py::arg("time"));
   // ---------------------------------------------------------------------------
+  // function: add_grid_scalar_components_at_time
+  // ---------------------------------------------------------------------------
+  const char* add_grid_scalar_components_at_time_doc = R"pydoc(
+      Assigns velocity vectors for a time step as add_grid_scalars_at_time does, from
+      separate arrays of their x and y components. NumPy arrays of float32 or float64
+      are read where they lie, with the GIL released.
+
+      Args:
+          u (iterable): The x component of each vector.
+
+          v (iterable): The y component of each vector.
+
+          scalar_loc (string): Whether the vectors are assigned to cells or points.
+
+          cell_activity (iterable): Whether each cell or point is active.
+
+          activity_loc (string): Whether the activities are assigned to cells or points.
+
+          time (float): The time of the scalars.
+  )pydoc";
+  gridtrace.def("add_grid_scalar_components_at_time", [](xms::XmGridTrace &self,
+          py::object u,
+          py::object v,
+          std::string scalar_loc,
+          py::object cell_activity,
+          std::string activity_loc,
+          double time) {
+            iAddArrayScalars(self, u, v, scalar_loc, cell_activity, activity_loc, time);
+          }, add_grid_scalar_components_at_time_doc, py::arg("u"), py::arg("v"),
+          py::arg("scalar_loc"), py::arg("cell_activity"), py::arg("activity_loc"),
+          py::arg("time"));
+  // ---------------------------------------------------------------------------
+  // function: add_grid_scalars_at_time_async
+  // ---------------------------------------------------------------------------
+  const char* add_grid_scalars_at_time_async_doc = R"pydoc(
+      Adds a time step as add_grid_scalars_at_time does, but converts it on a background
+      thread while the current window is traced. The step joins the window when the next
+      continue_traces returns; anything else that adds a step or traces first waits for it.
+      Results are identical to adding each step before the continue_traces that follows it.
+
+      Args:
+          scalars (iterable): The velocity vectors.
+
+          scalar_loc (string): Whether the vectors are assigned to cells or points.
+
+          cell_activity (iterable): Whether each cell or point is active.
+
+          activity_loc (string): Whether the activities are assigned to cells or points.
+
+          time (float): The time of the scalars.
+  )pydoc";
+  gridtrace.def("add_grid_scalars_at_time_async", [](xms::XmGridTrace &self,
+          py::iterable vel_scalars,
+          std::string scalar_loc,
+          py::iterable cell_activity,
+          std::string activity_loc,
+          double time) {
+            boost::shared_ptr<xms::VecPt3d> scalars =
+              xms::VecPt3dFromPyIter(vel_scalars);
+            xms::DynBitset activity = xms::DynamicBitsetFromPyIter(cell_activity);
+            self.AddGridScalarsAtTimeAsync(*scalars, iDataLocationFromString(scalar_loc),
+              activity, iDataLocationFromString(activity_loc), time);
+          }, add_grid_scalars_at_time_async_doc, py::arg("scalars"),
+          py::arg("scalar_loc"), py::arg("cell_activity"), py::arg("activity_loc"),
+           py::arg("time"));
+  // ---------------------------------------------------------------------------
+  // function: add_grid_scalar_changes_at_time
+  // ---------------------------------------------------------------------------
+  const char* add_grid_scalar_changes_at_time_doc = R"pydoc(
+      Adds a time step that is the last one added with a few points or cells changed.
+      Only the changed vectors and activities are given; the data and activity
+      locations are the last step's. Refused, with an error logged, before any whole
+      step has been added, at a time not after the newest step's, or if an index is
+      out of range.
+
+      Args:
+          indices (iterable): The points or cells whose vectors changed.
+
+          scalars (iterable): The new vector of each, parallel to indices.
+
+          activity_flips (iterable): The points or cells whose activity toggled.
+
+          time (float): The time of the scalars.
+  )pydoc";
+  gridtrace.def("add_grid_scalar_changes_at_time", [](xms::XmGridTrace &self,
+          py::iterable indices,
+          py::iterable vel_scalars,
+          py::iterable activity_flips,
+          double time) {
+            boost::shared_ptr<xms::VecInt> changed = xms::VecIntFromPyIter(indices);
+            boost::shared_ptr<xms::VecPt3d> scalars = xms::VecPt3dFromPyIter(vel_scalars);
+            boost::shared_ptr<xms::VecInt> flips = xms::VecIntFromPyIter(activity_flips);
+            self.AddGridScalarChangesAtTime(*changed, *scalars, *flips, time);
+          }, add_grid_scalar_changes_at_time_doc, py::arg("indices"), py::arg("scalars"),
+          py::arg("activity_flips"), py::arg("time"));
+  // ---------------------------------------------------------------------------
+  // function: add_cached_grid_scalars_at_time
+  // ---------------------------------------------------------------------------
+  const char* add_cached_grid_scalars_at_time_doc = R"pydoc(
+      Adds the step of time_step_dataset at a time from the time step cache, if it is
+      there, exactly as it was when first added but without converting or fitting it.
+      Counted as a hit or a miss in get_statistics.
+
+      Args:
+          time (float): The time of the step.
+
+      Returns:
+          bool: True if the step was cached and has been added; False, with nothing
+          added, if it was not.
+  )pydoc";
+  gridtrace.def("add_cached_grid_scalars_at_time", [](xms::XmGridTrace &self,
+          double time) -> bool {
+            return self.AddCachedGridScalarsAtTime(time);
+          }, add_cached_grid_scalars_at_time_doc, py::arg("time"));
+  // ---------------------------------------------------------------------------
+  // function: clear_time_step_cache
+  // ---------------------------------------------------------------------------
+  const char* clear_time_step_cache_doc = R"pydoc(
+      Drops every step in the time step cache, as when a dataset's values have been
+      edited.
+  )pydoc";
+  gridtrace.def("clear_time_step_cache", [](xms::XmGridTrace &self) {
+          self.ClearTimeStepCache();
+        }, clear_time_step_cache_doc);
+  // ---------------------------------------------------------------------------
   // function: trace_point
   // ---------------------------------------------------------------------------
   const char* trace_point_doc = R"pydoc(
@@ -304,6 +990,40 @@ void initXmGridTrace(py::module &m) {
           return py::make_tuple(resultTrace, resultTimes);
         }, trace_point_doc, py::arg("pt"), py::arg("pt_time"));
   // ---------------------------------------------------------------------------
+  // function: trace_points
+  // ---------------------------------------------------------------------------
+  const char* trace_points_doc = R"pydoc(
+      Runs the Grid Trace for many points, each exactly as trace_point would, with the
+      GIL released throughout. The points are stepped together on thread_count threads,
+      and a batch begun with start_traces is left as it was.
+
+      Args:
+          pts (iterable): The starting point of each trace; an N x 2 or N x 3 NumPy array
+          is read without converting each point to a Python object.
+
+          pt_times (iterable): The starting time of each trace, one per point, or one
+          number for them all.
+
+      Returns:
+          tuple: The traces in the layout of get_flat_trace_results: the position of each
+          vertex as an N x 2 float64 array, the time of each vertex, where each trace
+          begins as a uint64 array one longer than pts, and why each trace stopped as an
+          int32 array of exit_reason_enum values.
+  )pydoc";
+  gridtrace.def("trace_points", [](xms::XmGridTrace &self, py::object pts,
+    py::object pt_times) -> py::tuple {
+          SeedReader seeds(pts, pt_times, "trace_points");
+          xms::VecDbl xy, times;
+          std::vector<size_t> offsets;
+          std::vector<xms::XmGridTraceExitEnum> reasons;
+          {
+            py::gil_scoped_release release;
+            seeds.Read();
+            self.TracePoints(seeds.m_pts, seeds.m_times, xy, times, offsets, reasons);
+          }
+          return iFlatResults(std::move(xy), std::move(times), std::move(offsets), reasons);
+        }, trace_points_doc, py::arg("pts"), py::arg("pt_times"));
+  // ---------------------------------------------------------------------------
   // function: get_exit_message
   // ---------------------------------------------------------------------------
   const char* get_exit_message_doc = R"pydoc(
@@ -322,7 +1042,8 @@ void initXmGridTrace(py::module &m) {
 
       Prefer this over get_exit_message when deciding what to do with a trace; the message
       is for display. WAITING_FOR_TIME_STEP means the path stops early because the field is
-      not known past the second loaded time step, not that the particle came to rest.
+      not known past the newest loaded time step in the window, not that the particle
+      came to rest.
 
       Returns:
           exit_reason_enum: The exit reason of the last trace operation.
@@ -330,14 +1051,30 @@ void initXmGridTrace(py::module &m) {
   gridtrace.def("get_exit_reason", &xms::XmGridTrace::GetExitReason,
     get_exit_reason_doc);
   // ---------------------------------------------------------------------------
+  // function: get_exit_edge
+  // ---------------------------------------------------------------------------
+  const char* get_exit_edge_doc = R"pydoc(
+      Returns the cell edge the last trace operation left the grid through.
+
+      Returns:
+          tuple: The cell and the edge's index within the cell, as UGrid.get_cell_edge
+          numbers them; both -1 if the trace did not stop with LEFT_GRID.
+  )pydoc";
+  gridtrace.def("get_exit_edge", [](const xms::XmGridTrace &self) -> py::tuple {
+          int cellIdx, cellEdgeIdx;
+          self.GetExitEdge(cellIdx, cellEdgeIdx);
+          return py::make_tuple(cellIdx, cellEdgeIdx);
+        }, get_exit_edge_doc);
+  // ---------------------------------------------------------------------------
   // function: start_traces
   // ---------------------------------------------------------------------------
   const char* start_traces_doc = R"pydoc(
       Begins tracing a batch of seeds against the currently loaded time steps.
 
-      A trace runs only as far as the second loaded time step, because that is as far as
-      the field is known. Supply the next time step with add_grid_scalars_at_time and call
-      continue_traces to carry every unfinished trace onward::
+      A trace runs only as far as the newest loaded time step in the window, because
+      that is as far as the field is known. Supply the next time step with
+      add_grid_scalars_at_time and call continue_traces to carry every unfinished
+      trace onward::
 
           tracer.start_traces(seeds, seed_times)
           while tracer.continue_traces() > 0:
@@ -351,24 +1088,18 @@ void initXmGridTrace(py::module &m) {
       flight per tracer; starting a batch discards any previous one.
 
       Args:
-          pts (iterable): The starting point of each trace.
+          pts (iterable): The starting point of each trace. An N x 2 or N x 3 NumPy
+          array is read without converting each point to a Python object.
 
-          pt_times (iterable): The starting time of each trace, one per point.
+          pt_times (iterable): The starting time of each trace, one per point, or one
+          number for them all.
   )pydoc";
-  gridtrace.def("start_traces", [](xms::XmGridTrace &self, py::iterable pts,
-    py::iterable pt_times) {
-          boost::shared_ptr<xms::VecPt3d> points = xms::VecPt3dFromPyIter(pts);
-          boost::shared_ptr<xms::VecDbl> times = xms::VecDblFromPyIter(pt_times);
-          if (points->size() != times->size())
-          {
-            // Raised rather than logged: the C++ side refuses the batch and returns empty,
-            // which from Python would look like a tracer that silently did nothing.
-            std::string msg = "start_traces needs one start time per point, got " +
-                              std::to_string(points->size()) + " points and " +
-                              std::to_string(times->size()) + " times";
-            throw py::value_error(msg);
-          }
-          self.StartTraces(*points, *times);
+  gridtrace.def("start_traces", [](xms::XmGridTrace &self, py::object pts,
+    py::object pt_times) {
+          SeedReader seeds(pts, pt_times, "start_traces");
+          py::gil_scoped_release release;
+          seeds.Read();
+          self.StartTraces(seeds.m_pts, seeds.m_times);
         }, start_traces_doc, py::arg("pts"), py::arg("pt_times"));
   // ---------------------------------------------------------------------------
   // function: continue_traces
@@ -414,6 +1145,152 @@ void initXmGridTrace(py::module &m) {
           }
           return py::make_tuple(traces, times, reasons);
         }, get_trace_results_doc);
+  // ---------------------------------------------------------------------------
+  // function: get_flat_trace_results
+  // ---------------------------------------------------------------------------
+  const char* get_flat_trace_results_doc = R"pydoc(
+      Returns the batch traced so far as flat NumPy arrays: every trace's vertices one
+      after another, and where each trace begins. The same results as
+      get_trace_results without a Python object per trace or per vertex, in the layout
+      a vertex buffer wants. Trace i is rows offsets[i] up to offsets[i + 1].
+
+      Returns:
+          tuple: The position of each vertex as an N x 2 float64 array, the time of
+          each vertex as an N float64 array, where each trace begins as a uint64 array
+          one longer than the seeds passed to start_traces, and why each trace stopped
+          as an int32 array of exit_reason_enum values.
+  )pydoc";
+  gridtrace.def("get_flat_trace_results", [](const xms::XmGridTrace &self) -> py::tuple {
+          xms::VecDbl xy, times;
+          std::vector<size_t> offsets;
+          std::vector<xms::XmGridTraceExitEnum> reasons;
+          {
+            py::gil_scoped_release release;
+            self.GetFlatTraceResults(xy, times, offsets, reasons);
+          }
+          return iFlatResults(std::move(xy), std::move(times), std::move(offsets), reasons);
+        }, get_flat_trace_results_doc);
+  // ---------------------------------------------------------------------------
+  // function: take_trace_results
+  // ---------------------------------------------------------------------------
+  const char* take_trace_results_doc = R"pydoc(
+      Returns the batch's results as get_trace_results does, and frees the batch.
+      Afterwards the tracer holds no batch.
+
+      Returns:
+          tuple: The positions of each trace, the times of each trace, and why each trace
+          stopped as an exit_reason_enum, all parallel to the seeds passed to start_traces.
+  )pydoc";
+  gridtrace.def("take_trace_results", [](xms::XmGridTrace &self) -> py::iterable {
+          std::vector<xms::VecPt3d> outTraces;
+          std::vector<xms::VecDbl> outTimes;
+          std::vector<xms::XmGridTraceExitEnum> outReasons;
+          self.TakeTraceResults(outTraces, outTimes, outReasons);
+          py::list traces, times, reasons;
+          for (size_t i = 0; i < outTraces.size(); ++i)
+          {
+            traces.append(xms::PyIterFromVecPt3d(outTraces[i]));
+            times.append(xms::PyIterFromVecDbl(outTimes[i]));
+            reasons.append(outReasons[i]);
+          }
+          return py::make_tuple(traces, times, reasons);
+        }, take_trace_results_doc);
+  // ---------------------------------------------------------------------------
+  // function: take_trace_result
+  // ---------------------------------------------------------------------------
+  const char* take_trace_result_doc = R"pydoc(
+      Returns one finished trace of the batch and frees its vertices, so a long run
+      can hand each trace on as soon as it stops. A taken trace keeps its exit reason
+      but has no positions in later results.
+
+      Args:
+          index (int): The trace, by the index of its seed in start_traces.
+
+      Returns:
+          tuple: The positions, the times and the exit_reason_enum of the trace, or None
+          if the trace is still running or there is no such trace.
+  )pydoc";
+  gridtrace.def("take_trace_result", [](xms::XmGridTrace &self, size_t index) -> py::object {
+          xms::VecPt3d trace;
+          xms::VecDbl times;
+          xms::XmGridTraceExitEnum reason;
+          if (!self.TakeTraceResult(index, trace, times, reason))
+            return py::none();
+          return py::make_tuple(xms::PyIterFromVecPt3d(trace), xms::PyIterFromVecDbl(times),
+                                reason);
+        }, take_trace_result_doc, py::arg("index"));
+  // ---------------------------------------------------------------------------
+  // function: get_trace_exit_edges
+  // ---------------------------------------------------------------------------
+  const char* get_trace_exit_edges_doc = R"pydoc(
+      Returns the cell edge each trace of the batch left the grid through.
+
+      For a trace that stopped on entering an inactive cell, this is the edge of the last
+      active cell it was in.
+
+      Returns:
+          tuple: The cell each trace left through and the edge's index within that cell,
+          both parallel to the seeds passed to start_traces; -1 for a trace that did not
+          stop with LEFT_GRID.
+  )pydoc";
+  gridtrace.def("get_trace_exit_edges", [](const xms::XmGridTrace &self) -> py::iterable {
+          xms::VecInt cells, cellEdges;
+          self.GetTraceExitEdges(cells, cellEdges);
+          return py::make_tuple(xms::PyIterFromVecInt(cells), xms::PyIterFromVecInt(cellEdges));
+        }, get_trace_exit_edges_doc);
+  // ---------------------------------------------------------------------------
+  // function: get_statistics
+  // ---------------------------------------------------------------------------
+  const char* get_statistics_doc = R"pydoc(
+      Returns what the tracer has done since it was made or reset_statistics was last
+      called. Always collected; counts from the threads of continue_traces are added in
+      when it returns.
+
+      Returns:
+          dict: accepted_steps, rejected_steps, and the rejections by cause in
+          velocity_splits, direction_splits and error_rejections; evaluations of the field;
+          searches, the whole-grid point locations a walk could not replace;
+          boundary_exits, steps cut back at the edge of the grid or of the active cells;
+          exit_reasons, a dict of traces stopped by exit_reason_enum;
+          time_step_cache_hits and time_step_cache_misses of
+          add_cached_grid_scalars_at_time; and the wall time in
+          seconds of add_scalars_seconds, triangulation_seconds (part of the first),
+          stepping_seconds, time_step_wait_seconds (waiting on add_grid_scalars_at_time_async)
+          and result_copy_seconds.
+  )pydoc";
+  gridtrace.def("get_statistics", [](const xms::XmGridTrace &self) -> py::dict {
+          const xms::XmGridTraceStatistics& stats = self.GetStatistics();
+          py::dict exitReasons;
+          for (int i = 0; i < xms::XmGridTraceStatistics::EXIT_REASON_COUNT; ++i)
+            exitReasons[py::cast((xms::XmGridTraceExitEnum)i)] = stats.m_exitReasons[i];
+          py::dict result;
+          result["accepted_steps"] = stats.m_acceptedSteps;
+          result["rejected_steps"] = stats.m_rejectedSteps;
+          result["velocity_splits"] = stats.m_velocitySplits;
+          result["direction_splits"] = stats.m_directionSplits;
+          result["error_rejections"] = stats.m_errorRejections;
+          result["evaluations"] = stats.m_evaluations;
+          result["searches"] = stats.m_searches;
+          result["boundary_exits"] = stats.m_boundaryExits;
+          result["exit_reasons"] = exitReasons;
+          result["time_step_cache_hits"] = stats.m_timeStepCacheHits;
+          result["time_step_cache_misses"] = stats.m_timeStepCacheMisses;
+          result["add_scalars_seconds"] = stats.m_addScalarsSeconds;
+          result["triangulation_seconds"] = stats.m_triangulationSeconds;
+          result["stepping_seconds"] = stats.m_steppingSeconds;
+          result["time_step_wait_seconds"] = stats.m_timeStepWaitSeconds;
+          result["result_copy_seconds"] = stats.m_resultCopySeconds;
+          return result;
+        }, get_statistics_doc);
+  // ---------------------------------------------------------------------------
+  // function: reset_statistics
+  // ---------------------------------------------------------------------------
+  const char* reset_statistics_doc = R"pydoc(
+      Zeroes the statistics get_statistics returns.
+  )pydoc";
+  gridtrace.def("reset_statistics", [](xms::XmGridTrace &self) {
+          self.ResetStatistics();
+        }, reset_statistics_doc);
 
     // XmGridTraceExitEnum
     py::enum_<xms::XmGridTraceExitEnum>(m, "exit_reason_enum",
@@ -428,6 +1305,13 @@ void initXmGridTrace(py::module &m) {
         .value("SEED_NOT_TRACEABLE", xms::GTEXIT_SEED_NOT_TRACEABLE)
         .value("EXTRACTION_FAILED", xms::GTEXIT_EXTRACTION_FAILED);
 
+    // XmGridTraceIntegratorEnum
+    py::enum_<xms::XmGridTraceIntegratorEnum>(m, "integrator_enum",
+                    "integrator_enum how a trace is advanced from one point to the next")
+        .value("EULER", xms::GTINT_EULER)
+        .value("RK4", xms::GTINT_RK4)
+        .value("DORMAND_PRINCE", xms::GTINT_DORMAND_PRINCE);
+
     // DataLocationEnum
     py::enum_<xms::DataLocationEnum>(m, "data_location_enum",
                     "data_location_enum location mapping for dataset values")